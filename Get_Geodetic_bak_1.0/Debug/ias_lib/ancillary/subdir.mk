@@ -21,6 +21,8 @@ C_SRCS += \
 ../ias_lib/ancillary/ias_ancillary_preprocess.c \
 ../ias_lib/ancillary/ias_ancillary_preprocess_attitude.c \
 ../ias_lib/ancillary/ias_ancillary_preprocess_ephemeris.c \
+../ias_lib/ancillary/ias_ancillary_resample_ephemeris.c \
+../ias_lib/ancillary/ias_ancillary_screen_ephemeris.c \
 ../ias_lib/ancillary/ias_ancillary_smooth_ephemeris.c 
 
 OBJS += \
@@ -41,6 +43,8 @@ OBJS += \
 ./ias_lib/ancillary/ias_ancillary_preprocess.o \
 ./ias_lib/ancillary/ias_ancillary_preprocess_attitude.o \
 ./ias_lib/ancillary/ias_ancillary_preprocess_ephemeris.o \
+./ias_lib/ancillary/ias_ancillary_resample_ephemeris.o \
+./ias_lib/ancillary/ias_ancillary_screen_ephemeris.o \
 ./ias_lib/ancillary/ias_ancillary_smooth_ephemeris.o 
 
 C_DEPS += \
@@ -61,6 +65,8 @@ C_DEPS += \
 ./ias_lib/ancillary/ias_ancillary_preprocess.d \
 ./ias_lib/ancillary/ias_ancillary_preprocess_attitude.d \
 ./ias_lib/ancillary/ias_ancillary_preprocess_ephemeris.d \
+./ias_lib/ancillary/ias_ancillary_resample_ephemeris.d \
+./ias_lib/ancillary/ias_ancillary_screen_ephemeris.d \
 ./ias_lib/ancillary/ias_ancillary_smooth_ephemeris.d 
 
 
@@ -6,7 +6,10 @@
 C_SRCS += \
 ../ias_lib/io/L0R/ias_l0r.c \
 ../ias_lib/io/L0R/ias_l0r_anc.c \
+../ias_lib/io/L0R/ias_l0r_anc_snapshot.c \
 ../ias_lib/io/L0R/ias_l0r_band.c \
+../ias_lib/io/L0R/ias_l0r_band_chunk.c \
+../ias_lib/io/L0R/ias_l0r_band_iterator.c \
 ../ias_lib/io/L0R/ias_l0r_hdf.c \
 ../ias_lib/io/L0R/ias_l0r_header.c \
 ../ias_lib/io/L0R/ias_l0r_mta.c 
@@ -14,7 +17,10 @@ C_SRCS += \
 OBJS += \
 ./ias_lib/io/L0R/ias_l0r.o \
 ./ias_lib/io/L0R/ias_l0r_anc.o \
+./ias_lib/io/L0R/ias_l0r_anc_snapshot.o \
 ./ias_lib/io/L0R/ias_l0r_band.o \
+./ias_lib/io/L0R/ias_l0r_band_chunk.o \
+./ias_lib/io/L0R/ias_l0r_band_iterator.o \
 ./ias_lib/io/L0R/ias_l0r_hdf.o \
 ./ias_lib/io/L0R/ias_l0r_header.o \
 ./ias_lib/io/L0R/ias_l0r_mta.o 
@@ -22,7 +28,10 @@ OBJS += \
 C_DEPS += \
 ./ias_lib/io/L0R/ias_l0r.d \
 ./ias_lib/io/L0R/ias_l0r_anc.d \
+./ias_lib/io/L0R/ias_l0r_anc_snapshot.d \
 ./ias_lib/io/L0R/ias_l0r_band.d \
+./ias_lib/io/L0R/ias_l0r_band_chunk.d \
+./ias_lib/io/L0R/ias_l0r_band_iterator.d \
 ./ias_lib/io/L0R/ias_l0r_hdf.d \
 ./ias_lib/io/L0R/ias_l0r_header.d \
 ./ias_lib/io/L0R/ias_l0r_mta.d 
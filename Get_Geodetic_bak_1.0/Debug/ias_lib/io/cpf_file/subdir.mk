@@ -55,7 +55,8 @@ C_SRCS += \
 ../ias_lib/io/cpf_file/ias_cpf_parse_tirs_temp_sens.c \
 ../ias_lib/io/cpf_file/ias_cpf_parse_tirs_thermal_constants.c \
 ../ias_lib/io/cpf_file/ias_cpf_parse_ut1_times.c \
-../ias_lib/io/cpf_file/ias_cpf_read.c 
+../ias_lib/io/cpf_file/ias_cpf_read.c \
+../ias_lib/io/cpf_file/ias_cpf_snapshot.c 
 
 OBJS += \
 ./ias_lib/io/cpf_file/ias_cpf_cache.o \
@@ -109,7 +110,8 @@ OBJS += \
 ./ias_lib/io/cpf_file/ias_cpf_parse_tirs_temp_sens.o \
 ./ias_lib/io/cpf_file/ias_cpf_parse_tirs_thermal_constants.o \
 ./ias_lib/io/cpf_file/ias_cpf_parse_ut1_times.o \
-./ias_lib/io/cpf_file/ias_cpf_read.o 
+./ias_lib/io/cpf_file/ias_cpf_read.o \
+./ias_lib/io/cpf_file/ias_cpf_snapshot.o 
 
 C_DEPS += \
 ./ias_lib/io/cpf_file/ias_cpf_cache.d \
@@ -163,7 +165,8 @@ C_DEPS += \
 ./ias_lib/io/cpf_file/ias_cpf_parse_tirs_temp_sens.d \
 ./ias_lib/io/cpf_file/ias_cpf_parse_tirs_thermal_constants.d \
 ./ias_lib/io/cpf_file/ias_cpf_parse_ut1_times.d \
-./ias_lib/io/cpf_file/ias_cpf_read.d 
+./ias_lib/io/cpf_file/ias_cpf_read.d \
+./ias_lib/io/cpf_file/ias_cpf_snapshot.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -6,6 +6,7 @@
 C_SRCS += \
 ../ias_lib/los_model/sensor/ias_sensor_adjust_los_for_ssm.c \
 ../ias_lib/los_model/sensor/ias_sensor_align_ssm_data.c \
+../ias_lib/los_model/sensor/ias_sensor_build_los_table.c \
 ../ias_lib/los_model/sensor/ias_sensor_check_ssm_encoder_data.c \
 ../ias_lib/los_model/sensor/ias_sensor_find_los_vector.c \
 ../ias_lib/los_model/sensor/ias_sensor_find_time.c \
@@ -20,6 +21,7 @@ C_SRCS += \
 OBJS += \
 ./ias_lib/los_model/sensor/ias_sensor_adjust_los_for_ssm.o \
 ./ias_lib/los_model/sensor/ias_sensor_align_ssm_data.o \
+./ias_lib/los_model/sensor/ias_sensor_build_los_table.o \
 ./ias_lib/los_model/sensor/ias_sensor_check_ssm_encoder_data.o \
 ./ias_lib/los_model/sensor/ias_sensor_find_los_vector.o \
 ./ias_lib/los_model/sensor/ias_sensor_find_time.o \
@@ -34,6 +36,7 @@ OBJS += \
 C_DEPS += \
 ./ias_lib/los_model/sensor/ias_sensor_adjust_los_for_ssm.d \
 ./ias_lib/los_model/sensor/ias_sensor_align_ssm_data.d \
+./ias_lib/los_model/sensor/ias_sensor_build_los_table.d \
 ./ias_lib/los_model/sensor/ias_sensor_check_ssm_encoder_data.d \
 ./ias_lib/los_model/sensor/ias_sensor_find_los_vector.d \
 ./ias_lib/los_model/sensor/ias_sensor_find_time.d \
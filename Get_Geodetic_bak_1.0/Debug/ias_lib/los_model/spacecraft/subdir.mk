@@ -7,25 +7,31 @@ C_SRCS += \
 ../ias_lib/los_model/spacecraft/ias_sc_model_attitude_jitter_tools.c \
 ../ias_lib/los_model/spacecraft/ias_sc_model_correct_attitude.c \
 ../ias_lib/los_model/spacecraft/ias_sc_model_correct_ephem_convert_ecef2eci.c \
+../ias_lib/los_model/spacecraft/ias_sc_model_ephemeris_interpolator.c \
 ../ias_lib/los_model/spacecraft/ias_sc_model_find_attitude_at_time.c \
 ../ias_lib/los_model/spacecraft/ias_sc_model_get_position_and_velocity_at_time.c \
-../ias_lib/los_model/spacecraft/ias_sc_model_set_ancillary.c 
+../ias_lib/los_model/spacecraft/ias_sc_model_set_ancillary.c \
+../ias_lib/los_model/spacecraft/ias_sc_model_time_base.c 
 
 OBJS += \
 ./ias_lib/los_model/spacecraft/ias_sc_model_attitude_jitter_tools.o \
 ./ias_lib/los_model/spacecraft/ias_sc_model_correct_attitude.o \
 ./ias_lib/los_model/spacecraft/ias_sc_model_correct_ephem_convert_ecef2eci.o \
+./ias_lib/los_model/spacecraft/ias_sc_model_ephemeris_interpolator.o \
 ./ias_lib/los_model/spacecraft/ias_sc_model_find_attitude_at_time.o \
 ./ias_lib/los_model/spacecraft/ias_sc_model_get_position_and_velocity_at_time.o \
-./ias_lib/los_model/spacecraft/ias_sc_model_set_ancillary.o 
+./ias_lib/los_model/spacecraft/ias_sc_model_set_ancillary.o \
+./ias_lib/los_model/spacecraft/ias_sc_model_time_base.o 
 
 C_DEPS += \
 ./ias_lib/los_model/spacecraft/ias_sc_model_attitude_jitter_tools.d \
 ./ias_lib/los_model/spacecraft/ias_sc_model_correct_attitude.d \
 ./ias_lib/los_model/spacecraft/ias_sc_model_correct_ephem_convert_ecef2eci.d \
+./ias_lib/los_model/spacecraft/ias_sc_model_ephemeris_interpolator.d \
 ./ias_lib/los_model/spacecraft/ias_sc_model_find_attitude_at_time.d \
 ./ias_lib/los_model/spacecraft/ias_sc_model_get_position_and_velocity_at_time.d \
-./ias_lib/los_model/spacecraft/ias_sc_model_set_ancillary.d 
+./ias_lib/los_model/spacecraft/ias_sc_model_set_ancillary.d \
+./ias_lib/los_model/spacecraft/ias_sc_model_time_base.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
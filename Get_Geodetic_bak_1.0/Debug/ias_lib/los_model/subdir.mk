@@ -12,6 +12,7 @@ C_SRCS += \
 ../ias_lib/los_model/ias_los_model_get_satellite_state_vector_at_location.c \
 ../ias_lib/los_model/ias_los_model_initialize.c \
 ../ias_lib/los_model/ias_los_model_input_line_samp_to_geodetic.c \
+../ias_lib/los_model/ias_los_model_input_line_samp_to_geodetic_batch.c \
 ../ias_lib/los_model/ias_los_model_lunar_projection.c \
 ../ias_lib/los_model/ias_los_model_set_cpf.c \
 ../ias_lib/los_model/ias_los_model_set_l0r.c 
@@ -25,6 +26,7 @@ OBJS += \
 ./ias_lib/los_model/ias_los_model_get_satellite_state_vector_at_location.o \
 ./ias_lib/los_model/ias_los_model_initialize.o \
 ./ias_lib/los_model/ias_los_model_input_line_samp_to_geodetic.o \
+./ias_lib/los_model/ias_los_model_input_line_samp_to_geodetic_batch.o \
 ./ias_lib/los_model/ias_los_model_lunar_projection.o \
 ./ias_lib/los_model/ias_los_model_set_cpf.o \
 ./ias_lib/los_model/ias_los_model_set_l0r.o 
@@ -38,6 +40,7 @@ C_DEPS += \
 ./ias_lib/los_model/ias_los_model_get_satellite_state_vector_at_location.d \
 ./ias_lib/los_model/ias_los_model_initialize.d \
 ./ias_lib/los_model/ias_los_model_input_line_samp_to_geodetic.d \
+./ias_lib/los_model/ias_los_model_input_line_samp_to_geodetic_batch.d \
 ./ias_lib/los_model/ias_los_model_lunar_projection.d \
 ./ias_lib/los_model/ias_los_model_set_cpf.d \
 ./ias_lib/los_model/ias_los_model_set_l0r.d 
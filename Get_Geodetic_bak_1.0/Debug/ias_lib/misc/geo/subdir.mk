@@ -28,6 +28,7 @@ C_SRCS += \
 ../ias_lib/misc/geo/ias_geo_correct_for_light_travel_time.c \
 ../ias_lib/misc/geo/ias_geo_correct_for_velocity_aberration.c \
 ../ias_lib/misc/geo/ias_geo_create_transformation_matrix.c \
+../ias_lib/misc/geo/ias_geo_earth_orientation_cache.c \
 ../ias_lib/misc/geo/ias_geo_ecef2eci.c \
 ../ias_lib/misc/geo/ias_geo_eci2ecef.c \
 ../ias_lib/misc/geo/ias_geo_extract_window.c \
@@ -38,12 +39,14 @@ C_SRCS += \
 ../ias_lib/misc/geo/ias_geo_find_mjdcoords.c \
 ../ias_lib/misc/geo/ias_geo_find_sec.c \
 ../ias_lib/misc/geo/ias_geo_find_target_position.c \
+../ias_lib/misc/geo/ias_geo_find_target_position_batch.c \
 ../ias_lib/misc/geo/ias_geo_get_units.c \
 ../ias_lib/misc/geo/ias_geo_handle_180.c \
 ../ias_lib/misc/geo/ias_geo_lagrange_interpolate.c \
 ../ias_lib/misc/geo/ias_geo_novas_wrapper.c \
 ../ias_lib/misc/geo/ias_geo_projection_transformation.c \
 ../ias_lib/misc/geo/ias_geo_report_proj_err.c \
+../ias_lib/misc/geo/ias_geo_time_system.c \
 ../ias_lib/misc/geo/ias_geo_transform_ecef2j2k.c \
 ../ias_lib/misc/geo/ias_geo_transform_j2k2tod.c \
 ../ias_lib/misc/geo/ias_geo_transform_nutation.c \
@@ -77,6 +80,7 @@ OBJS += \
 ./ias_lib/misc/geo/ias_geo_correct_for_light_travel_time.o \
 ./ias_lib/misc/geo/ias_geo_correct_for_velocity_aberration.o \
 ./ias_lib/misc/geo/ias_geo_create_transformation_matrix.o \
+./ias_lib/misc/geo/ias_geo_earth_orientation_cache.o \
 ./ias_lib/misc/geo/ias_geo_ecef2eci.o \
 ./ias_lib/misc/geo/ias_geo_eci2ecef.o \
 ./ias_lib/misc/geo/ias_geo_extract_window.o \
@@ -87,12 +91,14 @@ OBJS += \
 ./ias_lib/misc/geo/ias_geo_find_mjdcoords.o \
 ./ias_lib/misc/geo/ias_geo_find_sec.o \
 ./ias_lib/misc/geo/ias_geo_find_target_position.o \
+./ias_lib/misc/geo/ias_geo_find_target_position_batch.o \
 ./ias_lib/misc/geo/ias_geo_get_units.o \
 ./ias_lib/misc/geo/ias_geo_handle_180.o \
 ./ias_lib/misc/geo/ias_geo_lagrange_interpolate.o \
 ./ias_lib/misc/geo/ias_geo_novas_wrapper.o \
 ./ias_lib/misc/geo/ias_geo_projection_transformation.o \
 ./ias_lib/misc/geo/ias_geo_report_proj_err.o \
+./ias_lib/misc/geo/ias_geo_time_system.o \
 ./ias_lib/misc/geo/ias_geo_transform_ecef2j2k.o \
 ./ias_lib/misc/geo/ias_geo_transform_j2k2tod.o \
 ./ias_lib/misc/geo/ias_geo_transform_nutation.o \
@@ -126,6 +132,7 @@ C_DEPS += \
 ./ias_lib/misc/geo/ias_geo_correct_for_light_travel_time.d \
 ./ias_lib/misc/geo/ias_geo_correct_for_velocity_aberration.d \
 ./ias_lib/misc/geo/ias_geo_create_transformation_matrix.d \
+./ias_lib/misc/geo/ias_geo_earth_orientation_cache.d \
 ./ias_lib/misc/geo/ias_geo_ecef2eci.d \
 ./ias_lib/misc/geo/ias_geo_eci2ecef.d \
 ./ias_lib/misc/geo/ias_geo_extract_window.d \
@@ -136,12 +143,14 @@ C_DEPS += \
 ./ias_lib/misc/geo/ias_geo_find_mjdcoords.d \
 ./ias_lib/misc/geo/ias_geo_find_sec.d \
 ./ias_lib/misc/geo/ias_geo_find_target_position.d \
+./ias_lib/misc/geo/ias_geo_find_target_position_batch.d \
 ./ias_lib/misc/geo/ias_geo_get_units.d \
 ./ias_lib/misc/geo/ias_geo_handle_180.d \
 ./ias_lib/misc/geo/ias_geo_lagrange_interpolate.d \
 ./ias_lib/misc/geo/ias_geo_novas_wrapper.d \
 ./ias_lib/misc/geo/ias_geo_projection_transformation.d \
 ./ias_lib/misc/geo/ias_geo_report_proj_err.d \
+./ias_lib/misc/geo/ias_geo_time_system.d \
 ./ias_lib/misc/geo/ias_geo_transform_ecef2j2k.d \
 ./ias_lib/misc/geo/ias_geo_transform_j2k2tod.d \
 ./ias_lib/misc/geo/ias_geo_transform_nutation.d \
@@ -42,4 +42,5 @@ ias_lib/io/L0R \
 ias_lib/grid \
 ias_lib/ancillary \
 MQ \
+benchmark \
 
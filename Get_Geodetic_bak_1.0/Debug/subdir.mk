@@ -4,27 +4,45 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../frame_executor.c \
+../geolocation_grid.c \
 ../main.c \
+../mwdImage_frame_index.c \
+../mwd_daemon.c \
+../mwd_metrics.c \
+../mwd_scene.c \
 ../read_ephemeris_data.c \
 ../read_parameter.c \
 ../read_write_mwdImage.c \
-../threadpool.c \
+../scene_cache.c \
 ../update_longitude_latiude.c 
 
 OBJS += \
+./frame_executor.o \
+./geolocation_grid.o \
 ./main.o \
+./mwdImage_frame_index.o \
+./mwd_daemon.o \
+./mwd_metrics.o \
+./mwd_scene.o \
 ./read_ephemeris_data.o \
 ./read_parameter.o \
 ./read_write_mwdImage.o \
-./threadpool.o \
+./scene_cache.o \
 ./update_longitude_latiude.o 
 
 C_DEPS += \
+./frame_executor.d \
+./geolocation_grid.d \
 ./main.d \
+./mwdImage_frame_index.d \
+./mwd_daemon.d \
+./mwd_metrics.d \
+./mwd_scene.d \
 ./read_ephemeris_data.d \
 ./read_parameter.d \
 ./read_write_mwdImage.d \
-./threadpool.d \
+./scene_cache.d \
 ./update_longitude_latiude.d 
 
 
@@ -7,7 +7,13 @@
 
 #include "string.h"
 #include "stdlib.h"
+#include <stdio.h>
+#include <unistd.h>
 #include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
 #include "amqp.h"
 #include "amqp_framing.h"
 
@@ -15,17 +21,63 @@
 #include "MQSend.h"
 #include "utils.h"
 
-/* These variables are used in MQ_Init*/
-int sockfd;
-amqp_connection_state_t conn;
-amqp_basic_properties_t props;
+/* A message waiting in the publisher queue */
+typedef struct mq_message
+{
+	char routing_key[NAME_MAX];		/* order ID of the message */
+	char body[NAME_MAX];			/* formatted message */
+	int progress;					/* may be coalesced or dropped */
+} MQ_MESSAGE;
+
+/* Messages are published by a sender thread so the threads reporting never
+ * wait on the broker. The queue is bounded: under pressure the progress
+ * messages are coalesced, then dropped, and the status messages displace
+ * the oldest progress message. */
+typedef struct mq_publisher
+{
+	pthread_mutex_t lock;			/* protects the fields below */
+	pthread_cond_t cond;			/* signaled on new messages and stop */
+	pthread_t thread;				/* sender thread */
+	MQ_MESSAGE queue[MQ_QUEUE_SIZE];/* ring of the waiting messages */
+	int head;						/* index of the oldest message */
+	int count;						/* number of waiting messages */
+	int stopping;					/* set by MQ_Shutdown */
+	long long num_sent;				/* messages published */
+	long long num_coalesced;		/* progress messages replaced */
+	long long num_dropped;			/* messages dropped */
+	long long num_reconnects;		/* connections after the first */
+} MQ_PUBLISHER;
+
+/* These variables are only used by the sender thread */
+static int sockfd;
+static amqp_connection_state_t conn;
+static amqp_basic_properties_t props;
+static int mq_connected = 0;
 
 static int mq_init_success = 0;
+static int mq_exit_registered = 0;
+static MQ_PUBLISHER publisher =
+{
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.thread = 0,
+	.queue = {{{0}}},
+	.head = 0,
+	.count = 0,
+	.stopping = 0,
+	.num_sent = 0,
+	.num_coalesced = 0,
+	.num_dropped = 0,
+	.num_reconnects = 0
+};
 
-int MQ_Init()
+/* Open the connection and the channel of the broker */
+static int mq_connect()
 {
 	int status;/* flag for  error !*/
 	int port;
+	amqp_rpc_reply_t reply;
+	struct timeval timeout;
 	port = atoi(mq_params.Port);
 	/*MQ INIT START*/
 	conn = amqp_new_connection();
@@ -33,16 +85,28 @@ int MQ_Init()
 	status = die_on_error(sockfd = amqp_open_socket(mq_params.Host, port),
 			"Opening socket");
 	if (status != SUCCESS) {
-		mq_init_success = 0;/* MQ init is wrong! */
+		amqp_destroy_connection(conn);
 		return ERROR;
 	}
+	/* a broker not answering fails the connection instead of hanging it */
+	timeout.tv_sec = MQ_SOCKET_TIMEOUT_SECONDS;
+	timeout.tv_usec = 0;
+	setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
 	amqp_set_sockfd(conn, sockfd);
-	die_on_amqp_error(
-			amqp_login(conn, "/", 0, 131072, 0, AMQP_SASL_METHOD_PLAIN,
-					mq_params.UserName, mq_params.PassWord), "logging in");
-
-	amqp_channel_open(conn, 1);
-	die_on_amqp_error(amqp_get_rpc_reply(conn), "Opening channel");
+	reply = amqp_login(conn, "/", 0, 131072, 0, AMQP_SASL_METHOD_PLAIN,
+					mq_params.UserName, mq_params.PassWord);
+	die_on_amqp_error(reply, "logging in");
+	if (reply.reply_type == AMQP_RESPONSE_NORMAL) {
+		amqp_channel_open(conn, 1);
+		reply = amqp_get_rpc_reply(conn);
+		die_on_amqp_error(reply, "Opening channel");
+	}
+	if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
+		amqp_destroy_connection(conn);
+		close(sockfd);
+		return ERROR;
+	}
 
 	props._flags = AMQP_BASIC_CONTENT_TYPE_FLAG | AMQP_BASIC_DELIVERY_MODE_FLAG;
 
@@ -51,10 +115,185 @@ int MQ_Init()
 	props.delivery_mode = 2; /*persistent delivery mode*/
 	/*MQ INIT END*/
 
+	mq_connected = 1;
+	return SUCCESS;
+}
+
+/* Close the connection, politely when it is still usable */
+static void mq_disconnect(int usable)
+{
+	if (!mq_connected)
+		return;
+	if (usable) {
+		amqp_channel_close(conn, 1, AMQP_REPLY_SUCCESS);
+		amqp_connection_close(conn, AMQP_REPLY_SUCCESS);
+	}
+	amqp_destroy_connection(conn);
+	close(sockfd);
+	mq_connected = 0;
+}
+
+/* Wait for a number of seconds or until MQ_Shutdown, the lock is held */
+static void wait_seconds(int seconds)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += seconds;
+	while (!publisher.stopping)
+	{
+		if (pthread_cond_timedwait(&publisher.cond, &publisher.lock,
+				&deadline) == ETIMEDOUT)
+			break;
+	}
+}
+
+/* Remove the message at a position of the queue, the lock is held */
+static void remove_message(int position)
+{
+	int i;
+
+	for (i = position; i < publisher.count - 1; i++)
+	{
+		publisher.queue[(publisher.head + i) % MQ_QUEUE_SIZE] =
+			publisher.queue[(publisher.head + i + 1) % MQ_QUEUE_SIZE];
+	}
+	publisher.count--;
+}
+
+/* Publish the queued messages in batches until MQ_Shutdown, connecting and
+ * reconnecting with a growing delay while the broker is unreachable */
+static void *mq_sender_main(void *arg)
+{
+	MQ_MESSAGE batch[MQ_BATCH_SIZE];
+	int batch_size = 0;
+	int next = 0;
+	int first;
+	int backoff = MQ_RECONNECT_MIN_SECONDS;
+	int connections = 0;
+	int reconnected;
+	time_t stop_deadline = 0;
+	int i;
+
+	(void)arg;
+
+	pthread_mutex_lock(&publisher.lock);
+	for (;;)
+	{
+		/* Take the next batch, keeping an unsent one */
+		if (next == batch_size)
+		{
+			while (publisher.count == 0 && !publisher.stopping)
+				pthread_cond_wait(&publisher.cond, &publisher.lock);
+			if (publisher.count == 0)
+				break;
+			batch_size = (publisher.count < MQ_BATCH_SIZE)
+					? publisher.count : MQ_BATCH_SIZE;
+			for (i = 0; i < batch_size; i++)
+			{
+				batch[i] = publisher.queue[publisher.head];
+				publisher.head = (publisher.head + 1) % MQ_QUEUE_SIZE;
+			}
+			publisher.count -= batch_size;
+			next = 0;
+		}
+		if (publisher.stopping && stop_deadline == 0)
+			stop_deadline = time(NULL) + MQ_SHUTDOWN_SECONDS;
+		if (stop_deadline != 0 && time(NULL) >= stop_deadline)
+			break;
+		pthread_mutex_unlock(&publisher.lock);
+
+		/* The reconnection is counted once the lock is taken again */
+		reconnected = 0;
+		if (!mq_connected && mq_connect() == SUCCESS)
+		{
+			reconnected = (connections++ > 0);
+			backoff = MQ_RECONNECT_MIN_SECONDS;
+		}
+
+		/* Publish outside the lock so the senders never wait on the broker */
+		first = next;
+		while (mq_connected && next < batch_size)
+		{
+			if (die_on_error(amqp_basic_publish(conn, 1,
+						amqp_cstring_bytes(mq_params.ExchangeName),
+						amqp_cstring_bytes(batch[next].routing_key), 0, 0,
+						&props, amqp_cstring_bytes(batch[next].body)),
+						"Publish") != SUCCESS)
+			{
+				mq_disconnect(0);
+				break;
+			}
+			next++;
+		}
+		if (mq_connected)
+			amqp_maybe_release_buffers(conn);
+
+		pthread_mutex_lock(&publisher.lock);
+		publisher.num_sent += next - first;
+		publisher.num_reconnects += reconnected;
+		if (!mq_connected)
+		{
+			if (publisher.stopping)
+				break;
+			wait_seconds(backoff);
+			backoff = (backoff * 2 < MQ_RECONNECT_MAX_SECONDS)
+					? backoff * 2 : MQ_RECONNECT_MAX_SECONDS;
+		}
+	}
+
+	/* Whatever could not be sent before the deadline is lost */
+	publisher.num_dropped += publisher.count + batch_size - next;
+	publisher.count = 0;
+	pthread_mutex_unlock(&publisher.lock);
+
+	mq_disconnect(1);
+	return NULL;
+}
+
+int MQ_Init()
+{
+	int status;/* flag for  error !*/
+
+	if (mq_init_success)
+		return SUCCESS;
+
+	/* The connection is opened by the sender thread */
+	status = pthread_create(&publisher.thread, NULL, mq_sender_main, NULL);
+	if (status != 0) {
+		fprintf(stderr, "Starting the MQ sender thread failed\n");
+		mq_init_success = 0;/* MQ init is wrong! */
+		return ERROR;
+	}
+
+	/* the queued messages are flushed however the program ends */
+	if (!mq_exit_registered) {
+		atexit(MQ_Shutdown);
+		mq_exit_registered = 1;
+	}
+
 	mq_init_success = 1;/* flag for MQ init successful! */
 	return SUCCESS;
 }
 
+void MQ_Shutdown()
+{
+	if (!mq_init_success)
+		return;
+
+	/* Let the sender drain the queue before closing the connection */
+	pthread_mutex_lock(&publisher.lock);
+	publisher.stopping = 1;
+	pthread_cond_broadcast(&publisher.cond);
+	pthread_mutex_unlock(&publisher.lock);
+	pthread_join(publisher.thread, NULL);
+	mq_init_success = 0;
+
+	fprintf(stderr, "MQ messages: %lld sent, %lld coalesced, %lld dropped, "
+			"%lld reconnects\n", publisher.num_sent, publisher.num_coalesced,
+			publisher.num_dropped, publisher.num_reconnects);
+}
+
 int getmqmessage
 (
 	char *status, /* I:the status of the mq message */
@@ -64,37 +303,44 @@ int getmqmessage
 {
 	char TimeStamp[30];
 	time_t nowtime;
-	struct tm *timeinfo;
+	struct tm timeinfo;
 	time(&nowtime);
-	timeinfo = localtime(&nowtime);
-	strftime(TimeStamp, sizeof(TimeStamp), "%Y-%m-%d %H:%M:%S", timeinfo);
+	localtime_r(&nowtime, &timeinfo);
+	strftime(TimeStamp, sizeof(TimeStamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
 
-	memset(buffer, 0, sizeof(buffer));
-	strcpy(buffer, status);
-	strcat(buffer, "@");
-	strcat(buffer, TimeStamp);
-	strcat(buffer, "@");
-	strcat(buffer, message);
+	/* the buffer is NAME_MAX long, longer messages are truncated */
+	snprintf(buffer, NAME_MAX, "%s@%s@%s", status, TimeStamp, message);
 
 	return EXIT_SUCCESS;
 }
 
 int MQSend(int level, char *mqmessage)
+{
+	return MQSendOrder(mq_params.OrderId, level, mqmessage);
+}
+
+/* Queue a message for a given order, the order ID is the routing key. This
+ * never waits on the broker: progress messages may be coalesced or dropped
+ * when the queue fills up. */
+int MQSendOrder(const char *order_id, int level, char *mqmessage)
 {
 
 	char msg_level[NAME_MAX];
-	char buff[NAME_MAX];
-//	int status;
-	/**if it is the first time to send MQ message,connect;or send MQ message directly*/
+	MQ_MESSAGE *message;
+	int progress = 0;
+	int i;
+	/**messages sent before MQ_Init are ignored*/
 	if (get_mq_init_success())
 	{
 		switch (level) {
 		case 0:
 		case 1:
 			strcpy(msg_level, "Running");
+			progress = 1;
 			break;
 		case 2:
 			strcpy(msg_level, "Warning");
+			progress = 1;
 			break;
 		case 3:
 			strcpy(msg_level, "Error");
@@ -113,12 +359,53 @@ int MQSend(int level, char *mqmessage)
 			return ERROR;
 		}
 
-		getmqmessage(msg_level, mqmessage, buff);
-		die_on_error(
-				amqp_basic_publish(conn, 1,
-						amqp_cstring_bytes(mq_params.ExchangeName),
-						amqp_cstring_bytes(mq_params.OrderId), 0, 0, &props,
-						amqp_cstring_bytes(buff)), "Publish");
+		pthread_mutex_lock(&publisher.lock);
+		message = NULL;
+		if (progress && publisher.count >= MQ_COALESCE_THRESHOLD)
+		{
+			/* Replace the newest waiting progress message of the order */
+			for (i = publisher.count - 1; i >= 0 && message == NULL; i--)
+			{
+				MQ_MESSAGE *queued = &publisher.queue[(publisher.head + i)
+						% MQ_QUEUE_SIZE];
+				if (queued->progress
+						&& strcmp(queued->routing_key, order_id) == 0)
+					message = queued;
+			}
+			if (message != NULL)
+				publisher.num_coalesced++;
+		}
+		if (message == NULL && publisher.count == MQ_QUEUE_SIZE)
+		{
+			/* Status messages displace the oldest progress message */
+			for (i = 0; i < publisher.count && !progress; i++)
+			{
+				if (publisher.queue[(publisher.head + i)
+						% MQ_QUEUE_SIZE].progress)
+				{
+					remove_message(i);
+					break;
+				}
+			}
+			publisher.num_dropped++;
+			if (publisher.count == MQ_QUEUE_SIZE)
+			{
+				pthread_mutex_unlock(&publisher.lock);
+				return SUCCESS;
+			}
+		}
+		if (message == NULL)
+		{
+			message = &publisher.queue[(publisher.head + publisher.count)
+					% MQ_QUEUE_SIZE];
+			publisher.count++;
+		}
+		snprintf(message->routing_key, sizeof(message->routing_key), "%s",
+				order_id);
+		getmqmessage(msg_level, mqmessage, message->body);
+		message->progress = progress;
+		pthread_cond_signal(&publisher.cond);
+		pthread_mutex_unlock(&publisher.lock);
 	}
 	return SUCCESS;
 }
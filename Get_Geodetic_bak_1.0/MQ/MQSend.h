@@ -9,6 +9,20 @@
 #define MQSEND_H_
 
 #include <limits.h>         /* MQ parameters in ODL file */
+
+/* messages waiting to be published, progress messages are coalesced past
+   the threshold and dropped when the queue is full */
+#define MQ_QUEUE_SIZE 256
+#define MQ_COALESCE_THRESHOLD (MQ_QUEUE_SIZE * 3 / 4)
+/* messages published per wake-up of the sender thread */
+#define MQ_BATCH_SIZE 32
+/* delay between the connection attempts, doubled after each failure */
+#define MQ_RECONNECT_MIN_SECONDS 1
+#define MQ_RECONNECT_MAX_SECONDS 32
+/* socket timeout of the broker connection */
+#define MQ_SOCKET_TIMEOUT_SECONDS 10
+/* time given to the sender to drain the queue at shutdown */
+#define MQ_SHUTDOWN_SECONDS 5
 /* Modified by XQian 2012.11.27 for MQ parameters to read */
 /* MQ parameters in ODL file */
 typedef struct MQparameters
@@ -27,6 +41,8 @@ MQ_PARAMS mq_params;          /* Modified by XQian 2012.11.27 for MQ parameters
 
 int MQ_Init();
 
+void MQ_Shutdown();
+
 int get_mq_init_success();
 
 int getmqmessage
@@ -38,4 +54,6 @@ int getmqmessage
 
 int MQSend(int level, char *mqmessage);
 
+int MQSendOrder(const char *order_id, int level, char *mqmessage);
+
 #endif /* MQCONPARAM_H_ */
@@ -0,0 +1,477 @@
+/*
+ * geolocation_benchmark.c
+ *
+ *  Microbenchmark of the routines of the geolocation of a frame, run over a
+ *  model built from a CPF and a synthetic ephemeris.
+ *
+ *  Usage: geolocation_benchmark <cpf_file> [calls_per_thread] [threads...]
+ *
+ *  For every routine and thread count, each thread makes the given number
+ *  of calls over a fixed set of points spread over the ephemeris span. The
+ *  cost per call is the wall time times the thread count over the calls,
+ *  so it stays flat while the routine scales.
+ *
+ *  Built with "make benchmarks" in Debug/, against the same objects and
+ *  libraries as Get_Geodetic.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ias_logging.h"
+#include "ias_satellite_attributes.h"
+#include "ias_cpf.h"
+#include "ias_geo.h"
+#include "ias_los_model.h"
+#include "ias_threadsync.h"
+#include "mwd_scene.h"
+#include "update_longitude_latitude.h"
+#include "synthetic_ephemeris.h"
+
+#define BENCHMARK_START_TIME 446904000.0	//2014-03-01, J2000 seconds
+#define BENCHMARK_SPAN 300.0				//seconds of frames
+#define BENCHMARK_NUM_POINTS 4096			//distinct inputs of the calls
+#define BENCHMARK_DEFAULT_CALLS 200000		//calls per thread
+#define BENCHMARK_MAX_THREADS 64
+
+
+/* Inputs of the routines, each stage computed from the previous one */
+typedef struct benchmark_inputs
+{
+	const IAS_LOS_MODEL *model;
+	const IAS_SENSOR_BAND_MODEL *band;
+	long long image_time[BENCHMARK_NUM_POINTS];	//ms since 1970
+	double eph_time[BENCHMARK_NUM_POINTS];		//seconds from the epoch
+	double sample[BENCHMARK_NUM_POINTS];		//detector of the SCA
+	IAS_VECTOR satpos[BENCHMARK_NUM_POINTS];
+	IAS_VECTOR satvel[BENCHMARK_NUM_POINTS];
+	IAS_VECTOR new_los[BENCHMARK_NUM_POINTS];	//ECEF LOS
+	IAS_VECTOR vel_aberr_los[BENCHMARK_NUM_POINTS];
+	IAS_VECTOR target_vec[BENCHMARK_NUM_POINTS];
+}BENCHMARK_INPUTS;
+
+/* runs calls of a routine, returns the number of points done */
+typedef long long (*BENCHMARK_FUNC)(const BENCHMARK_INPUTS *inputs,
+		long long calls, double *checksum);
+
+typedef struct benchmark_case
+{
+	const char *name;
+	BENCHMARK_FUNC func;
+}BENCHMARK_CASE;
+
+typedef struct benchmark_thread
+{
+	pthread_t thread;
+	pthread_barrier_t *barrier;
+	const BENCHMARK_INPUTS *inputs;
+	BENCHMARK_FUNC func;
+	long long calls;
+	long long points;
+	double checksum;
+	struct timespec start;
+	struct timespec end;
+}BENCHMARK_THREAD;
+
+
+static long long bench_find_los_vector(const BENCHMARK_INPUTS *inputs,
+		long long calls, double *checksum)
+{
+	IAS_VECTOR los;
+	long long i;
+
+	for(i = 0; i < calls; i++)
+	{
+		ias_sensor_find_los_vector(FRAME_LOCATION_SCA_INDEX,
+				inputs->sample[i % BENCHMARK_NUM_POINTS],IAS_NOMINAL_DETECTOR,
+				inputs->band,&los);
+		*checksum += los.x;
+	}
+	return calls;
+}
+
+static long long bench_position_and_velocity(const BENCHMARK_INPUTS *inputs,
+		long long calls, double *checksum)
+{
+	IAS_VECTOR satpos;
+	IAS_VECTOR satvel;
+	long long i;
+
+	for(i = 0; i < calls; i++)
+	{
+		ias_sc_model_get_position_and_velocity_at_time(
+				&inputs->model->spacecraft.ephemeris,IAS_EARTH,
+				inputs->eph_time[i % BENCHMARK_NUM_POINTS],&satpos,&satvel);
+		*checksum += satpos.x;
+	}
+	return calls;
+}
+
+static long long bench_velocity_aberration(const BENCHMARK_INPUTS *inputs,
+		long long calls, double *checksum)
+{
+	IAS_VECTOR vel_aberr_los;
+	long long i;
+	int k;
+
+	for(i = 0; i < calls; i++)
+	{
+		k = i % BENCHMARK_NUM_POINTS;
+		ias_geo_correct_for_velocity_aberration(&inputs->satpos[k],
+				&inputs->satvel[k],IAS_EARTH,&inputs->model->earth,
+				&inputs->new_los[k],&vel_aberr_los);
+		*checksum += vel_aberr_los.x;
+	}
+	return calls;
+}
+
+static long long bench_find_target_position(const BENCHMARK_INPUTS *inputs,
+		long long calls, double *checksum)
+{
+	IAS_VECTOR target_vec;
+	double latc;
+	double longitude;
+	double radius;
+	long long i;
+	int k;
+
+	for(i = 0; i < calls; i++)
+	{
+		k = i % BENCHMARK_NUM_POINTS;
+		ias_geo_find_target_position(&inputs->satpos[k],
+				&inputs->vel_aberr_los[k],&inputs->model->earth,0.0,
+				&target_vec,&latc,&longitude,&radius);
+		*checksum += latc;
+	}
+	return calls;
+}
+
+static long long bench_light_travel_time(const BENCHMARK_INPUTS *inputs,
+		long long calls, double *checksum)
+{
+	IAS_VECTOR ltarvec;
+	double latc;
+	double longitude;
+	double radius;
+	long long i;
+	int k;
+
+	for(i = 0; i < calls; i++)
+	{
+		k = i % BENCHMARK_NUM_POINTS;
+		ias_geo_correct_for_light_travel_time(&inputs->satpos[k],
+				&inputs->model->earth,&inputs->target_vec[k],&ltarvec,&latc,
+				&longitude,&radius);
+		*checksum += latc;
+	}
+	return calls;
+}
+
+static long long bench_line_samp_to_geodetic(const BENCHMARK_INPUTS *inputs,
+		long long calls, double *checksum)
+{
+	double latitude;
+	double longitude;
+	long long i;
+	int k;
+
+	for(i = 0; i < calls; i++)
+	{
+		k = i % BENCHMARK_NUM_POINTS;
+		ias_los_model_input_line_samp_to_geodetic(inputs->image_time[k],
+				inputs->sample[k],FRAME_LOCATION_BAND_INDEX,
+				FRAME_LOCATION_SCA_INDEX,0.0,inputs->model,
+				IAS_NOMINAL_DETECTOR,NULL,&latitude,&longitude);
+		*checksum += latitude;
+	}
+	return calls;
+}
+
+static long long bench_line_samp_to_geodetic_batch(
+		const BENCHMARK_INPUTS *inputs, long long calls, double *checksum)
+{
+	double latitude[IAS_LOS_MODEL_BATCH_SIZE];
+	double longitude[IAS_LOS_MODEL_BATCH_SIZE];
+	long long done;
+	int start;
+	int count;
+
+	/* The batches walk the points in order, a frame range at a time */
+	for(done = 0; done < calls; done += count)
+	{
+		start = done % BENCHMARK_NUM_POINTS;
+		count = IAS_LOS_MODEL_BATCH_SIZE;
+		if(count > BENCHMARK_NUM_POINTS - start)
+			count = BENCHMARK_NUM_POINTS - start;
+		if(count > calls - done)
+			count = calls - done;
+		ias_los_model_input_line_samp_to_geodetic_batch(count,
+				&inputs->image_time[start],&inputs->sample[start],NULL,NULL,
+				0.0,FRAME_LOCATION_BAND_INDEX,FRAME_LOCATION_SCA_INDEX,0.0,
+				inputs->model,IAS_NOMINAL_DETECTOR,latitude,longitude,NULL);
+		*checksum += latitude[0];
+	}
+	return calls;
+}
+
+static const BENCHMARK_CASE benchmark_cases[] =
+{
+	{"ias_sensor_find_los_vector", bench_find_los_vector},
+	{"ias_sc_model_get_position_and_velocity", bench_position_and_velocity},
+	{"ias_geo_correct_for_velocity_aberration", bench_velocity_aberration},
+	{"ias_geo_find_target_position", bench_find_target_position},
+	{"ias_geo_correct_for_light_travel_time", bench_light_travel_time},
+	{"ias_los_model_input_line_samp_to_geodetic",
+			bench_line_samp_to_geodetic},
+	{"ias_los_model_input_..._batch", bench_line_samp_to_geodetic_batch},
+};
+
+
+/* *********************************************************************************
+ * NAME:			prepare_inputs
+ *
+ * PURPOSE:	spread the points over the ephemeris span and the detectors of
+ * 			the SCA, and compute the intermediate vectors of each point the
+ * 			way the full routine does, so every routine is timed on the
+ * 			values it sees in the pipeline
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+static int prepare_inputs(const IAS_LOS_MODEL *model, BENCHMARK_INPUTS *inputs)
+{
+	const IAS_SC_TIME_BASE *time_base = &model->spacecraft.ephemeris.time_base;
+	const IAS_SENSOR_BAND_MODEL *band =
+			&model->sensor.bands[FRAME_LOCATION_BAND_INDEX];
+	int detectors = band->scas[FRAME_LOCATION_SCA_INDEX].detectors;
+	IAS_VECTOR sensor_los;
+	IAS_VECTOR pert_los;
+	double orb2ecf[3][3];
+	double attpert[3][3];
+	double latc;
+	double longitude;
+	double radius;
+	int k;
+
+	inputs->model = model;
+	inputs->band = band;
+	for(k = 0; k < BENCHMARK_NUM_POINTS; k++)
+	{
+		inputs->image_time[k] = time_base->epoch_ms
+				+ (long long)(BENCHMARK_SPAN * 1000.0 * k / BENCHMARK_NUM_POINTS);
+		inputs->eph_time[k] = ias_sc_model_get_time_from_epoch(time_base,
+				inputs->image_time[k]);
+		inputs->sample[k] = (k * 7) % detectors;
+
+		if(ias_sensor_find_los_vector(FRAME_LOCATION_SCA_INDEX,
+				inputs->sample[k],IAS_NOMINAL_DETECTOR,band,&sensor_los)
+				!= SUCCESS)
+		{
+			IAS_LOG_ERROR("Finding the LOS vector of point %d",k);
+			return ERROR;
+		}
+		ias_sc_model_get_position_and_velocity_at_time(
+				&model->spacecraft.ephemeris,IAS_EARTH,inputs->eph_time[k],
+				&inputs->satpos[k],&inputs->satvel[k]);
+		if(ias_geo_convert_sensor_los_to_spacecraft(band->sensor->sensor2acs,
+				IAS_EARTH,&inputs->satpos[k],&inputs->satvel[k],&sensor_los,
+				0.0,0.0,0.0,orb2ecf,attpert,&pert_los,&inputs->new_los[k])
+				!= SUCCESS
+			|| ias_geo_correct_for_velocity_aberration(&inputs->satpos[k],
+				&inputs->satvel[k],IAS_EARTH,&model->earth,
+				&inputs->new_los[k],&inputs->vel_aberr_los[k]) != SUCCESS
+			|| ias_geo_find_target_position(&inputs->satpos[k],
+				&inputs->vel_aberr_los[k],&model->earth,0.0,
+				&inputs->target_vec[k],&latc,&longitude,&radius) != SUCCESS)
+		{
+			IAS_LOG_ERROR("Locating point %d of the benchmark",k);
+			return ERROR;
+		}
+	}
+
+	return SUCCESS;
+}
+
+
+static void *benchmark_thread_main(void *arg)
+{
+	BENCHMARK_THREAD *thread = arg;
+
+	pthread_barrier_wait(thread->barrier);
+	clock_gettime(CLOCK_MONOTONIC,&thread->start);
+	thread->points = thread->func(thread->inputs,thread->calls,
+			&thread->checksum);
+	clock_gettime(CLOCK_MONOTONIC,&thread->end);
+
+	return NULL;
+}
+
+static double seconds_between(const struct timespec *start,
+		const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/* *********************************************************************************
+ * NAME:			run_case
+ *
+ * PURPOSE:	time a routine on a number of threads started together. The
+ * 			wall time runs from the first start to the last end.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+static int run_case(const BENCHMARK_CASE *benchmark_case,
+		const BENCHMARK_INPUTS *inputs, int num_threads, long long calls)
+{
+	BENCHMARK_THREAD threads[BENCHMARK_MAX_THREADS];
+	pthread_barrier_t barrier;
+	struct timespec first_start;
+	struct timespec last_end;
+	long long points = 0;
+	double checksum = 0.0;
+	double wall;
+	int i;
+
+	memset(threads,0,sizeof(threads));
+	pthread_barrier_init(&barrier,NULL,num_threads);
+	for(i = 0; i < num_threads; i++)
+	{
+		threads[i].barrier = &barrier;
+		threads[i].inputs = inputs;
+		threads[i].func = benchmark_case->func;
+		threads[i].calls = calls;
+		if(pthread_create(&threads[i].thread,NULL,benchmark_thread_main,
+				&threads[i]) != 0)
+		{
+			IAS_LOG_ERROR("Starting benchmark thread %d",i);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for(i = 0; i < num_threads; i++)
+	{
+		pthread_join(threads[i].thread,NULL);
+		if(i == 0 || seconds_between(&threads[i].start,&first_start) > 0)
+			first_start = threads[i].start;
+		if(i == 0 || seconds_between(&last_end,&threads[i].end) > 0)
+			last_end = threads[i].end;
+		points += threads[i].points;
+		checksum += threads[i].checksum;
+	}
+	pthread_barrier_destroy(&barrier);
+
+	wall = seconds_between(&first_start,&last_end);
+	printf("%-42s %7d %12.1f %14.0f   (%g)\n",benchmark_case->name,num_threads,
+			wall * num_threads / points * 1e9,points / wall,checksum);
+	fflush(stdout);
+
+	return SUCCESS;
+}
+
+
+int main(int argc, char **argv)
+{
+	int thread_counts[BENCHMARK_MAX_THREADS];
+	int num_thread_counts = 0;
+	long long calls = BENCHMARK_DEFAULT_CALLS;
+	IAS_L0R_EPHEMERIS *l0r_ephemeris;
+	long long num_frame_of_ephemeris;
+	MWD_SCENE_MODEL *scene_model;
+	BENCHMARK_INPUTS *inputs;
+	IAS_CPF *cpf;
+	int num_processors;
+	int i;
+	int j;
+
+	if(argc < 2)
+	{
+		fprintf(stderr,"Usage: %s <cpf_file> [calls_per_thread] "
+				"[threads...]\n",argv[0]);
+		return EXIT_FAILURE;
+	}
+	if(argc > 2)
+		calls = atoll(argv[2]);
+	for(i = 3; i < argc && num_thread_counts < BENCHMARK_MAX_THREADS; i++)
+	{
+		thread_counts[num_thread_counts] = atoi(argv[i]);
+		if(thread_counts[num_thread_counts] < 1
+				|| thread_counts[num_thread_counts] > BENCHMARK_MAX_THREADS)
+		{
+			fprintf(stderr,"Thread counts go from 1 to %d\n",
+					BENCHMARK_MAX_THREADS);
+			return EXIT_FAILURE;
+		}
+		num_thread_counts++;
+	}
+	if(num_thread_counts == 0)
+	{
+		/* Powers of two up to the number of processors */
+		num_processors = IAS_THREAD_GET_NUM_PROCESSORS();
+		for(i = 1; i <= num_processors && i <= BENCHMARK_MAX_THREADS; i *= 2)
+			thread_counts[num_thread_counts++] = i;
+		if(thread_counts[num_thread_counts - 1] < num_processors
+				&& num_processors <= BENCHMARK_MAX_THREADS)
+			thread_counts[num_thread_counts++] = num_processors;
+	}
+	if(calls < 1)
+	{
+		fprintf(stderr,"The number of calls must be positive\n");
+		return EXIT_FAILURE;
+	}
+
+	/* The model of a scene over the synthetic orbit */
+	if(ias_sat_attr_initialize(IAS_L8) != SUCCESS)
+	{
+		IAS_LOG_ERROR("Initializing IAS Satellite Attributes Library");
+		return EXIT_FAILURE;
+	}
+	cpf = ias_cpf_read(argv[1]);
+	if(cpf == NULL)
+	{
+		IAS_LOG_ERROR("Reading the CPF %s",argv[1]);
+		return EXIT_FAILURE;
+	}
+	if(synthetic_ephemeris_create(BENCHMARK_START_TIME,BENCHMARK_SPAN,
+			&l0r_ephemeris,&num_frame_of_ephemeris) != SUCCESS)
+	{
+		ias_cpf_free(cpf);
+		return EXIT_FAILURE;
+	}
+	scene_model = create_scene_model_from_ephemeris(l0r_ephemeris,
+			num_frame_of_ephemeris,cpf);
+	free(l0r_ephemeris);
+	ias_cpf_free(cpf);
+	if(scene_model == NULL)
+	{
+		IAS_LOG_ERROR("Building the benchmark model");
+		return EXIT_FAILURE;
+	}
+
+	inputs = malloc(sizeof(*inputs));
+	if(inputs == NULL || prepare_inputs(scene_model->model,inputs) != SUCCESS)
+	{
+		free(inputs);
+		free_scene_model(scene_model);
+		return EXIT_FAILURE;
+	}
+
+	printf("%-42s %7s %12s %14s\n","routine","threads","ns/call",
+			"points/sec");
+	for(i = 0; i < (int)(sizeof(benchmark_cases) / sizeof(benchmark_cases[0]));
+			i++)
+	{
+		/* Warm up the caches and the lazily built tables */
+		double checksum = 0.0;
+		benchmark_cases[i].func(inputs,BENCHMARK_NUM_POINTS,&checksum);
+
+		for(j = 0; j < num_thread_counts; j++)
+			run_case(&benchmark_cases[i],inputs,thread_counts[j],calls);
+	}
+
+	free(inputs);
+	free_scene_model(scene_model);
+	return EXIT_SUCCESS;
+}
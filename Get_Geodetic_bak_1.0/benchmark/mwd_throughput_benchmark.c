@@ -0,0 +1,296 @@
+/*
+ * mwd_throughput_benchmark.c
+ *
+ *  End to end benchmark of the update of a mwdImage: a synthetic mwdImage
+ *  and a matching ephemeris file are written to a work directory, then the
+ *  scene is built and updated like main() does, for each thread count.
+ *
+ *  Usage: mwd_throughput_benchmark <cpf_file> <work_directory> [size_mb]
+ *             [threads...]
+ *
+ *  The mwdImage is written again before each run, so every run starts from
+ *  unlocated frames and reads and writes the whole file, and the located
+ *  frames are checked after each run. The file was just written, so the
+ *  runs measure the pipeline with a warm page cache unless the cache is
+ *  dropped between them. The stage metrics of each run are written to
+ *  metrics_<threads>.json in the work directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ias_logging.h"
+#include "ias_satellite_attributes.h"
+#include "ias_cpf.h"
+#include "ias_threadsync.h"
+#include "read_write_mwdImage.h"
+#include "mwdImage_frame_index.h"
+#include "mwd_scene.h"
+#include "synthetic_ephemeris.h"
+#include "synthetic_mwd.h"
+
+#define BENCHMARK_START_TIME 446904000.0	//2014-03-01, J2000 seconds
+#define BENCHMARK_SPAN 600.0				//seconds the frames span
+#define BENCHMARK_DEFAULT_SIZE_MB 4096		//size of the mwdImage
+#define BENCHMARK_MAX_THREAD_COUNTS 32
+#define BENCHMARK_NUM_CHECKS 1024			//OLI frames checked after a run
+#define BENCHMARK_MWD_FILENAME "synthetic.mwd"
+#define BENCHMARK_EPHEMERIS_FILENAME "synthetic_ephemeris.dat"
+
+
+static double now_seconds()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+/* *********************************************************************************
+ * NAME:			write_ephemeris
+ *
+ * PURPOSE:	write the synthetic ephemeris of the benchmark. It covers the span
+ * 			of the frames with a margin.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+static int write_ephemeris(const PARAMETERS *param)
+{
+	IAS_L0R_EPHEMERIS *l0r_ephemeris;
+	long long num_frame_of_ephemeris;
+	int status;
+
+	if(synthetic_ephemeris_create(BENCHMARK_START_TIME,BENCHMARK_SPAN,
+			&l0r_ephemeris,&num_frame_of_ephemeris) != SUCCESS)
+		return ERROR;
+	status = synthetic_ephemeris_write(param->ephemeris_filename,l0r_ephemeris,
+			num_frame_of_ephemeris);
+	free(l0r_ephemeris);
+	return status;
+}
+
+
+/* *********************************************************************************
+ * NAME:			count_located_frames
+ *
+ * PURPOSE:	check evenly spaced OLI frames of the updated mwdImage for a
+ * 			latitude and longitude written by the pipeline
+ *
+ * RETURN: number of checked frames located, -1 on error
+ * *********************************************************************************/
+static long long count_located_frames(const char *filename,
+		long long *num_checked)
+{
+	MWD_FRAME_INDEX frame_index;
+	const MWD_FRAME_INDEX_ENTRY *entry;
+	char header[FRAME_HEADER_SIZE];
+	struct stat file_stat;
+	double longitude;
+	double latitude;
+	long long num_located = 0;
+	long long step;
+	long long i;
+	int fd;
+
+	*num_checked = 0;
+	fd = open(filename,O_RDONLY);
+	if(fd < 0 || fstat(fd,&file_stat) != 0
+			|| build_frame_index(fd,file_stat.st_size,&frame_index) != SUCCESS)
+	{
+		IAS_LOG_ERROR("failed to index the updated mwdImage %s!\n",filename);
+		if(fd >= 0)
+			close(fd);
+		return -1;
+	}
+
+	step = frame_index.num_entries / BENCHMARK_NUM_CHECKS;
+	if(step < 1)
+		step = 1;
+	for(i = 0; i < frame_index.num_entries; i += step)
+	{
+		entry = &frame_index.entries[i];
+		if(entry->mode[0] != 'O'
+				|| pread(fd,header,sizeof(header),entry->offset)
+					!= sizeof(header))
+			continue;
+
+		memcpy(&longitude,header+FRAME_LONGITUDE_OFFSET,sizeof(double));
+		memcpy(&latitude,header+FRAME_LATITUDE_OFFSET,sizeof(double));
+		(*num_checked)++;
+		if(longitude != 0.0 || latitude != 0.0)
+			num_located++;
+	}
+
+	free_frame_index(&frame_index);
+	close(fd);
+	return num_located;
+}
+
+
+int main(int argc, char **argv)
+{
+	int thread_counts[BENCHMARK_MAX_THREAD_COUNTS];
+	int num_thread_counts = 0;
+	long long size_mb = BENCHMARK_DEFAULT_SIZE_MB;
+	SYNTHETIC_MWD_INFO info;
+	PARAMETERS parameters;
+	MWD_SCENE_MODEL *scene_model;
+	IAS_CPF *cpf;
+	long long num_located;
+	long long num_checked;
+	double start;
+	double write_seconds;
+	double model_seconds;
+	double update_seconds;
+	int num_processors;
+	int status = SUCCESS;
+	int i;
+
+	if(argc < 3)
+	{
+		fprintf(stderr,"Usage: %s <cpf_file> <work_directory> [size_mb] "
+				"[threads...]\n",argv[0]);
+		return EXIT_FAILURE;
+	}
+	if(argc > 3)
+		size_mb = atoll(argv[3]);
+	for(i = 4; i < argc && num_thread_counts < BENCHMARK_MAX_THREAD_COUNTS; i++)
+	{
+		thread_counts[num_thread_counts] = atoi(argv[i]);
+		if(thread_counts[num_thread_counts] < 1)
+		{
+			fprintf(stderr,"The thread counts must be positive\n");
+			return EXIT_FAILURE;
+		}
+		num_thread_counts++;
+	}
+	if(num_thread_counts == 0)
+	{
+		/* Powers of two up to the number of processors */
+		num_processors = IAS_THREAD_GET_NUM_PROCESSORS();
+		for(i = 1; i <= num_processors
+				&& num_thread_counts < BENCHMARK_MAX_THREAD_COUNTS; i *= 2)
+			thread_counts[num_thread_counts++] = i;
+		if(thread_counts[num_thread_counts - 1] < num_processors
+				&& num_thread_counts < BENCHMARK_MAX_THREAD_COUNTS)
+			thread_counts[num_thread_counts++] = num_processors;
+	}
+	if(size_mb < 1)
+	{
+		fprintf(stderr,"The size of the mwdImage must be positive\n");
+		return EXIT_FAILURE;
+	}
+
+	memset(&parameters,0,sizeof(parameters));
+	if(snprintf(parameters.mwdImage_filename,
+				sizeof(parameters.mwdImage_filename),"%s/%s",argv[2],
+				BENCHMARK_MWD_FILENAME)
+			>= (int)sizeof(parameters.mwdImage_filename)
+		|| snprintf(parameters.ephemeris_filename,
+				sizeof(parameters.ephemeris_filename),"%s/%s",argv[2],
+				BENCHMARK_EPHEMERIS_FILENAME)
+			>= (int)sizeof(parameters.ephemeris_filename))
+	{
+		fprintf(stderr,"The work directory name is too long\n");
+		return EXIT_FAILURE;
+	}
+	parameters.satellite_id = IAS_L8;
+
+	if(ias_sat_attr_initialize(parameters.satellite_id) != SUCCESS)
+	{
+		IAS_LOG_ERROR("Initializing IAS Satellite Attributes Library");
+		return EXIT_FAILURE;
+	}
+	cpf = ias_cpf_read(argv[1]);
+	if(cpf == NULL)
+	{
+		IAS_LOG_ERROR("Reading the CPF %s",argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	if(write_ephemeris(&parameters) != SUCCESS)
+	{
+		ias_cpf_free(cpf);
+		unlink(parameters.ephemeris_filename);
+		return EXIT_FAILURE;
+	}
+
+	for(i = 0; i < num_thread_counts && status == SUCCESS; i++)
+	{
+		/* Start every run from unlocated frames, so the check after the run
+		   only sees what this run wrote */
+		start = now_seconds();
+		if(synthetic_mwd_write(parameters.mwdImage_filename,
+				size_mb * 1024 * 1024,BENCHMARK_START_TIME,BENCHMARK_SPAN,
+				&info) != SUCCESS)
+		{
+			status = ERROR;
+			break;
+		}
+		write_seconds = now_seconds() - start;
+		if(i == 0)
+		{
+			printf("Wrote %lld frames (%lld OLI, %lld TIRS, %lld PAN), %.2f GB "
+					"in %.1f s\n",info.num_frames,info.num_oli_frames,
+					info.num_tirs_frames,info.num_pan_frames,
+					info.file_size / 1e9,write_seconds);
+			printf("%7s %10s %10s %8s %12s %14s\n","threads","model s",
+					"update s","GB/s","frames/s","OLI frames/s");
+		}
+
+		parameters.num_threads = thread_counts[i];
+		snprintf(parameters.metrics_filename,
+				sizeof(parameters.metrics_filename),"%s/metrics_%d.json",
+				argv[2],thread_counts[i]);
+
+		/* The model is built from the ephemeris file like main() does */
+		start = now_seconds();
+		scene_model = create_scene_model(&parameters,cpf);
+		model_seconds = now_seconds() - start;
+		if(scene_model == NULL)
+		{
+			IAS_LOG_ERROR("Building the scene model");
+			status = ERROR;
+			break;
+		}
+
+		start = now_seconds();
+		status = update_mwdImage_scene(&parameters,scene_model,"");
+		update_seconds = now_seconds() - start;
+		free_scene_model(scene_model);
+		if(status != SUCCESS)
+		{
+			IAS_LOG_ERROR("Updating the mwdImage with %d threads",
+					thread_counts[i]);
+			break;
+		}
+
+		num_located = count_located_frames(parameters.mwdImage_filename,
+				&num_checked);
+		if(num_located < 0 || num_checked == 0 || num_located < num_checked)
+		{
+			IAS_LOG_ERROR("Only %lld of %lld checked OLI frames are located "
+					"with %d threads",num_located,num_checked,thread_counts[i]);
+			status = ERROR;
+			break;
+		}
+
+		printf("%7d %10.3f %10.3f %8.3f %12.0f %14.0f\n",thread_counts[i],
+				model_seconds,update_seconds,info.file_size / 1e9
+				/ update_seconds,info.num_frames / update_seconds,
+				info.num_oli_frames / update_seconds);
+		fflush(stdout);
+	}
+	ias_cpf_free(cpf);
+
+	if(status == SUCCESS)
+		printf("All %lld checked OLI frames are located in every run\n",
+				num_checked);
+
+	unlink(parameters.mwdImage_filename);
+	unlink(parameters.ephemeris_filename);
+	return (status == SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
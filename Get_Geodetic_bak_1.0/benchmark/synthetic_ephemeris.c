@@ -0,0 +1,173 @@
+/*
+ * synthetic_ephemeris.c
+ *
+ *  Ephemeris records of a circular orbit, in ECEF coordinates.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ias_const.h"
+#include "ias_logging.h"
+#include "read_ephemeris_data.h"
+#include "synthetic_ephemeris.h"
+
+#define EARTH_GM 3.986004418e14				//m^3/s^2
+#define EARTH_ROTATION_RATE 7.2921158553e-5	//rad/s
+
+
+/* *********************************************************************************
+ * NAME:			synthetic_ephemeris_create
+ *
+ * PURPOSE:	compute the ephemeris of a circular orbit over the span of the
+ * 			frames plus a margin on each side. The orbit is propagated in an
+ * 			inertial frame and rotated with the Earth, so the records hold the
+ * 			ECEF position and velocity like the flight ephemeris.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int synthetic_ephemeris_create(double start_time, double duration,
+		IAS_L0R_EPHEMERIS **l0r_ephemeris, long long *num_frame_of_ephemeris)
+{
+	double mean_motion = sqrt(EARTH_GM / pow(SYNTHETIC_ORBIT_RADIUS,3));
+	double inclination = SYNTHETIC_ORBIT_INCLINATION * M_PI / 180.0;
+	double first_time = floor(start_time - SYNTHETIC_EPHEMERIS_MARGIN);
+	IAS_L0R_EPHEMERIS *records;
+	long long count;
+	long long i;
+
+	count = (long long)ceil((duration + 2 * SYNTHETIC_EPHEMERIS_MARGIN)
+			/ SYNTHETIC_EPHEMERIS_INTERVAL) + 1;
+	records = calloc(count,sizeof(*records));
+	if(records == NULL)
+	{
+		IAS_LOG_ERROR("failed to allocate the synthetic ephemeris!\n");
+		return ERROR;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		double seconds = first_time + i * SYNTHETIC_EPHEMERIS_INTERVAL;
+		double elapsed = seconds - first_time;
+		double u = mean_motion * elapsed;		//argument of latitude
+		double theta = EARTH_ROTATION_RATE * elapsed;	//Earth rotation
+		double speed = SYNTHETIC_ORBIT_RADIUS * mean_motion;
+		IAS_VECTOR inertial_pos;
+		IAS_VECTOR inertial_vel;
+		IAS_VECTOR *pos = &records[i].ecef_position_meters;
+		IAS_VECTOR *vel = &records[i].ecef_velocity_meters_per_sec;
+
+		inertial_pos.x = SYNTHETIC_ORBIT_RADIUS * cos(u);
+		inertial_pos.y = SYNTHETIC_ORBIT_RADIUS * sin(u) * cos(inclination);
+		inertial_pos.z = SYNTHETIC_ORBIT_RADIUS * sin(u) * sin(inclination);
+		inertial_vel.x = -speed * sin(u);
+		inertial_vel.y = speed * cos(u) * cos(inclination);
+		inertial_vel.z = speed * cos(u) * sin(inclination);
+
+		/* Rotate with the Earth, the ECEF velocity loses the rotation */
+		pos->x = cos(theta) * inertial_pos.x + sin(theta) * inertial_pos.y;
+		pos->y = -sin(theta) * inertial_pos.x + cos(theta) * inertial_pos.y;
+		pos->z = inertial_pos.z;
+		vel->x = cos(theta) * inertial_vel.x + sin(theta) * inertial_vel.y
+				+ EARTH_ROTATION_RATE * pos->y;
+		vel->y = -sin(theta) * inertial_vel.x + cos(theta) * inertial_vel.y
+				- EARTH_ROTATION_RATE * pos->x;
+		vel->z = inertial_vel.z;
+
+		records[i].l0r_time.days_from_J2000 =
+				(int)floor(seconds / IAS_SEC_PER_DAY);
+		records[i].l0r_time.seconds_of_day = seconds
+				- (double)records[i].l0r_time.days_from_J2000 * IAS_SEC_PER_DAY;
+		records[i].time_tag_sec_orig = seconds;
+		records[i].warning_flag = 0;
+	}
+
+	*l0r_ephemeris = records;
+	*num_frame_of_ephemeris = count;
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			synthetic_ephemeris_pack_record
+ *
+ * PURPOSE:	pack a record at the byte offsets of the ephemeris file, the
+ * 			reverse of the decoding of read_ephemeris_data.c
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void synthetic_ephemeris_pack_record(const IAS_L0R_EPHEMERIS *ephemeris,
+		char *record)
+{
+	memset(record,0,EPHEMERIS_RECORD_SIZE);
+	memcpy(record+EPHEMERIS_DAYS_OFFSET,
+			&ephemeris->l0r_time.days_from_J2000,
+			sizeof(ephemeris->l0r_time.days_from_J2000));
+	memcpy(record+EPHEMERIS_SECONDS_OFFSET,
+			&ephemeris->l0r_time.seconds_of_day,
+			sizeof(ephemeris->l0r_time.seconds_of_day));
+	memcpy(record+EPHEMERIS_TIME_TAG_OFFSET,&ephemeris->time_tag_sec_orig,
+			sizeof(ephemeris->time_tag_sec_orig));
+	memcpy(record+EPHEMERIS_POSITION_OFFSET,
+			&ephemeris->ecef_position_meters.x,sizeof(double));
+	memcpy(record+EPHEMERIS_POSITION_OFFSET+sizeof(double),
+			&ephemeris->ecef_position_meters.y,sizeof(double));
+	memcpy(record+EPHEMERIS_POSITION_OFFSET+2*sizeof(double),
+			&ephemeris->ecef_position_meters.z,sizeof(double));
+	memcpy(record+EPHEMERIS_VELOCITY_OFFSET,
+			&ephemeris->ecef_velocity_meters_per_sec.x,sizeof(double));
+	memcpy(record+EPHEMERIS_VELOCITY_OFFSET+sizeof(double),
+			&ephemeris->ecef_velocity_meters_per_sec.y,sizeof(double));
+	memcpy(record+EPHEMERIS_VELOCITY_OFFSET+2*sizeof(double),
+			&ephemeris->ecef_velocity_meters_per_sec.z,sizeof(double));
+	memcpy(record+EPHEMERIS_WARNING_FLAG_OFFSET,&ephemeris->warning_flag,
+			sizeof(ephemeris->warning_flag));
+}
+
+
+/* *********************************************************************************
+ * NAME:			synthetic_ephemeris_write
+ *
+ * PURPOSE:	write the records as an ephemeris file
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int synthetic_ephemeris_write(const char *filename,
+		const IAS_L0R_EPHEMERIS *l0r_ephemeris,
+		long long num_frame_of_ephemeris)
+{
+	char record[EPHEMERIS_RECORD_SIZE];
+	FILE *fp;
+	long long i;
+
+	fp = fopen(filename,"wb");
+	if(fp == NULL)
+	{
+		IAS_LOG_ERROR("failed to open the ephemeris file %s!\n",filename);
+		return ERROR;
+	}
+
+	for(i = 0; i < num_frame_of_ephemeris; i++)
+	{
+		synthetic_ephemeris_pack_record(&l0r_ephemeris[i],record);
+		if(fwrite(record,sizeof(record),1,fp) != 1)
+		{
+			IAS_LOG_ERROR("failed to write the ephemeris file %s!\n",
+					filename);
+			fclose(fp);
+			unlink(filename);
+			return ERROR;
+		}
+	}
+
+	if(fclose(fp) != 0)
+	{
+		IAS_LOG_ERROR("failed to close the ephemeris file %s!\n",filename);
+		unlink(filename);
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
@@ -0,0 +1,42 @@
+/*
+ * synthetic_ephemeris.h
+ *
+ *  Ephemeris of a circular sun-synchronous orbit at the Landsat 8 altitude,
+ *  for the benchmarks to build a model without flight data. The records can
+ *  also be written as an ephemeris file in the format of the flight one.
+ */
+
+#ifndef SYNTHETIC_EPHEMERIS_H_
+#define SYNTHETIC_EPHEMERIS_H_
+
+#include "ias_l0r.h"
+
+#define SYNTHETIC_ORBIT_RADIUS 7083137.0		//meters, 705 km altitude
+#define SYNTHETIC_ORBIT_INCLINATION 98.2		//degrees
+#define SYNTHETIC_EPHEMERIS_INTERVAL 1.0		//seconds between the records
+#define SYNTHETIC_EPHEMERIS_MARGIN 60.0			//seconds before and after
+												//the span of the frames
+
+
+int synthetic_ephemeris_create
+(
+	double start_time,					//I:start of the frames, J2000 seconds
+	double duration,					//I:seconds of frames
+	IAS_L0R_EPHEMERIS **l0r_ephemeris,	//O:records, freed by the caller
+	long long *num_frame_of_ephemeris	//O:number of records
+);
+
+void synthetic_ephemeris_pack_record
+(
+	const IAS_L0R_EPHEMERIS *ephemeris,	//I:record to pack
+	char *record						//O:EPHEMERIS_RECORD_SIZE bytes
+);
+
+int synthetic_ephemeris_write
+(
+	const char *filename,				//I:ephemeris file to create
+	const IAS_L0R_EPHEMERIS *l0r_ephemeris,	//I:records to write
+	long long num_frame_of_ephemeris	//I:number of records
+);
+
+#endif /* SYNTHETIC_EPHEMERIS_H_ */
@@ -0,0 +1,146 @@
+/*
+ * synthetic_mwd.c
+ *
+ *  Write synthetic mwdImage files.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ias_logging.h"
+#include "read_write_mwdImage.h"
+#include "synthetic_mwd.h"
+
+
+/* Mode field and length of a frame of the pattern */
+static int frame_of_pattern(long long frame_number, const char **mode)
+{
+	const char *pattern = SYNTHETIC_MWD_MODE_PATTERN;
+
+	switch(pattern[frame_number % (sizeof(SYNTHETIC_MWD_MODE_PATTERN) - 1)])
+	{
+	case 'T':
+		*mode = "TIRS";
+		return SYNTHETIC_MWD_TIRS_FRAME_LENGTH;
+	case 'P':
+		*mode = "PAN";
+		return SYNTHETIC_MWD_PAN_FRAME_LENGTH;
+	default:
+		*mode = "OLI";
+		return SYNTHETIC_MWD_OLI_FRAME_LENGTH;
+	}
+}
+
+
+/* *********************************************************************************
+ * NAME:			synthetic_mwd_write
+ *
+ * PURPOSE:	write frames following the mode pattern until the file reaches
+ * 			the target size. The frame times are spread evenly over the
+ * 			span, in ms since 1970 like the flight frames, and the lat/lon
+ * 			are left at zero for the pipeline to fill. The payload is a
+ * 			fixed byte pattern.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int synthetic_mwd_write(const char *filename, long long target_size,
+		double start_time, double duration, SYNTHETIC_MWD_INFO *info)
+{
+	char *buffer;
+	char *frame;
+	const char *mode;
+	long long buffer_used = 0;
+	long long start_ms;
+	long long num_frames;
+	long long file_size;
+	long long frame_time;
+	long long k;
+	unsigned short band = SYNTHETIC_MWD_BAND;
+	int frame_length;
+	int frame_number;
+	int i;
+	FILE *fp;
+
+	memset(info,0,sizeof(*info));
+
+	/* Count the frames first, their times depend on the number of frames */
+	for(num_frames = 0, file_size = 0; file_size < target_size; num_frames++)
+		file_size += frame_of_pattern(num_frames,&mode);
+	if(num_frames == 0)
+	{
+		IAS_LOG_ERROR("No frame to write in the mwdImage file!\n");
+		return ERROR;
+	}
+
+	buffer = malloc(SYNTHETIC_MWD_WRITE_BUFFER_SIZE);
+	if(buffer == NULL)
+	{
+		IAS_LOG_ERROR("failed to allocate the write buffer!\n");
+		return ERROR;
+	}
+	fp = fopen(filename,"wb");
+	if(fp == NULL)
+	{
+		IAS_LOG_ERROR("failed to open the mwdImage file %s!\n",filename);
+		free(buffer);
+		return ERROR;
+	}
+
+	start_ms = J2000_SUB_UTC_EPOCH + (long long)(start_time * 1000.0);
+	for(k = 0; k < num_frames; k++)
+	{
+		frame_length = frame_of_pattern(k,&mode);
+		if(buffer_used + frame_length > SYNTHETIC_MWD_WRITE_BUFFER_SIZE)
+		{
+			if(fwrite(buffer,buffer_used,1,fp) != 1)
+				break;
+			buffer_used = 0;
+		}
+
+		frame = buffer + buffer_used;
+		frame_time = start_ms + (long long)(duration * 1000.0 * k / num_frames);
+		frame_number = (int)k;
+
+		memset(frame,0,FRAME_HEADER_SIZE);
+		frame[0] = 'L';
+		frame[1] = '8';
+		memcpy(frame+2,&frame_number,sizeof(int));
+		memcpy(frame+FRAME_LENGTH_OFFSET,&frame_length,sizeof(int));
+		memcpy(frame+FRAME_TIME_OFFSET,&frame_time,sizeof(long long));
+		memcpy(frame+FRAME_TIME_OFFSET+sizeof(long long),&band,sizeof(band));
+		strncpy(frame+FRAME_MODE_OFFSET,mode,4);
+		for(i = FRAME_HEADER_SIZE; i < frame_length; i++)
+			frame[i] = (char)(i * 131);
+		buffer_used += frame_length;
+
+		if(mode[0] == 'O')
+			info->num_oli_frames++;
+		else if(mode[0] == 'T')
+			info->num_tirs_frames++;
+		else
+			info->num_pan_frames++;
+	}
+
+	if(k < num_frames || (buffer_used > 0
+			&& fwrite(buffer,buffer_used,1,fp) != 1))
+	{
+		IAS_LOG_ERROR("failed to write the mwdImage file %s!\n",filename);
+		fclose(fp);
+		unlink(filename);
+		free(buffer);
+		return ERROR;
+	}
+	free(buffer);
+
+	if(fclose(fp) != 0)
+	{
+		IAS_LOG_ERROR("failed to close the mwdImage file %s!\n",filename);
+		unlink(filename);
+		return ERROR;
+	}
+
+	info->file_size = file_size;
+	info->num_frames = num_frames;
+	return SUCCESS;
+}
@@ -0,0 +1,44 @@
+/*
+ * synthetic_mwd.h
+ *
+ *  Synthetic mwdImage files: "L8" frame headers laid out like the flight
+ *  ones, with OLI, TIRS and PAN frames interleaved and spread evenly over a
+ *  time span, so the whole pipeline can run without flight data.
+ */
+
+#ifndef SYNTHETIC_MWD_H_
+#define SYNTHETIC_MWD_H_
+
+/* Frame lengths, headers included */
+#define SYNTHETIC_MWD_OLI_FRAME_LENGTH 65536
+#define SYNTHETIC_MWD_TIRS_FRAME_LENGTH 16384
+#define SYNTHETIC_MWD_PAN_FRAME_LENGTH 131072
+/* Pattern of the frame modes, repeated over the file */
+#define SYNTHETIC_MWD_MODE_PATTERN "OOOOOOTOP"
+#define SYNTHETIC_MWD_BAND 7					//band field of the headers
+#define SYNTHETIC_MWD_WRITE_BUFFER_SIZE 8388608	//bytes written at a time
+
+
+/* Frames written to a synthetic mwdImage */
+typedef struct synthetic_mwd_info
+{
+	long long file_size;				//bytes of the file
+	long long num_frames;				//frames of the file
+	long long num_oli_frames;			//OLI frames of the file
+	long long num_tirs_frames;			//TIRS frames of the file
+	long long num_pan_frames;			//PAN frames of the file
+}SYNTHETIC_MWD_INFO;
+
+
+int synthetic_mwd_write
+(
+	const char *filename,				//I:mwdImage file to create
+	long long target_size,				//I:bytes to write, rounded up to
+										//	a whole frame
+	double start_time,					//I:time of the first frame, J2000
+										//	seconds
+	double duration,					//I:seconds the frames span
+	SYNTHETIC_MWD_INFO *info			//O:frames written
+);
+
+#endif /* SYNTHETIC_MWD_H_ */
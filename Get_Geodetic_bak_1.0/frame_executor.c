@@ -0,0 +1,410 @@
+/*
+ * frame_executor.c
+ *
+ *  Work-stealing pool of worker threads for the frame geolocation.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "ias_const.h"
+#include "ias_logging.h"
+#include "ias_threadsync.h"
+#include "frame_executor.h"
+
+
+/* chunks [lo, hi) of a job left in the queue of a worker */
+typedef struct chunk_queue
+{
+	pthread_mutex_t lock;
+	long long lo;
+	long long hi;
+	unsigned long generation;	//job the chunks belong to
+} CHUNK_QUEUE;
+
+typedef struct frame_executor_worker
+{
+	struct frame_executor *executor;
+	pthread_t thread;
+	int index;
+	long long busy_ns;			//time spent running chunks
+} FRAME_EXECUTOR_WORKER;
+
+struct frame_executor
+{
+	pthread_mutex_t lock;		//protects the job and the counters below
+	pthread_cond_t work_cond;	//signaled when a job is submitted
+	pthread_cond_t done_cond;	//signaled when the last chunk is done
+	FRAME_EXECUTOR_WORKER *workers;
+	CHUNK_QUEUE *queues;		//one queue per worker
+	int thread_count;
+	int shutdown;
+
+	/* current job */
+	unsigned long generation;
+	FRAME_EXECUTOR_FUNC func;
+	void *arg;
+	long long num_frames;
+	int frames_per_chunk;
+	long long remaining_chunks;
+};
+
+
+/* *********************************************************************************
+ * NAME:			take_chunk
+ *
+ * PURPOSE:	take the next chunk from the worker's own queue, or steal half of
+ * 			the chunks left in the queue of another worker
+ *
+ * RETURN: 1 if a chunk was found, 0 when no chunk of the job is left
+ * *********************************************************************************/
+static int take_chunk(FRAME_EXECUTOR *executor, int index,
+		unsigned long generation, long long *chunk)
+{
+	CHUNK_QUEUE *own = &executor->queues[index];
+	CHUNK_QUEUE *victim;
+	long long lo;
+	long long hi;
+	int i;
+
+	pthread_mutex_lock(&own->lock);
+	if(own->generation == generation && own->lo < own->hi)
+	{
+		*chunk = own->lo++;
+		pthread_mutex_unlock(&own->lock);
+		return 1;
+	}
+	pthread_mutex_unlock(&own->lock);
+
+	/* Steal from the back of the other queues */
+	for(i = 1; i < executor->thread_count; i++)
+	{
+		victim = &executor->queues[(index + i) % executor->thread_count];
+		pthread_mutex_lock(&victim->lock);
+		if(victim->generation != generation || victim->lo >= victim->hi)
+		{
+			pthread_mutex_unlock(&victim->lock);
+			continue;
+		}
+		hi = victim->hi;
+		lo = victim->hi - (victim->hi - victim->lo + 1) / 2;
+		victim->hi = lo;
+		pthread_mutex_unlock(&victim->lock);
+
+		/* Run the first stolen chunk, queue the others for later */
+		pthread_mutex_lock(&own->lock);
+		own->lo = lo + 1;
+		own->hi = hi;
+		own->generation = generation;
+		pthread_mutex_unlock(&own->lock);
+		*chunk = lo;
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_thread
+ *
+ * PURPOSE:	wait for jobs and run their chunks until the executor is destroyed
+ *
+ * RETURN: NULL
+ * *********************************************************************************/
+static void *frame_executor_thread(void *worker_ptr)
+{
+	FRAME_EXECUTOR_WORKER *worker = (FRAME_EXECUTOR_WORKER *)worker_ptr;
+	FRAME_EXECUTOR *executor = worker->executor;
+	unsigned long seen_generation = 0;
+	unsigned long generation;
+	FRAME_EXECUTOR_FUNC func;
+	void *arg;
+	long long num_frames;
+	int frames_per_chunk;
+	long long chunk;
+	long long start_frame;
+	long long end_frame;
+	struct timespec chunk_start;
+	struct timespec chunk_end;
+
+	for( ; ; )
+	{
+		pthread_mutex_lock(&executor->lock);
+		while(executor->generation == seen_generation && !executor->shutdown)
+		{
+			pthread_cond_wait(&executor->work_cond,&executor->lock);
+		}
+		if(executor->shutdown)
+		{
+			pthread_mutex_unlock(&executor->lock);
+			break;
+		}
+		generation = seen_generation = executor->generation;
+		func = executor->func;
+		arg = executor->arg;
+		num_frames = executor->num_frames;
+		frames_per_chunk = executor->frames_per_chunk;
+		pthread_mutex_unlock(&executor->lock);
+
+		while(take_chunk(executor,worker->index,generation,&chunk))
+		{
+			start_frame = chunk * frames_per_chunk;
+			end_frame = start_frame + frames_per_chunk;
+			if(end_frame > num_frames)
+			{
+				end_frame = num_frames;
+			}
+			clock_gettime(CLOCK_MONOTONIC,&chunk_start);
+			func(arg,start_frame,end_frame);
+			clock_gettime(CLOCK_MONOTONIC,&chunk_end);
+			__sync_fetch_and_add(&worker->busy_ns,
+					(chunk_end.tv_sec - chunk_start.tv_sec) * 1000000000LL
+					+ (chunk_end.tv_nsec - chunk_start.tv_nsec));
+
+			if(__sync_sub_and_fetch(&executor->remaining_chunks,1) == 0)
+			{
+				pthread_mutex_lock(&executor->lock);
+				pthread_cond_broadcast(&executor->done_cond);
+				pthread_mutex_unlock(&executor->lock);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_create
+ *
+ * PURPOSE:	start the workers of the executor
+ *
+ * RETURN: pointer to the executor or NULL
+ * *********************************************************************************/
+FRAME_EXECUTOR *frame_executor_create(int num_threads)
+{
+	FRAME_EXECUTOR *executor;
+	int i;
+
+	if(num_threads < 0)
+	{
+		IAS_LOG_ERROR("Invalid number of threads %d",num_threads);
+		return NULL;
+	}
+	if(num_threads == 0)
+	{
+		num_threads = IAS_THREAD_GET_NUM_PROCESSORS();
+		if(num_threads < 1)
+		{
+			num_threads = 1;
+		}
+	}
+
+	executor = calloc(1,sizeof(*executor));
+	if(executor == NULL)
+	{
+		IAS_LOG_ERROR("Allocating the frame executor");
+		return NULL;
+	}
+
+	executor->workers = calloc(num_threads,sizeof(*executor->workers));
+	executor->queues = calloc(num_threads,sizeof(*executor->queues));
+	if(executor->workers == NULL || executor->queues == NULL)
+	{
+		IAS_LOG_ERROR("Allocating the frame executor workers");
+		free(executor->workers);
+		free(executor->queues);
+		free(executor);
+		return NULL;
+	}
+
+	pthread_mutex_init(&executor->lock,NULL);
+	pthread_cond_init(&executor->work_cond,NULL);
+	pthread_cond_init(&executor->done_cond,NULL);
+	for(i = 0; i < num_threads; i++)
+	{
+		pthread_mutex_init(&executor->queues[i].lock,NULL);
+	}
+
+	for(i = 0; i < num_threads; i++)
+	{
+		executor->workers[i].executor = executor;
+		executor->workers[i].index = i;
+		if(pthread_create(&executor->workers[i].thread,NULL,
+				frame_executor_thread,&executor->workers[i]) != 0)
+		{
+			IAS_LOG_ERROR("Starting frame executor thread %d",i);
+			frame_executor_destroy(executor);
+			return NULL;
+		}
+		executor->thread_count++;
+	}
+
+	IAS_LOG_INFO("Frame executor started with %d threads",
+			executor->thread_count);
+	return executor;
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_get_thread_count
+ *
+ * PURPOSE:	get the number of workers of the executor
+ *
+ * RETURN: number of workers
+ * *********************************************************************************/
+int frame_executor_get_thread_count(const FRAME_EXECUTOR *executor)
+{
+	return executor->thread_count;
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_get_busy_seconds
+ *
+ * PURPOSE:	get the time a worker has spent running chunks since the executor
+ * 			was created
+ *
+ * RETURN: busy time in seconds
+ * *********************************************************************************/
+double frame_executor_get_busy_seconds(FRAME_EXECUTOR *executor, int index)
+{
+	return __sync_fetch_and_add(&executor->workers[index].busy_ns,0) / 1e9;
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_get_pending_chunks
+ *
+ * PURPOSE:	get the number of chunks of the current job not done yet
+ *
+ * RETURN: number of chunks
+ * *********************************************************************************/
+long long frame_executor_get_pending_chunks(FRAME_EXECUTOR *executor)
+{
+	return __sync_fetch_and_add(&executor->remaining_chunks,0);
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_submit
+ *
+ * PURPOSE:	start running func over the frames [0, num_frames) without
+ * 			waiting. The chunks are spread evenly over the worker queues.
+ * 			The previous job must have been waited for.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int frame_executor_submit(FRAME_EXECUTOR *executor, FRAME_EXECUTOR_FUNC func,
+		void *arg, long long num_frames, int frames_per_chunk)
+{
+	long long num_chunks;
+	unsigned long generation;
+	int i;
+
+	if(func == NULL || num_frames < 0 || frames_per_chunk < 1)
+	{
+		IAS_LOG_ERROR("Invalid frame executor job");
+		return ERROR;
+	}
+
+	pthread_mutex_lock(&executor->lock);
+	if(executor->remaining_chunks != 0)
+	{
+		pthread_mutex_unlock(&executor->lock);
+		IAS_LOG_ERROR("The previous frame executor job is not done");
+		return ERROR;
+	}
+
+	num_chunks = (num_frames + frames_per_chunk - 1) / frames_per_chunk;
+	if(num_chunks == 0)
+	{
+		pthread_mutex_unlock(&executor->lock);
+		return SUCCESS;
+	}
+
+	generation = executor->generation + 1;
+	for(i = 0; i < executor->thread_count; i++)
+	{
+		pthread_mutex_lock(&executor->queues[i].lock);
+		executor->queues[i].lo = i * num_chunks / executor->thread_count;
+		executor->queues[i].hi = (i + 1) * num_chunks / executor->thread_count;
+		executor->queues[i].generation = generation;
+		pthread_mutex_unlock(&executor->queues[i].lock);
+	}
+
+	executor->func = func;
+	executor->arg = arg;
+	executor->num_frames = num_frames;
+	executor->frames_per_chunk = frames_per_chunk;
+	executor->remaining_chunks = num_chunks;
+	executor->generation = generation;
+	pthread_cond_broadcast(&executor->work_cond);
+	pthread_mutex_unlock(&executor->lock);
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_wait
+ *
+ * PURPOSE:	wait until all the chunks of the submitted job are done
+ *
+ * RETURN: SUCCESS
+ * *********************************************************************************/
+int frame_executor_wait(FRAME_EXECUTOR *executor)
+{
+	pthread_mutex_lock(&executor->lock);
+	while(__sync_fetch_and_add(&executor->remaining_chunks,0) != 0)
+	{
+		pthread_cond_wait(&executor->done_cond,&executor->lock);
+	}
+	pthread_mutex_unlock(&executor->lock);
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			frame_executor_destroy
+ *
+ * PURPOSE:	wait for the current job, stop the workers and free the executor
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void frame_executor_destroy(FRAME_EXECUTOR *executor)
+{
+	int i;
+
+	if(executor == NULL)
+	{
+		return;
+	}
+
+	frame_executor_wait(executor);
+
+	pthread_mutex_lock(&executor->lock);
+	executor->shutdown = 1;
+	pthread_cond_broadcast(&executor->work_cond);
+	pthread_mutex_unlock(&executor->lock);
+
+	for(i = 0; i < executor->thread_count; i++)
+	{
+		pthread_join(executor->workers[i].thread,NULL);
+	}
+
+	for(i = 0; i < executor->thread_count; i++)
+	{
+		pthread_mutex_destroy(&executor->queues[i].lock);
+	}
+	pthread_mutex_destroy(&executor->lock);
+	pthread_cond_destroy(&executor->work_cond);
+	pthread_cond_destroy(&executor->done_cond);
+	free(executor->workers);
+	free(executor->queues);
+	free(executor);
+}
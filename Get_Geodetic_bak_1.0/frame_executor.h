@@ -0,0 +1,66 @@
+/*
+ * frame_executor.h
+ *
+ *  Long-lived pool of worker threads running a function over a range of
+ *  frames. The range is split into chunks spread over per-worker queues;
+ *  a worker that runs out of chunks steals half of the chunks left in the
+ *  queue of another worker. Jobs are started without waiting, so the caller
+ *  can map the next window and write back the previous one meanwhile.
+ */
+
+#ifndef FRAME_EXECUTOR_H_
+#define FRAME_EXECUTOR_H_
+
+#include <pthread.h>
+
+#define FRAMES_PER_CHUNK 64
+
+/* function run on the frames [start_frame, end_frame) of a job */
+typedef void (*FRAME_EXECUTOR_FUNC)(void *arg, long long start_frame,
+		long long end_frame);
+
+/* forward reference, nothing outside the executor needs its members */
+typedef struct frame_executor FRAME_EXECUTOR;
+
+
+FRAME_EXECUTOR *frame_executor_create
+(
+	int num_threads			//I:number of workers, 0 for one per processor
+);
+
+int frame_executor_get_thread_count
+(
+	const FRAME_EXECUTOR *executor	//I:executor to query
+);
+
+double frame_executor_get_busy_seconds
+(
+	FRAME_EXECUTOR *executor,		//I:executor to query
+	int index						//I:index of the worker
+);
+
+long long frame_executor_get_pending_chunks
+(
+	FRAME_EXECUTOR *executor		//I:executor to query
+);
+
+int frame_executor_submit
+(
+	FRAME_EXECUTOR *executor,		//I/O:executor to run the job
+	FRAME_EXECUTOR_FUNC func,		//I:function to run on each chunk
+	void *arg,						//I:argument passed to func
+	long long num_frames,			//I:number of frames of the job
+	int frames_per_chunk			//I:frames per chunk
+);
+
+int frame_executor_wait
+(
+	FRAME_EXECUTOR *executor		//I/O:executor to wait for
+);
+
+void frame_executor_destroy
+(
+	FRAME_EXECUTOR *executor		//I:executor to stop and free
+);
+
+#endif /* FRAME_EXECUTOR_H_ */
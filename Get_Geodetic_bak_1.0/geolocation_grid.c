@@ -0,0 +1,556 @@
+/*
+ * geolocation_grid.c
+ *
+ *  Per-pixel geolocation of the OLI frames through a coarse grid of exactly
+ *  located nodes.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ias_logging.h"
+#include "ias_geo.h"
+#include "ias_math.h"
+#include "frame_executor.h"
+#include "geolocation_grid.h"
+
+
+/* *********************************************************************************
+ * NAME:			geolocation_grid_open
+ *
+ * PURPOSE:	set up the grid of a band and create the grid file, writing its
+ * 			header. The grid columns of a SCA are every GRID_CELL_SAMPLES
+ * 			detectors plus the last detector, as the in_samps of an ias_lib
+ * 			grid band.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int geolocation_grid_open
+(
+	const PARAMETERS *param,			//I:parameters
+	const IAS_LOS_MODEL *model,			//I:LOS model
+	int band_index,						//I:band index to locate
+	const MWD_FRAME_INDEX *oli_frame_index, //I:OLI frames to locate
+	GEOLOCATION_GRID *grid				//O:grid and its open output file
+)
+{
+	const IAS_SENSOR_BAND_MODEL *band;
+	GEOLOCATION_GRID_FILE_HEADER header;
+	int cell_samps;
+	int i;
+
+	memset(grid,0,sizeof(*grid));
+	grid->fd = -1;
+
+	if(band_index < 0 || band_index >= model->sensor.band_count)
+	{
+		IAS_LOG_ERROR("invalid band index %d for the geolocation grid!\n",
+				band_index);
+		return ERROR;
+	}
+	band = &model->sensor.bands[band_index];
+	if(band->sca_count <= 0 || band->scas[0].detectors <= 1)
+	{
+		IAS_LOG_ERROR("band index %d has no detectors to grid!\n",band_index);
+		return ERROR;
+	}
+
+	grid->band_index = band_index;
+	grid->sca_count = band->sca_count;
+	grid->detectors = band->scas[0].detectors;
+	grid->sample_spacing = param->grid_sample_spacing;
+	grid->samples_per_sca = (grid->detectors - 1)/grid->sample_spacing + 1;
+	grid->num_layers = param->grid_view_angles ? 3 : 2;
+	grid->cell_frames = param->grid_cell_frames;
+	if(grid->cell_frames > FRAMES_PER_CHUNK)
+	{
+		grid->cell_frames = FRAMES_PER_CHUNK;
+	}
+	grid->first_entry = oli_frame_index->entries;
+	grid->chunk_size = 2*sizeof(long long) + (long long)grid->num_layers
+			* grid->sca_count * grid->samples_per_sca * sizeof(double);
+
+	/* Grid columns through a SCA, the last one on the last detector */
+	cell_samps = param->grid_cell_samples;
+	if(cell_samps > grid->detectors - 1)
+	{
+		cell_samps = grid->detectors - 1;
+	}
+	grid->ngrid_samps = (grid->detectors - 2)/cell_samps + 2;
+	grid->inv_cell_samps = 1.0/cell_samps;
+	grid->in_samps = malloc(grid->ngrid_samps*sizeof(int));
+	if(grid->in_samps == NULL)
+	{
+		IAS_LOG_ERROR("failed to allocate memory for the geolocation grid!\n");
+		return ERROR;
+	}
+	for(i = 0 ; i < grid->ngrid_samps - 1 ; i++)
+	{
+		grid->in_samps[i] = i*cell_samps;
+	}
+	grid->in_samps[grid->ngrid_samps - 1] = grid->detectors - 1;
+
+	grid->fd = open(param->grid_filename,O_WRONLY|O_CREAT|O_TRUNC,0644);
+	if(grid->fd < 0)
+	{
+		IAS_LOG_ERROR("failed to create the geolocation grid file %s: %s\n",
+				param->grid_filename,strerror(errno));
+		geolocation_grid_close(grid);
+		return ERROR;
+	}
+
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,GEOLOCATION_GRID_FILE_MAGIC,
+			sizeof(GEOLOCATION_GRID_FILE_MAGIC));
+	header.version = GEOLOCATION_GRID_FILE_VERSION;
+	header.band_index = grid->band_index;
+	header.sca_count = grid->sca_count;
+	header.detectors = grid->detectors;
+	header.sample_spacing = grid->sample_spacing;
+	header.samples_per_sca = grid->samples_per_sca;
+	header.num_layers = grid->num_layers;
+	header.num_frames = oli_frame_index->num_entries;
+	header.chunk_size = grid->chunk_size;
+
+	/* Size the file so the chunks can be written in any order */
+	if(pwrite(grid->fd,&header,sizeof(header),0) != sizeof(header)
+			|| ftruncate(grid->fd,sizeof(header)
+				+ header.num_frames*header.chunk_size) != 0)
+	{
+		IAS_LOG_ERROR("failed to write the geolocation grid file %s: %s\n",
+				param->grid_filename,strerror(errno));
+		geolocation_grid_close(grid);
+		return ERROR;
+	}
+
+	IAS_LOG_INFO("geolocation grid of %d SCAs x %d samples, %d grid columns "
+			"per SCA, written to %s",grid->sca_count,grid->samples_per_sca,
+			grid->ngrid_samps,param->grid_filename);
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			get_view_angle
+ *
+ * PURPOSE:	angle at the satellite between the nadir and the direction of a
+ * 			located target
+ *
+ * RETURN: the view angle in radians
+ * *********************************************************************************/
+static double get_view_angle
+(
+	const IAS_EARTH_CHARACTERISTICS *earth,	//I:Earth parameters
+	const IAS_VECTOR *satpos,			//I:satellite position (ECEF)
+	double latitude,					//I:target latitude
+	double longitude					//I:target longitude
+)
+{
+	IAS_VECTOR target;
+	double dx, dy, dz;
+	double cos_angle;
+
+	ias_geo_convert_geod2cart(latitude,longitude,0.0,earth->semi_major_axis,
+			(earth->semi_major_axis - earth->semi_minor_axis)
+				/ earth->semi_major_axis,&target);
+
+	dx = target.x - satpos->x;
+	dy = target.y - satpos->y;
+	dz = target.z - satpos->z;
+	cos_angle = -(dx*satpos->x + dy*satpos->y + dz*satpos->z)
+			/ (sqrt(dx*dx + dy*dy + dz*dz)
+				* sqrt(satpos->x*satpos->x + satpos->y*satpos->y
+					+ satpos->z*satpos->z));
+	if(cos_angle > 1.0)
+	{
+		cos_angle = 1.0;
+	}
+
+	return acos(cos_angle);
+}
+
+
+/* *********************************************************************************
+ * NAME:			fit_cell_row
+ *
+ * PURPOSE:	fit the bilinear mapping of each cell of a SCA between two grid
+ * 			rows with ias_geo_compute_forward_mappings, as for the cells of an
+ * 			ias_lib grid band: the a coefficients map the detector and the
+ * 			line fraction (0 on the top row, 1 on the bottom row) to the
+ * 			first layer and the b coefficients to the second. Longitudes are
+ * 			unwrapped along the row first so a cell crossing the 180 degree
+ * 			meridian is fitted the short way.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+static int fit_cell_row
+(
+	const GEOLOCATION_GRID *grid,		//I:grid of the nodes
+	const double *top_a,				//I:first layer on the top row
+	const double *bottom_a,				//I:first layer on the bottom row
+	const double *top_b,				//I:second layer on the top row
+	const double *bottom_b,				//I:second layer on the bottom row
+	int unwrap_a,						//I:1 if the first layer is longitude
+	double pi,							//I:value of pi
+	double *row_a,						//I:scratch of 2*ngrid_samps values
+	double *row_b,						//I:scratch of 2*ngrid_samps values
+	IAS_COEFFICIENTS *coef				//O:coefficients of the ngrid_samps-1
+										//	cells
+)
+{
+	static const int cell_lines[2] = {0,1};
+	int n = grid->ngrid_samps;
+	int col;
+
+	memcpy(row_a,top_a,n*sizeof(double));
+	memcpy(row_a + n,bottom_a,n*sizeof(double));
+	memcpy(row_b,top_b,n*sizeof(double));
+	memcpy(row_b + n,bottom_b,n*sizeof(double));
+
+	if(unwrap_a)
+	{
+		for(col = 0 ; col < 2*n ; col++)
+		{
+			/* along the top row, and each bottom node from the one above */
+			double previous = (col < n) ? row_a[(col > 0) ? col - 1 : 0]
+					: row_a[col - n];
+
+			if(row_a[col] - previous > pi)
+				row_a[col] -= 2.0*pi;
+			else if(row_a[col] - previous < -pi)
+				row_a[col] += 2.0*pi;
+		}
+	}
+
+	return ias_geo_compute_forward_mappings(1,cell_lines,grid->in_samps,row_b,
+			row_a,1,n - 1,coef);
+}
+
+
+/* *********************************************************************************
+ * NAME:			geolocation_grid_locate_frames
+ *
+ * PURPOSE:	locate the pixels of consecutive frames of the index and write
+ * 			their chunks. The grid rows are every cell_frames frames plus the
+ * 			last frame; all the nodes of the rows are located in one batch,
+ * 			and each pixel is interpolated in its cell, across the detectors
+ * 			and in time between the frames of the rows.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int geolocation_grid_locate_frames
+(
+	const GEOLOCATION_GRID *grid,		//I:grid to fill
+	const IAS_LOS_MODEL *model,			//I:LOS model
+	const MWD_FRAME_INDEX_ENTRY *entry,	//I:frames to locate, in index order
+	int num_frames						//I:number of frames
+)
+{
+	int nrows;
+	int nodes_per_row = grid->sca_count*grid->ngrid_samps;
+	int num_nodes;
+	int *row_frame = NULL;
+	long long *node_time = NULL;
+	double *node_sample = NULL;
+	int *node_sca = NULL;
+	double *node_value[3] = {NULL,NULL,NULL};
+	int *node_status = NULL;
+	char *chunk = NULL;
+	IAS_COEFFICIENTS *cell_coef[2] = {NULL,NULL};
+	int *cell_valid = NULL;
+	double *row_a = NULL;
+	double *row_b = NULL;
+	int ncells = grid->ngrid_samps - 1;
+	int num_cell_rows;
+	int num_cells;
+	double *raster;
+	long long chunk_offset;
+	double pi = ias_math_get_pi();
+	int layer, row, frame, sca, col, samp, node;
+	int status = ERROR;
+
+	if(num_frames <= 0)
+	{
+		return SUCCESS;
+	}
+
+	/* Rows of the grid, the last one on the last frame */
+	nrows = (num_frames - 2)/grid->cell_frames + 2;
+	if(num_frames == 1)
+	{
+		nrows = 1;
+	}
+	num_nodes = nrows*nodes_per_row;
+	num_cell_rows = (nrows > 1) ? nrows - 1 : 1;
+	num_cells = num_cell_rows*grid->sca_count*ncells;
+
+	row_frame = malloc(nrows*sizeof(int));
+	node_time = malloc(num_nodes*sizeof(long long));
+	node_sample = malloc(num_nodes*sizeof(double));
+	node_sca = malloc(num_nodes*sizeof(int));
+	node_status = malloc(num_nodes*sizeof(int));
+	chunk = malloc(grid->chunk_size);
+	cell_coef[0] = malloc(num_cells*sizeof(IAS_COEFFICIENTS));
+	cell_valid = malloc(num_cells*sizeof(int));
+	row_a = malloc(2*grid->ngrid_samps*sizeof(double));
+	row_b = malloc(2*grid->ngrid_samps*sizeof(double));
+	if(grid->num_layers > GEOLOCATION_GRID_VIEW_ANGLE)
+	{
+		cell_coef[1] = malloc(num_cells*sizeof(IAS_COEFFICIENTS));
+		if(cell_coef[1] == NULL)
+		{
+			IAS_LOG_ERROR("failed to allocate memory for the geolocation grid!\n");
+			goto done;
+		}
+	}
+	for(layer = 0 ; layer < grid->num_layers ; layer++)
+	{
+		node_value[layer] = malloc(num_nodes*sizeof(double));
+		if(node_value[layer] == NULL)
+		{
+			IAS_LOG_ERROR("failed to allocate memory for the geolocation grid!\n");
+			goto done;
+		}
+	}
+	if(row_frame == NULL || node_time == NULL || node_sample == NULL
+			|| node_sca == NULL || node_status == NULL || chunk == NULL
+			|| cell_coef[0] == NULL || cell_valid == NULL || row_a == NULL
+			|| row_b == NULL)
+	{
+		IAS_LOG_ERROR("failed to allocate memory for the geolocation grid!\n");
+		goto done;
+	}
+
+	for(row = 0 ; row < nrows ; row++)
+	{
+		row_frame[row] = row*grid->cell_frames;
+	}
+	row_frame[nrows - 1] = num_frames - 1;
+
+	/* Locate the nodes, in row order so the ephemeris windows are reused */
+	node = 0;
+	for(row = 0 ; row < nrows ; row++)
+	{
+		for(sca = 0 ; sca < grid->sca_count ; sca++)
+		{
+			for(col = 0 ; col < grid->ngrid_samps ; col++)
+			{
+				node_time[node] = entry[row_frame[row]].time;
+				node_sample[node] = grid->in_samps[col];
+				node_sca[node] = sca;
+				node++;
+			}
+		}
+	}
+
+	ias_los_model_input_line_samp_to_geodetic_batch(num_nodes,node_time,
+			node_sample,NULL,node_sca,0.0,grid->band_index,0,0.0,model,
+			IAS_NOMINAL_DETECTOR,node_value[GEOLOCATION_GRID_LATITUDE],
+			node_value[GEOLOCATION_GRID_LONGITUDE],node_status);
+
+	if(grid->num_layers > GEOLOCATION_GRID_VIEW_ANGLE)
+	{
+		const IAS_SC_EPHEMERIS_MODEL *eph = &model->spacecraft.ephemeris;
+		IAS_SC_EPHEMERIS_INTERPOLATOR interp;
+		IAS_VECTOR satpos;
+		IAS_VECTOR satvel;
+
+		ias_sc_model_init_ephemeris_interpolator(eph,model->acquisition_type,
+				&interp);
+		for(row = 0 ; row < nrows ; row++)
+		{
+			ias_sc_model_interpolate_ephemeris(&interp,
+					ias_sc_model_get_time_from_epoch(&eph->time_base,
+						entry[row_frame[row]].time),&satpos,&satvel);
+			for(node = row*nodes_per_row ; node < (row + 1)*nodes_per_row ;
+					node++)
+			{
+				node_value[GEOLOCATION_GRID_VIEW_ANGLE][node] =
+					(node_status[node] == SUCCESS) ? get_view_angle(
+						&model->earth,&satpos,
+						node_value[GEOLOCATION_GRID_LATITUDE][node],
+						node_value[GEOLOCATION_GRID_LONGITUDE][node]) : 0.0;
+			}
+		}
+	}
+
+	/* Fit the cells between each pair of rows: longitude and latitude in
+	   the a and b coefficients, the view angle in both of the second set */
+	for(row = 0 ; row < num_cell_rows ; row++)
+	{
+		int bottom_row = (nrows > 1) ? row + 1 : row;
+
+		for(sca = 0 ; sca < grid->sca_count ; sca++)
+		{
+			int top = row*nodes_per_row + sca*grid->ngrid_samps;
+			int bottom = bottom_row*nodes_per_row + sca*grid->ngrid_samps;
+			int cell = (row*grid->sca_count + sca)*ncells;
+
+			for(col = 0 ; col < ncells ; col++)
+			{
+				cell_valid[cell + col] = node_status[top + col] == SUCCESS
+						&& node_status[top + col + 1] == SUCCESS
+						&& node_status[bottom + col] == SUCCESS
+						&& node_status[bottom + col + 1] == SUCCESS;
+			}
+
+			if(fit_cell_row(grid,
+					&node_value[GEOLOCATION_GRID_LONGITUDE][top],
+					&node_value[GEOLOCATION_GRID_LONGITUDE][bottom],
+					&node_value[GEOLOCATION_GRID_LATITUDE][top],
+					&node_value[GEOLOCATION_GRID_LATITUDE][bottom],1,pi,
+					row_a,row_b,&cell_coef[0][cell]) != SUCCESS
+				|| (cell_coef[1] != NULL && fit_cell_row(grid,
+					&node_value[GEOLOCATION_GRID_VIEW_ANGLE][top],
+					&node_value[GEOLOCATION_GRID_VIEW_ANGLE][bottom],
+					&node_value[GEOLOCATION_GRID_VIEW_ANGLE][top],
+					&node_value[GEOLOCATION_GRID_VIEW_ANGLE][bottom],0,pi,
+					row_a,row_b,&cell_coef[1][cell]) != SUCCESS))
+			{
+				IAS_LOG_ERROR("failed to fit the geolocation grid cells!\n");
+				goto done;
+			}
+		}
+	}
+
+	/* Interpolate the pixels of each frame in the cells of its rows */
+	raster = (double *)(chunk + 2*sizeof(long long));
+	chunk_offset = sizeof(GEOLOCATION_GRID_FILE_HEADER)
+			+ (entry - grid->first_entry)*grid->chunk_size;
+	row = 0;
+	for(frame = 0 ; frame < num_frames ; frame++)
+	{
+		double line_fraction = 0.0;
+		int top_row;
+		int bottom_row;
+
+		while(row < nrows - 2 && frame >= row_frame[row + 1])
+		{
+			row++;
+		}
+		top_row = row;
+		bottom_row = (nrows > 1) ? row + 1 : row;
+		if(entry[row_frame[bottom_row]].time
+				!= entry[row_frame[top_row]].time)
+		{
+			line_fraction = (double)(entry[frame].time
+						- entry[row_frame[top_row]].time)
+					/ (entry[row_frame[bottom_row]].time
+						- entry[row_frame[top_row]].time);
+		}
+
+		memcpy(chunk,&entry[frame].time,sizeof(long long));
+		memcpy(chunk + sizeof(long long),&entry[frame].offset,
+				sizeof(long long));
+
+		for(sca = 0 ; sca < grid->sca_count ; sca++)
+		{
+			int first_cell = (top_row*grid->sca_count + sca)*ncells;
+
+			for(samp = 0 ; samp < grid->samples_per_sca ; samp++)
+			{
+				double detector = samp*grid->sample_spacing;
+				double detector_line = detector*line_fraction;
+				double *pixel = &raster[sca*grid->samples_per_sca + samp];
+				int layer_size = grid->sca_count*grid->samples_per_sca;
+				const IAS_COEFFICIENTS *coef;
+				double longitude;
+
+				col = (int)(detector*grid->inv_cell_samps);
+				if(col > ncells - 1)
+				{
+					col = ncells - 1;
+				}
+
+				if(!cell_valid[first_cell + col])
+				{
+					for(layer = 0 ; layer < grid->num_layers ; layer++)
+					{
+						pixel[layer*layer_size] = GEOLOCATION_GRID_FILL_VALUE;
+					}
+					continue;
+				}
+
+				coef = &cell_coef[0][first_cell + col];
+				longitude = coef->a[0] + coef->a[1]*detector
+					+ coef->a[2]*line_fraction + coef->a[3]*detector_line;
+				if(longitude > pi)
+					longitude -= 2.0*pi;
+				else if(longitude < -pi)
+					longitude += 2.0*pi;
+				pixel[GEOLOCATION_GRID_LONGITUDE*layer_size] = longitude;
+				pixel[GEOLOCATION_GRID_LATITUDE*layer_size] = coef->b[0]
+					+ coef->b[1]*detector + coef->b[2]*line_fraction
+					+ coef->b[3]*detector_line;
+
+				if(cell_coef[1] != NULL)
+				{
+					coef = &cell_coef[1][first_cell + col];
+					pixel[GEOLOCATION_GRID_VIEW_ANGLE*layer_size] = coef->a[0]
+						+ coef->a[1]*detector + coef->a[2]*line_fraction
+						+ coef->a[3]*detector_line;
+				}
+			}
+		}
+
+		if(pwrite(grid->fd,chunk,grid->chunk_size,chunk_offset)
+				!= grid->chunk_size)
+		{
+			IAS_LOG_ERROR("failed to write the geolocation grid: %s\n",
+					strerror(errno));
+			goto done;
+		}
+		chunk_offset += grid->chunk_size;
+	}
+
+	status = SUCCESS;
+
+done:
+	free(row_frame);
+	free(node_time);
+	free(node_sample);
+	free(node_sca);
+	free(node_status);
+	free(chunk);
+	free(cell_coef[0]);
+	free(cell_coef[1]);
+	free(cell_valid);
+	free(row_a);
+	free(row_b);
+	for(layer = 0 ; layer < 3 ; layer++)
+	{
+		free(node_value[layer]);
+	}
+	return status;
+}
+
+
+/* *********************************************************************************
+ * NAME:			geolocation_grid_close
+ *
+ * PURPOSE:	close the grid file and free the grid
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int geolocation_grid_close
+(
+	GEOLOCATION_GRID *grid				//I/O:grid to close
+)
+{
+	int status = SUCCESS;
+
+	if(grid->fd >= 0 && close(grid->fd) != 0)
+	{
+		IAS_LOG_ERROR("failed to close the geolocation grid file: %s\n",
+				strerror(errno));
+		status = ERROR;
+	}
+	free(grid->in_samps);
+	memset(grid,0,sizeof(*grid));
+	grid->fd = -1;
+	return status;
+}
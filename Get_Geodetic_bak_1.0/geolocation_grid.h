@@ -0,0 +1,89 @@
+/*
+ * geolocation_grid.h
+ *
+ *  Optional per-pixel geolocation of the OLI frames. For every frame a
+ *  raster of lat/lon (and optionally view angle) is written for the
+ *  detectors of all the SCAs of a band. The LOS model is only evaluated at
+ *  the nodes of a coarse grid, every few detectors and every few frames, and
+ *  the pixels in between are interpolated in their grid cell the way the
+ *  ias_lib grid interpolates within an IAS_GRID_BAND_TYPE cell.
+ */
+
+#ifndef GEOLOCATION_GRID_H_
+#define GEOLOCATION_GRID_H_
+
+#include "ias_los_model.h"
+#include "read_parameter.h"
+#include "mwdImage_frame_index.h"
+
+#define GEOLOCATION_GRID_FILE_MAGIC "MWDGEOG"
+#define GEOLOCATION_GRID_FILE_VERSION 1
+/* value of the pixels of a cell with a node that could not be located */
+#define GEOLOCATION_GRID_FILL_VALUE -9999.0
+
+/* layers of the raster of a frame, in file order */
+#define GEOLOCATION_GRID_LATITUDE 0
+#define GEOLOCATION_GRID_LONGITUDE 1
+#define GEOLOCATION_GRID_VIEW_ANGLE 2
+
+
+/* header of the grid file. It is followed by one chunk per OLI frame, in
+ * frame index order: the frame time and file offset (two long longs), then
+ * num_layers rasters of sca_count * samples_per_sca doubles in radians. */
+typedef struct geolocation_grid_file_header
+{
+	char magic[8];
+	int version;
+	int band_index;				//band index located
+	int sca_count;				//number of SCAs of the band
+	int detectors;				//detectors per SCA
+	int sample_spacing;			//detectors between output samples
+	int samples_per_sca;		//output samples per SCA
+	int num_layers;				//2 for lat/lon, 3 with the view angle
+	int reserved;
+	long long num_frames;		//number of frame chunks
+	long long chunk_size;		//bytes per frame chunk
+}GEOLOCATION_GRID_FILE_HEADER;
+
+
+typedef struct geolocation_grid
+{
+	int fd;								//descriptor of the grid file
+	int band_index;						//band index located
+	int sca_count;						//number of SCAs of the band
+	int detectors;						//detectors per SCA
+	int sample_spacing;					//detectors between output samples
+	int samples_per_sca;				//output samples per SCA
+	int num_layers;						//layers written per frame
+	int cell_frames;					//frames per grid cell
+	int ngrid_samps;					//grid columns through a SCA
+	int *in_samps;						//detector of each grid column
+	double inv_cell_samps;				//1 / detectors per grid cell
+	long long chunk_size;				//bytes per frame chunk
+	const MWD_FRAME_INDEX_ENTRY *first_entry; //first OLI frame of the index
+}GEOLOCATION_GRID;
+
+
+int geolocation_grid_open
+(
+	const PARAMETERS *param,			//I:parameters
+	const IAS_LOS_MODEL *model,			//I:LOS model
+	int band_index,						//I:band index to locate
+	const MWD_FRAME_INDEX *oli_frame_index, //I:OLI frames to locate
+	GEOLOCATION_GRID *grid				//O:grid and its open output file
+);
+
+int geolocation_grid_locate_frames
+(
+	const GEOLOCATION_GRID *grid,		//I:grid to fill
+	const IAS_LOS_MODEL *model,			//I:LOS model
+	const MWD_FRAME_INDEX_ENTRY *entry,	//I:frames to locate, in index order
+	int num_frames						//I:number of frames
+);
+
+int geolocation_grid_close
+(
+	GEOLOCATION_GRID *grid				//I/O:grid to close
+);
+
+#endif /* GEOLOCATION_GRID_H_ */
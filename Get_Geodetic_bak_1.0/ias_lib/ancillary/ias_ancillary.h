@@ -28,6 +28,7 @@ SIRU: Scalable Inertial Reference Unit
 #include "ias_l0r.h"
 #include "ias_cpf.h"
 #include "ias_structures.h"
+#include "ias_math.h"
 #include "ias_ancillary_io.h"
 
 /* Function prototypes */
@@ -96,8 +97,9 @@ int ias_ancillary_preprocess_ephemeris_for_MWD
     int *invalid_ephemeris_count,       /* O: number of invalid ephemeris points
                                              detected */
     double *ephemeris_start_time,		/* O: first valid ephemeris data time */
-    double *ephemeris_end_time			/* O: last valid ephemeris data time */
-
+    double *ephemeris_end_time,			/* O: last valid ephemeris data time */
+    IAS_MATH_TIME_SYSTEM *time_system  /* O: time system of the ephemeris
+                                             span */
 );
 //////////////////////////////////////////////////////////////////////////////////
 
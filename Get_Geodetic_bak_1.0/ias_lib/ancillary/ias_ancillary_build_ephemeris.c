@@ -5,7 +5,8 @@ PURPOSE: Generate the ECEF version of the ephemeris data.  Update the
          ephemeris model with both ECI and ECEF versions of the data.
          Copy both versions of the data to the ancillary ephemeris
          structure.  The ephemeris time is also applied to the model and
-         ancillary structures.
+         ancillary structures.  The times are converted through the time
+         system of the ephemeris span.
 
 RETURN VALUE: Type = int
     Value    Description
@@ -23,7 +24,8 @@ RETURN VALUE: Type = int
 
 int ias_ancillary_build_ephemeris
 (
-    IAS_CPF *cpf,                 /* I: CPF structure */
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: time system of the
+                                        ephemeris span */
     int valid_ephemeris_count,    /* I: number of ephemeris points for the
                                         smoothed arrays */
     const double *smoothed_ephemeris_seconds_since_j2000, /* I: array of
@@ -39,14 +41,13 @@ int ias_ancillary_build_ephemeris
     int index = 0;               /* loop counter */
 
     double epoch_time[3];        /* ephemeris time year, DOY, SOD */
-    double pole_wander_x;        /* X shift pole wander */
-    double pole_wander_y;        /* Y shift pole wander */
-    double ut1_utc_correction;   /* UT1-UTC coord time difference */
-    double modified_julian_date; /* modified julian date */
+    double record_time;          /* J2000 seconds of the current record */
 
     IAS_VECTOR ecef_pos;         /* ephemeris position data in ECEF */
     IAS_VECTOR ecef_vel;         /* ephemeris velocity data in ECEF */
     IAS_ANC_EPHEMERIS_RECORD *anc_eph_records = NULL;/* ptr to eph records */
+    IAS_GEO_EARTH_ORIENTATION_CACHE *earth_orientation = NULL;
+                                 /* ECEF to J2000 rotation over the records */
 
 #if DEBUG_GENERATE_DATA_FILES == 1
     FILE *ofp = NULL;
@@ -57,20 +58,24 @@ int ias_ancillary_build_ephemeris
 
     /* smoothed_ephemeris_seconds_since_j2000 is still in spacecraft
        use it to recalculate epoch time */
-    if (ias_math_convert_j2000_seconds_to_year_doy_sod(
-            smoothed_ephemeris_seconds_since_j2000[0], epoch_time) != SUCCESS)
+    if (ias_math_time_system_convert_j2000_seconds_to_year_doy_sod(
+            time_system, smoothed_ephemeris_seconds_since_j2000[0],
+            epoch_time) != SUCCESS)
     {
         IAS_LOG_ERROR("Converting J2000 seconds %lf to Year, DOY, SOD format",
                 smoothed_ephemeris_seconds_since_j2000[0]);
         return ERROR;
     }
 
-    /* get x and y shift pole wander and UT1-UTC time difference */
-    if (ias_geo_compute_getmjdcoords(epoch_time, cpf, &modified_julian_date,
-                                     &pole_wander_x, &pole_wander_y,
-                                     &ut1_utc_correction) == ERROR)
+    /* The records are IAS_EPHEM_SAMPLING_PERIOD apart from the first one */
+    earth_orientation = ias_geo_create_earth_orientation_cache(time_system,
+            smoothed_ephemeris_seconds_since_j2000[0],
+            smoothed_ephemeris_seconds_since_j2000[0]
+            + (valid_ephemeris_count - 1) * IAS_EPHEM_SAMPLING_PERIOD,
+            IAS_GEO_EARTH_ORIENTATION_SPACING);
+    if (earth_orientation == NULL)
     {
-        IAS_LOG_ERROR("Establishing Earth Model");
+        IAS_LOG_ERROR("Establishing Earth orientation");
         return ERROR;
     }
 
@@ -96,11 +101,14 @@ int ias_ancillary_build_ephemeris
         anc_eph_records[index].eci_velocity[2] = smoothed_eph_vel[index].z;
 
         /* Convert true-of-date to ECEF */
-        if (ias_geo_eci2ecef(pole_wander_x, pole_wander_y, ut1_utc_correction,
+        record_time = smoothed_ephemeris_seconds_since_j2000[0]
+            + index * IAS_EPHEM_SAMPLING_PERIOD;
+        if (ias_geo_eci2ecef_cached(earth_orientation, record_time,
                          &smoothed_eph_pos[index], &smoothed_eph_vel[index],
-                         epoch_time, &ecef_pos, &ecef_vel) != SUCCESS)
+                         &ecef_pos, &ecef_vel) != SUCCESS)
         {
             IAS_LOG_ERROR("Converting ECI coordinate to ECEF");
+            ias_geo_free_earth_orientation_cache(earth_orientation);
             return ERROR;
         }
 
@@ -112,11 +120,8 @@ int ias_ancillary_build_ephemeris
         anc_eph_records[index].ecef_velocity[0] = ecef_vel.x;
         anc_eph_records[index].ecef_velocity[1] = ecef_vel.y;
         anc_eph_records[index].ecef_velocity[2] = ecef_vel.z;
-
-        /* Adjust epoch time by one sample step. */
-        ias_math_add_seconds_to_year_doy_sod(IAS_EPHEM_SAMPLING_PERIOD,
-                                             epoch_time);
     }
+    ias_geo_free_earth_orientation_cache(earth_orientation);
 
 #if DEBUG_GENERATE_DATA_FILES == 1
     ofp = fopen("anc_eph.eci.dat", "w");
@@ -43,6 +43,7 @@ int ias_ancillary_preprocess_ephemeris
     IAS_VECTOR *smoothed_eph_pos = NULL; /* smoothed ephemeris position data */
     IAS_VECTOR *smoothed_eph_vel = NULL; /* smoothed ephemeris velocity data */
     int number_ephemeris_records;        /* size of ephemeris structures */
+    IAS_MATH_TIME_SYSTEM time_system;    /* time system of the ephemeris */
 
     *anc_ephemeris_data = NULL;
 
@@ -99,6 +100,18 @@ int ias_ancillary_preprocess_ephemeris
         return ERROR;
     }
 
+    /* Establish the time system of the smoothed ephemeris span */
+    if (ias_geo_init_time_system(cpf, ephemeris_seconds_since_j2000[0],
+            ephemeris_seconds_since_j2000[valid_ephemeris_count - 1],
+            &time_system) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Initializing the ephemeris time system");
+        free(ephemeris_seconds_since_j2000);
+        free(smoothed_eph_pos);
+        free(smoothed_eph_vel);
+        return ERROR;
+    }
+
     /* Allocate the ancillary data structure */
     *anc_ephemeris_data =
         ias_ancillary_allocate_ephemeris(valid_ephemeris_count);
@@ -116,8 +129,9 @@ int ias_ancillary_preprocess_ephemeris
        The memory for the ephemeris records in the model structure are
        allocated inside the build routine. */
     if (ias_ancillary_build_ephemeris(
-            cpf, valid_ephemeris_count, ephemeris_seconds_since_j2000,
-            smoothed_eph_pos, smoothed_eph_vel, *anc_ephemeris_data) != SUCCESS)
+            &time_system, valid_ephemeris_count,
+            ephemeris_seconds_since_j2000, smoothed_eph_pos,
+            smoothed_eph_vel, *anc_ephemeris_data) != SUCCESS)
     {
         IAS_LOG_ERROR("Building ancillary ephemeris");
         free(ephemeris_seconds_since_j2000);
@@ -146,7 +160,9 @@ int ias_ancillary_preprocess_ephemeris_for_MWD
     int *invalid_ephemeris_count,       /* O: number of bad ephemeris points
                                              detected */
     double *ephemeris_start_time,		/* O: first valid ephemeris data time */
-    double *ephemeris_end_time			/* O: last valid ephemeris data time */
+    double *ephemeris_end_time,			/* O: last valid ephemeris data time */
+    IAS_MATH_TIME_SYSTEM *time_system  /* O: time system of the ephemeris
+                                             span */
 )
 {
     int valid_ephemeris_count = 0;       /* valid ephemeris count */
@@ -207,7 +223,7 @@ int ias_ancillary_preprocess_ephemeris_for_MWD
             &valid_ephemeris_count,
             invalid_ephemeris_count, ephemeris_seconds_since_j2000,
             smoothed_eph_pos, smoothed_eph_vel,
-            &start_time,&end_time ) != SUCCESS)
+            &start_time,&end_time,time_system) != SUCCESS)
     {
         IAS_LOG_ERROR("Computing smoothed ephemeris");
         free(ephemeris_seconds_since_j2000);
@@ -237,8 +253,9 @@ int ias_ancillary_preprocess_ephemeris_for_MWD
        The memory for the ephemeris records in the model structure are
        allocated inside the build routine. */
     if (ias_ancillary_build_ephemeris(
-            cpf, valid_ephemeris_count, ephemeris_seconds_since_j2000,
-            smoothed_eph_pos, smoothed_eph_vel, *anc_ephemeris_data) != SUCCESS)
+            time_system, valid_ephemeris_count,
+            ephemeris_seconds_since_j2000, smoothed_eph_pos,
+            smoothed_eph_vel, *anc_ephemeris_data) != SUCCESS)
     {
         IAS_LOG_ERROR("Building ancillary ephemeris");
         free(ephemeris_seconds_since_j2000);
@@ -4,6 +4,7 @@
 #include "ias_l0r.h"
 #include "ias_cpf.h"
 #include "ias_ancillary_io.h"
+#include "ias_geo.h"
 
 /* turn on the generation of data files for debugging
    A value of 0 turns the file generation off.
@@ -18,6 +19,13 @@
 #define IAS_ANCILLARY_IMU_TIME   0.02   /* Units are in seconds. 1.0 or 0.02 */
 #define IAS_ANCILLARY_QUAT_TIME  0.02   /* Units are in seconds. 0.1 or 0.02 */
 
+/* Threads preprocessing the ephemeris: at most IAS_ANCILLARY_EPHEMERIS_THREADS
+   and at least IAS_ANCILLARY_RECORDS_PER_THREAD records for each one */
+#define IAS_ANCILLARY_EPHEMERIS_THREADS  8
+#define IAS_ANCILLARY_RECORDS_PER_THREAD 2048
+
+struct ias_threadpool;
+
 typedef enum ias_coordinate_system
 {
     IAS_ECEF,              /* Earth Centered Earth Fixed */
@@ -180,13 +188,53 @@ int ias_ancillary_smooth_ephemeris_for_MWD
     IAS_VECTOR *smoothed_eph_vel,       /* O: array of smoothed ephemeris
                                              velocity data */
     double *ephemeris_start_time,		/* O: first valid ephemeris data time */
-    double *ephemeris_end_time			/* O: last valid ephemeris data time */
+    double *ephemeris_end_time,			/* O: last valid ephemeris data time */
+    IAS_MATH_TIME_SYSTEM *time_system  /* O: time system of the ephemeris
+                                             span */
 );
 ///////////////////////////////////////////////////////////////////////////////////
 
+int ias_ancillary_screen_ephemeris
+(
+    struct ias_threadpool *pool,       /* I: threads to screen with */
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *earth_orientation,
+                                       /* I: Earth orientation over the
+                                             records */
+    const struct IAS_CPF_ORBIT_PARAMETERS *orbit_parameters,
+                                       /* I: CPF orbit parameters */
+    const struct IAS_CPF_ANCILLARY_QA_THRESHOLDS *anc_qa_thresholds,
+                                       /* I: CPF ancillary QA thresholds */
+    const IAS_L0R_EPHEMERIS *l0r_ephemeris, /* I: L0R ephemeris records */
+    int first_record,                  /* I: first record to screen */
+    int record_count,                  /* I: number of records to screen */
+    int *valid_ephemeris_count,        /* O: number of valid records */
+    double *ephemeris_seconds_since_j2000, /* O: times of the valid
+                                             records */
+    IAS_VECTOR *eci_pos,               /* O: J2000 positions of the valid
+                                             records */
+    IAS_VECTOR *eci_vel                /* O: J2000 velocities of the valid
+                                             records */
+);
+
+int ias_ancillary_resample_ephemeris
+(
+    struct ias_threadpool *pool,       /* I: threads to resample with */
+    const double *ephemeris_seconds_since_j2000, /* I: record times */
+    const IAS_VECTOR *eci_pos,         /* I: record positions */
+    const IAS_VECTOR *eci_vel,         /* I: record velocities */
+    int record_count,                  /* I: number of records, at least
+                                             IAS_LAGRANGE_PTS */
+    double sampling_period,            /* I: time between samples */
+    int max_samples,                   /* I: size of the output arrays */
+    int *sample_count,                 /* O: number of samples */
+    IAS_VECTOR *resampled_pos,         /* O: sample positions */
+    IAS_VECTOR *resampled_vel          /* O: sample velocities */
+);
+
 int ias_ancillary_build_ephemeris
 (
-    IAS_CPF *cpf,                        /* I: CPF structure */
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: time system of the
+                                               ephemeris span */
     int valid_ephemeris_count,           /* I: number of ephemeris points for
                                                the smoothed arrays */
     const double *smoothed_ephemeris_seconds_since_j2000,
@@ -0,0 +1,215 @@
+/*****************************************************************************
+NAME: ias_ancillary_resample_ephemeris
+
+PURPOSE: Interpolate the screened ephemeris at evenly spaced times with
+         Lagrange interpolation.  The output samples are split in contiguous
+         ranges, one per thread of the pool, that the threads claim in turn.
+         The records around the first sample of a range are found with a
+         binary search, then the records are advanced through as the serial
+         loop did.
+
+RETURN VALUE: Type = int
+    Value    Description
+    -----    -----------
+    SUCCESS  Successful completion
+    ERROR    Operation failed
+
+NOTES:
+    - The number of samples is the one the serial loop produced: the
+      samples up to the last record time, but at least IAS_LAGRANGE_PTS and
+      at most max_samples.
+    - The sample times are computed from their index instead of being
+      accumulated, so they do not drift over long ephemeris spans.
+*****************************************************************************/
+
+#include <math.h>
+#include "ias_const.h"
+#include "ias_logging.h"
+#include "ias_geo.h"
+#include "ias_threadpool.h"
+#include "ias_ancillary_private.h"
+
+typedef struct resample_ephemeris_work
+{
+    const double *seconds;          /* record times, increasing */
+    const IAS_VECTOR *pos;          /* record positions */
+    const IAS_VECTOR *vel;          /* record velocities */
+    int record_count;               /* number of records */
+    double start_time;              /* time of the first sample */
+    double sampling_period;         /* time between samples */
+    int sample_count;               /* number of samples */
+    int range_count;                /* number of sample ranges */
+    int next_range;                 /* next range to claim */
+    IAS_THREAD_MUTEX_TYPE range_mutex; /* protects next_range */
+    IAS_VECTOR *resampled_pos;      /* sample positions */
+    IAS_VECTOR *resampled_vel;      /* sample velocities */
+} RESAMPLE_EPHEMERIS_WORK;
+
+/* Find the number of records at or before a time */
+static int count_records_before
+(
+    const double *seconds,          /* I: record times, increasing */
+    int record_count,               /* I: number of records */
+    double time                     /* I: time to look for */
+)
+{
+    int low = 0;
+    int high = record_count;
+
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+
+        if (seconds[middle] <= time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+/* Interpolate the samples of a range */
+static void resample_range
+(
+    RESAMPLE_EPHEMERIS_WORK *work,  /* I/O: resampling work */
+    int first_sample,               /* I: first sample of the range */
+    int end_sample                  /* I: sample after the range */
+)
+{
+    int max_start_index = work->record_count - IAS_LAGRANGE_PTS;
+    int record_index;
+    int sample;
+
+    record_index = count_records_before(work->seconds, work->record_count,
+            work->start_time + first_sample * work->sampling_period);
+
+    for (sample = first_sample; sample < end_sample; sample++)
+    {
+        double sample_time = work->start_time
+            + sample * work->sampling_period;
+        int start_index;
+
+        while (record_index < work->record_count
+                && work->seconds[record_index] <= sample_time)
+        {
+            record_index++;
+        }
+
+        /* Center the interpolation points on the sample when possible */
+        start_index = record_index - IAS_LAGRANGE_PTS / 2;
+        if (start_index > max_start_index)
+            start_index = max_start_index;
+        if (start_index < 0)
+            start_index = 0;
+
+        ias_geo_lagrange_interpolate(&work->seconds[start_index],
+                &work->pos[start_index], &work->vel[start_index],
+                IAS_LAGRANGE_PTS, sample_time,
+                &work->resampled_pos[sample], &work->resampled_vel[sample]);
+    }
+}
+
+/* Interpolate the ranges of samples claimed.  The ranges are claimed instead
+   of being taken from the thread number since a pool thread may run a
+   function more than once, and a pool without threads runs it once in the
+   calling thread. */
+static int resample_ranges
+(
+    void *params,                   /* I/O: resampling work */
+    int thread_number               /* I: thread number (unused) */
+)
+{
+    RESAMPLE_EPHEMERIS_WORK *work = params;
+    int range;
+
+    for (;;)
+    {
+        IAS_THREAD_LOCK_MUTEX(&work->range_mutex);
+        range = work->next_range;
+        if (range < work->range_count)
+            work->next_range++;
+        IAS_THREAD_UNLOCK_MUTEX(&work->range_mutex);
+
+        if (range >= work->range_count)
+            break;
+
+        resample_range(work,
+                (int)((long long)work->sample_count * range
+                    / work->range_count),
+                (int)((long long)work->sample_count * (range + 1)
+                    / work->range_count));
+    }
+
+    return SUCCESS;
+}
+
+int ias_ancillary_resample_ephemeris
+(
+    struct ias_threadpool *pool,       /* I: threads to resample with */
+    const double *ephemeris_seconds_since_j2000, /* I: record times */
+    const IAS_VECTOR *eci_pos,         /* I: record positions */
+    const IAS_VECTOR *eci_vel,         /* I: record velocities */
+    int record_count,                  /* I: number of records, at least
+                                             IAS_LAGRANGE_PTS */
+    double sampling_period,            /* I: time between samples */
+    int max_samples,                   /* I: size of the output arrays */
+    int *sample_count,                 /* O: number of samples */
+    IAS_VECTOR *resampled_pos,         /* O: sample positions */
+    IAS_VECTOR *resampled_vel          /* O: sample velocities */
+)
+{
+    RESAMPLE_EPHEMERIS_WORK work;
+    double start_time = ephemeris_seconds_since_j2000[0];
+    double stop_time = ephemeris_seconds_since_j2000[record_count - 1];
+    int count;
+
+    if (record_count < IAS_LAGRANGE_PTS || sampling_period <= 0.0)
+    {
+        IAS_LOG_ERROR("Cannot resample %d ephemeris records every %f "
+                "seconds", record_count, sampling_period);
+        return ERROR;
+    }
+
+    /* Samples up to the last record time */
+    count = (int)floor((stop_time - start_time) / sampling_period) + 1;
+    while (start_time + count * sampling_period <= stop_time)
+        count++;
+    while (count > 0 && start_time + (count - 1) * sampling_period > stop_time)
+        count--;
+    if (count < IAS_LAGRANGE_PTS)
+        count = IAS_LAGRANGE_PTS;
+    if (count > max_samples)
+        count = max_samples;
+
+    work.seconds = ephemeris_seconds_since_j2000;
+    work.pos = eci_pos;
+    work.vel = eci_vel;
+    work.record_count = record_count;
+    work.start_time = start_time;
+    work.sampling_period = sampling_period;
+    work.sample_count = count;
+    work.range_count = ias_threadpool_get_thread_count(pool);
+    if (work.range_count < 1)
+        work.range_count = 1;
+    work.resampled_pos = resampled_pos;
+    work.resampled_vel = resampled_vel;
+    work.next_range = 0;
+    if (IAS_THREAD_CREATE_MUTEX(&work.range_mutex) != 0)
+    {
+        IAS_LOG_ERROR("Creating the resampling mutex");
+        return ERROR;
+    }
+
+    if (ias_threadpool_run_function(pool, resample_ranges, &work) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Interpolating the ephemeris samples");
+        IAS_THREAD_DESTROY_MUTEX(&work.range_mutex);
+        return ERROR;
+    }
+    IAS_THREAD_DESTROY_MUTEX(&work.range_mutex);
+
+    *sample_count = count;
+
+    return SUCCESS;
+}
@@ -0,0 +1,385 @@
+/*****************************************************************************
+NAME: ias_ancillary_screen_ephemeris
+
+PURPOSE: Convert the L0R ephemeris records to J2000 and reject the outliers
+         whose angular momentum or orbital radius is off nominal.  The work
+         is split in data-parallel passes over contiguous ranges of records,
+         one range per thread of the pool:
+         1) transform: every record is converted to J2000 through the Earth
+            orientation cache
+         2) QA mask: the angular momentum and orbital radius of the records
+            are checked against squared bounds in a loop without branches
+            or square roots the compiler vectorizes, counting the valid
+            records of each range
+         3) compaction: once the ranges are given their offsets in the
+            output from the counts, the valid records of every range are
+            copied there, in record order
+
+RETURN VALUE: Type = int
+    Value    Description
+    -----    -----------
+    SUCCESS  Successful completion
+    ERROR    Operation failed
+*****************************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+#include "ias_const.h"
+#include "ias_logging.h"
+#include "ias_l0r.h"
+#include "ias_cpf.h"
+#include "ias_math.h"
+#include "ias_geo.h"
+#include "ias_threadpool.h"
+#include "ias_ancillary_private.h"
+
+typedef struct screen_ephemeris_work
+{
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *earth_orientation;
+    const IAS_L0R_EPHEMERIS *l0r_ephemeris; /* L0R ephemeris records */
+    int first_record;               /* first record to screen */
+    int record_count;               /* number of records to screen */
+    int range_count;                /* number of record ranges */
+    int next_range;                 /* next range to claim in a pass */
+    IAS_THREAD_MUTEX_TYPE range_mutex; /* protects next_range */
+    double min_ang_momentum_sq;     /* squared angular momentum bounds */
+    double max_ang_momentum_sq;
+    double min_orbit_radius_sq;     /* squared orbital radius bounds, in
+                                       meters */
+    double max_orbit_radius_sq;
+    IAS_VECTOR *record_pos;         /* J2000 position of every record */
+    IAS_VECTOR *record_vel;         /* J2000 velocity of every record */
+    double *valid;                  /* QA mask of every record, 1.0 for
+                                       the valid ones and 0.0 for the
+                                       outliers */
+    int *range_valid_count;         /* valid records of each range */
+    int *range_offset;              /* output index of each range */
+    double *ephemeris_seconds;      /* compacted record times */
+    IAS_VECTOR *eci_pos;            /* compacted J2000 positions */
+    IAS_VECTOR *eci_vel;            /* compacted J2000 velocities */
+} SCREEN_EPHEMERIS_WORK;
+
+/* Find the bounds on the squared magnitude of a vector whose magnitude
+   must be within tolerance of nominal */
+static void get_squared_bounds
+(
+    double nominal,                 /* I: nominal magnitude */
+    double tolerance,               /* I: tolerance on the magnitude */
+    double *min_squared,            /* O: lower bound on the squared
+                                          magnitude */
+    double *max_squared             /* O: upper bound on the squared
+                                          magnitude */
+)
+{
+    double min_magnitude = nominal - tolerance;
+    double max_magnitude = nominal + tolerance;
+
+    if (min_magnitude < 0.0)
+        min_magnitude = 0.0;
+
+    *min_squared = min_magnitude * min_magnitude;
+    *max_squared = max_magnitude * max_magnitude;
+
+    /* Nothing passes a negative tolerance */
+    if (max_magnitude < 0.0)
+    {
+        *min_squared = 1.0;
+        *max_squared = 0.0;
+    }
+}
+
+/* Claim the next range of records of a pass, counted from the first record
+   screened.  The ranges are claimed instead of being taken from the thread
+   number since a pool thread may run a function more than once in a pass,
+   and a pool without threads runs it once in the calling thread.
+   Returns 0 when all the ranges are claimed. */
+static int claim_record_range
+(
+    SCREEN_EPHEMERIS_WORK *work,    /* I/O: screening work */
+    int *range,                     /* O: range index */
+    int *first_record,              /* O: first record of the range */
+    int *end_record                 /* O: record after the range */
+)
+{
+    IAS_THREAD_LOCK_MUTEX(&work->range_mutex);
+    *range = work->next_range;
+    if (*range < work->range_count)
+        work->next_range++;
+    IAS_THREAD_UNLOCK_MUTEX(&work->range_mutex);
+
+    if (*range >= work->range_count)
+        return 0;
+
+    *first_record = (int)((long long)work->record_count * *range
+            / work->range_count);
+    *end_record = (int)((long long)work->record_count * (*range + 1)
+            / work->range_count);
+
+    return 1;
+}
+
+/* Transform and QA mask passes over the records of the ranges claimed */
+static int transform_and_check_records
+(
+    void *params,                   /* I/O: screening work */
+    int thread_number               /* I: thread number (unused) */
+)
+{
+    SCREEN_EPHEMERIS_WORK *work = params;
+    const IAS_VECTOR *pos = work->record_pos;
+    const IAS_VECTOR *vel = work->record_vel;
+    double *valid = work->valid;
+    int range;
+    int first_record;
+    int end_record;
+    int index;
+
+    while (claim_record_range(work, &range, &first_record, &end_record))
+    {
+        int valid_count = 0;
+
+        for (index = first_record; index < end_record; index++)
+        {
+            const IAS_L0R_EPHEMERIS *record
+                = &work->l0r_ephemeris[work->first_record + index];
+            double seconds = IAS_L0R_CONVERT_TIME_TO_SECONDS_SINCE_J2000(
+                    record->l0r_time);
+
+            if (ias_geo_transform_ecef2j2k_cached(work->earth_orientation,
+                    seconds, &record->ecef_position_meters,
+                    &record->ecef_velocity_meters_per_sec,
+                    &work->record_pos[index], &work->record_vel[index])
+                    != SUCCESS)
+            {
+                IAS_LOG_ERROR("Converting ECEF coordinate to ECI J2000");
+                return ERROR;
+            }
+        }
+
+        /* Both the angular momentum and the orbital radius must be within
+           tolerance for a record to be valid.  The squared magnitudes are
+           compared to the squared bounds and the mask is kept in doubles
+           so the loop has no square root, branch or type conversion and is
+           vectorized. */
+        for (index = first_record; index < end_record; index++)
+        {
+            double hx = pos[index].y * vel[index].z
+                - pos[index].z * vel[index].y;
+            double hy = pos[index].z * vel[index].x
+                - pos[index].x * vel[index].z;
+            double hz = pos[index].x * vel[index].y
+                - pos[index].y * vel[index].x;
+            double ang_momentum_squared = hx * hx + hy * hy + hz * hz;
+            double orbit_radius_squared = pos[index].x * pos[index].x
+                + pos[index].y * pos[index].y + pos[index].z * pos[index].z;
+
+            valid[index] = ((ang_momentum_squared >= work->min_ang_momentum_sq)
+                & (ang_momentum_squared <= work->max_ang_momentum_sq)
+                & (orbit_radius_squared >= work->min_orbit_radius_sq)
+                & (orbit_radius_squared <= work->max_orbit_radius_sq))
+                ? 1.0 : 0.0;
+        }
+
+        for (index = first_record; index < end_record; index++)
+            valid_count += (valid[index] != 0.0);
+
+        work->range_valid_count[range] = valid_count;
+    }
+
+    return SUCCESS;
+}
+
+/* Compaction pass copying the valid records of the ranges claimed to their
+   output */
+static int compact_records
+(
+    void *params,                   /* I/O: screening work */
+    int thread_number               /* I: thread number (unused) */
+)
+{
+    SCREEN_EPHEMERIS_WORK *work = params;
+    int range;
+    int first_record;
+    int end_record;
+    int output;
+    int index;
+
+    while (claim_record_range(work, &range, &first_record, &end_record))
+    {
+        output = work->range_offset[range];
+        for (index = first_record; index < end_record; index++)
+        {
+            if (work->valid[index] == 0.0)
+                continue;
+
+            work->ephemeris_seconds[output]
+                = IAS_L0R_CONVERT_TIME_TO_SECONDS_SINCE_J2000(
+                    work->l0r_ephemeris[work->first_record + index].l0r_time);
+            work->eci_pos[output] = work->record_pos[index];
+            work->eci_vel[output] = work->record_vel[index];
+            output++;
+        }
+    }
+
+    return SUCCESS;
+}
+
+int ias_ancillary_screen_ephemeris
+(
+    struct ias_threadpool *pool,       /* I: threads to screen with */
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *earth_orientation,
+                                       /* I: Earth orientation over the
+                                             records */
+    const struct IAS_CPF_ORBIT_PARAMETERS *orbit_parameters,
+                                       /* I: CPF orbit parameters */
+    const struct IAS_CPF_ANCILLARY_QA_THRESHOLDS *anc_qa_thresholds,
+                                       /* I: CPF ancillary QA thresholds */
+    const IAS_L0R_EPHEMERIS *l0r_ephemeris, /* I: L0R ephemeris records */
+    int first_record,                  /* I: first record to screen */
+    int record_count,                  /* I: number of records to screen */
+    int *valid_ephemeris_count,        /* O: number of valid records */
+    double *ephemeris_seconds_since_j2000, /* O: times of the valid
+                                             records */
+    IAS_VECTOR *eci_pos,               /* O: J2000 positions of the valid
+                                             records */
+    IAS_VECTOR *eci_vel                /* O: J2000 velocities of the valid
+                                             records */
+)
+{
+    SCREEN_EPHEMERIS_WORK work;
+    int valid_count;
+    int range;
+    int index;
+#if DEBUG_GENERATE_DATA_FILES == 1
+    FILE *ofp = NULL;
+#endif
+
+    *valid_ephemeris_count = 0;
+    if (record_count < 1)
+        return SUCCESS;
+
+    work.earth_orientation = earth_orientation;
+    work.l0r_ephemeris = l0r_ephemeris;
+    work.first_record = first_record;
+    work.record_count = record_count;
+    work.range_count = ias_threadpool_get_thread_count(pool);
+    if (work.range_count < 1)
+        work.range_count = 1;
+    get_squared_bounds(orbit_parameters->nominal_angular_momentum,
+            anc_qa_thresholds->angular_momentum_tolerance,
+            &work.min_ang_momentum_sq, &work.max_ang_momentum_sq);
+    get_squared_bounds(orbit_parameters->nominal_orbit_radius * 1000.0,
+            anc_qa_thresholds->orbit_radius_tolerance,
+            &work.min_orbit_radius_sq, &work.max_orbit_radius_sq);
+    work.ephemeris_seconds = ephemeris_seconds_since_j2000;
+    work.eci_pos = eci_pos;
+    work.eci_vel = eci_vel;
+
+    work.record_pos = malloc(sizeof(*work.record_pos) * record_count);
+    work.record_vel = malloc(sizeof(*work.record_vel) * record_count);
+    work.valid = malloc(sizeof(*work.valid) * record_count);
+    work.range_valid_count = malloc(sizeof(*work.range_valid_count)
+            * work.range_count);
+    work.range_offset = malloc(sizeof(*work.range_offset) * work.range_count);
+    if (work.record_pos == NULL || work.record_vel == NULL
+            || work.valid == NULL || work.range_valid_count == NULL
+            || work.range_offset == NULL
+            || IAS_THREAD_CREATE_MUTEX(&work.range_mutex) != 0)
+    {
+        IAS_LOG_ERROR("Setting up the screening of %d ephemeris records",
+                record_count);
+        free(work.record_pos);
+        free(work.record_vel);
+        free(work.valid);
+        free(work.range_valid_count);
+        free(work.range_offset);
+        return ERROR;
+    }
+
+    /* Log start of ephemeris check in log */
+    IAS_LOG_DEBUG("Identifying ephemeris outliers");
+    work.next_range = 0;
+    if (ias_threadpool_run_function(pool, transform_and_check_records, &work)
+            != SUCCESS)
+    {
+        IAS_LOG_ERROR("Checking the ephemeris records");
+        IAS_THREAD_DESTROY_MUTEX(&work.range_mutex);
+        free(work.record_pos);
+        free(work.record_vel);
+        free(work.valid);
+        free(work.range_valid_count);
+        free(work.range_offset);
+        return ERROR;
+    }
+
+    /* The valid records of a range follow those of the ranges before it */
+    valid_count = 0;
+    for (range = 0; range < work.range_count; range++)
+    {
+        work.range_offset[range] = valid_count;
+        valid_count += work.range_valid_count[range];
+    }
+
+    work.next_range = 0;
+    if (ias_threadpool_run_function(pool, compact_records, &work) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Compacting the valid ephemeris records");
+        IAS_THREAD_DESTROY_MUTEX(&work.range_mutex);
+        free(work.record_pos);
+        free(work.record_vel);
+        free(work.valid);
+        free(work.range_valid_count);
+        free(work.range_offset);
+        return ERROR;
+    }
+
+#if DEBUG_GENERATE_DATA_FILES == 1
+    ofp = fopen("ecef.vectors.dat", "w");
+#endif
+    for (index = 0; index < record_count; index++)
+    {
+        const IAS_L0R_EPHEMERIS *record = &l0r_ephemeris[first_record + index];
+        const IAS_VECTOR *ecef_pos = &record->ecef_position_meters;
+        const IAS_VECTOR *ecef_vel = &record->ecef_velocity_meters_per_sec;
+
+        if (work.valid[index] == 0.0)
+        {
+            IAS_LOG_DEBUG("Eliminated Ephemeris outlier index:%d x pos:%f "
+                         "y pos:%f z pos:%f x vel:%f y vel:%f z vel:%f",
+                         first_record + index,
+                         ecef_pos->x, ecef_pos->y, ecef_pos->z,
+                         ecef_vel->x, ecef_vel->y, ecef_vel->z);
+        }
+#if DEBUG_GENERATE_DATA_FILES == 1
+        else
+        {
+            double ecef2eci_time[3];
+
+            ias_math_time_system_convert_j2000_seconds_to_year_doy_sod(
+                &earth_orientation->time_system,
+                IAS_L0R_CONVERT_TIME_TO_SECONDS_SINCE_J2000(record->l0r_time),
+                ecef2eci_time);
+            fprintf(ofp,
+                "%d %f %f %f %e %e %e %e %e %e\n",
+                first_record + index,
+                ecef2eci_time[0], ecef2eci_time[1], ecef2eci_time[2],
+                ecef_pos->x, ecef_pos->y, ecef_pos->z,
+                ecef_vel->x, ecef_vel->y, ecef_vel->z);
+        }
+#endif
+    }
+#if DEBUG_GENERATE_DATA_FILES == 1
+    fclose(ofp);
+#endif
+
+    IAS_THREAD_DESTROY_MUTEX(&work.range_mutex);
+    free(work.record_pos);
+    free(work.record_vel);
+    free(work.valid);
+    free(work.range_valid_count);
+    free(work.range_offset);
+
+    *valid_ephemeris_count = valid_count;
+
+    return SUCCESS;
+}
@@ -19,6 +19,7 @@ RETURN VALUE: Type = int
 #include "ias_cpf.h"
 #include "ias_math.h"
 #include "ias_geo.h"
+#include "ias_threadpool.h"
 #include "ias_ancillary_private.h"
 
 #define ERROR_MSG_MEMORY "Allocating memory for %s"
@@ -612,33 +613,24 @@ int ias_ancillary_smooth_ephemeris_for_MWD
     IAS_VECTOR *smoothed_eph_vel,       /* O: array of smoothed ephemeris
                                              velocity data */
     double *ephemeris_start_time,		/* O: first valid ephemeris data time */
-    double *ephemeris_end_time			/* O: last valid ephemeris data time */
+    double *ephemeris_end_time,			/* O: last valid ephemeris data time */
+    IAS_MATH_TIME_SYSTEM *time_system  /* O: time system of the ephemeris
+                                             span */
 )
 {
     /* variables for counters and loop control */
-    int max_lagrange_start_index;
     int eph_index;
-    int eph_count;
-    int lagrange_start_index;
 
     int number_of_eph_points;    /* number of ephemeris points */
     int valid_eph_count;         /* number of valid ephemeris points */
     int invalid_eph_count;       /* number of bad ephemeris points */
     int first_valid_record;      /* the first valid ephemeris record */
     int last_valid_record;       /* the last valid ephemeris record */
+    int thread_count;            /* number of preprocessing threads */
+    int status;                  /* resampling status */
 
     double current_seconds;      /* current seconds time */
     double epoch_time[3];        /* ephemeris time year, DOY, SOD */
-    double ecef2eci_time[3];     /* ephemeris time year, DOY, SOD, for the
-                                    ecef2eci conversion */
-    double mag_of_ang_momentum;  /* magnitude of angular momentum */
-    double orbit_radius;         /* orbital radius of satellite */
-    double lagrange_stop_time;   /* Lagrange interpolation time */
-    double pole_wander_x;        /* X shift pole wander */
-    double pole_wander_y;        /* Y shift pole wander */
-    double ut1_utc_correction;   /* ut1-utc coord time difference */
-    double modified_julian_date; /* modified Julian date */
-    double nom_orbit_radius_in_meters; /* nominal orbit radius in meters */
     double delta_time;           /* Ephemeris propagation time step */
     double acceleration_x;       /* Propagation gravitational acceleration */
     double acceleration_y;       /* terms for x, y, and z directions */
@@ -647,11 +639,11 @@ int ias_ancillary_smooth_ephemeris_for_MWD
 
     IAS_VECTOR *eci_pos = NULL;  /* ephemeris position data in ECI */
     IAS_VECTOR *eci_vel = NULL;  /* ephemeris velocity data in ECI */
-    const IAS_VECTOR *ecef_pos = NULL; /* ephemeris position data in ECEF */
-    const IAS_VECTOR *ecef_vel = NULL; /* ephemeris velocity data in ECEF */
     IAS_VECTOR *raw_pos = NULL;  /* interpolated ephemeris position data */
     IAS_VECTOR *raw_vel = NULL;  /* interpolated ephemeris velocity data */
-    IAS_VECTOR momentum_vector;  /* angular momentum vector for qc check */
+    IAS_GEO_EARTH_ORIENTATION_CACHE *earth_orientation = NULL;
+                                 /* ECEF to J2000 rotation over the records */
+    struct ias_threadpool *pool = NULL; /* ephemeris preprocessing threads */
 
     const struct IAS_CPF_ORBIT_PARAMETERS *orbit_parameters = NULL;
         /* CPF parameters for the orbit parameters */
@@ -672,10 +664,6 @@ int ias_ancillary_smooth_ephemeris_for_MWD
         return ERROR;
     }
 
-    /* convert the radius to meters so that the multiplications are reduced */
-    nom_orbit_radius_in_meters =
-        orbit_parameters->nominal_orbit_radius * 1000.0;
-
     /* get the QA thresholds from the cpf */
     anc_qa_thresholds = ias_cpf_get_ancil_qa_thresholds(cpf);
     if (anc_qa_thresholds == NULL)
@@ -801,25 +789,6 @@ int ias_ancillary_smooth_ephemeris_for_MWD
 //            return ERROR;
 //        }
 //    }
-    ///////////////////////////////////////////////////////////////
-    //added by LYL at 2014/3/6
-    if (ias_math_init_leap_seconds(current_seconds, &earth_constants->leap_seconds_data))
-	{
-		IAS_LOG_ERROR("Init leap seconds");
-		ias_cpf_free(cpf);
-		exit(EXIT_FAILURE);
-	}
-
-
-
-    if (ias_math_convert_j2000_seconds_to_year_doy_sod(
-            current_seconds, epoch_time) != SUCCESS)
-    {
-        IAS_LOG_ERROR("Converting J2000 seconds %lf to Year, DOY, SOD format",
-                      current_seconds);
-        return ERROR;
-    }
-
     current_seconds = IAS_L0R_CONVERT_TIME_TO_SECONDS_SINCE_J2000(
         l0r_ephemeris[last_valid_record].l0r_time);
 
@@ -830,6 +799,24 @@ int ias_ancillary_smooth_ephemeris_for_MWD
     *ephemeris_end_time = current_seconds;
     IAS_LOG_DEBUG("Upper bounds on ephemeris time %lf", current_seconds);
 
+    /* The leap seconds and Earth orientation of the ephemeris span are kept
+       in its own time system rather than in the process-wide leap seconds,
+       so several spans can be processed at once */
+    if (ias_geo_init_time_system(cpf, *ephemeris_start_time,
+            *ephemeris_end_time, time_system) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Initializing the ephemeris time system");
+        return ERROR;
+    }
+
+    if (ias_math_time_system_convert_j2000_seconds_to_year_doy_sod(
+            time_system, *ephemeris_start_time, epoch_time) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Converting J2000 seconds %lf to Year, DOY, SOD format",
+                      *ephemeris_start_time);
+        return ERROR;
+    }
+
 //    if (interval_stop > current_seconds)
 //    {
 //        IAS_LOG_WARNING("Scene time %lf ends after end of ephemeris time %lf",
@@ -890,11 +877,14 @@ int ias_ancillary_smooth_ephemeris_for_MWD
         return ERROR;
     }
 
-    /* get x and y shift pole wander and UT1-UTC time difference */
-    if (ias_geo_compute_getmjdcoords(epoch_time, cpf, &modified_julian_date,
-            &pole_wander_x, &pole_wander_y, &ut1_utc_correction) == ERROR)
+    /* The Earth orientation is computed on a coarse grid over the records
+       instead of for every record */
+    earth_orientation = ias_geo_create_earth_orientation_cache(time_system,
+            *ephemeris_start_time, *ephemeris_end_time,
+            IAS_GEO_EARTH_ORIENTATION_SPACING);
+    if (earth_orientation == NULL)
     {
-        IAS_LOG_ERROR("Establishing Earth Model");
+        IAS_LOG_ERROR("Establishing Earth orientation");
         free(eci_pos);
         free(eci_vel);
         free(raw_pos);
@@ -902,98 +892,52 @@ int ias_ancillary_smooth_ephemeris_for_MWD
         return ERROR;
     }
 
-#if DEBUG_GENERATE_DATA_FILES == 1
-    ofp = fopen("ecef.vectors.dat", "w");
-#endif
-
-    /* Log start of ephemeris check in log */
-    IAS_LOG_DEBUG("Identifying ephemeris outliers");
-    valid_eph_count = 0;
-    invalid_eph_count = 0;
-    for (eph_index = first_valid_record;
-         eph_index <= last_valid_record;
-         eph_index++)
+    /* Data-parallel screening of the records for outliers */
+    thread_count = (last_valid_record - first_valid_record + 1)
+        / IAS_ANCILLARY_RECORDS_PER_THREAD;
+    if (thread_count > IAS_THREAD_GET_NUM_PROCESSORS())
+        thread_count = IAS_THREAD_GET_NUM_PROCESSORS();
+    if (thread_count > IAS_ANCILLARY_EPHEMERIS_THREADS)
+        thread_count = IAS_ANCILLARY_EPHEMERIS_THREADS;
+    if (thread_count < 2)
+        thread_count = 0;
+
+    pool = ias_threadpool_initialize(thread_count);
+    if (pool == NULL)
     {
-        /* Perform angular momentum check */
-        ecef_pos = &l0r_ephemeris[eph_index].ecef_position_meters;
-        ecef_vel = &l0r_ephemeris[eph_index].ecef_velocity_meters_per_sec;
-        smoothed_ephemeris_seconds_since_j2000[valid_eph_count]
-            = IAS_L0R_CONVERT_TIME_TO_SECONDS_SINCE_J2000(
-                l0r_ephemeris[eph_index].l0r_time);
-
-        /* Get the Year, DOY, and SOD for the eci value to generate. */
-        if (ias_math_convert_j2000_seconds_to_year_doy_sod(
-                smoothed_ephemeris_seconds_since_j2000[valid_eph_count],
-                ecef2eci_time) != SUCCESS)
-        {
-            IAS_LOG_ERROR("Converting J2000 seconds %lf to Year, DOY, SOD"
-                " format",
-                smoothed_ephemeris_seconds_since_j2000[valid_eph_count]);
-            free(eci_pos);
-            free(eci_vel);
-            free(raw_pos);
-            free(raw_vel);
-            return ERROR;
-        }
-
-        /* Convert to inertial for angular momentum checks */
-        if (ias_geo_transform_ecef2j2k(pole_wander_x, pole_wander_y,
-                ut1_utc_correction, ecef_pos, ecef_vel, ecef2eci_time,
-                &eci_pos[valid_eph_count], &eci_vel[valid_eph_count])
-                != SUCCESS)
-        {
-            IAS_LOG_ERROR("Converting ECEF coordinate to ECI J2000");
-            free(eci_pos);
-            free(eci_vel);
-            free(raw_pos);
-            free(raw_vel);
-            return ERROR;
-        }
-
-        ias_math_compute_3dvec_cross(&eci_pos[valid_eph_count],
-            &eci_vel[valid_eph_count], &momentum_vector);
-        mag_of_ang_momentum = ias_math_compute_vector_length(&momentum_vector);
-
-        /* Perform orbital radius check */
-        orbit_radius = ias_math_compute_vector_length(
-            &eci_pos[valid_eph_count]);
-
-        if (fabs(mag_of_ang_momentum
-                 - orbit_parameters->nominal_angular_momentum)
-                <= anc_qa_thresholds->angular_momentum_tolerance
-            && /* both conditions must be met */
-            fabs(orbit_radius - nom_orbit_radius_in_meters)
-                <= anc_qa_thresholds->orbit_radius_tolerance)
-        {
-            /* If angular momentum and orbital radius check out, increment the
-               count of valid ephemeris points */
+        IAS_LOG_ERROR("Creating the ephemeris preprocessing threads");
+        ias_geo_free_earth_orientation_cache(earth_orientation);
+        free(eci_pos);
+        free(eci_vel);
+        free(raw_pos);
+        free(raw_vel);
+        return ERROR;
+    }
 
-#if DEBUG_GENERATE_DATA_FILES == 1
-            fprintf(ofp,
-                "%d %f %f %f %e %e %e %e %e %e\n",
-                eph_index,
-                ecef2eci_time[0], ecef2eci_time[1], ecef2eci_time[2],
-                ecef_pos->x, ecef_pos->y, ecef_pos->z,
-                ecef_vel->x, ecef_vel->y, ecef_vel->z);
-#endif
-            /* Increment to the next save position in the arrays. */
-            valid_eph_count++;
-        }
-        else
-        {
-            IAS_LOG_DEBUG("Eliminated Ephemeris outlier index:%d x pos:%f "
-                         "y pos:%f z pos:%f x vel:%f y vel:%f z vel:%f",
-                         eph_index,
-                         ecef_pos->x, ecef_pos->y, ecef_pos->z,
-                         ecef_vel->x, ecef_vel->y, ecef_vel->z);
-            invalid_eph_count++;
-        }
+    if (ias_ancillary_screen_ephemeris(pool, earth_orientation,
+            orbit_parameters, anc_qa_thresholds, l0r_ephemeris,
+            first_valid_record, last_valid_record - first_valid_record + 1,
+            &valid_eph_count, smoothed_ephemeris_seconds_since_j2000,
+            eci_pos, eci_vel) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Identifying ephemeris outliers");
+        ias_threadpool_destroy(pool);
+        ias_geo_free_earth_orientation_cache(earth_orientation);
+        free(eci_pos);
+        free(eci_vel);
+        free(raw_pos);
+        free(raw_vel);
+        return ERROR;
     }
+    invalid_eph_count = last_valid_record - first_valid_record + 1
+        - valid_eph_count;
+    ias_geo_free_earth_orientation_cache(earth_orientation);
 
     /* Exit if no valid ephemeris points were found */
     if (valid_eph_count < 1)
     {
         IAS_LOG_ERROR("No valid ephemeris points were found.");
+        ias_threadpool_destroy(pool);
         free(eci_pos);
         free(eci_vel);
         free(raw_pos);
@@ -1057,8 +1001,6 @@ int ias_ancillary_smooth_ephemeris_for_MWD
     }
 
 #if DEBUG_GENERATE_DATA_FILES == 1
-    fclose(ofp);
-
     ofp = fopen("eci.vectors.dat", "w");
 
     for (eph_index = 0; eph_index < valid_eph_count; eph_index++)
@@ -1082,6 +1024,7 @@ int ias_ancillary_smooth_ephemeris_for_MWD
             != SUCCESS)
     {
         IAS_LOG_ERROR("Smoothing ephemeris time");
+        ias_threadpool_destroy(pool);
         free(eci_pos);
         free(eci_vel);
         free(raw_pos);
@@ -1089,51 +1032,24 @@ int ias_ancillary_smooth_ephemeris_for_MWD
         return ERROR;
     }
 
-    /* Loop over all the smoothed time stamps to interpolate the ephemeris info
-       at that time, stopping when the full time span is covered or until all
-       the array entries are filled.  At a minimum, the ephemeris count needs
-       to reach IAS_LAGRANGE_PTS. */
-    lagrange_stop_time = smoothed_ephemeris_seconds_since_j2000[0];
-    eph_count = 0;
-    max_lagrange_start_index = number_of_eph_points - IAS_LAGRANGE_PTS;
-    lagrange_start_index = 0;
-    while ((lagrange_stop_time <=
-           smoothed_ephemeris_seconds_since_j2000[number_of_eph_points - 1]
-            || eph_count < IAS_LAGRANGE_PTS)
-           && eph_count < number_of_eph_points)
+    /* Interpolate the ephemeris info at evenly spaced time stamps over the
+       full time span, or until all the array entries are filled.  At a
+       minimum, the ephemeris count needs to reach IAS_LAGRANGE_PTS. */
+    status = ias_ancillary_resample_ephemeris(pool,
+            smoothed_ephemeris_seconds_since_j2000, eci_pos, eci_vel,
+            number_of_eph_points, IAS_EPHEM_SAMPLING_PERIOD,
+            number_of_eph_points, &valid_eph_count, raw_pos, raw_vel);
+    ias_threadpool_destroy(pool);
+    pool = NULL;
+    if (status != SUCCESS)
     {
-        /* Find Lagrange interpolation start index */
-        while ((lagrange_start_index < number_of_eph_points) &&
-               (smoothed_ephemeris_seconds_since_j2000[lagrange_start_index]
-                <= lagrange_stop_time))
-        {
-            lagrange_start_index++;
-        }
-
-        lagrange_start_index -= IAS_LAGRANGE_PTS / 2;
-
-        if (lagrange_start_index < 0)
-            lagrange_start_index = 0;
-
-        if (lagrange_start_index > max_lagrange_start_index)
-            lagrange_start_index = max_lagrange_start_index;
-
-        /* Interpolate position and velocity vector using Lagrange
-           interpolation. */
-        ias_geo_lagrange_interpolate(
-                 &smoothed_ephemeris_seconds_since_j2000[lagrange_start_index],
-                 &eci_pos[lagrange_start_index],
-                 &eci_vel[lagrange_start_index],
-                 IAS_LAGRANGE_PTS,
-                 lagrange_stop_time,
-                 &raw_pos[eph_count],
-                 &raw_vel[eph_count]);
-
-        lagrange_stop_time += IAS_EPHEM_SAMPLING_PERIOD;
-
-        eph_count++;
+        IAS_LOG_ERROR("Resampling ephemeris");
+        free(eci_pos);
+        free(eci_vel);
+        free(raw_pos);
+        free(raw_vel);
+        return ERROR;
     }
-    valid_eph_count = eph_count;
 
     /* free memory no longer used */
     free(eci_pos);
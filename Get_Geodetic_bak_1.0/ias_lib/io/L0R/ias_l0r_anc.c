@@ -7812,3 +7812,655 @@ int ias_l0r_get_ancillary_oli_tirs_temperature_records_count
 }
 
 
+
+/*******************************************************************************
+* Ancillary field projection routines
+*  read selected fields of a table into one array per field
+*******************************************************************************/
+/* Alignment of the fields in the projected records */
+#define PROJECTION_FIELD_ALIGNMENT 8
+
+/* Description of a table used to resolve the field names of a projection */
+typedef struct ANCILLARY_TABLE_INFO
+{
+    IAS_L0R_ANCILLARY_TABLE table; /* table described, checks the order */
+    const char *table_name;        /* path of the table in the file */
+    int field_count;               /* number of fields of the table */
+    const char **field_names;      /* names of the fields */
+    const size_t *field_sizes;     /* sizes of the fields in memory */
+} ANCILLARY_TABLE_INFO;
+
+/* Tables in the order of IAS_L0R_ANCILLARY_TABLE */
+static const ANCILLARY_TABLE_INFO ancillary_tables[] =
+{
+    {IAS_L0R_ANCILLARY_ATTITUDE,
+        GROUP_NAME_SPACECRAFT"/"GROUP_NAME_ACS"/"TABLE_NAME_ATTITUDE,
+        TABLE_SIZE_ATTITUDE, FIELD_NAMES_ATTITUDE, IAS_L0R_ATTITUDE_SIZES},
+    {IAS_L0R_ANCILLARY_ATTITUDE_FILTER,
+        GROUP_NAME_SPACECRAFT"/"GROUP_NAME_ACS"/"TABLE_NAME_ATTITUDE_FILTER,
+        TABLE_SIZE_ATTITUDE_FILTER, FIELD_NAMES_ATTITUDE_FILTER,
+        IAS_L0R_ATTITUDE_FILTER_SIZES},
+    {IAS_L0R_ANCILLARY_EPHEMERIS,
+        GROUP_NAME_SPACECRAFT"/"TABLE_NAME_EPHEMERIS,
+        TABLE_SIZE_EPHEMERIS, FIELD_NAMES_EPHEMERIS, IAS_L0R_EPHEMERIS_SIZES},
+    {IAS_L0R_ANCILLARY_GPS_POSITION,
+        GROUP_NAME_SPACECRAFT"/"TABLE_NAME_GPS_POSITION,
+        TABLE_SIZE_GPS_POSITION, FIELD_NAMES_GPS_POSITION, IAS_L0R_GPS_SIZES},
+    {IAS_L0R_ANCILLARY_GPS_RANGE,
+        GROUP_NAME_SPACECRAFT"/"TABLE_NAME_GPS_RANGE,
+        TABLE_SIZE_GPS_RANGE, FIELD_NAMES_GPS_RANGE, IAS_L0R_GPS_RANGE_SIZES},
+    {IAS_L0R_ANCILLARY_IMU,
+        GROUP_NAME_SPACECRAFT"/"GROUP_NAME_IMU"/"TABLE_NAME_IMU,
+        TABLE_SIZE_IMU, field_names_imu, IAS_L0R_IMU_SIZES},
+    {IAS_L0R_ANCILLARY_IMU_LATENCY,
+        GROUP_NAME_SPACECRAFT"/"GROUP_NAME_IMU"/"TABLE_NAME_IMU_LATENCY,
+        TABLE_SIZE_IMU_LATENCY, field_names_imu_latency,
+        IAS_L0R_IMU_LATENCY_SIZES},
+    {IAS_L0R_ANCILLARY_OLI_TELEMETRY_GROUP_3,
+        GROUP_NAME_TELEMETRY"/"GROUP_NAME_OLI"/"
+        TABLE_NAME_OLI_TELEMETRY_GROUP_3,
+        TABLE_SIZE_TELEMETRY_GROUP_3, FIELD_NAMES_TELEMETRY_GROUP_3,
+        IAS_L0R_OLI_TELEMETRY_GROUP_3_SIZES},
+    {IAS_L0R_ANCILLARY_OLI_TELEMETRY_GROUP_4,
+        GROUP_NAME_TELEMETRY"/"GROUP_NAME_OLI"/"
+        TABLE_NAME_OLI_TELEMETRY_GROUP_4,
+        TABLE_SIZE_TELEMETRY_GROUP_4, FIELD_NAMES_PAYLOAD_OLI_GROUP_4,
+        IAS_L0R_OLI_TELEMETRY_GROUP_4_SIZES},
+    {IAS_L0R_ANCILLARY_OLI_TELEMETRY_GROUP_5,
+        GROUP_NAME_TELEMETRY"/"GROUP_NAME_OLI"/"
+        TABLE_NAME_OLI_TELEMETRY_GROUP_5,
+        TABLE_SIZE_TELEMETRY_GROUP_5, FIELD_NAMES_PAYLOAD_OLI_GROUP_5,
+        IAS_L0R_OLI_TELEMETRY_GROUP_5_SIZES},
+    {IAS_L0R_ANCILLARY_TIRS_TELEMETRY,
+        GROUP_NAME_TELEMETRY"/"GROUP_NAME_TIRS"/"TABLE_NAME_TIRS_TELEMETRY,
+        TABLE_SIZE_TIRS_TELEMETRY, FIELD_NAMES_TIRS_TELEMETRY,
+        IAS_L0R_TIRS_TELEMETRY_SIZES},
+    {IAS_L0R_ANCILLARY_STAR_TRACKER_CENTROID,
+        GROUP_NAME_SPACECRAFT"/"TABLE_NAME_STAR_TRACKER_CENTROID,
+        TABLE_SIZE_STAR_TRACKER_CENTROID, field_names_star_tracker_centroid,
+        IAS_L0R_STAR_TRACKER_CENTROID_SIZES},
+    {IAS_L0R_ANCILLARY_STAR_TRACKER_QUATERNION,
+        GROUP_NAME_SPACECRAFT"/"TABLE_NAME_STAR_TRACKER_QUATERNION,
+        TABLE_SIZE_STAR_TRACKER_QUATERNION,
+        field_names_star_tracker_quaternion,
+        IAS_L0R_STAR_TRACKER_QUATERNION_SIZES},
+    {IAS_L0R_ANCILLARY_GYRO_TEMPERATURE,
+        GROUP_NAME_SPACECRAFT"/"GROUP_NAME_TEMPERATURES"/"
+        TABLE_NAME_TEMPERATURES_GYRO,
+        TABLE_SIZE_TEMPERATURES_GYRO, field_names_temperatures_gyro,
+        IAS_L0R_GYRO_TEMPERATURE_SIZES},
+    {IAS_L0R_ANCILLARY_OLI_TIRS_TEMPERATURE,
+        GROUP_NAME_SPACECRAFT"/"GROUP_NAME_TEMPERATURES"/"
+        TABLE_NAME_TEMPERATURES_OLI_TIRS,
+        TABLE_SIZE_TEMPERATURES_OLI_TIRS, field_names_temperatures_oli_tirs,
+        IAS_L0R_OLI_TIRS_TEMPERATURE_SIZES}
+};
+
+/* Selected fields of a table and their layout in the projected records */
+typedef struct ANCILLARY_PROJECTION
+{
+    const ANCILLARY_TABLE_INFO *info; /* table the fields are read from */
+    int field_count;       /* number of fields selected */
+    int *field_index;      /* index of each field in the table */
+    size_t *field_size;    /* size of each field in memory */
+    size_t *field_offset;  /* offset of each field in a projected record */
+    size_t record_size;    /* size of a projected record */
+} ANCILLARY_PROJECTION;
+
+struct ias_l0r_ancillary_cursor
+{
+    L0RIO *l0r;                       /* file the records are read from */
+    ANCILLARY_PROJECTION projection;  /* fields read */
+    int records_per_read;             /* maximum number of records per read */
+    int next_record;                  /* first record of the next read */
+    int record_count;                 /* records in the table */
+    unsigned char *records;           /* projected records of a read */
+};
+
+/******************************************************************************
+ NAME: ias_l0r_find_ancillary_table
+
+ PURPOSE: Looks up the description of an ancillary table
+
+ RETURNS: Pointer to the description, NULL if the table is not known
+******************************************************************************/
+static const ANCILLARY_TABLE_INFO *ias_l0r_find_ancillary_table
+(
+    const IAS_L0R_ANCILLARY_TABLE table /* I: table to look up */
+)
+{
+    if (table < 0 || table >= IAS_L0R_ANCILLARY_TABLE_COUNT
+        || (size_t)table >= sizeof(ancillary_tables)
+            / sizeof(ancillary_tables[0])
+        || ancillary_tables[table].table != table)
+    {
+        IAS_LOG_ERROR("Unknown ancillary table %d", table);
+        return NULL;
+    }
+
+    return &ancillary_tables[table];
+}
+
+/******************************************************************************
+ NAME: ias_l0r_find_ancillary_field
+
+ PURPOSE: Looks up a field of an ancillary table by name
+
+ RETURNS: Index of the field in the table, -1 if the table has no such field
+******************************************************************************/
+static int ias_l0r_find_ancillary_field
+(
+    const ANCILLARY_TABLE_INFO *info, /* I: table to search */
+    const char *field_name            /* I: name of the field */
+)
+{
+    int index;
+
+    for (index = 0; index < info->field_count; index++)
+    {
+        if (strcmp(info->field_names[index], field_name) == 0)
+            return index;
+    }
+
+    return -1;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_free_ancillary_projection
+
+ PURPOSE: Frees the arrays of a projection
+******************************************************************************/
+static void ias_l0r_free_ancillary_projection
+(
+    ANCILLARY_PROJECTION *projection /* I/O: projection to free */
+)
+{
+    free(projection->field_index);
+    free(projection->field_size);
+    free(projection->field_offset);
+    projection->field_index = NULL;
+    projection->field_size = NULL;
+    projection->field_offset = NULL;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_init_ancillary_projection
+
+ PURPOSE: Resolves the names of the fields selected and lays them out in a
+          projected record, each field aligned to PROJECTION_FIELD_ALIGNMENT
+          bytes.
+
+ RETURNS: SUCCESS- The projection was set up
+          ERROR- A field is not in the table or memory was not available
+******************************************************************************/
+static int ias_l0r_init_ancillary_projection
+(
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to read */
+    const int field_count,        /* I: number of fields to read */
+    const char **field_names,     /* I: names of the fields to read */
+    ANCILLARY_PROJECTION *projection /* O: fields and their layout */
+)
+{
+    int index;
+
+    memset(projection, 0, sizeof(*projection));
+
+    projection->info = ias_l0r_find_ancillary_table(table);
+    if (projection->info == NULL)
+        return ERROR;
+
+    if (field_count < 1 || field_names == NULL)
+    {
+        IAS_LOG_ERROR("No fields requested from %s",
+            projection->info->table_name);
+        return ERROR;
+    }
+
+    projection->field_index = malloc(field_count
+        * sizeof(*projection->field_index));
+    projection->field_size = malloc(field_count
+        * sizeof(*projection->field_size));
+    projection->field_offset = malloc(field_count
+        * sizeof(*projection->field_offset));
+    if (projection->field_index == NULL || projection->field_size == NULL
+        || projection->field_offset == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the projection of %s",
+            projection->info->table_name);
+        ias_l0r_free_ancillary_projection(projection);
+        return ERROR;
+    }
+    projection->field_count = field_count;
+
+    for (index = 0; index < field_count; index++)
+    {
+        int field = ias_l0r_find_ancillary_field(projection->info,
+            field_names[index]);
+        if (field < 0)
+        {
+            IAS_LOG_ERROR("Table %s has no field %s",
+                projection->info->table_name, field_names[index]);
+            ias_l0r_free_ancillary_projection(projection);
+            return ERROR;
+        }
+
+        projection->field_index[index] = field;
+        projection->field_size[index] = projection->info->field_sizes[field];
+        projection->field_offset[index] = projection->record_size;
+        projection->record_size += (projection->field_size[index]
+            + PROJECTION_FIELD_ALIGNMENT - 1)
+            / PROJECTION_FIELD_ALIGNMENT * PROJECTION_FIELD_ALIGNMENT;
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_anc_read_fields
+
+ PURPOSE: Reads the fields of a projection from a range of records with a
+          single HDF5 call and copies each field to its column.  A single
+          field is read straight into its column.
+
+ RETURNS: SUCCESS- The columns were filled
+          ERROR- The records could not be read
+******************************************************************************/
+static int ias_l0r_anc_read_fields
+(
+    HDFIO *hdfio_ptr,             /* I: structure for the file used in I/O */
+    const ANCILLARY_PROJECTION *projection, /* I: fields to read */
+    const int index,              /* I: first record */
+    const int count,              /* I: number of records */
+    unsigned char *records,       /* I/O: room for count projected records,
+                                          not used for a single field */
+    void **columns                /* O: one array of count values per field */
+)
+{
+    herr_t hdf_status;
+    int field;
+    int record;
+
+    if (projection->field_count == 1)
+    {
+        size_t offset = 0;
+
+        hdf_status = H5TBread_fields_index(hdfio_ptr->file_id_ancillary,
+            projection->info->table_name, 1, projection->field_index,
+            index, count, projection->field_size[0], &offset,
+            projection->field_size, columns[0]);
+        if (hdf_status < 0)
+        {
+            IAS_LOG_ERROR("Error reading from %s",
+                projection->info->table_name);
+            return ERROR;
+        }
+        return SUCCESS;
+    }
+
+    hdf_status = H5TBread_fields_index(hdfio_ptr->file_id_ancillary,
+        projection->info->table_name, projection->field_count,
+        projection->field_index, index, count, projection->record_size,
+        projection->field_offset, projection->field_size, records);
+    if (hdf_status < 0)
+    {
+        IAS_LOG_ERROR("Error reading from %s", projection->info->table_name);
+        return ERROR;
+    }
+
+    for (field = 0; field < projection->field_count; field++)
+    {
+        size_t size = projection->field_size[field];
+        const unsigned char *source = records + projection->field_offset[field];
+        unsigned char *column = columns[field];
+
+        for (record = 0; record < count; record++)
+        {
+            memcpy(column, source, size);
+            column += size;
+            source += projection->record_size;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_establish_ancillary_read
+
+ PURPOSE: Checks the ancillary data is open and gets the number of records
+          of a table
+
+ RETURNS: SUCCESS- The table can be read
+          ERROR- The ancillary data is not open or the table is missing
+******************************************************************************/
+static int ias_l0r_establish_ancillary_read
+(
+    L0RIO *l0r,              /* I: structure for the file used in I/O */
+    const char *table_name,  /* I: table to read */
+    int *record_count        /* O: number of records in the table */
+)
+{
+    HDFIO *hdfio_ptr = l0r;
+
+    if (l0r == NULL)
+    {
+        IAS_LOG_ERROR("Error NULL pointer received");
+        return ERROR;
+    }
+
+    if (hdfio_ptr->access_mode_ancillary < 0)
+    {
+        IAS_LOG_ERROR("Ancillary data is not open");
+        return ERROR;
+    }
+
+    if (ias_l0r_establish_ancillary_file(hdfio_ptr, FALSE) < 0
+        || hdfio_ptr->file_id_ancillary <= 0)
+    {
+        IAS_LOG_ERROR("Error establish file for read");
+        return ERROR;
+    }
+
+    if (ias_l0r_get_anc_table_records_count(hdfio_ptr, table_name,
+         record_count) == ERROR)
+    {
+        IAS_LOG_ERROR("Unable to get size of %s", table_name);
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_get_ancillary_field_size
+
+ PURPOSE: Gets the size in memory of a field of an ancillary table, which is
+          the size of each value of its column in ias_l0r_get_ancillary_fields
+
+ RETURNS: SUCCESS- The size was found
+          ERROR- The table has no such field
+******************************************************************************/
+int ias_l0r_get_ancillary_field_size
+(
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table of the field */
+    const char *field_name,       /* I: name of the field */
+    size_t *size                  /* O: size of a value of the field */
+)
+{
+    const ANCILLARY_TABLE_INFO *info;
+    int field;
+
+    info = ias_l0r_find_ancillary_table(table);
+    if (info == NULL)
+        return ERROR;
+
+    field = ias_l0r_find_ancillary_field(info, field_name);
+    if (field < 0)
+    {
+        IAS_LOG_ERROR("Table %s has no field %s", info->table_name,
+            field_name);
+        return ERROR;
+    }
+
+    *size = info->field_sizes[field];
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_get_ancillary_table_fields
+
+ PURPOSE: Gets the names of all the fields of an ancillary table, in the
+          order of the table
+
+ RETURNS: SUCCESS- The names were found
+          ERROR- The table is not known
+******************************************************************************/
+int ias_l0r_get_ancillary_table_fields
+(
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to describe */
+    int *field_count,             /* O: number of fields of the table */
+    const char ***field_names     /* O: names of the fields, not to be
+                                        freed */
+)
+{
+    const ANCILLARY_TABLE_INFO *info;
+
+    info = ias_l0r_find_ancillary_table(table);
+    if (info == NULL)
+        return ERROR;
+
+    *field_count = info->field_count;
+    *field_names = info->field_names;
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_get_ancillary_table_records_count
+
+ PURPOSE: Gets the number of records of an ancillary table
+
+ RETURNS: SUCCESS- Size determined
+          ERROR- Size not able to be determined
+******************************************************************************/
+int ias_l0r_get_ancillary_table_records_count
+(
+    L0RIO *l0r,                   /* I: structure for the file used in I/O */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to count */
+    int *size                     /* O: number of records in the table */
+)
+{
+    const ANCILLARY_TABLE_INFO *info;
+
+    info = ias_l0r_find_ancillary_table(table);
+    if (info == NULL)
+        return ERROR;
+
+    return ias_l0r_establish_ancillary_read(l0r, info->table_name, size);
+}
+
+/******************************************************************************
+ NAME: ias_l0r_get_ancillary_fields
+
+ PURPOSE: Reads selected fields of a range of records of an ancillary table
+          into one array per field.  The fields are named as in the table,
+          e.g. "l0r_time_days_from_J2000", and each value has the size of
+          the member of the record structure it is read into.
+
+ RETURNS: SUCCESS- The columns were filled
+          ERROR- Could not read the fields
+******************************************************************************/
+int ias_l0r_get_ancillary_fields
+(
+    L0RIO *l0r,                   /* I: structure for the file used in I/O */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to read */
+    const int field_count,        /* I: number of fields to read */
+    const char **field_names,     /* I: names of the fields to read */
+    const int index,              /* I: first record */
+    const int count,              /* I: number of records */
+    void **columns                /* O: one array of count values per field */
+)
+{
+    ANCILLARY_PROJECTION projection;
+    unsigned char *records = NULL;
+    int record_count;
+    int status;
+
+    if (ias_l0r_init_ancillary_projection(table, field_count, field_names,
+        &projection) != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    if (ias_l0r_establish_ancillary_read(l0r, projection.info->table_name,
+        &record_count) != SUCCESS)
+    {
+        ias_l0r_free_ancillary_projection(&projection);
+        return ERROR;
+    }
+    if (index < 0 || count < 0 || record_count < (index + count))
+    {
+        IAS_LOG_ERROR("Insufficient records to read from %s"
+            " Attempting to read %d "
+            "records out of %d from %d", projection.info->table_name, count,
+            record_count, index);
+        ias_l0r_free_ancillary_projection(&projection);
+        return ERROR;
+    }
+    if (count == 0)
+    {
+        ias_l0r_free_ancillary_projection(&projection);
+        return SUCCESS;
+    }
+
+    if (field_count > 1)
+    {
+        records = malloc(count * projection.record_size);
+        if (records == NULL)
+        {
+            IAS_LOG_ERROR("Allocating %d records of %s", count,
+                projection.info->table_name);
+            ias_l0r_free_ancillary_projection(&projection);
+            return ERROR;
+        }
+    }
+
+    status = ias_l0r_anc_read_fields(l0r, &projection, index, count,
+        records, columns);
+
+    free(records);
+    ias_l0r_free_ancillary_projection(&projection);
+    return status;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_open_ancillary_cursor
+
+ PURPOSE: Sets up the reading of selected fields of an ancillary table a
+          batch of records at a time, so a large table like the IMU table is
+          never held in memory at once.  The fields are named as in
+          ias_l0r_get_ancillary_fields.
+
+ RETURNS: Pointer to the cursor, NULL on error
+******************************************************************************/
+IAS_L0R_ANCILLARY_CURSOR *ias_l0r_open_ancillary_cursor
+(
+    L0RIO *l0r,                   /* I: structure for the file used in I/O */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to read */
+    const int field_count,        /* I: number of fields to read */
+    const char **field_names,     /* I: names of the fields to read */
+    const int records_per_read    /* I: maximum number of records returned
+                                        by each read */
+)
+{
+    IAS_L0R_ANCILLARY_CURSOR *cursor;
+
+    if (records_per_read < 1)
+    {
+        IAS_LOG_ERROR("Invalid number of records per read %d",
+            records_per_read);
+        return NULL;
+    }
+
+    cursor = calloc(1, sizeof(*cursor));
+    if (cursor == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the ancillary cursor");
+        return NULL;
+    }
+    cursor->l0r = l0r;
+    cursor->records_per_read = records_per_read;
+
+    if (ias_l0r_init_ancillary_projection(table, field_count, field_names,
+        &cursor->projection) != SUCCESS)
+    {
+        free(cursor);
+        return NULL;
+    }
+
+    if (ias_l0r_establish_ancillary_read(l0r,
+        cursor->projection.info->table_name, &cursor->record_count)
+        != SUCCESS)
+    {
+        ias_l0r_close_ancillary_cursor(cursor);
+        return NULL;
+    }
+
+    if (field_count > 1)
+    {
+        cursor->records = malloc(records_per_read
+            * cursor->projection.record_size);
+        if (cursor->records == NULL)
+        {
+            IAS_LOG_ERROR("Allocating %d records of %s", records_per_read,
+                cursor->projection.info->table_name);
+            ias_l0r_close_ancillary_cursor(cursor);
+            return NULL;
+        }
+    }
+
+    return cursor;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_get_next_ancillary_fields
+
+ PURPOSE: Reads the fields of the next batch of records of a cursor
+
+ RETURNS: SUCCESS- The columns were filled, or all the records were read
+          ERROR- Could not read the fields
+******************************************************************************/
+int ias_l0r_get_next_ancillary_fields
+(
+    IAS_L0R_ANCILLARY_CURSOR *cursor, /* I: cursor to advance */
+    void **columns,               /* O: one array per field, with room for
+                                        records_per_read values each */
+    int *index,                   /* O: first record returned */
+    int *records_read             /* O: number of records returned, 0 once
+                                        all the records were returned */
+)
+{
+    int count;
+
+    *index = cursor->next_record;
+    *records_read = 0;
+
+    count = cursor->record_count - cursor->next_record;
+    if (count <= 0)
+        return SUCCESS;
+    if (count > cursor->records_per_read)
+        count = cursor->records_per_read;
+
+    if (ias_l0r_anc_read_fields(cursor->l0r, &cursor->projection,
+        cursor->next_record, count, cursor->records, columns) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Reading %d records from %d", count,
+            cursor->next_record);
+        return ERROR;
+    }
+
+    cursor->next_record += count;
+    *records_read = count;
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_close_ancillary_cursor
+
+ PURPOSE: Frees a cursor.  The ancillary data stays open.
+
+ RETURNS: SUCCESS- The cursor was freed
+******************************************************************************/
+int ias_l0r_close_ancillary_cursor
+(
+    IAS_L0R_ANCILLARY_CURSOR *cursor /* I: cursor to free */
+)
+{
+    if (cursor == NULL)
+        return SUCCESS;
+
+    ias_l0r_free_ancillary_projection(&cursor->projection);
+    free(cursor->records);
+    free(cursor);
+
+    return SUCCESS;
+}
@@ -0,0 +1,535 @@
+/*-----------------------------------------------------------------------------
+
+NAME: ias_l0r_anc_snapshot.c
+
+PURPOSE: Snapshot of the attitude, ephemeris and IMU ancillary tables of an
+         L0R in a flat binary file.  Every field of these tables is saved as
+         a column of values, so a process working on the same L0R many times
+         maps the snapshot and uses the columns in place instead of reading
+         and decoding the HDF5 tables each time.
+
+ALGORITHM REFERENCES: NONE
+
+NOTES: The snapshot file is a header, a directory of the columns, and the
+       values of each column, each column aligned to
+       SNAPSHOT_COLUMN_ALIGNMENT bytes.  The values are in the byte order
+       and the structure layout of the host that wrote the snapshot.  The
+       header records the byte order and the format version, and the size
+       of each column value is checked against the library when the column
+       is looked up.
+       The snapshot is not tied to the L0R it was made from, the caller is
+       responsible for using the snapshot of the right L0R.
+
+-----------------------------------------------------------------------------*/
+
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+/* project included headers */
+#include "ias_logging.h"
+#include "ias_l0r.h"
+#include "ias_types.h"
+
+#define SNAPSHOT_MAGIC "L0RANCS"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_FIELD_NAME_LENGTH 64
+#define SNAPSHOT_COLUMN_ALIGNMENT 64
+
+/* Number of records read from the L0R at a time when writing a snapshot */
+#define SNAPSHOT_RECORDS_PER_READ 4096
+
+/* Header of the snapshot file, followed by the column headers */
+typedef struct IAS_L0R_ANC_SNAPSHOT_HEADER
+{
+    char magic[8];              /* SNAPSHOT_MAGIC */
+    int version;                /* SNAPSHOT_VERSION */
+    int byte_order;             /* SNAPSHOT_BYTE_ORDER as written */
+    int num_columns;            /* number of columns in the file */
+    int reserved;
+    long long file_size;        /* size of the snapshot file */
+} IAS_L0R_ANC_SNAPSHOT_HEADER;
+
+/* Header of a column, the values are at the offset given */
+typedef struct IAS_L0R_ANC_SNAPSHOT_COLUMN
+{
+    char field_name[SNAPSHOT_FIELD_NAME_LENGTH]; /* name of the field */
+    int table;                  /* IAS_L0R_ANCILLARY_TABLE of the field */
+    int value_size;             /* size of each value */
+    long long count;            /* number of values */
+    long long offset;           /* offset of the values in the file */
+} IAS_L0R_ANC_SNAPSHOT_COLUMN;
+
+struct ias_l0r_ancillary_snapshot
+{
+    char *memblock;             /* mapped snapshot file */
+    long long size;             /* size of the mapping */
+    int num_columns;            /* number of columns */
+    const IAS_L0R_ANC_SNAPSHOT_COLUMN *columns; /* column headers */
+};
+
+/* Tables saved in the snapshot */
+static const IAS_L0R_ANCILLARY_TABLE snapshot_tables[] =
+{
+    IAS_L0R_ANCILLARY_ATTITUDE,
+    IAS_L0R_ANCILLARY_EPHEMERIS,
+    IAS_L0R_ANCILLARY_IMU
+};
+
+#define NUM_SNAPSHOT_TABLES \
+    (int)(sizeof(snapshot_tables) / sizeof(snapshot_tables[0]))
+
+/******************************************************************************
+ NAME: write_table_columns
+
+ PURPOSE: Reads all the fields of a table a batch of records at a time and
+          writes each field to its column in the snapshot file.  The columns
+          were sized from the record count of the table, so reading more or
+          fewer records than that is an error.
+
+ RETURNS: SUCCESS- The columns were written
+          ERROR- The table could not be read or the file written
+******************************************************************************/
+static int write_table_columns
+(
+    L0RIO *l0r,                   /* I: L0R with the ancillary data open */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to save */
+    const IAS_L0R_ANC_SNAPSHOT_COLUMN *columns, /* I: headers of the columns
+                                        of the table, in the field order */
+    int fd                        /* I: snapshot file */
+)
+{
+    IAS_L0R_ANCILLARY_CURSOR *cursor;
+    const char **field_names;
+    void **values;
+    int field_count;
+    int index;
+    int records_read;
+    long long total_records_read = 0;
+    int field;
+    int status = SUCCESS;
+
+    if (ias_l0r_get_ancillary_table_fields(table, &field_count, &field_names)
+        != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    values = calloc(field_count, sizeof(*values));
+    if (values == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the column buffers");
+        return ERROR;
+    }
+    for (field = 0; field < field_count; field++)
+    {
+        values[field] = malloc(SNAPSHOT_RECORDS_PER_READ
+            * columns[field].value_size);
+        if (values[field] == NULL)
+        {
+            IAS_LOG_ERROR("Allocating the column buffers");
+            status = ERROR;
+            break;
+        }
+    }
+
+    cursor = NULL;
+    if (status == SUCCESS)
+    {
+        cursor = ias_l0r_open_ancillary_cursor(l0r, table, field_count,
+            field_names, SNAPSHOT_RECORDS_PER_READ);
+        if (cursor == NULL)
+            status = ERROR;
+    }
+
+    while (status == SUCCESS)
+    {
+        if (ias_l0r_get_next_ancillary_fields(cursor, values, &index,
+            &records_read) != SUCCESS)
+        {
+            status = ERROR;
+            break;
+        }
+        if (records_read == 0)
+            break;
+        if ((long long)index + records_read > columns[0].count)
+        {
+            IAS_LOG_ERROR("The ancillary table %d has more than the %lld "
+                "records counted", table, columns[0].count);
+            status = ERROR;
+            break;
+        }
+        total_records_read += records_read;
+
+        for (field = 0; field < field_count; field++)
+        {
+            size_t size = (size_t)records_read * columns[field].value_size;
+
+            if (pwrite(fd, values[field], size, columns[field].offset
+                + (long long)index * columns[field].value_size)
+                != (ssize_t)size)
+            {
+                IAS_LOG_ERROR("Writing the column %s",
+                    columns[field].field_name);
+                status = ERROR;
+                break;
+            }
+        }
+    }
+
+    if (status == SUCCESS && total_records_read != columns[0].count)
+    {
+        IAS_LOG_ERROR("Read %lld of the %lld records of the ancillary table "
+            "%d", total_records_read, columns[0].count, table);
+        status = ERROR;
+    }
+
+    ias_l0r_close_ancillary_cursor(cursor);
+    for (field = 0; field < field_count; field++)
+        free(values[field]);
+    free(values);
+
+    return status;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_write_ancillary_snapshot
+
+ PURPOSE: Saves every field of the attitude, ephemeris and IMU tables of an
+          L0R to a snapshot file.  The ancillary data must be open for
+          reading.  The file is written under a temporary name and renamed,
+          so a process mapping the snapshot never sees it partially written.
+
+ RETURNS: SUCCESS- The snapshot was written
+          ERROR- The snapshot could not be written
+******************************************************************************/
+int ias_l0r_write_ancillary_snapshot
+(
+    L0RIO *l0r,                   /* I: L0R with the ancillary data open */
+    const char *snapshot_filename /* I: snapshot file to write */
+)
+{
+    IAS_L0R_ANC_SNAPSHOT_HEADER header;
+    IAS_L0R_ANC_SNAPSHOT_COLUMN *columns;
+    char temp_filename[PATH_MAX];
+    const char **field_names;
+    int field_counts[NUM_SNAPSHOT_TABLES];
+    int record_counts[NUM_SNAPSHOT_TABLES];
+    int num_columns = 0;
+    int column;
+    int table;
+    int field;
+    int fd;
+    long long offset;
+    int status = SUCCESS;
+
+    for (table = 0; table < NUM_SNAPSHOT_TABLES; table++)
+    {
+        if (ias_l0r_get_ancillary_table_fields(snapshot_tables[table],
+                &field_counts[table], &field_names) != SUCCESS
+            || ias_l0r_get_ancillary_table_records_count(l0r,
+                snapshot_tables[table], &record_counts[table]) != SUCCESS)
+        {
+            IAS_LOG_ERROR("Getting the ancillary table %d",
+                snapshot_tables[table]);
+            return ERROR;
+        }
+        num_columns += field_counts[table];
+    }
+
+    columns = calloc(num_columns, sizeof(*columns));
+    if (columns == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the snapshot column headers");
+        return ERROR;
+    }
+
+    /* lay out the columns after the header and the column headers */
+    offset = sizeof(header) + num_columns * sizeof(*columns);
+    column = 0;
+    for (table = 0; table < NUM_SNAPSHOT_TABLES; table++)
+    {
+        ias_l0r_get_ancillary_table_fields(snapshot_tables[table],
+            &field_counts[table], &field_names);
+        for (field = 0; field < field_counts[table]; field++, column++)
+        {
+            size_t value_size;
+
+            if (strlen(field_names[field]) >= SNAPSHOT_FIELD_NAME_LENGTH
+                || ias_l0r_get_ancillary_field_size(snapshot_tables[table],
+                    field_names[field], &value_size) != SUCCESS)
+            {
+                IAS_LOG_ERROR("Field %s can not be saved",
+                    field_names[field]);
+                free(columns);
+                return ERROR;
+            }
+
+            offset = (offset + SNAPSHOT_COLUMN_ALIGNMENT - 1)
+                / SNAPSHOT_COLUMN_ALIGNMENT * SNAPSHOT_COLUMN_ALIGNMENT;
+            strncpy(columns[column].field_name, field_names[field],
+                sizeof(columns[column].field_name));
+            columns[column].table = snapshot_tables[table];
+            columns[column].value_size = value_size;
+            columns[column].count = record_counts[table];
+            columns[column].offset = offset;
+            offset += columns[column].count * columns[column].value_size;
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.num_columns = num_columns;
+    header.file_size = offset;
+
+    /* a unique temporary name, so concurrent writers of the same snapshot
+       do not write into the same file */
+    if (snprintf(temp_filename, sizeof(temp_filename), "%s.XXXXXX",
+                 snapshot_filename) >= (int)sizeof(temp_filename))
+    {
+        IAS_LOG_ERROR("The snapshot file name is too long");
+        free(columns);
+        return ERROR;
+    }
+
+    fd = mkstemp(temp_filename);
+    if (fd < 0)
+    {
+        IAS_LOG_ERROR("Opening the snapshot %s", temp_filename);
+        free(columns);
+        return ERROR;
+    }
+
+    if (fchmod(fd, 0644) != 0
+        || ftruncate(fd, header.file_size) != 0
+        || pwrite(fd, &header, sizeof(header), 0) != sizeof(header)
+        || pwrite(fd, columns, num_columns * sizeof(*columns), sizeof(header))
+            != (ssize_t)(num_columns * sizeof(*columns)))
+    {
+        IAS_LOG_ERROR("Writing the snapshot %s", temp_filename);
+        status = ERROR;
+    }
+
+    column = 0;
+    for (table = 0; table < NUM_SNAPSHOT_TABLES && status == SUCCESS; table++)
+    {
+        if (write_table_columns(l0r, snapshot_tables[table], &columns[column],
+            fd) != SUCCESS)
+        {
+            IAS_LOG_ERROR("Saving the ancillary table %d to %s",
+                snapshot_tables[table], temp_filename);
+            status = ERROR;
+        }
+        column += field_counts[table];
+    }
+    free(columns);
+
+    /* the data must be on disk before the rename makes it visible */
+    if (status == SUCCESS && fsync(fd) != 0)
+    {
+        IAS_LOG_ERROR("Flushing the snapshot %s", temp_filename);
+        status = ERROR;
+    }
+    if (close(fd) != 0 && status == SUCCESS)
+    {
+        IAS_LOG_ERROR("Closing the snapshot %s", temp_filename);
+        status = ERROR;
+    }
+    if (status == SUCCESS && rename(temp_filename, snapshot_filename) != 0)
+    {
+        IAS_LOG_ERROR("Renaming the snapshot %s to %s", temp_filename,
+            snapshot_filename);
+        status = ERROR;
+    }
+    if (status != SUCCESS)
+        unlink(temp_filename);
+
+    return status;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_open_ancillary_snapshot
+
+ PURPOSE: Maps a snapshot file read only and checks it was written by this
+          version of the library on a host with the same byte order
+
+ RETURNS: Pointer to the snapshot, NULL if it is missing or not usable
+******************************************************************************/
+IAS_L0R_ANCILLARY_SNAPSHOT *ias_l0r_open_ancillary_snapshot
+(
+    const char *snapshot_filename /* I: snapshot file to map */
+)
+{
+    IAS_L0R_ANCILLARY_SNAPSHOT *snapshot;
+    IAS_L0R_ANC_SNAPSHOT_HEADER header;
+    struct stat st;
+    char *memblock;
+    int fd;
+    int column;
+
+    fd = open(snapshot_filename, O_RDONLY);
+    if (fd < 0)
+    {
+        IAS_LOG_ERROR("Opening the snapshot %s", snapshot_filename);
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(header))
+    {
+        IAS_LOG_ERROR("The snapshot %s is truncated", snapshot_filename);
+        close(fd);
+        return NULL;
+    }
+
+    memblock = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memblock == MAP_FAILED)
+    {
+        IAS_LOG_ERROR("Could not map the snapshot %s", snapshot_filename);
+        return NULL;
+    }
+
+    memcpy(&header, memblock, sizeof(header));
+    if (strncmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+        || header.version != SNAPSHOT_VERSION
+        || header.byte_order != SNAPSHOT_BYTE_ORDER)
+    {
+        IAS_LOG_ERROR("%s is not a snapshot of this version",
+            snapshot_filename);
+        munmap(memblock, st.st_size);
+        return NULL;
+    }
+    if (header.file_size != st.st_size || header.num_columns < 0
+        || sizeof(header) + header.num_columns
+            * sizeof(IAS_L0R_ANC_SNAPSHOT_COLUMN) > (size_t)st.st_size)
+    {
+        IAS_LOG_ERROR("The snapshot %s is truncated", snapshot_filename);
+        munmap(memblock, st.st_size);
+        return NULL;
+    }
+
+    snapshot = malloc(sizeof(*snapshot));
+    if (snapshot == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the snapshot");
+        munmap(memblock, st.st_size);
+        return NULL;
+    }
+    snapshot->memblock = memblock;
+    snapshot->size = st.st_size;
+    snapshot->num_columns = header.num_columns;
+    snapshot->columns = (const IAS_L0R_ANC_SNAPSHOT_COLUMN *)
+        (memblock + sizeof(header));
+
+    /* check each column is inside the file and aligned */
+    for (column = 0; column < snapshot->num_columns; column++)
+    {
+        const IAS_L0R_ANC_SNAPSHOT_COLUMN *current
+            = &snapshot->columns[column];
+
+        if (current->value_size <= 0 || current->count < 0
+            || current->offset % SNAPSHOT_COLUMN_ALIGNMENT != 0
+            || current->offset < 0 || current->offset > snapshot->size
+            || current->count > (snapshot->size - current->offset)
+                / current->value_size
+            || memchr(current->field_name, '\0',
+                sizeof(current->field_name)) == NULL)
+        {
+            IAS_LOG_ERROR("The snapshot %s is corrupt", snapshot_filename);
+            ias_l0r_close_ancillary_snapshot(snapshot);
+            return NULL;
+        }
+    }
+
+    return snapshot;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_get_ancillary_snapshot_column
+
+ PURPOSE: Finds the values of a field of an ancillary table in a snapshot.
+          The values point into the mapped file, they are laid out like the
+          columns of ias_l0r_get_ancillary_fields and stay valid until the
+          snapshot is closed.
+
+ RETURNS: SUCCESS- The column was found
+          ERROR- The snapshot has no such column
+******************************************************************************/
+int ias_l0r_get_ancillary_snapshot_column
+(
+    const IAS_L0R_ANCILLARY_SNAPSHOT *snapshot, /* I: mapped snapshot */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table of the field */
+    const char *field_name,       /* I: name of the field */
+    const void **values,          /* O: values of the field */
+    int *count                    /* O: number of values */
+)
+{
+    const IAS_L0R_ANC_SNAPSHOT_COLUMN *current;
+    size_t value_size;
+    int column;
+
+    for (column = 0; column < snapshot->num_columns; column++)
+    {
+        current = &snapshot->columns[column];
+        if (current->table != (int)table
+            || strcmp(current->field_name, field_name) != 0)
+        {
+            continue;
+        }
+
+        /* the layout of the field must not have changed since the write */
+        if (ias_l0r_get_ancillary_field_size(table, field_name, &value_size)
+                != SUCCESS
+            || value_size != (size_t)current->value_size)
+        {
+            IAS_LOG_ERROR("The snapshot values of %s do not match the "
+                "ancillary tables", field_name);
+            return ERROR;
+        }
+
+        if (current->count > INT_MAX)
+        {
+            IAS_LOG_ERROR("The snapshot column %s has too many values",
+                field_name);
+            return ERROR;
+        }
+
+        *values = snapshot->memblock + current->offset;
+        *count = current->count;
+        return SUCCESS;
+    }
+
+    IAS_LOG_ERROR("The snapshot has no column %s for table %d", field_name,
+        table);
+    return ERROR;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_close_ancillary_snapshot
+
+ PURPOSE: Unmaps a snapshot.  The values returned for its columns are no
+          longer valid.
+
+ RETURNS: SUCCESS- The snapshot was unmapped
+******************************************************************************/
+int ias_l0r_close_ancillary_snapshot
+(
+    IAS_L0R_ANCILLARY_SNAPSHOT *snapshot /* I: snapshot to unmap */
+)
+{
+    if (snapshot == NULL)
+        return SUCCESS;
+
+    munmap(snapshot->memblock, snapshot->size);
+    free(snapshot);
+
+    return SUCCESS;
+}
@@ -81,9 +81,46 @@ static int ias_l0r_truncate_image
     const IAS_L0R_BAND_DATASET dataset_type /* I: Image or Offset dataset */
 );
 
+static size_t ias_l0r_next_prime
+(
+    size_t value /* I: smallest value wanted */
+);
+
 /*******************************************************************************
  Subroutine definitions
 ******************************************************************************/
+/******************************************************************************
+ NAME: ias_l0r_next_prime
+
+ PURPOSE: Finds the smallest prime number not less than the value given.
+          Used to size the hash table of the chunk cache.
+
+ RETURNS: The prime number
+******************************************************************************/
+static size_t ias_l0r_next_prime
+(
+    size_t value /* I: smallest value wanted */
+)
+{
+    size_t divisor;
+
+    if (value <= 2)
+        return 2;
+    if (value % 2 == 0)
+        value++;
+
+    for (;; value += 2)
+    {
+        for (divisor = 3; divisor * divisor <= value; divisor += 2)
+        {
+            if (value % divisor == 0)
+                break;
+        }
+        if (divisor * divisor > value)
+            return value;
+    }
+}
+
 /******************************************************************************
  NAME: ias_l0r_establish_band_file
 
@@ -276,8 +313,6 @@ static int ias_l0r_establish_band_dataset
     const IAS_BAND_ATTRIBUTES *band_attributes = NULL;
     const IAS_SATELLITE_ATTRIBUTES *landsat8_attributes = NULL;
 
-    const int CHUNK_NUM_LINES = 128;
-
     band_attributes = ias_sat_attr_get_band_attributes(band_number);
     landsat8_attributes = ias_sat_attr_get_attributes();
 
@@ -308,7 +343,7 @@ static int ias_l0r_establish_band_dataset
 
     chunk_dims[IAS_L0R_IMAGE_DIMENSION_SCA] = 1;
     /*  Set a reasonable number of lines to be part of a chunk */
-    chunk_dims[IAS_L0R_IMAGE_DIMENSION_LINE] = 128;
+    chunk_dims[IAS_L0R_IMAGE_DIMENSION_LINE] = IAS_L0R_BAND_CHUNK_LINES;
     chunk_dims[IAS_L0R_IMAGE_DIMENSION_DETECTOR] =
         band_attributes->detectors_per_sca;
 
@@ -486,10 +521,11 @@ static int ias_l0r_establish_band_dataset
             int bytes_per_pixel = sizeof(uint16_t); 
             int num_detectors;   /* number of detectors across entire focal
                                     plane */
+            int num_chunks;      /* number of chunks held by the cache */
             size_t rdcc_nslots;  /* number of chunk slots in the data chunk 
-                                    hash table -- not changed */
+                                    hash table */
             size_t rdcc_nbytes;  /* total size of cache for dataset */
-            double rdcc_w0;      /* preemption policy -- not changed */
+            double rdcc_w0;      /* preemption policy */
     
             /* get the default cache values */
             status = H5Pget_chunk_cache(dataset_access_properties, 
@@ -507,10 +543,24 @@ static int ias_l0r_establish_band_dataset
                 band_attributes->scas;
     
             /* total number of bytes to accommodate all chunks across the focal 
-               plane in memory.  Then, multiplying by 2 to increase the total 
-               cache size to allow enough room for storing 2 chunks */
-            rdcc_nbytes = (bytes_per_pixel * num_detectors * CHUNK_NUM_LINES);
-            rdcc_nbytes *= 2; 
+               plane in memory.  Then, multiplying by the number of chunk rows
+               to cache so the next row can be loaded while the current one is
+               still being read */
+            rdcc_nbytes = (bytes_per_pixel * num_detectors
+                * IAS_L0R_BAND_CHUNK_LINES);
+            rdcc_nbytes *= IAS_L0R_BAND_CACHE_CHUNK_ROWS;
+
+            /* the chunks are hashed by their index modulo the number of slots,
+               so use a prime number of slots well above the number of cached
+               chunks to keep the chunks of different SCAs from colliding */
+            num_chunks = band_attributes->scas * IAS_L0R_BAND_CACHE_CHUNK_ROWS;
+            rdcc_nslots = ias_l0r_next_prime(num_chunks
+                * IAS_L0R_BAND_CACHE_SLOTS_PER_CHUNK);
+
+            /* the band is normally read sequentially, so evict the chunks
+               that have been fully read first */
+            rdcc_w0 = 1.0;
+
             status = H5Pset_chunk_cache(dataset_access_properties, rdcc_nslots, 
                 rdcc_nbytes, rdcc_w0);
             if(status < 0)
@@ -661,6 +711,85 @@ static int ias_l0r_get_band_dataset_records_count
     return SUCCESS;
 }
 
+/******************************************************************************
+ NAME: ias_l0r_establish_band_image_dataset
+
+ PURPOSE: Establishes access to the image dataset of a band for the routines
+          working on its chunks directly.  The band must be open in a mode
+          allowing the access wanted.
+
+ RETURNS: SUCCESS- The dataset ID was returned, -1 when the dataset does not
+                   exist and was not to be created
+          ERROR- Access could not be established
+******************************************************************************/
+int ias_l0r_establish_band_image_dataset
+(
+    HDFIO *hdfio_ptr,           /* I: Pointer used in I/O */
+    const int band_number,      /* I: Band number of the dataset */
+    const int create_if_absent, /* I: TRUE to create the dataset, which
+                                      needs the band open for writing */
+    hid_t *dataset_id           /* O: Image dataset ID */
+)
+{
+    const IAS_BAND_ATTRIBUTES *band_attributes = NULL;
+    BAND_INFO *band_info = NULL;
+
+    *dataset_id = -1;
+
+    if (hdfio_ptr == NULL)
+    {
+        IAS_LOG_ERROR("Error NULL pointer received");
+        return ERROR;
+    }
+
+    band_attributes = ias_sat_attr_get_band_attributes(band_number);
+    if (band_attributes == NULL)
+    {
+        IAS_LOG_ERROR("Unable to get band attributes for band #%i",
+            band_number);
+        return ERROR;
+    }
+    band_info = &hdfio_ptr->band_info[band_attributes->band_index];
+
+    if (band_info->access_mode != IAS_WRITE &&
+        band_info->access_mode != IAS_UPDATE &&
+        (create_if_absent || band_info->access_mode != IAS_READ))
+    {
+        IAS_LOG_ERROR("Current access mode %d for band %d does not allow %s",
+            band_info->access_mode, band_number,
+            create_if_absent ? "writing" : "reading");
+        return ERROR;
+    }
+
+    if (ias_l0r_establish_band_file(hdfio_ptr, band_number, create_if_absent)
+        == ERROR)
+    {
+        IAS_LOG_ERROR("Error establishing access to band %d file",
+            band_number);
+        return ERROR;
+    }
+    if (band_info->file_id <= 0)
+    {
+        if (create_if_absent)
+        {
+            IAS_LOG_ERROR("Error establishing access to band %d file",
+                band_number);
+            return ERROR;
+        }
+        return SUCCESS;
+    }
+
+    if (ias_l0r_establish_band_dataset(hdfio_ptr, band_number,
+        create_if_absent, IAS_L0R_IMAGE_DATASET) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Problems establishing dataset");
+        return ERROR;
+    }
+
+    *dataset_id = band_info->image_dataset_id;
+    return SUCCESS;
+}
+
 /*******************************************************************************
 *public routines
 *******************************************************************************/
@@ -0,0 +1,1390 @@
+/*-----------------------------------------------------------------------------
+
+NAME: ias_l0r_band_chunk.c
+
+PURPOSE: Reading and writing of the band image datasets a chunk at a time,
+         bypassing the HDF5 filter pipeline so the zlib work is spread over
+         threads.  The compressed chunks of a read are read by the calling
+         thread and inflated and unshuffled by a thread pool.  The chunks of
+         a write are shuffled and deflated by a thread pool and written in
+         order by a single I/O thread.
+
+ALGORITHM REFERENCES: NONE
+
+NOTES: The reads make HDF5 calls from the calling thread only.  The writer
+       makes them from its I/O thread, so the caller must not make HDF5 calls
+       of its own while a writer is open unless the HDF5 library was built
+       thread safe; with other builds the chunks are written by the calling
+       thread instead.  The routines apply the filters the L0R library
+       creates the image datasets with (shuffle then deflate).  The reads
+       fall back to the filter pipeline for any other layout, or when the
+       HDF5 library is older than 1.10.3 and has no direct chunk access.
+
+-----------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+/* project included headers */
+#include "ias_logging.h"
+#include "ias_l0r.h"
+#include "ias_l0r_hdf.h"
+#include "ias_types.h"
+#include "ias_satellite_attributes.h"
+#include "ias_threadpool.h"
+
+/* Chunks inflated per thread in a batch.  A batch is inflated while the
+   compressed chunks of the next one are read. */
+#define CHUNKS_PER_THREAD 4
+
+/* Bytes per pixel of the image datasets */
+#define BYTES_PER_PIXEL sizeof(uint16_t)
+
+#if H5_VERSION_GE(1,10,3)
+
+/* Compressed chunk as stored in the file */
+typedef struct
+{
+    int sca;                 /* SCA of the chunk */
+    uint32_t chunk_line;     /* first line of the chunk */
+    uint32_t filter_mask;    /* filters skipped when the chunk was written */
+    hsize_t size;            /* bytes of data, 0 if the chunk was never
+                                allocated */
+    hsize_t capacity;        /* bytes allocated for data */
+    unsigned char *data;     /* chunk data */
+} RAW_CHUNK;
+
+/* Chunks inflated by the thread pool at a time */
+typedef struct
+{
+    RAW_CHUNK *chunks;       /* chunks of the batch */
+    int chunk_count;         /* number of chunks of the batch */
+} CHUNK_BATCH;
+
+/* Parameters shared by the threads inflating the chunks */
+typedef struct
+{
+    const CHUNK_BATCH *batch; /* batch being inflated */
+    int next_chunk;          /* next chunk of the batch to inflate */
+    IAS_THREAD_MUTEX_TYPE next_chunk_mutex; /* mutex for next_chunk */
+    int thread_count;        /* number of threads inflating the batch */
+    int shuffle_filter;      /* pipeline index of the shuffle filter, -1 if
+                                the dataset is not shuffled */
+    int deflate_filter;      /* pipeline index of the deflate filter, -1 if
+                                the dataset is not compressed */
+    uint32_t detectors;      /* detectors per SCA */
+    uint32_t line_start;     /* first line read */
+    uint32_t line_count;     /* number of lines read */
+    size_t chunk_bytes;      /* bytes of an inflated chunk */
+    unsigned char **scratch; /* inflated chunk of each thread */
+    uint16_t *image;         /* lines ordered by [SCA][LINE][DETECTOR] */
+} INFLATE_PARAMS;
+
+/******************************************************************************
+ NAME: get_chunk_filters
+
+ PURPOSE: Checks the image dataset is chunked like the L0R library creates
+          it, with at most the shuffle and deflate filters in that order, and
+          finds the pipeline index of each filter.
+
+ RETURNS: SUCCESS- The chunks can be decoded by this module
+          WARNING- The chunks have to be read through the filter pipeline
+          ERROR- The dataset properties could not be read
+******************************************************************************/
+static int get_chunk_filters
+(
+    hid_t dataset_id,        /* I: image dataset */
+    uint32_t detectors,      /* I: detectors per SCA */
+    int *shuffle_filter,     /* O: index of the shuffle filter or -1 */
+    int *deflate_filter,     /* O: index of the deflate filter or -1 */
+    int *deflate_level       /* O: compression level of the deflate filter */
+)
+{
+    hid_t create_plist;
+    hid_t type_id;
+    hsize_t chunk_dims[IAS_L0R_IMAGE_DIMENSIONS];
+    H5Z_filter_t filter;
+    unsigned int flags;
+    size_t cd_nelmts;
+    unsigned int cd_values[8];
+    int filter_count;
+    int index;
+    int status = SUCCESS;
+
+    *shuffle_filter = -1;
+    *deflate_filter = -1;
+    *deflate_level = 0;
+
+    /* the chunks are decoded as little endian 16-bit pixels */
+    type_id = H5Dget_type(dataset_id);
+    if (type_id < 0)
+    {
+        IAS_LOG_ERROR("Getting the datatype of the image dataset");
+        return ERROR;
+    }
+    if (H5Tget_size(type_id) != BYTES_PER_PIXEL ||
+        H5Tget_order(type_id) != H5T_ORDER_LE)
+    {
+        status = WARNING;
+    }
+    H5Tclose(type_id);
+    if (status != SUCCESS)
+        return status;
+
+    create_plist = H5Dget_create_plist(dataset_id);
+    if (create_plist < 0)
+    {
+        IAS_LOG_ERROR("Getting the creation properties of the image dataset");
+        return ERROR;
+    }
+
+    if (H5Pget_layout(create_plist) != H5D_CHUNKED ||
+        H5Pget_chunk(create_plist, IAS_L0R_IMAGE_DIMENSIONS, chunk_dims)
+            != IAS_L0R_IMAGE_DIMENSIONS ||
+        chunk_dims[IAS_L0R_IMAGE_DIMENSION_SCA] != 1 ||
+        chunk_dims[IAS_L0R_IMAGE_DIMENSION_LINE] != IAS_L0R_BAND_CHUNK_LINES ||
+        chunk_dims[IAS_L0R_IMAGE_DIMENSION_DETECTOR] != detectors)
+    {
+        H5Pclose(create_plist);
+        return WARNING;
+    }
+
+    filter_count = H5Pget_nfilters(create_plist);
+    if (filter_count < 0)
+    {
+        IAS_LOG_ERROR("Getting the filters of the image dataset");
+        H5Pclose(create_plist);
+        return ERROR;
+    }
+    for (index = 0; index < filter_count && status == SUCCESS; index++)
+    {
+        cd_nelmts = sizeof(cd_values) / sizeof(cd_values[0]);
+        filter = H5Pget_filter2(create_plist, index, &flags, &cd_nelmts,
+            cd_values, 0, NULL, NULL);
+        if (filter == H5Z_FILTER_SHUFFLE && *shuffle_filter < 0 &&
+            *deflate_filter < 0)
+        {
+            *shuffle_filter = index;
+        }
+        else if (filter == H5Z_FILTER_DEFLATE && *deflate_filter < 0)
+        {
+            *deflate_filter = index;
+            if (cd_nelmts > 0)
+                *deflate_level = cd_values[0];
+        }
+        else if (filter < 0)
+        {
+            IAS_LOG_ERROR("Getting filter %d of the image dataset", index);
+            status = ERROR;
+        }
+        else
+        {
+            status = WARNING;
+        }
+    }
+
+    H5Pclose(create_plist);
+    return status;
+}
+
+/******************************************************************************
+ NAME: read_raw_chunks
+
+ PURPOSE: Reads the compressed data of the chunks of a batch.  The chunks
+          follow each other along the lines, one chunk of every SCA at a
+          time.
+
+ RETURNS: SUCCESS- The chunks were read
+          ERROR- A chunk could not be read
+******************************************************************************/
+static int read_raw_chunks
+(
+    hid_t dataset_id,        /* I: image dataset */
+    int sca_count,           /* I: number of SCAs of the band */
+    uint32_t first_chunk_line, /* I: first line of the first chunk read */
+    int first_chunk,         /* I: index of the first chunk of the batch */
+    int chunk_count,         /* I: number of chunks of the batch */
+    CHUNK_BATCH *batch       /* I/O: batch to read the chunks into */
+)
+{
+    RAW_CHUNK *chunk;
+    hsize_t offset[IAS_L0R_IMAGE_DIMENSIONS];
+    unsigned char *data;
+    int index;
+
+    for (index = 0; index < chunk_count; index++)
+    {
+        chunk = &batch->chunks[index];
+        chunk->sca = (first_chunk + index) % sca_count;
+        chunk->chunk_line = first_chunk_line + (uint32_t)
+            ((first_chunk + index) / sca_count) * IAS_L0R_BAND_CHUNK_LINES;
+        chunk->filter_mask = 0;
+
+        offset[IAS_L0R_IMAGE_DIMENSION_SCA] = chunk->sca;
+        offset[IAS_L0R_IMAGE_DIMENSION_LINE] = chunk->chunk_line;
+        offset[IAS_L0R_IMAGE_DIMENSION_DETECTOR] = 0;
+
+        /* chunks never written are not allocated and read as fill */
+        if (H5Dget_chunk_storage_size(dataset_id, offset, &chunk->size) < 0)
+            chunk->size = 0;
+        if (chunk->size == 0)
+            continue;
+
+        if (chunk->size > chunk->capacity)
+        {
+            data = realloc(chunk->data, chunk->size);
+            if (data == NULL)
+            {
+                IAS_LOG_ERROR("Allocating %lu bytes for a chunk",
+                    (unsigned long)chunk->size);
+                return ERROR;
+            }
+            chunk->data = data;
+            chunk->capacity = chunk->size;
+        }
+
+        if (H5Dread_chunk(dataset_id, H5P_DEFAULT, offset,
+            &chunk->filter_mask, chunk->data) < 0)
+        {
+            IAS_LOG_ERROR("Reading the chunk at line %u of SCA %d",
+                chunk->chunk_line, chunk->sca);
+            return ERROR;
+        }
+    }
+    batch->chunk_count = chunk_count;
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: inflate_chunk
+
+ PURPOSE: Inflates and unshuffles a chunk, and copies its lines within the
+          lines read to the image.
+
+ RETURNS: SUCCESS- The chunk was decoded
+          ERROR- The chunk data is not valid
+******************************************************************************/
+static int inflate_chunk
+(
+    const INFLATE_PARAMS *params, /* I: parameters of the read */
+    const RAW_CHUNK *chunk,  /* I: chunk to decode */
+    unsigned char *scratch   /* I/O: buffer for the inflated chunk */
+)
+{
+    const unsigned char *bytes;
+    uint16_t *output;
+    uLongf inflated_size;
+    size_t pixel_count;
+    size_t pixel;
+    size_t first_pixel;
+    size_t last_pixel;
+    uint32_t first_line;
+    uint32_t end_line;
+    int shuffled;
+    int status;
+
+    /* lines of the chunk within the lines read */
+    first_line = chunk->chunk_line;
+    if (first_line < params->line_start)
+        first_line = params->line_start;
+    end_line = chunk->chunk_line + IAS_L0R_BAND_CHUNK_LINES;
+    if (end_line > params->line_start + params->line_count)
+        end_line = params->line_start + params->line_count;
+
+    output = params->image + ((size_t)chunk->sca * params->line_count
+        + (first_line - params->line_start)) * params->detectors;
+    first_pixel = (size_t)(first_line - chunk->chunk_line)
+        * params->detectors;
+    last_pixel = (size_t)(end_line - chunk->chunk_line) * params->detectors;
+
+    if (chunk->size == 0)
+    {
+        /* the fill value of the image datasets is zero */
+        memset(output, 0, (last_pixel - first_pixel) * BYTES_PER_PIXEL);
+        return SUCCESS;
+    }
+
+    /* a filter bit set in the mask means it was skipped for this chunk */
+    bytes = chunk->data;
+    if (params->deflate_filter >= 0 &&
+        !(chunk->filter_mask & (1u << params->deflate_filter)))
+    {
+        inflated_size = params->chunk_bytes;
+        status = uncompress(scratch, &inflated_size, chunk->data,
+            chunk->size);
+        if (status != Z_OK || inflated_size != params->chunk_bytes)
+        {
+            IAS_LOG_ERROR("Inflating the chunk at line %u of SCA %d, zlib "
+                "status %d", chunk->chunk_line, chunk->sca, status);
+            return ERROR;
+        }
+        bytes = scratch;
+    }
+    else if (chunk->size != params->chunk_bytes)
+    {
+        IAS_LOG_ERROR("The chunk at line %u of SCA %d has %lu bytes instead "
+            "of %lu", chunk->chunk_line, chunk->sca,
+            (unsigned long)chunk->size, (unsigned long)params->chunk_bytes);
+        return ERROR;
+    }
+
+    /* shuffled chunks hold all the low bytes, then all the high bytes */
+    shuffled = (params->shuffle_filter >= 0 &&
+        !(chunk->filter_mask & (1u << params->shuffle_filter)));
+    pixel_count = params->chunk_bytes / BYTES_PER_PIXEL;
+    if (shuffled)
+    {
+        for (pixel = first_pixel; pixel < last_pixel; pixel++)
+        {
+            *output++ = bytes[pixel]
+                | (uint16_t)(bytes[pixel_count + pixel] << 8);
+        }
+    }
+    else
+    {
+        for (pixel = first_pixel; pixel < last_pixel; pixel++)
+        {
+            *output++ = bytes[2 * pixel]
+                | (uint16_t)(bytes[2 * pixel + 1] << 8);
+        }
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: inflate_batch
+
+ PURPOSE: Thread routine decoding the chunks of the batch not taken by the
+          other threads yet.
+
+ RETURNS: SUCCESS- The chunks were decoded
+          ERROR- A chunk could not be decoded
+******************************************************************************/
+static int inflate_batch
+(
+    void *thread_params,     /* I: INFLATE_PARAMS of the read */
+    int thread_number        /* I: number of this thread */
+)
+{
+    INFLATE_PARAMS *params = thread_params;
+    int index;
+
+    /* a pool without threads calls the routine once with number 1 */
+    thread_number %= params->thread_count;
+
+    /* the chunks are handed out one at a time since a fast thread can run
+       the routine more than once for the same start of the pool */
+    while (TRUE)
+    {
+        IAS_THREAD_LOCK_MUTEX(&params->next_chunk_mutex);
+        index = params->next_chunk++;
+        IAS_THREAD_UNLOCK_MUTEX(&params->next_chunk_mutex);
+        if (index >= params->batch->chunk_count)
+            break;
+
+        if (inflate_chunk(params, &params->batch->chunks[index],
+            params->scratch[thread_number]) != SUCCESS)
+        {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: read_chunks_parallel
+
+ PURPOSE: Reads the lines of every SCA, inflating the chunks on the thread
+          pool while the compressed chunks of the next batch are read.
+
+ RETURNS: SUCCESS- The lines were read
+          ERROR- The lines could not be read
+******************************************************************************/
+static int read_chunks_parallel
+(
+    hid_t dataset_id,        /* I: image dataset */
+    int sca_count,           /* I: number of SCAs of the band */
+    INFLATE_PARAMS *params,  /* I/O: parameters of the read */
+    struct ias_threadpool *pool /* I: threads inflating the chunks */
+)
+{
+    CHUNK_BATCH batches[2];
+    uint32_t first_chunk_line;
+    int batch_size;
+    int total_chunks;
+    int next_chunk;
+    int chunk_count;
+    int current = 0;
+    int index;
+    int status = SUCCESS;
+    int thread_status;
+
+    first_chunk_line = params->line_start / IAS_L0R_BAND_CHUNK_LINES
+        * IAS_L0R_BAND_CHUNK_LINES;
+    total_chunks = sca_count * (int)((params->line_start + params->line_count
+        - 1 - first_chunk_line) / IAS_L0R_BAND_CHUNK_LINES + 1);
+    batch_size = params->thread_count * CHUNKS_PER_THREAD;
+
+    memset(batches, 0, sizeof(batches));
+    for (index = 0; index < 2; index++)
+    {
+        batches[index].chunks = calloc(batch_size, sizeof(RAW_CHUNK));
+        if (batches[index].chunks == NULL)
+        {
+            IAS_LOG_ERROR("Allocating the chunk batches");
+            status = ERROR;
+        }
+    }
+
+    chunk_count = (total_chunks < batch_size) ? total_chunks : batch_size;
+    if (status == SUCCESS)
+    {
+        status = read_raw_chunks(dataset_id, sca_count, first_chunk_line, 0,
+            chunk_count, &batches[current]);
+    }
+    next_chunk = chunk_count;
+
+    while (status == SUCCESS)
+    {
+        params->batch = &batches[current];
+        params->next_chunk = 0;
+
+        if (ias_threadpool_get_thread_count(pool) == 0)
+        {
+            status = ias_threadpool_run_function(pool, inflate_batch, params);
+            if (status != SUCCESS)
+                break;
+        }
+        else if (ias_threadpool_start_function(pool, inflate_batch, params)
+            != SUCCESS)
+        {
+            IAS_LOG_ERROR("Starting the threads inflating the chunks");
+            status = ERROR;
+            break;
+        }
+
+        /* read the next batch while the threads inflate this one */
+        chunk_count = total_chunks - next_chunk;
+        if (chunk_count > batch_size)
+            chunk_count = batch_size;
+        if (chunk_count > 0)
+        {
+            status = read_raw_chunks(dataset_id, sca_count,
+                first_chunk_line, next_chunk, chunk_count,
+                &batches[1 - current]);
+            next_chunk += chunk_count;
+        }
+
+        if (ias_threadpool_get_thread_count(pool) > 0)
+        {
+            thread_status = ias_threadpool_wait_for_completion(pool);
+            if (thread_status != SUCCESS)
+                status = ERROR;
+        }
+
+        if (chunk_count <= 0)
+            break;
+        current = 1 - current;
+    }
+
+    for (index = 0; index < 2; index++)
+    {
+        if (batches[index].chunks == NULL)
+            continue;
+        for (chunk_count = 0; chunk_count < batch_size; chunk_count++)
+            free(batches[index].chunks[chunk_count].data);
+        free(batches[index].chunks);
+    }
+
+    return status;
+}
+
+#endif
+
+/******************************************************************************
+ NAME: ias_l0r_get_band_lines_parallel
+
+ PURPOSE: Reads the lines as specified into the buffer passed in, like
+          ias_l0r_get_band_lines, with the chunks inflated by the thread
+          pool.  Buffer space must be allocated before calling.
+
+ RETURNS: SUCCESS- Image data was read into the buffer
+          ERROR- Image data could not be read into the buffer
+******************************************************************************/
+int ias_l0r_get_band_lines_parallel
+(
+    L0RIO *l0r,            /* I: structure for the file used in I/O */
+    const int band_number, /* I: band number */
+    const uint32_t line_number_start, /* I: First line to read */
+    const int line_count,  /* I: Number of lines to read */
+    const int line_size,   /* I: Number of pixels per line for which space
+                                 has been allocated for */
+    struct ias_threadpool *pool, /* I: threads inflating the chunks */
+    uint16_t *image_lines  /* O: Image data, complete lines of data
+                                 ordered by [SCA][LINE][DETECTOR] */
+)
+{
+#if H5_VERSION_GE(1,10,3)
+    const IAS_BAND_ATTRIBUTES *band_attributes = NULL;
+    INFLATE_PARAMS params;
+    hid_t dataset_id;
+    int band_lines;
+    int deflate_level;
+    int index;
+    int status;
+
+    if (l0r == NULL || pool == NULL || image_lines == NULL)
+    {
+        IAS_LOG_ERROR("Error NULL pointer received");
+        return ERROR;
+    }
+
+    band_attributes = ias_sat_attr_get_band_attributes(band_number);
+    if (band_attributes == NULL)
+    {
+        IAS_LOG_ERROR("Unable to get band attributes for band #%i",
+            band_number);
+        return ERROR;
+    }
+
+    if (line_size < (band_attributes->scas *
+                     band_attributes->detectors_per_sca))
+    {
+        IAS_LOG_ERROR("Line size passed of %i is too small"
+                      " A size of at least %i is needed for band %i",
+                      line_size, (band_attributes->scas *
+                     band_attributes->detectors_per_sca), band_number );
+        return ERROR;
+    }
+
+    if (ias_l0r_establish_band_image_dataset(l0r, band_number, FALSE,
+        &dataset_id) != SUCCESS)
+    {
+        return ERROR;
+    }
+    if (dataset_id < 0)
+    {
+        IAS_LOG_ERROR("Attempting to read non-existent data for band %d",
+            band_number);
+        return ERROR;
+    }
+
+    if (ias_l0r_get_band_records_count(l0r, band_number, &band_lines)
+        != SUCCESS)
+    {
+        IAS_LOG_ERROR("Getting the number of lines of band %d", band_number);
+        return ERROR;
+    }
+    if (line_count <= 0 || line_number_start >= (uint32_t)band_lines ||
+        (uint32_t)line_count > (uint32_t)band_lines - line_number_start)
+    {
+        IAS_LOG_ERROR("Lines %u to %u are not within the %d lines of "
+            "band %d", line_number_start,
+            line_number_start + line_count - 1, band_lines, band_number);
+        return ERROR;
+    }
+
+    memset(&params, 0, sizeof(params));
+    status = get_chunk_filters(dataset_id, band_attributes->detectors_per_sca,
+        &params.shuffle_filter, &params.deflate_filter, &deflate_level);
+    if (status == ERROR)
+        return ERROR;
+    if (status == WARNING)
+    {
+        /* not laid out like the L0R library creates it */
+        return ias_l0r_get_band_lines(l0r, band_number, line_number_start,
+            line_count, line_size, image_lines);
+    }
+
+    params.thread_count = ias_threadpool_get_thread_count(pool);
+    if (params.thread_count < 1)
+        params.thread_count = 1;
+    params.detectors = band_attributes->detectors_per_sca;
+    params.line_start = line_number_start;
+    params.line_count = line_count;
+    params.chunk_bytes = (size_t)IAS_L0R_BAND_CHUNK_LINES * params.detectors
+        * BYTES_PER_PIXEL;
+    params.image = image_lines;
+
+    params.scratch = calloc(params.thread_count, sizeof(*params.scratch));
+    if (params.scratch == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the inflate buffers");
+        return ERROR;
+    }
+    for (index = 0; index < params.thread_count; index++)
+    {
+        params.scratch[index] = malloc(params.chunk_bytes);
+        if (params.scratch[index] == NULL)
+        {
+            IAS_LOG_ERROR("Allocating the inflate buffers");
+            status = ERROR;
+            break;
+        }
+    }
+
+    if (status != ERROR && IAS_THREAD_CREATE_MUTEX(&params.next_chunk_mutex)
+        != 0)
+    {
+        IAS_LOG_ERROR("Creating the mutex of the inflate threads");
+        status = ERROR;
+    }
+    else if (status != ERROR)
+    {
+        status = read_chunks_parallel(dataset_id, band_attributes->scas,
+            &params, pool);
+        if (status != SUCCESS)
+        {
+            IAS_LOG_ERROR("Reading lines %u to %u of band %d",
+                line_number_start, line_number_start + line_count - 1,
+                band_number);
+        }
+        IAS_THREAD_DESTROY_MUTEX(&params.next_chunk_mutex);
+    }
+
+    for (index = 0; index < params.thread_count; index++)
+        free(params.scratch[index]);
+    free(params.scratch);
+
+    return status;
+#else
+    /* no direct chunk access, read through the filter pipeline */
+    return ias_l0r_get_band_lines(l0r, band_number, line_number_start,
+        line_count, line_size, image_lines);
+#endif
+}
+
+#if H5_VERSION_GE(1,10,3)
+
+/* States of the chunk slots of a writer */
+#define SLOT_FREE 0          /* slot can take a new chunk */
+#define SLOT_FILLED 1        /* chunk waits to be compressed */
+#define SLOT_COMPRESSED 2    /* chunk waits to be written */
+
+/* Chunk on its way through a writer */
+typedef struct
+{
+    int state;               /* SLOT_FREE, SLOT_FILLED or SLOT_COMPRESSED */
+    int sca;                 /* SCA of the chunk */
+    uint32_t chunk_line;     /* first line of the chunk */
+    uint32_t line_count;     /* lines of the chunk in the band */
+    uint16_t *pixels;        /* chunk pixels, padded with fill */
+    unsigned char *data;     /* chunk as written to the file */
+    size_t size;             /* bytes of data */
+    uint32_t filter_mask;    /* filters skipped for the chunk */
+} WRITE_SLOT;
+
+struct ias_l0r_band_chunk_writer
+{
+    HDFIO *hdfio_ptr;        /* file written */
+    int band_number;         /* band written */
+    int band_index;          /* index of the band in the band info */
+    hid_t dataset_id;        /* image dataset written */
+    uint32_t line_extent;    /* lines of the dataset */
+    int sca_count;           /* SCAs of the band */
+    uint32_t detectors;      /* detectors per SCA */
+    size_t chunk_bytes;      /* bytes of a chunk before compression */
+    size_t data_capacity;    /* bytes allocated for a compressed chunk */
+    int shuffle_filter;      /* pipeline index of the shuffle filter or -1 */
+    int deflate_filter;      /* pipeline index of the deflate filter or -1 */
+    int deflate_level;       /* compression level of the deflate filter */
+
+    /* the slots are used in turn: chunk number n goes through slot
+       n % slot_count, so the chunks are compressed and written in the
+       order they were submitted */
+    WRITE_SLOT *slots;       /* chunks in flight */
+    int slot_count;          /* maximum number of chunks in flight */
+    long submitted;          /* number of chunks submitted */
+    long compressing;        /* number of chunks taken for compression */
+    long written;            /* number of chunks written */
+    int closing;             /* flag no more chunks will be submitted */
+    int status;              /* ERROR once a chunk failed */
+    IAS_THREAD_MUTEX_TYPE mutex; /* mutex for the slots and counters */
+    IAS_THREAD_COND changed; /* signaled when a slot changes state */
+    int mutex_created;       /* flag the mutex and condition were created */
+
+    struct ias_threadpool *compress_pool; /* threads compressing chunks */
+    int compress_thread_count; /* number of compressing threads */
+    unsigned char **scratch; /* shuffled chunk of each compressing thread */
+    struct ias_threadpool *io_pool; /* thread writing the chunks, NULL when
+                                       the calling thread writes them */
+};
+
+/******************************************************************************
+ Condition checks of the writer threads, called with the mutex locked
+******************************************************************************/
+static int compress_work_ready(void *param)
+{
+    const IAS_L0R_BAND_CHUNK_WRITER *writer = param;
+
+    return writer->status != SUCCESS || writer->closing ||
+        writer->compressing < writer->submitted;
+}
+
+static int next_write_ready(void *param)
+{
+    const IAS_L0R_BAND_CHUNK_WRITER *writer = param;
+
+    if (writer->status != SUCCESS)
+        return TRUE;
+    if (writer->written == writer->submitted)
+        return writer->closing;
+    return writer->slots[writer->written % writer->slot_count].state
+        == SLOT_COMPRESSED;
+}
+
+static int next_slot_free(void *param)
+{
+    const IAS_L0R_BAND_CHUNK_WRITER *writer = param;
+
+    return writer->status != SUCCESS ||
+        writer->slots[writer->submitted % writer->slot_count].state
+            == SLOT_FREE;
+}
+
+/******************************************************************************
+ NAME: compress_chunk
+
+ PURPOSE: Shuffles and deflates the pixels of a chunk like the HDF5 filters
+          of the dataset would.  Like the HDF5 deflate filter, a chunk that
+          does not get smaller is stored as is, with the filter skipped.
+
+ RETURNS: SUCCESS- The chunk was compressed
+          ERROR- zlib failed
+******************************************************************************/
+static int compress_chunk
+(
+    const IAS_L0R_BAND_CHUNK_WRITER *writer, /* I: writer */
+    WRITE_SLOT *slot,        /* I/O: chunk to compress */
+    unsigned char *scratch   /* I/O: buffer for the shuffled chunk */
+)
+{
+    unsigned char *bytes;
+    uLongf compressed_size;
+    size_t pixel_count;
+    size_t pixel;
+    int status;
+
+    slot->filter_mask = 0;
+    bytes = (writer->deflate_filter >= 0) ? scratch : slot->data;
+
+    /* the pixels are stored little endian, shuffled into all the low bytes
+       followed by all the high bytes */
+    pixel_count = writer->chunk_bytes / BYTES_PER_PIXEL;
+    if (writer->shuffle_filter >= 0)
+    {
+        for (pixel = 0; pixel < pixel_count; pixel++)
+        {
+            bytes[pixel] = slot->pixels[pixel] & 0xff;
+            bytes[pixel_count + pixel] = slot->pixels[pixel] >> 8;
+        }
+    }
+    else
+    {
+        for (pixel = 0; pixel < pixel_count; pixel++)
+        {
+            bytes[2 * pixel] = slot->pixels[pixel] & 0xff;
+            bytes[2 * pixel + 1] = slot->pixels[pixel] >> 8;
+        }
+    }
+    slot->size = writer->chunk_bytes;
+
+    if (writer->deflate_filter < 0)
+        return SUCCESS;
+
+    compressed_size = writer->data_capacity;
+    status = compress2(slot->data, &compressed_size, scratch,
+        writer->chunk_bytes, writer->deflate_level);
+    if (status != Z_OK)
+    {
+        IAS_LOG_ERROR("Deflating the chunk at line %u of SCA %d, zlib "
+            "status %d", slot->chunk_line, slot->sca, status);
+        return ERROR;
+    }
+    if (compressed_size < writer->chunk_bytes)
+    {
+        slot->size = compressed_size;
+    }
+    else
+    {
+        memcpy(slot->data, scratch, writer->chunk_bytes);
+        slot->filter_mask |= 1u << writer->deflate_filter;
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: compress_chunks
+
+ PURPOSE: Thread routine compressing the chunks submitted, in turn with the
+          other compressing threads, until the writer is closed.
+
+ RETURNS: SUCCESS- The chunks were compressed
+          ERROR- A chunk could not be compressed
+******************************************************************************/
+static int compress_chunks
+(
+    void *thread_params,     /* I: writer */
+    int thread_number        /* I: number of this thread */
+)
+{
+    IAS_L0R_BAND_CHUNK_WRITER *writer = thread_params;
+    WRITE_SLOT *slot;
+    int status = SUCCESS;
+
+    IAS_THREAD_LOCK_MUTEX(&writer->mutex);
+    while (status == SUCCESS)
+    {
+        if (ias_thread_wait_on_condition(&writer->mutex, &writer->changed,
+            compress_work_ready, writer) != SUCCESS)
+        {
+            status = ERROR;
+            break;
+        }
+        if (writer->status != SUCCESS ||
+            writer->compressing == writer->submitted)
+        {
+            /* failed, or closed with every chunk compressed */
+            break;
+        }
+        slot = &writer->slots[writer->compressing % writer->slot_count];
+        writer->compressing++;
+        IAS_THREAD_UNLOCK_MUTEX(&writer->mutex);
+
+        status = compress_chunk(writer, slot,
+            writer->scratch[thread_number % writer->compress_thread_count]);
+
+        IAS_THREAD_LOCK_MUTEX(&writer->mutex);
+        slot->state = SLOT_COMPRESSED;
+        ias_thread_broadcast_condition(&writer->mutex, &writer->changed);
+    }
+    if (status != SUCCESS)
+    {
+        writer->status = ERROR;
+        ias_thread_broadcast_condition(&writer->mutex, &writer->changed);
+    }
+    IAS_THREAD_UNLOCK_MUTEX(&writer->mutex);
+
+    return status;
+}
+
+/******************************************************************************
+ NAME: write_chunk
+
+ PURPOSE: Writes a compressed chunk to the dataset, extending the dataset
+          first when the chunk goes past its lines.
+
+ RETURNS: SUCCESS- The chunk was written
+          ERROR- The chunk could not be written
+******************************************************************************/
+static int write_chunk
+(
+    IAS_L0R_BAND_CHUNK_WRITER *writer, /* I/O: writer */
+    const WRITE_SLOT *slot   /* I: chunk to write */
+)
+{
+    BAND_INFO *band_info = &writer->hdfio_ptr->band_info[writer->band_index];
+    hsize_t offset[IAS_L0R_IMAGE_DIMENSIONS];
+    hsize_t dims[IAS_L0R_IMAGE_DIMENSIONS];
+
+    if (slot->chunk_line + slot->line_count > writer->line_extent)
+    {
+        dims[IAS_L0R_IMAGE_DIMENSION_SCA] = writer->sca_count;
+        dims[IAS_L0R_IMAGE_DIMENSION_LINE] = slot->chunk_line
+            + slot->line_count;
+        dims[IAS_L0R_IMAGE_DIMENSION_DETECTOR] = writer->detectors;
+        if (H5Dset_extent(writer->dataset_id, dims) < 0)
+        {
+            IAS_LOG_ERROR("Error setting extent");
+            return ERROR;
+        }
+
+        /* get a new dataspace for the dataset with the new extents  */
+        if (H5Sclose(band_info->image_dataspace_id) < 0)
+        {
+            IAS_LOG_ERROR("Error closing old dataspace");
+            return ERROR;
+        }
+        band_info->image_dataspace_id = H5Dget_space(writer->dataset_id);
+        if (band_info->image_dataspace_id < 0)
+        {
+            IAS_LOG_ERROR("Error getting the dataspace");
+            return ERROR;
+        }
+        writer->line_extent = dims[IAS_L0R_IMAGE_DIMENSION_LINE];
+    }
+
+    offset[IAS_L0R_IMAGE_DIMENSION_SCA] = slot->sca;
+    offset[IAS_L0R_IMAGE_DIMENSION_LINE] = slot->chunk_line;
+    offset[IAS_L0R_IMAGE_DIMENSION_DETECTOR] = 0;
+    if (H5Dwrite_chunk(writer->dataset_id, H5P_DEFAULT, slot->filter_mask,
+        offset, slot->size, slot->data) < 0)
+    {
+        IAS_LOG_ERROR("Writing the chunk at line %u of SCA %d of band %d",
+            slot->chunk_line, slot->sca, writer->band_number);
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: write_next_chunk
+
+ PURPOSE: Waits for the oldest chunk in flight to be compressed and writes
+          it.  Called with the mutex locked.
+
+ RETURNS: SUCCESS- The chunk was written, or there was none to write
+          ERROR- The writer failed
+******************************************************************************/
+static int write_next_chunk
+(
+    IAS_L0R_BAND_CHUNK_WRITER *writer /* I/O: writer */
+)
+{
+    WRITE_SLOT *slot;
+    int status;
+
+    if (ias_thread_wait_on_condition(&writer->mutex, &writer->changed,
+        next_write_ready, writer) != SUCCESS)
+    {
+        writer->status = ERROR;
+    }
+    if (writer->status != SUCCESS)
+        return ERROR;
+    if (writer->written == writer->submitted)
+        return SUCCESS;
+
+    slot = &writer->slots[writer->written % writer->slot_count];
+    IAS_THREAD_UNLOCK_MUTEX(&writer->mutex);
+    status = write_chunk(writer, slot);
+    IAS_THREAD_LOCK_MUTEX(&writer->mutex);
+
+    if (status != SUCCESS)
+        writer->status = ERROR;
+    slot->state = SLOT_FREE;
+    writer->written++;
+    ias_thread_broadcast_condition(&writer->mutex, &writer->changed);
+
+    return status;
+}
+
+/******************************************************************************
+ NAME: write_chunks
+
+ PURPOSE: I/O thread routine writing the chunks in the order they were
+          submitted until the writer is closed and every chunk is written.
+
+ RETURNS: SUCCESS- The chunks were written
+          ERROR- A chunk could not be written
+******************************************************************************/
+static int write_chunks
+(
+    void *thread_params,     /* I: writer */
+    int thread_number        /* I: number of this thread (unused) */
+)
+{
+    IAS_L0R_BAND_CHUNK_WRITER *writer = thread_params;
+    int status = SUCCESS;
+
+    IAS_THREAD_LOCK_MUTEX(&writer->mutex);
+    while (status == SUCCESS &&
+        !(writer->closing && writer->written == writer->submitted))
+    {
+        status = write_next_chunk(writer);
+    }
+    IAS_THREAD_UNLOCK_MUTEX(&writer->mutex);
+
+    return status;
+}
+
+/******************************************************************************
+ NAME: free_writer
+
+ PURPOSE: Stops the threads of a writer and frees it.
+
+ RETURNS: SUCCESS- Every thread completed its work
+          ERROR- A thread failed
+******************************************************************************/
+static int free_writer
+(
+    IAS_L0R_BAND_CHUNK_WRITER *writer /* I: writer to free */
+)
+{
+    int status = SUCCESS;
+    int index;
+
+    if (writer->compress_pool != NULL)
+    {
+        if (ias_threadpool_wait_for_completion(writer->compress_pool)
+            != SUCCESS)
+        {
+            status = ERROR;
+        }
+        ias_threadpool_destroy(writer->compress_pool);
+    }
+    if (writer->io_pool != NULL)
+    {
+        if (ias_threadpool_wait_for_completion(writer->io_pool) != SUCCESS)
+            status = ERROR;
+        ias_threadpool_destroy(writer->io_pool);
+    }
+    if (writer->mutex_created)
+    {
+        IAS_THREAD_DESTROY_COND(&writer->changed);
+        IAS_THREAD_DESTROY_MUTEX(&writer->mutex);
+    }
+
+    if (writer->scratch != NULL)
+    {
+        for (index = 0; index < writer->compress_thread_count; index++)
+            free(writer->scratch[index]);
+        free(writer->scratch);
+    }
+    if (writer->slots != NULL)
+    {
+        for (index = 0; index < writer->slot_count; index++)
+        {
+            free(writer->slots[index].pixels);
+            free(writer->slots[index].data);
+        }
+        free(writer->slots);
+    }
+    free(writer);
+
+    return status;
+}
+
+#endif
+
+/******************************************************************************
+ NAME: ias_l0r_open_band_chunk_writer
+
+ PURPOSE: Prepares the pipelined write of the image of a band.  The band
+          must be open for writing.  The rows of chunks given to
+          ias_l0r_write_band_chunk_row are compressed by thread_count threads
+          and written in order by an I/O thread, with at most
+          max_chunks_in_flight chunks of a SCA waiting to be compressed or
+          written, after which ias_l0r_write_band_chunk_row blocks.  The
+          image of the band must not be written by other routines while the
+          writer is open.
+
+ RETURNS: Pointer to the writer, or NULL on error
+******************************************************************************/
+IAS_L0R_BAND_CHUNK_WRITER *ias_l0r_open_band_chunk_writer
+(
+    L0RIO *l0r,            /* I: structure for the file used in I/O */
+    const int band_number, /* I: band number to write */
+    const int thread_count,/* I: number of threads compressing the chunks */
+    const int max_chunks_in_flight /* I: maximum number of chunks submitted
+                                         but not yet written */
+)
+{
+#if H5_VERSION_GE(1,10,3)
+    IAS_L0R_BAND_CHUNK_WRITER *writer = NULL;
+    const IAS_BAND_ATTRIBUTES *band_attributes = NULL;
+    hsize_t dims[IAS_L0R_IMAGE_DIMENSIONS];
+    hbool_t threadsafe = FALSE;
+    int status;
+    int index;
+
+    if (l0r == NULL)
+    {
+        IAS_LOG_ERROR("Error NULL pointer received");
+        return NULL;
+    }
+    if (thread_count < 1 || max_chunks_in_flight < 1)
+    {
+        IAS_LOG_ERROR("Invalid thread count %d or chunks in flight %d",
+            thread_count, max_chunks_in_flight);
+        return NULL;
+    }
+
+    band_attributes = ias_sat_attr_get_band_attributes(band_number);
+    if (band_attributes == NULL)
+    {
+        IAS_LOG_ERROR("Unable to get band attributes for band #%i",
+            band_number);
+        return NULL;
+    }
+
+    writer = malloc(sizeof(*writer));
+    if (writer == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the band chunk writer");
+        return NULL;
+    }
+    memset(writer, 0, sizeof(*writer));
+    writer->hdfio_ptr = l0r;
+    writer->band_number = band_number;
+    writer->band_index = band_attributes->band_index;
+    writer->sca_count = band_attributes->scas;
+    writer->detectors = band_attributes->detectors_per_sca;
+    writer->chunk_bytes = (size_t)IAS_L0R_BAND_CHUNK_LINES
+        * writer->detectors * BYTES_PER_PIXEL;
+    writer->data_capacity = compressBound(writer->chunk_bytes);
+    writer->slot_count = max_chunks_in_flight;
+    writer->compress_thread_count = thread_count;
+    writer->status = SUCCESS;
+
+    if (ias_l0r_establish_band_image_dataset(l0r, band_number, TRUE,
+        &writer->dataset_id) != SUCCESS)
+    {
+        free_writer(writer);
+        return NULL;
+    }
+    status = get_chunk_filters(writer->dataset_id, writer->detectors,
+        &writer->shuffle_filter, &writer->deflate_filter,
+        &writer->deflate_level);
+    if (status != SUCCESS)
+    {
+        if (status == WARNING)
+        {
+            IAS_LOG_ERROR("The image dataset of band %d is not laid out for "
+                "chunk writes", band_number);
+        }
+        free_writer(writer);
+        return NULL;
+    }
+    if (H5Sget_simple_extent_dims(l0r->band_info[writer->band_index].
+        image_dataspace_id, dims, NULL) != IAS_L0R_IMAGE_DIMENSIONS)
+    {
+        IAS_LOG_ERROR("Dataspace is not of the correct dimension");
+        free_writer(writer);
+        return NULL;
+    }
+    writer->line_extent = dims[IAS_L0R_IMAGE_DIMENSION_LINE];
+
+    writer->slots = calloc(writer->slot_count, sizeof(WRITE_SLOT));
+    writer->scratch = calloc(thread_count, sizeof(*writer->scratch));
+    if (writer->slots == NULL || writer->scratch == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the chunks in flight");
+        free_writer(writer);
+        return NULL;
+    }
+    for (index = 0; index < writer->slot_count; index++)
+    {
+        writer->slots[index].pixels = malloc(writer->chunk_bytes);
+        writer->slots[index].data = malloc(writer->data_capacity);
+        if (writer->slots[index].pixels == NULL ||
+            writer->slots[index].data == NULL)
+        {
+            IAS_LOG_ERROR("Allocating the chunks in flight");
+            free_writer(writer);
+            return NULL;
+        }
+    }
+    for (index = 0; index < thread_count; index++)
+    {
+        writer->scratch[index] = malloc(writer->chunk_bytes);
+        if (writer->scratch[index] == NULL)
+        {
+            IAS_LOG_ERROR("Allocating the compression buffers");
+            free_writer(writer);
+            return NULL;
+        }
+    }
+
+    if (IAS_THREAD_CREATE_MUTEX(&writer->mutex) != 0)
+    {
+        IAS_LOG_ERROR("Creating the mutex of the chunk writer");
+        free_writer(writer);
+        return NULL;
+    }
+    if (IAS_THREAD_CREATE_COND(&writer->changed) != 0)
+    {
+        IAS_LOG_ERROR("Creating the condition of the chunk writer");
+        IAS_THREAD_DESTROY_MUTEX(&writer->mutex);
+        free_writer(writer);
+        return NULL;
+    }
+    writer->mutex_created = TRUE;
+
+    writer->compress_pool = ias_threadpool_initialize(thread_count);
+    if (writer->compress_pool == NULL ||
+        ias_threadpool_start_function(writer->compress_pool,
+            compress_chunks, writer) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Starting the threads compressing band %d",
+            band_number);
+        if (writer->compress_pool != NULL)
+        {
+            ias_threadpool_destroy(writer->compress_pool);
+            writer->compress_pool = NULL;
+        }
+        free_writer(writer);
+        return NULL;
+    }
+
+    /* the I/O thread would make HDF5 calls concurrently with the caller */
+    if (H5is_library_threadsafe(&threadsafe) < 0 || !threadsafe)
+    {
+        IAS_LOG_DEBUG("The HDF5 library is not thread safe, the chunks of "
+            "band %d are written by the calling thread", band_number);
+    }
+    else
+    {
+        writer->io_pool = ias_threadpool_initialize(1);
+        if (writer->io_pool == NULL ||
+            ias_threadpool_start_function(writer->io_pool, write_chunks,
+                writer) != SUCCESS)
+        {
+            IAS_LOG_ERROR("Starting the thread writing band %d",
+                band_number);
+            if (writer->io_pool != NULL)
+            {
+                ias_threadpool_destroy(writer->io_pool);
+                writer->io_pool = NULL;
+            }
+            ias_l0r_close_band_chunk_writer(writer);
+            return NULL;
+        }
+    }
+
+    return writer;
+#else
+    IAS_LOG_ERROR("Writing chunks directly needs HDF5 1.10.3 or later");
+    return NULL;
+#endif
+}
+
+/******************************************************************************
+ NAME: ias_l0r_write_band_chunk_row
+
+ PURPOSE: Submits a row of chunks, lines of every SCA of the band starting
+          on a chunk boundary, to be compressed and written.  The lines are
+          copied, so the buffer can be reused as soon as the routine
+          returns.  Only the last row of the band may have fewer lines than
+          a chunk.
+
+ RETURNS: SUCCESS- The lines were submitted
+          ERROR- The lines are not a row of chunks or the writer failed
+******************************************************************************/
+int ias_l0r_write_band_chunk_row
+(
+    IAS_L0R_BAND_CHUNK_WRITER *writer, /* I: writer */
+    const uint32_t line_start, /* I: First line, a multiple of the chunk
+                                     lines */
+    const int line_count,  /* I: Number of lines, at most the chunk lines */
+    const uint16_t *image  /* I: Data to write, complete lines of data
+                                 ordered by [SCA][LINE][DETECTOR] */
+)
+{
+#if H5_VERSION_GE(1,10,3)
+    WRITE_SLOT *slot;
+    size_t sca_pixels;
+    int sca;
+    int status = SUCCESS;
+
+    if (writer == NULL || image == NULL)
+    {
+        IAS_LOG_ERROR("Error NULL pointer received");
+        return ERROR;
+    }
+    if (line_start % IAS_L0R_BAND_CHUNK_LINES != 0 || line_count < 1 ||
+        line_count > IAS_L0R_BAND_CHUNK_LINES)
+    {
+        IAS_LOG_ERROR("Lines %u to %u are not a row of chunks", line_start,
+            line_start + line_count - 1);
+        return ERROR;
+    }
+
+    sca_pixels = (size_t)line_count * writer->detectors;
+    for (sca = 0; sca < writer->sca_count && status == SUCCESS; sca++)
+    {
+        /* wait for the oldest chunk to leave the slot needed */
+        IAS_THREAD_LOCK_MUTEX(&writer->mutex);
+        while (writer->status == SUCCESS && !next_slot_free(writer))
+        {
+            if (writer->io_pool == NULL)
+                write_next_chunk(writer);
+            else if (ias_thread_wait_on_condition(&writer->mutex,
+                &writer->changed, next_slot_free, writer) != SUCCESS)
+            {
+                writer->status = ERROR;
+            }
+        }
+        status = writer->status;
+        IAS_THREAD_UNLOCK_MUTEX(&writer->mutex);
+        if (status != SUCCESS)
+            break;
+
+        /* the free slot belongs to this thread until it is submitted */
+        slot = &writer->slots[writer->submitted % writer->slot_count];
+        slot->sca = sca;
+        slot->chunk_line = line_start;
+        slot->line_count = line_count;
+        memcpy(slot->pixels, image + sca * sca_pixels,
+            sca_pixels * BYTES_PER_PIXEL);
+        memset(slot->pixels + sca_pixels, 0,
+            writer->chunk_bytes - sca_pixels * BYTES_PER_PIXEL);
+
+        IAS_THREAD_LOCK_MUTEX(&writer->mutex);
+        slot->state = SLOT_FILLED;
+        writer->submitted++;
+        ias_thread_broadcast_condition(&writer->mutex, &writer->changed);
+        IAS_THREAD_UNLOCK_MUTEX(&writer->mutex);
+    }
+
+    if (status != SUCCESS)
+    {
+        IAS_LOG_ERROR("Writing lines %u to %u of band %d", line_start,
+            line_start + line_count - 1, writer->band_number);
+        return ERROR;
+    }
+
+    return SUCCESS;
+#else
+    IAS_LOG_ERROR("Writing chunks directly needs HDF5 1.10.3 or later");
+    return ERROR;
+#endif
+}
+
+/******************************************************************************
+ NAME: ias_l0r_close_band_chunk_writer
+
+ PURPOSE: Waits for every chunk submitted to be written, stops the threads
+          and frees the writer.  The band stays open.
+
+ RETURNS: SUCCESS- Every chunk was written
+          ERROR- A chunk could not be written
+******************************************************************************/
+int ias_l0r_close_band_chunk_writer
+(
+    IAS_L0R_BAND_CHUNK_WRITER *writer /* I: writer to close */
+)
+{
+#if H5_VERSION_GE(1,10,3)
+    int status = SUCCESS;
+
+    if (writer == NULL)
+        return SUCCESS;
+
+    IAS_THREAD_LOCK_MUTEX(&writer->mutex);
+    writer->closing = TRUE;
+    ias_thread_broadcast_condition(&writer->mutex, &writer->changed);
+    if (writer->io_pool == NULL)
+    {
+        while (writer->status == SUCCESS &&
+            writer->written < writer->submitted)
+        {
+            write_next_chunk(writer);
+        }
+    }
+    IAS_THREAD_UNLOCK_MUTEX(&writer->mutex);
+
+    status = free_writer(writer);
+    if (status != SUCCESS)
+        IAS_LOG_ERROR("Writing the chunks of the band");
+
+    return status;
+#else
+    return SUCCESS;
+#endif
+}
@@ -0,0 +1,426 @@
+/*-----------------------------------------------------------------------------
+
+NAME: ias_l0r_band_iterator.c
+
+PURPOSE: Sequential reading of the image lines of a band.  The lines are
+         returned one row of chunks at a time, so each compressed chunk is
+         read and inflated once, and the next row can be read on a
+         background thread while the caller works on the current one.
+
+ALGORITHM REFERENCES: NONE
+
+NOTES: While a read is running on the background thread the caller must not
+       make HDF5 calls of its own, unless the HDF5 library was built thread
+       safe.  The prefetch is turned off when it is not, so the iterator can
+       be used with any HDF5 build.
+
+-----------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+
+/* project included headers */
+#include "ias_logging.h"
+#include "ias_l0r.h"
+#include "ias_l0r_hdf.h"
+#include "ias_types.h"
+#include "ias_satellite_attributes.h"
+#include "ias_threadpool.h"
+
+/* Number of line buffers, one returned to the caller and one being filled */
+#define NUMBER_OF_BUFFERS 2
+
+struct ias_l0r_band_line_iterator
+{
+    L0RIO *l0r;              /* file the lines are read from */
+    int band_number;         /* band read */
+    int sca_start;           /* first SCA read */
+    int sca_count;           /* number of SCAs read */
+    uint32_t detectors;      /* detectors per SCA */
+    uint32_t line_end;       /* one past the last line to return */
+    uint32_t next_line;      /* first line returned by the next call */
+    int status;              /* ERROR once a read failed */
+
+    uint16_t *buffers[NUMBER_OF_BUFFERS]; /* lines of a row of chunks,
+                                             ordered by [SCA][LINE][DETECTOR] */
+    int current_buffer;      /* buffer returned to the caller last */
+
+    struct ias_threadpool *prefetch_pool; /* background thread, NULL when not
+                                             prefetching */
+    int prefetch_pending;    /* flag a read was started on the thread */
+    uint32_t prefetch_line;  /* first line of the read started */
+    uint32_t prefetch_count; /* number of lines of the read started */
+};
+
+/******************************************************************************
+ NAME: block_line_count
+
+ PURPOSE: Finds the number of lines from the line given to the end of its
+          chunk row, limited to the lines of the iterator.
+
+ RETURNS: The number of lines
+******************************************************************************/
+static uint32_t block_line_count
+(
+    const IAS_L0R_BAND_LINE_ITERATOR *iterator, /* I: iterator */
+    uint32_t line             /* I: first line of the block */
+)
+{
+    uint32_t block_end;
+
+    block_end = (line / IAS_L0R_BAND_CHUNK_LINES + 1)
+        * IAS_L0R_BAND_CHUNK_LINES;
+    if (block_end > iterator->line_end)
+        block_end = iterator->line_end;
+
+    return block_end - line;
+}
+
+/******************************************************************************
+ NAME: read_block
+
+ PURPOSE: Reads the lines of every SCA of the iterator into a buffer.  The
+          block never crosses a chunk row, so each chunk is inflated once.
+
+ RETURNS: SUCCESS- The lines were read
+          ERROR- The lines could not be read
+******************************************************************************/
+static int read_block
+(
+    const IAS_L0R_BAND_LINE_ITERATOR *iterator, /* I: iterator */
+    uint32_t line_start,      /* I: First line to read */
+    uint32_t line_count,      /* I: Number of lines to read */
+    uint16_t *buffer          /* O: Lines ordered by [SCA][LINE][DETECTOR] */
+)
+{
+    int sca;
+
+    for (sca = 0; sca < iterator->sca_count; sca++)
+    {
+        if (ias_l0r_get_band_lines_sca(iterator->l0r, iterator->band_number,
+                iterator->sca_start + sca, line_start, 0, line_count,
+                iterator->detectors,
+                buffer + (size_t)sca * line_count * iterator->detectors)
+            != SUCCESS)
+        {
+            IAS_LOG_ERROR("Reading lines %u to %u of SCA %d of band %d",
+                line_start, line_start + line_count - 1,
+                iterator->sca_start + sca, iterator->band_number);
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: prefetch_block
+
+ PURPOSE: Thread routine reading the block started by start_prefetch into
+          the buffer not returned to the caller.
+
+ RETURNS: SUCCESS- The lines were read
+          ERROR- The lines could not be read
+******************************************************************************/
+static int prefetch_block
+(
+    void *params,             /* I: iterator */
+    int thread_number         /* I: thread number (unused) */
+)
+{
+    IAS_L0R_BAND_LINE_ITERATOR *iterator = params;
+
+    return read_block(iterator, iterator->prefetch_line,
+        iterator->prefetch_count,
+        iterator->buffers[(iterator->current_buffer + 1) % NUMBER_OF_BUFFERS]);
+}
+
+/******************************************************************************
+ NAME: start_prefetch
+
+ PURPOSE: Starts reading the block at the next line on the background thread,
+          when prefetching and lines are left.
+
+ RETURNS: SUCCESS- The read was started or there was nothing to start
+          ERROR- The read could not be started
+******************************************************************************/
+static int start_prefetch
+(
+    IAS_L0R_BAND_LINE_ITERATOR *iterator /* I/O: iterator */
+)
+{
+    if (iterator->prefetch_pool == NULL ||
+        iterator->next_line >= iterator->line_end)
+    {
+        return SUCCESS;
+    }
+
+    iterator->prefetch_line = iterator->next_line;
+    iterator->prefetch_count = block_line_count(iterator,
+        iterator->next_line);
+    if (ias_threadpool_start_function(iterator->prefetch_pool,
+            prefetch_block, iterator) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Starting the read of line %u of band %d",
+            iterator->prefetch_line, iterator->band_number);
+        return ERROR;
+    }
+    iterator->prefetch_pending = TRUE;
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_open_band_line_iterator
+
+ PURPOSE: Prepares the sequential read of the lines of a band.  The band
+          must be open for reading.  The lines are returned by
+          ias_l0r_get_next_band_lines one row of chunks at a time, with all
+          the detectors of the SCAs requested.
+
+          When prefetch is set the next row of chunks is read on a background
+          thread while the caller processes the current one, and the first
+          row is started here.
+
+ RETURNS: Pointer to the iterator, or NULL on error
+******************************************************************************/
+IAS_L0R_BAND_LINE_ITERATOR *ias_l0r_open_band_line_iterator
+(
+    L0RIO *l0r,                  /* I: structure for the file used in I/O */
+    const int band_number,       /* I: band number to read */
+    const int sca_start,         /* I: First SCA to read */
+    const int sca_count,         /* I: Number of SCAs to read */
+    const uint32_t line_start,   /* I: First line to read */
+    const uint32_t line_count,   /* I: Number of lines to read, 0 to read
+                                       to the end of the band */
+    const int prefetch           /* I: TRUE to read the next lines on a
+                                       background thread */
+)
+{
+    IAS_L0R_BAND_LINE_ITERATOR *iterator = NULL;
+    const IAS_BAND_ATTRIBUTES *band_attributes = NULL;
+    hbool_t threadsafe = FALSE;
+    size_t buffer_size;
+    int band_lines;
+    int index;
+
+    if (l0r == NULL)
+    {
+        IAS_LOG_ERROR("Error NULL pointer received");
+        return NULL;
+    }
+
+    band_attributes = ias_sat_attr_get_band_attributes(band_number);
+    if (band_attributes == NULL)
+    {
+        IAS_LOG_ERROR("Unable to get band attributes for band #%i",
+            band_number);
+        return NULL;
+    }
+
+    if (sca_start < 0 || sca_count < 1 ||
+        sca_start + sca_count > band_attributes->scas)
+    {
+        IAS_LOG_ERROR("SCAs %d to %d are not valid for band %d", sca_start,
+            sca_start + sca_count - 1, band_number);
+        return NULL;
+    }
+
+    if (ias_l0r_get_band_records_count(l0r, band_number, &band_lines)
+        != SUCCESS)
+    {
+        IAS_LOG_ERROR("Getting the number of lines of band %d", band_number);
+        return NULL;
+    }
+    if (line_start > (uint32_t)band_lines ||
+        (line_count > 0 &&
+         line_count > (uint32_t)band_lines - line_start))
+    {
+        IAS_LOG_ERROR("Lines %u to %u are past the %d lines of band %d",
+            line_start, line_start + line_count - 1, band_lines,
+            band_number);
+        return NULL;
+    }
+
+    iterator = malloc(sizeof(*iterator));
+    if (iterator == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the band line iterator");
+        return NULL;
+    }
+    memset(iterator, 0, sizeof(*iterator));
+
+    iterator->l0r = l0r;
+    iterator->band_number = band_number;
+    iterator->sca_start = sca_start;
+    iterator->sca_count = sca_count;
+    iterator->detectors = band_attributes->detectors_per_sca;
+    iterator->next_line = line_start;
+    if (line_count == 0)
+        iterator->line_end = band_lines;
+    else
+        iterator->line_end = line_start + line_count;
+    iterator->status = SUCCESS;
+
+    buffer_size = (size_t)sca_count * IAS_L0R_BAND_CHUNK_LINES
+        * iterator->detectors;
+    for (index = 0; index < NUMBER_OF_BUFFERS; index++)
+    {
+        iterator->buffers[index] = malloc(buffer_size * sizeof(uint16_t));
+        if (iterator->buffers[index] == NULL)
+        {
+            IAS_LOG_ERROR("Allocating the lines of band %d", band_number);
+            ias_l0r_close_band_line_iterator(iterator);
+            return NULL;
+        }
+    }
+
+    if (prefetch)
+    {
+        /* the thread would make HDF5 calls concurrently with the caller */
+        if (H5is_library_threadsafe(&threadsafe) < 0 || !threadsafe)
+        {
+            IAS_LOG_WARNING("The HDF5 library is not thread safe, reading "
+                "band %d without prefetching", band_number);
+        }
+        else
+        {
+            iterator->prefetch_pool = ias_threadpool_initialize(1);
+            if (iterator->prefetch_pool == NULL)
+            {
+                IAS_LOG_ERROR("Creating the prefetch thread of band %d",
+                    band_number);
+                ias_l0r_close_band_line_iterator(iterator);
+                return NULL;
+            }
+        }
+    }
+
+    if (start_prefetch(iterator) != SUCCESS)
+    {
+        ias_l0r_close_band_line_iterator(iterator);
+        return NULL;
+    }
+
+    return iterator;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_get_next_band_lines
+
+ PURPOSE: Returns the next lines of the iterator, up to the end of the
+          current row of chunks.  The lines stay valid until the next call
+          or until the iterator is closed.
+
+ RETURNS: SUCCESS- The lines were returned, or none are left
+          ERROR- The lines could not be read
+******************************************************************************/
+int ias_l0r_get_next_band_lines
+(
+    IAS_L0R_BAND_LINE_ITERATOR *iterator, /* I: iterator to advance */
+    const uint16_t **lines,      /* O: Image data ordered by
+                                       [SCA][LINE][DETECTOR], valid until
+                                       the next call */
+    uint32_t *line_start,        /* O: First line returned */
+    uint32_t *lines_read         /* O: Number of lines returned, 0 once all
+                                       the lines were returned */
+)
+{
+    uint32_t line_count;
+    int status;
+
+    if (iterator == NULL || lines == NULL || line_start == NULL ||
+        lines_read == NULL)
+    {
+        IAS_LOG_ERROR("Error NULL pointer received");
+        return ERROR;
+    }
+    if (iterator->status != SUCCESS)
+    {
+        IAS_LOG_ERROR("A previous read of band %d failed",
+            iterator->band_number);
+        return ERROR;
+    }
+
+    *lines = NULL;
+    *line_start = iterator->next_line;
+    *lines_read = 0;
+    if (iterator->next_line >= iterator->line_end)
+        return SUCCESS;
+
+    if (iterator->prefetch_pending)
+    {
+        /* the block was read into the other buffer by the thread */
+        status = ias_threadpool_wait_for_completion(iterator->prefetch_pool);
+        iterator->prefetch_pending = FALSE;
+        line_count = iterator->prefetch_count;
+        iterator->current_buffer = (iterator->current_buffer + 1)
+            % NUMBER_OF_BUFFERS;
+    }
+    else
+    {
+        line_count = block_line_count(iterator, iterator->next_line);
+        status = read_block(iterator, iterator->next_line, line_count,
+            iterator->buffers[iterator->current_buffer]);
+    }
+    if (status != SUCCESS)
+    {
+        IAS_LOG_ERROR("Reading line %u of band %d", iterator->next_line,
+            iterator->band_number);
+        iterator->status = ERROR;
+        return ERROR;
+    }
+
+    iterator->next_line += line_count;
+
+    /* read the next block while the caller works on this one */
+    if (start_prefetch(iterator) != SUCCESS)
+    {
+        iterator->status = ERROR;
+        return ERROR;
+    }
+
+    *lines = iterator->buffers[iterator->current_buffer];
+    *lines_read = line_count;
+
+    return SUCCESS;
+}
+
+/******************************************************************************
+ NAME: ias_l0r_close_band_line_iterator
+
+ PURPOSE: Waits for the read running on the background thread, if any, and
+          frees the iterator.  The band stays open.
+
+ RETURNS: SUCCESS- The iterator was freed
+          ERROR- The read running on the background thread failed
+******************************************************************************/
+int ias_l0r_close_band_line_iterator
+(
+    IAS_L0R_BAND_LINE_ITERATOR *iterator /* I: iterator to free */
+)
+{
+    int status = SUCCESS;
+    int index;
+
+    if (iterator == NULL)
+        return SUCCESS;
+
+    if (iterator->prefetch_pending)
+    {
+        status = ias_threadpool_wait_for_completion(iterator->prefetch_pool);
+        if (status != SUCCESS)
+        {
+            IAS_LOG_ERROR("Reading line %u of band %d",
+                iterator->prefetch_line, iterator->band_number);
+        }
+    }
+    if (iterator->prefetch_pool != NULL)
+        ias_threadpool_destroy(iterator->prefetch_pool);
+
+    for (index = 0; index < NUMBER_OF_BUFFERS; index++)
+        free(iterator->buffers[index]);
+    free(iterator);
+
+    return status;
+}
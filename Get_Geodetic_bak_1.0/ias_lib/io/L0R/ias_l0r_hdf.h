@@ -22,6 +22,17 @@ NOTES:
 
 #define IAS_L0R_HDF_PATH_MAX 256
 
+/* Lines in a chunk of the band image datasets.  A chunk covers one SCA. */
+#define IAS_L0R_BAND_CHUNK_LINES 128
+
+/* Rows of chunks (one chunk of every SCA) held by the chunk cache of a band
+   image dataset */
+#define IAS_L0R_BAND_CACHE_CHUNK_ROWS 2
+
+/* Hash table slots of the chunk cache per chunk it holds, following the
+   HDF5 guideline of about 100 slots per chunk to keep collisions rare */
+#define IAS_L0R_BAND_CACHE_SLOTS_PER_CHUNK 100
+
 typedef struct
 {
     hid_t file_id;        /* HDF ID used to access files */
@@ -138,6 +149,15 @@ int ias_l0r_hdf_object_exists
 );
 
 
+int ias_l0r_establish_band_image_dataset
+(
+    HDFIO *hdfio_ptr,           /* I: Pointer used in I/O */
+    const int band_number,      /* I: Band number of the dataset */
+    const int create_if_absent, /* I: TRUE to create the dataset, which
+                                      needs the band open for writing */
+    hid_t *dataset_id           /* O: Image dataset ID */
+);
+
 int ias_l0r_hdf_table_records_count
 (
     const hid_t file_id, /* I: HDF file ID */
@@ -18,6 +18,9 @@ NOTES:
 
 #include "ias_types.h"
 
+/* forward reference to the thread pool used by the parallel reads */
+struct ias_threadpool;
+
 /******************************************************************************
   General routines
 ******************************************************************************/
@@ -115,6 +118,19 @@ int ias_l0r_get_band_lines
                                 ordered by [SCA][LINE][DETECTOR] */
 );
 
+int ias_l0r_get_band_lines_parallel
+(
+    L0RIO *l0r,            /* I: structure for the file used in I/O */
+    const int band_number, /* I: band number */
+    const uint32_t line_number_start, /* I: First line to read */
+    const int line_count,  /* I: Number of lines to read */
+    const int line_size,   /* I: Number of pixels per line for which space
+                                 has been allocated for */
+    struct ias_threadpool *pool, /* I: threads inflating the chunks */
+    uint16_t *image_lines  /* O: Image data, complete lines of data
+                                 ordered by [SCA][LINE][DETECTOR] */
+);
+
 int ias_l0r_get_band_lines_sca
 (
     L0RIO *file,                 /* I: structure for the file used in I/O */
@@ -127,6 +143,35 @@ int ias_l0r_get_band_lines_sca
     uint16_t *lines              /* O: Image data */
 );
 
+IAS_L0R_BAND_LINE_ITERATOR *ias_l0r_open_band_line_iterator
+(
+    L0RIO *l0r,                  /* I: structure for the file used in I/O */
+    const int band_number,       /* I: band number to read */
+    const int sca_start,         /* I: First SCA to read */
+    const int sca_count,         /* I: Number of SCAs to read */
+    const uint32_t line_start,   /* I: First line to read */
+    const uint32_t line_count,   /* I: Number of lines to read, 0 to read
+                                       to the end of the band */
+    const int prefetch           /* I: TRUE to read the next lines on a
+                                       background thread */
+);
+
+int ias_l0r_get_next_band_lines
+(
+    IAS_L0R_BAND_LINE_ITERATOR *iterator, /* I: iterator to advance */
+    const uint16_t **lines,      /* O: Image data ordered by
+                                       [SCA][LINE][DETECTOR], valid until
+                                       the next call */
+    uint32_t *line_start,        /* O: First line returned */
+    uint32_t *lines_read         /* O: Number of lines returned, 0 once all
+                                       the lines were returned */
+);
+
+int ias_l0r_close_band_line_iterator
+(
+    IAS_L0R_BAND_LINE_ITERATOR *iterator /* I: iterator to free */
+);
+
 int ias_l0r_get_top_detector_offsets
 (
     L0RIO *file,           /* I: structure for the file used in I/O */
@@ -524,4 +569,90 @@ int ias_l0r_get_ancillary_oli_tirs_temperature_records_count
     int *size         /* O: number of records in this dataset */
 );
 
+int ias_l0r_get_ancillary_field_size
+(
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table of the field */
+    const char *field_name,       /* I: name of the field */
+    size_t *size                  /* O: size of a value of the field */
+);
+
+int ias_l0r_get_ancillary_table_fields
+(
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to describe */
+    int *field_count,             /* O: number of fields of the table */
+    const char ***field_names     /* O: names of the fields, not to be
+                                        freed */
+);
+
+int ias_l0r_get_ancillary_table_records_count
+(
+    L0RIO *l0r,                   /* I: structure for the file used in I/O */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to count */
+    int *size                     /* O: number of records in the table */
+);
+
+int ias_l0r_get_ancillary_fields
+(
+    L0RIO *l0r,                   /* I: structure for the file used in I/O */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to read */
+    const int field_count,        /* I: number of fields to read */
+    const char **field_names,     /* I: names of the fields to read */
+    const int index,              /* I: first record */
+    const int count,              /* I: number of records */
+    void **columns                /* O: one array of count values per field */
+);
+
+IAS_L0R_ANCILLARY_CURSOR *ias_l0r_open_ancillary_cursor
+(
+    L0RIO *l0r,                   /* I: structure for the file used in I/O */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table to read */
+    const int field_count,        /* I: number of fields to read */
+    const char **field_names,     /* I: names of the fields to read */
+    const int records_per_read    /* I: maximum number of records returned
+                                        by each read */
+);
+
+int ias_l0r_get_next_ancillary_fields
+(
+    IAS_L0R_ANCILLARY_CURSOR *cursor, /* I: cursor to advance */
+    void **columns,               /* O: one array per field, with room for
+                                        records_per_read values each */
+    int *index,                   /* O: first record returned */
+    int *records_read             /* O: number of records returned, 0 once
+                                        all the records were returned */
+);
+
+int ias_l0r_close_ancillary_cursor
+(
+    IAS_L0R_ANCILLARY_CURSOR *cursor /* I: cursor to free */
+);
+
+/*******************************************************************************
+*Ancillary snapshot
+*******************************************************************************/
+int ias_l0r_write_ancillary_snapshot
+(
+    L0RIO *l0r,                   /* I: L0R with the ancillary data open */
+    const char *snapshot_filename /* I: snapshot file to write */
+);
+
+IAS_L0R_ANCILLARY_SNAPSHOT *ias_l0r_open_ancillary_snapshot
+(
+    const char *snapshot_filename /* I: snapshot file to map */
+);
+
+int ias_l0r_get_ancillary_snapshot_column
+(
+    const IAS_L0R_ANCILLARY_SNAPSHOT *snapshot, /* I: mapped snapshot */
+    const IAS_L0R_ANCILLARY_TABLE table, /* I: table of the field */
+    const char *field_name,       /* I: name of the field */
+    const void **values,          /* O: values of the field */
+    int *count                    /* O: number of values */
+);
+
+int ias_l0r_close_ancillary_snapshot
+(
+    IAS_L0R_ANCILLARY_SNAPSHOT *snapshot /* I: snapshot to unmap */
+);
+
 #endif
@@ -1204,4 +1204,56 @@ typedef struct IAS_L0R_TIRS_FRAME_HEADER
 *******************************************************************************/
 typedef struct L0RIO L0RIO;
 
+/*******************************************************************************
+* IAS_L0R_BAND_LINE_ITERATOR
+*   Reads the lines of a band sequentially, one row of chunks at a time, see
+*   ias_l0r_open_band_line_iterator
+*******************************************************************************/
+typedef struct ias_l0r_band_line_iterator IAS_L0R_BAND_LINE_ITERATOR;
+
+/*******************************************************************************
+* IAS_L0R_BAND_CHUNK_WRITER
+*   Compresses and writes the image of a band a row of chunks at a time, see
+*   ias_l0r_open_band_chunk_writer
+*******************************************************************************/
+typedef struct ias_l0r_band_chunk_writer IAS_L0R_BAND_CHUNK_WRITER;
+
+/*******************************************************************************
+* IAS_L0R_ANCILLARY_TABLE
+*   Identifies the ancillary table read by ias_l0r_get_ancillary_fields
+*******************************************************************************/
+typedef enum IAS_L0R_ANCILLARY_TABLE
+{
+    IAS_L0R_ANCILLARY_ATTITUDE,
+    IAS_L0R_ANCILLARY_ATTITUDE_FILTER,
+    IAS_L0R_ANCILLARY_EPHEMERIS,
+    IAS_L0R_ANCILLARY_GPS_POSITION,
+    IAS_L0R_ANCILLARY_GPS_RANGE,
+    IAS_L0R_ANCILLARY_IMU,
+    IAS_L0R_ANCILLARY_IMU_LATENCY,
+    IAS_L0R_ANCILLARY_OLI_TELEMETRY_GROUP_3,
+    IAS_L0R_ANCILLARY_OLI_TELEMETRY_GROUP_4,
+    IAS_L0R_ANCILLARY_OLI_TELEMETRY_GROUP_5,
+    IAS_L0R_ANCILLARY_TIRS_TELEMETRY,
+    IAS_L0R_ANCILLARY_STAR_TRACKER_CENTROID,
+    IAS_L0R_ANCILLARY_STAR_TRACKER_QUATERNION,
+    IAS_L0R_ANCILLARY_GYRO_TEMPERATURE,
+    IAS_L0R_ANCILLARY_OLI_TIRS_TEMPERATURE,
+    IAS_L0R_ANCILLARY_TABLE_COUNT /* number of tables, not a table */
+}IAS_L0R_ANCILLARY_TABLE;
+
+/*******************************************************************************
+* IAS_L0R_ANCILLARY_CURSOR
+*   Reads selected fields of an ancillary table a batch of records at a time,
+*   see ias_l0r_open_ancillary_cursor
+*******************************************************************************/
+typedef struct ias_l0r_ancillary_cursor IAS_L0R_ANCILLARY_CURSOR;
+
+/*******************************************************************************
+* IAS_L0R_ANCILLARY_SNAPSHOT
+*   Mapped snapshot of the attitude, ephemeris and IMU tables, see
+*   ias_l0r_open_ancillary_snapshot
+*******************************************************************************/
+typedef struct ias_l0r_ancillary_snapshot IAS_L0R_ANCILLARY_SNAPSHOT;
+
 #endif
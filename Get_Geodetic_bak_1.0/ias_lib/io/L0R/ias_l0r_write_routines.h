@@ -31,6 +31,30 @@ int ias_l0r_set_band_lines
                                     ordered by [SCA][LINE][DETECTOR] */
 );
 
+IAS_L0R_BAND_CHUNK_WRITER *ias_l0r_open_band_chunk_writer
+(
+    L0RIO *l0r,            /* I: structure for the file used in I/O */
+    const int band_number, /* I: band number to write */
+    const int thread_count,/* I: number of threads compressing the chunks */
+    const int max_chunks_in_flight /* I: maximum number of chunks submitted
+                                         but not yet written */
+);
+
+int ias_l0r_write_band_chunk_row
+(
+    IAS_L0R_BAND_CHUNK_WRITER *writer, /* I: writer */
+    const uint32_t line_start, /* I: First line, a multiple of the chunk
+                                     lines */
+    const int line_count,  /* I: Number of lines, at most the chunk lines */
+    const uint16_t *image  /* I: Data to write, complete lines of data
+                                 ordered by [SCA][LINE][DETECTOR] */
+);
+
+int ias_l0r_close_band_chunk_writer
+(
+    IAS_L0R_BAND_CHUNK_WRITER *writer /* I: writer to close */
+);
+
 int ias_l0r_truncate_band_lines
 (
     L0RIO *l0r,              /* I: structure used with the L0R data */
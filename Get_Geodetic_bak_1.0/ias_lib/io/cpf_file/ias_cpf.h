@@ -33,6 +33,8 @@ Notes:
 #define IAS_CPF_LOS_EPHEMERIS_APRI_COUNT 12 /* los model correction parameter */
 #define IAS_CPF_LOS_ATTITUDE_APRI_COUNT 12 /* los model correction parameter */
 #define IAS_CPF_LOS_OBSERVATION_APRI_COUNT 2 /* los model correction parameter */
+#define IAS_CPF_SNAPSHOT_SUFFIX ".snap" /* snapshot of the parsed groups,
+                                           next to the CPF file */
 /***********************************************************************
   The structures to go into the IAS L8 OLI/TIRS CPF structure
 ***********************************************************************/
@@ -758,4 +760,10 @@ void ias_cpf_free
     IAS_CPF *cpf
 );
 
+int ias_cpf_write_snapshot
+(
+    IAS_CPF *cpf,                   /* I: CPF with the groups to save */
+    const char *snapshot_filename   /* I: snapshot file name */
+);
+
 #endif
@@ -7,7 +7,9 @@ PURPOSE: The ODL routines are extremely slow when parsing a huge ODL file like
     memory.  When specific fields are needed from the CPF, the respective
     "get" routine will use these routines to find the individual group
     needed and parse only that group with the ODL routines.  That speeds
-    up the CPF access by at least two orders of magnitude.
+    up the CPF access by at least two orders of magnitude.  The byte ranges
+    of all the groups are indexed in a single pass when the file is read,
+    so finding a group does not scan the buffer again.
 
 **************************************************************************/
 
@@ -141,37 +143,202 @@ int ias_cpf_cache_file
 
     /* terminate the buffer with a null terminator */
     cpf->raw_file_buffer[size] = '\0';
+    cpf->raw_file_size = size;
 
     /* close the file */
     fclose(file);
 
+    /* index the groups of the buffer */
+    if (ias_cpf_index_groups(cpf) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Indexing the groups of CPF file %s", filename);
+        free(cpf->raw_file_buffer);
+        cpf->raw_file_buffer = NULL;
+        return ERROR;
+    }
+
     return SUCCESS;
 }
 
 /*****************************************************************************
-NAME:  ias_cpf_get_odl_tree_from_cache
+NAME:  compare_group_index_entries
 
-PURPOSE: Finds the requested group in the CPF raw_file_buffer and parses it
-    into an ODL tree for parsing.
+PURPOSE: Comparison function for qsort and bsearch of the group index.  The
+    groups are sorted by name, then by position in the file.
 
-RETURNS:
-    Pointer to the ODL tree or NULL if an error occurs.
+RETURNS: <0, 0 or >0 as the first entry sorts before, with or after the second
 
 ******************************************************************************/
-IAS_OBJ_DESC *ias_cpf_get_odl_tree_from_cache
+static int compare_group_index_entries
+(
+    const void *entry1,
+    const void *entry2
+)
+{
+    const IAS_CPF_GROUP_INDEX_ENTRY *a = entry1;
+    const IAS_CPF_GROUP_INDEX_ENTRY *b = entry2;
+    int result;
+
+    result = strcmp(a->name, b->name);
+    if (result != 0)
+        return result;
+    if (a->start < b->start)
+        return -1;
+    return (a->start > b->start);
+}
+
+/*****************************************************************************
+NAME:  ias_cpf_index_groups
+
+PURPOSE: Records the byte range of every group of the CPF raw_file_buffer in
+    a single pass over its lines.  A group starts at a "GROUP = name" line
+    and ends at the next "END_GROUP = name" line, with the same spacing
+    rules as the search of ias_cpf_get_odl_tree_from_cache.  When a group
+    name appears more than once, the first one in the file is kept like the
+    search did.
+
+RETURNS: SUCCESS or ERROR
+
+******************************************************************************/
+int ias_cpf_index_groups
+(
+    IAS_CPF *cpf            /* I/O: CPF struct to index the buffer of */
+)
+{
+    const char *group_string = "GROUP = ";
+    const char *end_group_string = "END_GROUP = ";
+    int group_len = strlen(group_string);
+    int end_group_len = strlen(end_group_string);
+    IAS_CPF_GROUP_INDEX_ENTRY *entries = NULL;
+    IAS_CPF_GROUP_INDEX_ENTRY *new_entries;
+    int num_entries = 0;
+    int capacity = 0;
+    int num_kept;
+    int name_len;
+    int index;
+    char *line;
+    char *name;
+
+    free(cpf->group_index);
+    cpf->group_index = NULL;
+    cpf->num_groups = 0;
+
+    for (line = cpf->raw_file_buffer; line && *line; )
+    {
+        /* skip the indentation */
+        while (*line == ' ' || *line == '\t')
+            line++;
+
+        if (strncmp(line, group_string, group_len) == 0)
+        {
+            name = line + group_len;
+            name_len = strcspn(name, " \t\r\n");
+            if (name_len > 0 && name_len < IAS_CPF_GROUP_NAME_LENGTH
+                && (name[name_len] == ' ' || name[name_len] == '\r'
+                    || name[name_len] == '\n'))
+            {
+                if (num_entries == capacity)
+                {
+                    capacity = (capacity == 0) ? 64 : capacity * 2;
+                    new_entries = realloc(entries,
+                        capacity * sizeof(*entries));
+                    if (!new_entries)
+                    {
+                        IAS_LOG_ERROR("Allocating the CPF group index");
+                        free(entries);
+                        return ERROR;
+                    }
+                    entries = new_entries;
+                }
+                memcpy(entries[num_entries].name, name, name_len);
+                entries[num_entries].name[name_len] = '\0';
+                entries[num_entries].start = line - cpf->raw_file_buffer;
+                entries[num_entries].end = -1;
+                num_entries++;
+            }
+        }
+        else if (strncmp(line, end_group_string, end_group_len) == 0)
+        {
+            /* close the latest open group of that name */
+            name = line + end_group_len;
+            name_len = strcspn(name, " \t\r\n");
+            for (index = num_entries - 1; index >= 0; index--)
+            {
+                if (entries[index].end < 0
+                    && strlen(entries[index].name) == name_len
+                    && strncmp(entries[index].name, name, name_len) == 0)
+                {
+                    entries[index].end = name + name_len
+                        - cpf->raw_file_buffer;
+                    break;
+                }
+            }
+        }
+
+        line = strchr(line, '\n');
+        if (line)
+            line++;
+    }
+
+    /* sort by name, keeping the first complete group of each name */
+    qsort(entries, num_entries, sizeof(*entries), compare_group_index_entries);
+    num_kept = 0;
+    for (index = 0; index < num_entries; index++)
+    {
+        if (entries[index].end < 0)
+            continue;
+        if (num_kept > 0
+            && strcmp(entries[num_kept - 1].name, entries[index].name) == 0)
+            continue;
+        entries[num_kept++] = entries[index];
+    }
+
+    cpf->group_index = entries;
+    cpf->num_groups = num_kept;
+
+    return SUCCESS;
+}
+
+/*****************************************************************************
+NAME:  compare_group_name
+
+PURPOSE: Comparison function for bsearch of a group name in the group index.
+
+RETURNS: <0, 0 or >0 as the name sorts before, with or after the entry
+
+******************************************************************************/
+static int compare_group_name
+(
+    const void *name,
+    const void *entry
+)
+{
+    return strcmp(name, ((const IAS_CPF_GROUP_INDEX_ENTRY *)entry)->name);
+}
+
+/*****************************************************************************
+NAME:  search_group
+
+PURPOSE: Searches the CPF raw_file_buffer for a group that is not in the
+    group index.
+
+RETURNS: SUCCESS or ERROR
+
+******************************************************************************/
+static int search_group
 (
     const IAS_CPF *cpf,         /* I: CPF to use */
-    const char *group_name      /* I: group name to look for */
+    const char *group_name,     /* I: group name to look for */
+    char **group_start,         /* O: start of the group */
+    int *group_size             /* O: size of the group */
 )
 {
     char start_string[1000];
     char end_string[1000];
     char *start;
     char *end;
-    int group_size;
     int str_len;                /* start or end string length */
     int done;                   /* while loop control */
-    IAS_OBJ_DESC *tree;
     int return_value;
 
     /* Create the strings that define the start and end of the group wanted.
@@ -183,7 +350,7 @@ IAS_OBJ_DESC *ias_cpf_get_odl_tree_from_cache
     if (return_value < 0 || return_value >= sizeof(start_string))
     {
         IAS_LOG_ERROR("Creating the start_string");
-        return NULL;
+        return ERROR;
     }
 
     return_value = snprintf(end_string, sizeof(end_string), "END_GROUP = %s", 
@@ -191,7 +358,7 @@ IAS_OBJ_DESC *ias_cpf_get_odl_tree_from_cache
     if (return_value < 0 || return_value >= sizeof(end_string))
     {
         IAS_LOG_ERROR("Creating the end_string");
-        return NULL;
+        return ERROR;
     }
 
     /* search the raw buffer for the start of the wanted group */
@@ -207,7 +374,7 @@ IAS_OBJ_DESC *ias_cpf_get_odl_tree_from_cache
         if (!start)
         {
             IAS_LOG_ERROR("%s Group not found in CPF", group_name);
-            return NULL;
+            return ERROR;
         }
         
         /* check for new line, carriage return or space */
@@ -222,11 +389,53 @@ IAS_OBJ_DESC *ias_cpf_get_odl_tree_from_cache
     if (!end)
     {
         IAS_LOG_ERROR("%s Group not terminated in CPF", group_name);
-        return NULL;
+        return ERROR;
     }
 
     /* calculate the size of the buffer */
-    group_size = end - start + strlen(end_string);
+    *group_start = start;
+    *group_size = end - start + strlen(end_string);
+
+    return SUCCESS;
+}
+
+/*****************************************************************************
+NAME:  ias_cpf_get_odl_tree_from_cache
+
+PURPOSE: Finds the requested group in the CPF raw_file_buffer and parses it
+    into an ODL tree for parsing.
+
+RETURNS:
+    Pointer to the ODL tree or NULL if an error occurs.
+
+******************************************************************************/
+IAS_OBJ_DESC *ias_cpf_get_odl_tree_from_cache
+(
+    const IAS_CPF *cpf,         /* I: CPF to use */
+    const char *group_name      /* I: group name to look for */
+)
+{
+    const IAS_CPF_GROUP_INDEX_ENTRY *entry = NULL;
+    char *start;
+    int group_size;
+    IAS_OBJ_DESC *tree;
+
+    /* take the byte range of the group from the index, and only search the
+       buffer for a group the index does not have */
+    if (cpf->group_index)
+    {
+        entry = bsearch(group_name, cpf->group_index, cpf->num_groups,
+                        sizeof(*entry), compare_group_name);
+    }
+    if (entry)
+    {
+        start = cpf->raw_file_buffer + entry->start;
+        group_size = entry->end - entry->start;
+    }
+    else if (search_group(cpf, group_name, &start, &group_size) != SUCCESS)
+    {
+        return NULL;
+    }
 
 /* This code will need to be compiled on Solaris and fmemopen is not available
    on that platform so will need to handle the reading of cpf groups the 
@@ -235,8 +235,9 @@ void ias_cpf_free
         FREE_AND_NULL(cpf->cc_assessment.algorithm_names);
         FREE_AND_NULL(cpf->cc_assessment.weights);
     }
-    /* free the buffer with the file contents */
+    /* free the buffer with the file contents and its group index */
     FREE_AND_NULL(cpf->raw_file_buffer);
+    FREE_AND_NULL(cpf->group_index);
 
     /* free the CPF structure */
     free(cpf);
@@ -58,6 +58,21 @@ struct IAS_CPF *ias_cpf_read
         return NULL;
     }
 
+    /* restore the groups a previous run saved for this CPF, the others are
+       parsed from the buffer on first access */
+    if (strlen(filename) + strlen(IAS_CPF_SNAPSHOT_SUFFIX) < PATH_MAX)
+    {
+        char snapshot_filename[PATH_MAX];
+
+        sprintf(snapshot_filename, "%s%s", filename, IAS_CPF_SNAPSHOT_SUFFIX);
+        if (ias_cpf_read_snapshot(snapshot_filename, cpf) == ERROR)
+        {
+            IAS_LOG_ERROR("Reading CPF snapshot %s", snapshot_filename);
+            ias_cpf_free(cpf);
+            return NULL;
+        }
+    }
+
     return cpf;
 }
 
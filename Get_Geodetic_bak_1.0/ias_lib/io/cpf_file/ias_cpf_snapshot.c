@@ -0,0 +1,446 @@
+/*************************************************************************
+
+NAME: ias_cpf_snapshot
+
+PURPOSE: Even parsing only the groups needed, the ODL parse of the CPF groups
+    is a fixed cost for every scene processed with the same CPF.  The
+    snapshot file keeps the parsed groups in binary form next to the CPF, so
+    later runs map it and copy the groups into the CPF structure instead of
+    parsing them.  A snapshot only applies to the CPF contents it was made
+    from, which is checked with the size and a checksum of the CPF file.
+
+    Only the groups whose structure holds no pointer are saved, plus the
+    earth constants whose leap second arrays are saved after the structure.
+    The other groups are always parsed from the buffer on first access.
+
+**************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include "ias_cpf.h"
+#include "local_defines.h"
+#include "ias_logging.h"
+
+/* Header of the snapshot file, followed by the groups */
+typedef struct IAS_CPF_SNAPSHOT_HEADER
+{
+    char magic[8];
+    int version;
+    int num_groups;                 /* number of groups in the file */
+    long long cpf_size;             /* size of the CPF file */
+    unsigned long long cpf_checksum; /* checksum of the CPF file */
+} IAS_CPF_SNAPSHOT_HEADER;
+
+/* Header of a group, followed by its structure and arrays */
+typedef struct IAS_CPF_SNAPSHOT_GROUP_HEADER
+{
+    char name[32];                  /* name of the group in the table */
+    int size;                       /* size of the structure */
+    int array_size;                 /* size of the arrays after it */
+} IAS_CPF_SNAPSHOT_GROUP_HEADER;
+
+/* Group of the CPF structure that can be saved, and its loaded flag */
+typedef struct SNAPSHOT_GROUP
+{
+    const char *name;
+    size_t offset;
+    size_t size;
+    size_t loaded_offset;
+} SNAPSHOT_GROUP;
+
+#define SNAPSHOT_GROUP(member, loaded) \
+    { #member, offsetof(IAS_CPF, member), sizeof(((IAS_CPF *)0)->member), \
+      offsetof(IAS_CPF, loaded) }
+
+static const SNAPSHOT_GROUP snapshot_groups[] =
+{
+    SNAPSHOT_GROUP(ancil_eng_conv, ancil_eng_conv_loaded),
+    SNAPSHOT_GROUP(ancil_qa_thresholds, ancil_qa_thresh_loaded),
+    SNAPSHOT_GROUP(attitude, attitude_loaded),
+    SNAPSHOT_GROUP(b2b_assess, b2b_assess_loaded),
+    SNAPSHOT_GROUP(earth, earth_loaded),
+    SNAPSHOT_GROUP(file_attribs, file_attribs_loaded),
+    SNAPSHOT_GROUP(focal_plane, focal_plane_loaded),
+    SNAPSHOT_GROUP(fp_cal, fp_cal_loaded),
+    SNAPSHOT_GROUP(gcp_corr, gcp_corr_loaded),
+    SNAPSHOT_GROUP(geo_sys, geo_sys_loaded),
+    SNAPSHOT_GROUP(histogram_char, histogram_char_loaded),
+    SNAPSHOT_GROUP(i2i_assess, i2i_assess_loaded),
+    SNAPSHOT_GROUP(impulse_noise, impulse_noise_loaded),
+    SNAPSHOT_GROUP(los_model_correction, los_model_correction_loaded),
+    SNAPSHOT_GROUP(lunar_irrad, lunar_irrad_loaded),
+    SNAPSHOT_GROUP(oli_parameters, oli_parameter_loaded),
+    SNAPSHOT_GROUP(orbit, orbit_loaded),
+    SNAPSHOT_GROUP(radiance_rescale, radiance_rescale_loaded),
+    SNAPSHOT_GROUP(reflect_conv, reflect_conv_loaded),
+    SNAPSHOT_GROUP(sca_parms, sca_parm_loaded),
+    SNAPSHOT_GROUP(tirs_align_cal, tirs_align_cal_loaded),
+    SNAPSHOT_GROUP(tirs_parameters, tirs_parameter_loaded),
+    SNAPSHOT_GROUP(tirs_thermal_constants, tirs_thermal_constants_loaded),
+    SNAPSHOT_GROUP(ut1_times, ut1_times_loaded)
+};
+
+#define NUM_SNAPSHOT_GROUPS \
+    (int)(sizeof(snapshot_groups) / sizeof(snapshot_groups[0]))
+
+/* Number of leap second arrays of the earth constants */
+#define NUM_LEAP_SECONDS_ARRAYS 4
+
+/*****************************************************************************
+NAME:  compute_checksum
+
+PURPOSE: Computes the 64 bit FNV-1a hash of the CPF raw file buffer.
+
+RETURNS: The checksum
+
+******************************************************************************/
+static unsigned long long compute_checksum
+(
+    const IAS_CPF *cpf          /* I: CPF to checksum */
+)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned char *byte = (const unsigned char *)cpf->raw_file_buffer;
+    long index;
+
+    for (index = 0; index < cpf->raw_file_size; index++)
+    {
+        hash ^= byte[index];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*****************************************************************************
+NAME:  get_leap_seconds_arrays
+
+PURPOSE: Returns the addresses of the pointers to the leap second arrays of
+    the earth constants, in the order they are saved.
+
+RETURNS: Nothing
+
+******************************************************************************/
+static void get_leap_seconds_arrays
+(
+    IAS_CPF *cpf,               /* I: CPF to use */
+    int **arrays[NUM_LEAP_SECONDS_ARRAYS] /* O: pointers to the arrays */
+)
+{
+    IAS_MATH_LEAP_SECONDS_DATA *leap = &cpf->earth.leap_seconds_data;
+
+    arrays[0] = &leap->leap_years;
+    arrays[1] = &leap->leap_months;
+    arrays[2] = &leap->leap_days;
+    arrays[3] = &leap->num_leap_seconds;
+}
+
+/*****************************************************************************
+NAME:  count_loaded_groups
+
+PURPOSE: Counts the groups of the snapshot table loaded in the CPF.
+
+RETURNS: The number of loaded groups
+
+******************************************************************************/
+static int count_loaded_groups
+(
+    const IAS_CPF *cpf          /* I: CPF to use */
+)
+{
+    int count = 0;
+    int index;
+
+    for (index = 0; index < NUM_SNAPSHOT_GROUPS; index++)
+    {
+        if (*(const int *)((const char *)cpf
+                + snapshot_groups[index].loaded_offset))
+            count++;
+    }
+
+    return count;
+}
+
+/*****************************************************************************
+NAME:  restore_group
+
+PURPOSE: Copies a group of the mapped snapshot into the CPF structure and
+    sets its loaded flag.  A group already loaded is left alone.
+
+RETURNS: SUCCESS, WARNING if the group does not match the table, or ERROR
+
+******************************************************************************/
+static int restore_group
+(
+    const IAS_CPF_SNAPSHOT_GROUP_HEADER *group_header, /* I: group header */
+    const char *data,           /* I: structure and arrays of the group */
+    IAS_CPF *cpf                /* I/O: CPF to restore the group into */
+)
+{
+    const SNAPSHOT_GROUP *group = NULL;
+    int *loaded;
+    int **arrays[NUM_LEAP_SECONDS_ARRAYS];
+    int count;
+    int index;
+
+    for (index = 0; index < NUM_SNAPSHOT_GROUPS; index++)
+    {
+        if (strncmp(group_header->name, snapshot_groups[index].name,
+                    sizeof(group_header->name)) == 0)
+        {
+            group = &snapshot_groups[index];
+            break;
+        }
+    }
+    if (!group || group_header->size != group->size)
+        return WARNING;
+
+    loaded = (int *)((char *)cpf + group->loaded_offset);
+    if (*loaded)
+        return SUCCESS;
+
+    if (group->offset != offsetof(IAS_CPF, earth))
+    {
+        if (group_header->array_size != 0)
+            return WARNING;
+        memcpy((char *)cpf + group->offset, data, group->size);
+        *loaded = 1;
+        return SUCCESS;
+    }
+
+    /* the earth constants are followed by the leap second arrays */
+    memcpy(&count, data + offsetof(IAS_CPF_EARTH_CONSTANTS, leap_seconds_data)
+           + offsetof(IAS_MATH_LEAP_SECONDS_DATA, leap_seconds_count),
+           sizeof(count));
+    if (count < 0 || group_header->array_size
+        != NUM_LEAP_SECONDS_ARRAYS * count * (int)sizeof(int))
+        return WARNING;
+
+    memcpy(&cpf->earth, data, group->size);
+    get_leap_seconds_arrays(cpf, arrays);
+    for (index = 0; index < NUM_LEAP_SECONDS_ARRAYS; index++)
+        *arrays[index] = NULL;
+    for (index = 0; index < NUM_LEAP_SECONDS_ARRAYS; index++)
+    {
+        *arrays[index] = malloc(count * sizeof(int) + 1);
+        if (!*arrays[index])
+        {
+            IAS_LOG_ERROR("Allocating the leap seconds arrays");
+            for (index = 0; index < NUM_LEAP_SECONDS_ARRAYS; index++)
+            {
+                free(*arrays[index]);
+                *arrays[index] = NULL;
+            }
+            return ERROR;
+        }
+        memcpy(*arrays[index], data + group->size
+               + index * count * sizeof(int), count * sizeof(int));
+    }
+    *loaded = 1;
+
+    return SUCCESS;
+}
+
+/*****************************************************************************
+NAME:  ias_cpf_read_snapshot
+
+PURPOSE: Maps the snapshot file of the CPF and restores its groups into the
+    CPF structure.  A missing snapshot, or one made from other CPF contents
+    or by another version of the library, is ignored.
+
+RETURNS: SUCCESS, WARNING if the snapshot is not used, or ERROR
+
+******************************************************************************/
+int ias_cpf_read_snapshot
+(
+    const char *snapshot_filename, /* I: snapshot file name */
+    IAS_CPF *cpf                /* I/O: CPF struct to restore groups into */
+)
+{
+    IAS_CPF_SNAPSHOT_HEADER header;
+    IAS_CPF_SNAPSHOT_GROUP_HEADER group_header;
+    struct stat st;
+    char *memblock;
+    long long offset;
+    int fd;
+    int index;
+    int status = SUCCESS;
+
+    fd = open(snapshot_filename, O_RDONLY);
+    if (fd < 0)
+        return WARNING;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(header))
+    {
+        close(fd);
+        return WARNING;
+    }
+
+    memblock = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memblock == MAP_FAILED)
+    {
+        IAS_LOG_WARNING("Could not map the CPF snapshot %s",
+                        snapshot_filename);
+        return WARNING;
+    }
+
+    memcpy(&header, memblock, sizeof(header));
+    if (strncmp(header.magic, IAS_CPF_SNAPSHOT_MAGIC, sizeof(header.magic))
+            != 0
+        || header.version != IAS_CPF_SNAPSHOT_VERSION
+        || header.cpf_size != cpf->raw_file_size
+        || header.cpf_checksum != compute_checksum(cpf))
+    {
+        IAS_LOG_WARNING("Ignoring the CPF snapshot %s made from another CPF",
+                        snapshot_filename);
+        munmap(memblock, st.st_size);
+        return WARNING;
+    }
+
+    /* restore the groups one after the other */
+    offset = sizeof(header);
+    for (index = 0; index < header.num_groups && status != ERROR; index++)
+    {
+        if (offset + (long long)sizeof(group_header) > st.st_size)
+        {
+            status = WARNING;
+            break;
+        }
+        memcpy(&group_header, memblock + offset, sizeof(group_header));
+        offset += sizeof(group_header);
+        if (group_header.size < 0 || group_header.array_size < 0
+            || offset + group_header.size + group_header.array_size
+                > st.st_size)
+        {
+            status = WARNING;
+            break;
+        }
+
+        if (restore_group(&group_header, memblock + offset, cpf) == ERROR)
+            status = ERROR;
+        offset += group_header.size + group_header.array_size;
+    }
+    munmap(memblock, st.st_size);
+
+    if (status == WARNING)
+    {
+        IAS_LOG_WARNING("The CPF snapshot %s is truncated",
+                        snapshot_filename);
+    }
+    cpf->num_snapshot_groups = count_loaded_groups(cpf);
+
+    return status;
+}
+
+/*****************************************************************************
+NAME:  ias_cpf_write_snapshot
+
+PURPOSE: Saves the loaded groups of the snapshot table to the snapshot file,
+    unless they all came from the snapshot already.  The file is written
+    under a temporary name and renamed, so a process reading the snapshot
+    never sees it partially written.
+
+RETURNS: SUCCESS or ERROR
+
+******************************************************************************/
+int ias_cpf_write_snapshot
+(
+    IAS_CPF *cpf,                   /* I: CPF with the groups to save */
+    const char *snapshot_filename   /* I: snapshot file name */
+)
+{
+    IAS_CPF_SNAPSHOT_HEADER header;
+    IAS_CPF_SNAPSHOT_GROUP_HEADER group_header;
+    char temp_filename[PATH_MAX];
+    int **arrays[NUM_LEAP_SECONDS_ARRAYS];
+    const SNAPSHOT_GROUP *group;
+    int num_loaded;
+    int count;
+    int index;
+    int array_index;
+    int write_error = 0;
+    FILE *fp;
+
+    num_loaded = count_loaded_groups(cpf);
+    if (num_loaded == 0 || num_loaded == cpf->num_snapshot_groups)
+        return SUCCESS;
+
+    if (snprintf(temp_filename, sizeof(temp_filename), "%s.%d",
+                 snapshot_filename, (int)getpid()) >= sizeof(temp_filename))
+    {
+        IAS_LOG_ERROR("The CPF snapshot file name is too long");
+        return ERROR;
+    }
+
+    fp = fopen(temp_filename, "wb");
+    if (!fp)
+    {
+        IAS_LOG_ERROR("Opening CPF snapshot %s", temp_filename);
+        return ERROR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, IAS_CPF_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = IAS_CPF_SNAPSHOT_VERSION;
+    header.num_groups = num_loaded;
+    header.cpf_size = cpf->raw_file_size;
+    header.cpf_checksum = compute_checksum(cpf);
+    if (fwrite(&header, sizeof(header), 1, fp) != 1)
+        write_error = 1;
+
+    get_leap_seconds_arrays(cpf, arrays);
+    for (index = 0; index < NUM_SNAPSHOT_GROUPS && !write_error; index++)
+    {
+        group = &snapshot_groups[index];
+        if (!*(int *)((char *)cpf + group->loaded_offset))
+            continue;
+
+        count = 0;
+        if (group->offset == offsetof(IAS_CPF, earth))
+            count = cpf->earth.leap_seconds_data.leap_seconds_count;
+
+        memset(&group_header, 0, sizeof(group_header));
+        strncpy(group_header.name, group->name, sizeof(group_header.name));
+        group_header.size = group->size;
+        group_header.array_size = NUM_LEAP_SECONDS_ARRAYS * count * sizeof(int);
+        if (fwrite(&group_header, sizeof(group_header), 1, fp) != 1
+            || fwrite((char *)cpf + group->offset, group->size, 1, fp) != 1)
+        {
+            write_error = 1;
+            break;
+        }
+        for (array_index = 0; array_index < NUM_LEAP_SECONDS_ARRAYS
+             && count > 0; array_index++)
+        {
+            if (fwrite(*arrays[array_index], sizeof(int), count, fp) != count)
+            {
+                write_error = 1;
+                break;
+            }
+        }
+    }
+
+    if (fclose(fp) != 0 || write_error)
+    {
+        IAS_LOG_ERROR("Writing CPF snapshot %s", temp_filename);
+        unlink(temp_filename);
+        return ERROR;
+    }
+
+    if (rename(temp_filename, snapshot_filename) != 0)
+    {
+        IAS_LOG_ERROR("Renaming CPF snapshot %s", temp_filename);
+        unlink(temp_filename);
+        return ERROR;
+    }
+    cpf->num_snapshot_groups = num_loaded;
+
+    return SUCCESS;
+}
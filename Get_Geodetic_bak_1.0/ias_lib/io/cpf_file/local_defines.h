@@ -30,6 +30,19 @@ PURPOSE:    Provide the local structure, constants and prototype
     ias_odl_free_tree(tree); \
     tree = NULL
 
+/* Byte range of a group in the raw file buffer of the CPF */
+#define IAS_CPF_GROUP_NAME_LENGTH 64
+typedef struct IAS_CPF_GROUP_INDEX_ENTRY
+{
+    char name[IAS_CPF_GROUP_NAME_LENGTH];
+    long start;             /* offset of the "GROUP = name" text */
+    long end;               /* offset just past the "END_GROUP = name" text */
+} IAS_CPF_GROUP_INDEX_ENTRY;
+
+/* Snapshot file of the parsed groups */
+#define IAS_CPF_SNAPSHOT_MAGIC "IASCPFS"
+#define IAS_CPF_SNAPSHOT_VERSION 1
+
 /***********************************************************************
   The CPF Stucture 
 ***********************************************************************/
@@ -132,6 +145,11 @@ struct IAS_CPF
 
     char *raw_file_buffer;  /* buffer that holds the entire contents of the 
                                CPF file */
+    long raw_file_size;     /* size of the CPF file */
+    IAS_CPF_GROUP_INDEX_ENTRY *group_index; /* groups of the raw file buffer,
+                                               sorted by name */
+    int num_groups;         /* number of entries in the group index */
+    int num_snapshot_groups; /* groups restored from the snapshot file */
 };
 
 /***********************************************************************
@@ -496,6 +514,17 @@ IAS_OBJ_DESC *ias_cpf_get_odl_tree_from_cache
     const char *group_name      /* I: Name of group to retrieve */
 );
 
+int ias_cpf_index_groups
+(
+    IAS_CPF *cpf                /* I/O: CPF struct to index the buffer of */
+);
+
+int ias_cpf_read_snapshot
+(
+    const char *snapshot_filename, /* I: snapshot file name */
+    IAS_CPF *cpf                /* I/O: CPF struct to restore groups into */
+);
+
 int ias_cpf_convert_3digit_month_to_number
 (
     char *ascii_3digit_month,  /* I: Three char string representing month */
@@ -53,6 +53,10 @@ typedef struct ias_los_model
     IAS_SENSOR_MODEL sensor;            	/* Sensor model */
 } IAS_LOS_MODEL;
 
+/* Number of points processed together by
+   ias_los_model_input_line_samp_to_geodetic_batch */
+#define IAS_LOS_MODEL_BATCH_SIZE 64
+
 /* Forward reference to the lunar projection structure */
 typedef struct IAS_LUNAR_PROJECTION IAS_LUNAR_PROJECTION;
 
@@ -160,6 +164,31 @@ int ias_los_model_input_line_samp_to_geodetic
     double *target_long                 /* O: Target longitude */
 );
 
+int ias_los_model_input_line_samp_to_geodetic_batch
+(
+    int num_points,                     /* I: Number of points */
+    const long long *image_time,        /* I: Generation time of the image of
+                                              each point (ms since 1970) */
+    const double *sample,               /* I: Sample of each point or NULL */
+    const int *band_index,              /* I: Band index of each point or
+                                              NULL */
+    const int *sca_index,               /* I: SCA index of each point or
+                                              NULL */
+    double default_sample,              /* I: Sample when sample is NULL */
+    int default_band_index,             /* I: Band index when band_index is
+                                              NULL */
+    int default_sca_index,              /* I: SCA index when sca_index is
+                                              NULL */
+    double target_elev,                 /* I: Target elevation */
+    const IAS_LOS_MODEL *model,         /* I: LOS model information */
+    IAS_SENSOR_DETECTOR_TYPE dettype,   /* I: Detector type to project
+                                              NOMINAL, ACTUAL, or EXACT */
+    double *target_latd,                /* O: Target latitude of each point */
+    double *target_long,                /* O: Target longitude of each point */
+    int *point_status                   /* O: SUCCESS or ERROR for each point,
+                                              or NULL */
+);
+
 int ias_los_model_set_cpf
 (
     IAS_CPF *cpf,                  /* I: CPF structure pointer with values to
@@ -186,6 +186,7 @@ void ias_los_model_free
             free(sca->l0r_detector_offsets);
             free(sca->detector_offsets_across_track);
             free(sca->detector_offsets_along_track);
+            free(sca->nominal_los_table);
         }
 
         free(band->scas);
@@ -114,27 +114,14 @@ int ias_los_model_input_line_samp_to_geodetic
 
 
 
-//    double utc_epoch_time[3] = {2014, 62, 16397.029 };
-//    image_time = 353.109;
-    /* Added by LYL, convert time_t to double utc_epoch_time[3] */
-    double utc_epoch_time[3];
-    struct tm imageTime;
-    long image_time_seconds = image_time / 1000;
-    gmtime_r(&image_time_seconds,&imageTime);
-    utc_epoch_time[0] = imageTime.tm_year + 1900;
-    utc_epoch_time[1] = imageTime.tm_yday + 1;
-    utc_epoch_time[2] = (imageTime.tm_hour*60+imageTime.tm_min)*60
-    					+ imageTime.tm_sec + (double)(image_time%1000)/1000;
-
     /* Get the delta time relative to the ephemeris epoch */
-    if (ias_math_get_time_difference(utc_epoch_time,
-            model->spacecraft.ephemeris.utc_epoch_time, &delta_eph_time)
-            != SUCCESS)
+    if (!model->spacecraft.ephemeris.time_base.initialized)
     {
-        IAS_LOG_ERROR("Calculating time difference between the ephemeris and "
-            "image epoch times");
+        IAS_LOG_ERROR("The ephemeris time base is not initialized");
         return ERROR;
     }
+    delta_eph_time = ias_sc_model_get_time_from_epoch(
+            &model->spacecraft.ephemeris.time_base, image_time);
 
     IAS_LOG_DEBUG("   Delta ephemeris time %.8e", delta_eph_time);
 
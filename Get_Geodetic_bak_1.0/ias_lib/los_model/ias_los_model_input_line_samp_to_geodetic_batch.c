@@ -0,0 +1,302 @@
+/****************************************************************************
+Name: ias_los_model_input_line_samp_to_geodetic_batch
+
+Purpose: Calculates the geodetic coordinates for an array of image times in
+    one call. The result for each point is the one
+    ias_los_model_input_line_samp_to_geodetic gives for the same arguments,
+    but the work that does not depend on the point is done once per batch:
+    1) The delta ephemeris times of a block are converted together through
+       the time base of the ephemeris model.
+    2) When the sample, band and SCA are the same for all the points the
+       sensor LOS is found and transformed to the navigation reference once.
+    3) The ephemeris is interpolated with the polynomial of the current
+       window of records, rebuilt only when the window changes.
+    4) The points are processed in blocks of IAS_LOS_MODEL_BATCH_SIZE kept in
+       structure-of-arrays layout, and the steps that are plain vector
+       arithmetic (delta time, orbit to ECEF transformation, velocity
+       aberration) run as separate loops over a block so the compiler can
+       vectorize them. The Earth intersections, light travel time and
+       geodetic conversion go through ias_geo_find_target_position_batch.
+
+Returns:
+    SUCCESS if all the points were located, ERROR if any of them failed
+    (point_status tells which) or the arguments are invalid
+
+Notes:
+    - The sample, band_index and sca_index arrays are optional. A NULL array
+      means the matching default value is used for all the points.
+    - The attitude perturbation is the identity in this model (see
+      ias_geo_compute_orientation_matrices), so it is not applied.
+    - Only Earth acquisitions are batched. Stellar and lunar points are passed
+      to ias_los_model_input_line_samp_to_geodetic one at a time.
+
+*******************************************************************************
+                        Property of the U.S. Government
+                             USGS EROS Data Center
+*****************************************************************************/
+#include <math.h>
+#include "ias_los_model.h"
+#include "ias_geo.h"
+#include "ias_math.h"
+#include "logging_channel.h" /* define the debug logging channel */
+#include "ias_logging.h"
+
+/* Find the sensor LOS of a point and transform it to the navigation
+   reference of the spacecraft */
+static int find_navigation_los
+(
+    const IAS_LOS_MODEL *model,         /* I: LOS model information */
+    double sample,                      /* I: Input sample number */
+    int band_index,                     /* I: Input band index */
+    int sca_index,                      /* I: SCA index */
+    IAS_SENSOR_DETECTOR_TYPE dettype,   /* I: Detector type */
+    IAS_VECTOR *nav_los                 /* O: LOS in navigation coords */
+)
+{
+    const IAS_SENSOR_BAND_MODEL *band = &model->sensor.bands[band_index];
+    IAS_VECTOR sensor_los;
+
+    if (ias_sensor_find_los_vector(sca_index, sample, dettype, band,
+            &sensor_los) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Finding the LOS vector for SCA %d, Band index %d, "
+                "Detector %.8e", sca_index, band_index, sample);
+        return ERROR;
+    }
+
+    ias_math_transform_3dvec(&sensor_los, band->sensor->sensor2acs, nav_los);
+
+    return SUCCESS;
+}
+
+int ias_los_model_input_line_samp_to_geodetic_batch
+(
+    int num_points,                     /* I: Number of points */
+    const long long *image_time,        /* I: Generation time of the image of
+                                              each point (ms since 1970) */
+    const double *sample,               /* I: Sample of each point or NULL */
+    const int *band_index,              /* I: Band index of each point or
+                                              NULL */
+    const int *sca_index,               /* I: SCA index of each point or
+                                              NULL */
+    double default_sample,              /* I: Sample when sample is NULL */
+    int default_band_index,             /* I: Band index when band_index is
+                                              NULL */
+    int default_sca_index,              /* I: SCA index when sca_index is
+                                              NULL */
+    double target_elev,                 /* I: Target elevation */
+    const IAS_LOS_MODEL *model,         /* I: LOS model information */
+    IAS_SENSOR_DETECTOR_TYPE dettype,   /* I: Detector type to project
+                                              NOMINAL, ACTUAL, or EXACT */
+    double *target_latd,                /* O: Target latitude of each point */
+    double *target_long,                /* O: Target longitude of each point */
+    int *point_status                   /* O: SUCCESS or ERROR for each point,
+                                              or NULL */
+)
+{
+    const IAS_SC_EPHEMERIS_MODEL *eph = &model->spacecraft.ephemeris;
+    const IAS_EARTH_CHARACTERISTICS *earth = &model->earth;
+    int fixed_los = (sample == NULL && band_index == NULL && sca_index == NULL);
+    IAS_VECTOR fixed_nav_los;       /* Navigation LOS shared by the points */
+    IAS_SC_EPHEMERIS_INTERPOLATOR interp; /* Keeps the ephemeris window */
+    double inverse_c;
+    int failures = 0;
+    int start;
+    int count;
+    int i;
+
+    /* Per block arrays, one element per point */
+    double delta_eph_time[IAS_LOS_MODEL_BATCH_SIZE];
+    double satpos_x[IAS_LOS_MODEL_BATCH_SIZE];
+    double satpos_y[IAS_LOS_MODEL_BATCH_SIZE];
+    double satpos_z[IAS_LOS_MODEL_BATCH_SIZE];
+    double satvel_x[IAS_LOS_MODEL_BATCH_SIZE];
+    double satvel_y[IAS_LOS_MODEL_BATCH_SIZE];
+    double satvel_z[IAS_LOS_MODEL_BATCH_SIZE];
+    double nav_los_x[IAS_LOS_MODEL_BATCH_SIZE];
+    double nav_los_y[IAS_LOS_MODEL_BATCH_SIZE];
+    double nav_los_z[IAS_LOS_MODEL_BATCH_SIZE];
+    double los_x[IAS_LOS_MODEL_BATCH_SIZE];
+    double los_y[IAS_LOS_MODEL_BATCH_SIZE];
+    double los_z[IAS_LOS_MODEL_BATCH_SIZE];
+    double ground_x[IAS_LOS_MODEL_BATCH_SIZE];
+    double ground_y[IAS_LOS_MODEL_BATCH_SIZE];
+    double ground_z[IAS_LOS_MODEL_BATCH_SIZE];
+    int lane_status[IAS_LOS_MODEL_BATCH_SIZE];
+    int ok[IAS_LOS_MODEL_BATCH_SIZE];
+
+    if (num_points < 0 || image_time == NULL || target_latd == NULL
+            || target_long == NULL)
+    {
+        IAS_LOG_ERROR("Invalid batch of %d points", num_points);
+        return ERROR;
+    }
+
+    /* Stellar and lunar points are not batched */
+    if (model->acquisition_type != IAS_EARTH)
+    {
+        for (i = 0; i < num_points; i++)
+        {
+            int status = ias_los_model_input_line_samp_to_geodetic(
+                    image_time[i], sample ? sample[i] : default_sample,
+                    band_index ? band_index[i] : default_band_index,
+                    sca_index ? sca_index[i] : default_sca_index,
+                    target_elev, model, dettype, NULL, &target_latd[i],
+                    &target_long[i]);
+            if (point_status)
+                point_status[i] = status;
+            if (status != SUCCESS)
+                failures++;
+        }
+        return failures ? ERROR : SUCCESS;
+    }
+
+    if (!eph->time_base.initialized)
+    {
+        IAS_LOG_ERROR("The ephemeris time base is not initialized");
+        for (i = 0; point_status && i < num_points; i++)
+            point_status[i] = ERROR;
+        return ERROR;
+    }
+
+    if (fixed_los)
+    {
+        if (find_navigation_los(model, default_sample, default_band_index,
+                default_sca_index, dettype, &fixed_nav_los) != SUCCESS)
+        {
+            for (i = 0; point_status && i < num_points; i++)
+                point_status[i] = ERROR;
+            return ERROR;
+        }
+    }
+
+    inverse_c = 1.0 / earth->speed_of_light;
+    ias_sc_model_init_ephemeris_interpolator(eph, model->acquisition_type,
+            &interp);
+
+    for (start = 0; start < num_points; start += IAS_LOS_MODEL_BATCH_SIZE)
+    {
+        count = num_points - start;
+        if (count > IAS_LOS_MODEL_BATCH_SIZE)
+            count = IAS_LOS_MODEL_BATCH_SIZE;
+
+        ias_sc_model_get_times_from_epoch(&eph->time_base, count,
+                &image_time[start], delta_eph_time);
+
+        /* Spacecraft position and velocity */
+        for (i = 0; i < count; i++)
+        {
+            IAS_VECTOR satpos;
+            IAS_VECTOR satvel;
+
+            ok[i] = 1;
+            ias_sc_model_interpolate_ephemeris(&interp, delta_eph_time[i],
+                    &satpos, &satvel);
+            satpos_x[i] = satpos.x;
+            satpos_y[i] = satpos.y;
+            satpos_z[i] = satpos.z;
+            satvel_x[i] = satvel.x;
+            satvel_y[i] = satvel.y;
+            satvel_z[i] = satvel.z;
+        }
+
+        /* Sensor LOS in navigation coordinates */
+        for (i = 0; i < count; i++)
+        {
+            IAS_VECTOR nav_los = fixed_nav_los;
+
+            if (!fixed_los && ok[i] && find_navigation_los(model,
+                    sample ? sample[start + i] : default_sample,
+                    band_index ? band_index[start + i] : default_band_index,
+                    sca_index ? sca_index[start + i] : default_sca_index,
+                    dettype, &nav_los) != SUCCESS)
+            {
+                ok[i] = 0;
+                nav_los.x = nav_los.y = nav_los.z = 0.0;
+            }
+            nav_los_x[i] = nav_los.x;
+            nav_los_y[i] = nav_los.y;
+            nav_los_z[i] = nav_los.z;
+        }
+
+        /* LOS in ECEF coordinates, the columns of the orbit to ECEF
+           transformation being the directions of the velocity (x), the
+           angular momentum (y) and the nadir (z) */
+        for (i = 0; i < count; i++)
+        {
+            double zx = -satpos_x[i];
+            double zy = -satpos_y[i];
+            double zz = -satpos_z[i];
+            double yx = zy * satvel_z[i] - zz * satvel_y[i];
+            double yy = zz * satvel_x[i] - zx * satvel_z[i];
+            double yz = zx * satvel_y[i] - zy * satvel_x[i];
+            double xx = yy * zz - yz * zy;
+            double xy = yz * zx - yx * zz;
+            double xz = yx * zy - yy * zx;
+            double mx = sqrt(xx * xx + xy * xy + xz * xz);
+            double my = sqrt(yx * yx + yy * yy + yz * yz);
+            double mz = sqrt(zx * zx + zy * zy + zz * zz);
+            double cx;
+            double cy;
+            double cz;
+
+            if (mx == 0.0 || my == 0.0 || mz == 0.0)
+            {
+                ok[i] = 0;
+                mx = my = mz = 1.0;
+            }
+            cx = nav_los_x[i] / mx;
+            cy = nav_los_y[i] / my;
+            cz = nav_los_z[i] / mz;
+            los_x[i] = xx * cx + yx * cy + zx * cz;
+            los_y[i] = xy * cx + yy * cy + zy * cz;
+            los_z[i] = xz * cx + yz * cy + zz * cz;
+        }
+
+        /* Ground point of the uncorrected LOS for the velocity aberration */
+        ias_geo_find_target_position_batch(count, satpos_x, satpos_y,
+                satpos_z, los_x, los_y, los_z, earth, 0.0, 0, ground_x,
+                ground_y, ground_z, NULL, NULL, lane_status);
+        for (i = 0; i < count; i++)
+            ok[i] &= (lane_status[i] == SUCCESS);
+
+        /* Velocity aberration: the ground velocity is the Earth rotation
+           (0, 0, w) crossed with the ground point */
+        for (i = 0; i < count; i++)
+        {
+            double w = earth->earth_angular_velocity;
+            double nx = los_x[i] - (satvel_x[i] + w * ground_y[i]) * inverse_c;
+            double ny = los_y[i] - (satvel_y[i] - w * ground_x[i]) * inverse_c;
+            double nz = los_z[i] - satvel_z[i] * inverse_c;
+            double m = sqrt(nx * nx + ny * ny + nz * nz);
+
+            if (m == 0.0)
+                m = 1.0;
+            los_x[i] = nx / m;
+            los_y[i] = ny / m;
+            los_z[i] = nz / m;
+        }
+
+        /* Target, light travel time and geodetic coordinates */
+        ias_geo_find_target_position_batch(count, satpos_x, satpos_y,
+                satpos_z, los_x, los_y, los_z, earth, target_elev, 1,
+                ground_x, ground_y, ground_z, &target_latd[start],
+                &target_long[start], lane_status);
+
+        for (i = 0; i < count; i++)
+        {
+            int status = (ok[i] && lane_status[i] == SUCCESS)
+                ? SUCCESS : ERROR;
+
+            if (point_status)
+                point_status[start + i] = status;
+            if (status != SUCCESS)
+                failures++;
+        }
+    }
+
+    IAS_LOG_DEBUG("Located %d of %d points", num_points - failures,
+            num_points);
+
+    return failures ? ERROR : SUCCESS;
+}
@@ -108,6 +108,15 @@ int ias_los_model_set_cpf_for_MWD
         return ERROR;
     }
 
+    /* The MWD frames are all located with the same few detectors, so look
+       their LOS vectors up instead of evaluating them for each frame */
+    status = ias_sensor_build_los_table(&model->sensor);
+    if (status != SUCCESS)
+    {
+        IAS_LOG_ERROR("Building the sensor LOS tables");
+        return ERROR;
+    }
+
     return SUCCESS;
 }
 
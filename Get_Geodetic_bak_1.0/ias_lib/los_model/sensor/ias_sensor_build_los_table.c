@@ -0,0 +1,79 @@
+/******************************************************************************
+NAME: ias_sensor_build_los_table
+
+PURPOSE: Evaluates the NOMINAL line of sight vector of every detector of every
+    SCA of every band once and keeps it in the SCA model, so that
+    ias_sensor_find_los_vector can return it for whole detector numbers
+    without evaluating the Legendre polynomials again.
+
+RETURNS: SUCCESS or ERROR
+
+NOTES:
+    - Must be called after the SCA Legendre coefficients are set from the CPF.
+      Calling it again rebuilds the tables from the current coefficients.
+    - The tables are freed by ias_los_model_free.
+
+******************************************************************************/
+#include <stdlib.h>
+#include "ias_logging.h"
+#include "ias_const.h"
+#include "ias_sensor_model.h"
+
+int ias_sensor_build_los_table
+(
+    IAS_SENSOR_MODEL *sensor    /* I/O: Sensor model to add the tables to */
+)
+{
+    int band_index;             /* Index to the band array */
+    int sca_index;              /* Index to the SCA array of the band */
+    int detector;               /* Detector number */
+    long long table_count = 0;  /* Number of LOS vectors in all the tables */
+
+    for (band_index = 0; band_index < sensor->band_count; band_index++)
+    {
+        IAS_SENSOR_BAND_MODEL *band = &sensor->bands[band_index];
+
+        for (sca_index = 0; sca_index < band->sca_count; sca_index++)
+        {
+            IAS_SENSOR_SCA_MODEL *sca = &band->scas[sca_index];
+            IAS_VECTOR *table;
+
+            /* Drop any previous table so the LOS below is evaluated */
+            free(sca->nominal_los_table);
+            sca->nominal_los_table = NULL;
+
+            if (sca->detectors <= 0)
+                continue;
+
+            table = malloc(sca->detectors * sizeof(*table));
+            if (table == NULL)
+            {
+                IAS_LOG_ERROR("Allocating the LOS table for band index %d "
+                        "SCA %d", band_index, sca_index);
+                return ERROR;
+            }
+
+            for (detector = 0; detector < sca->detectors; detector++)
+            {
+                if (ias_sensor_find_los_vector(sca_index, detector,
+                        IAS_NOMINAL_DETECTOR, band, &table[detector])
+                        != SUCCESS)
+                {
+                    IAS_LOG_ERROR("Finding the LOS vector for band index %d "
+                            "SCA %d detector %d", band_index, sca_index,
+                            detector);
+                    free(table);
+                    return ERROR;
+                }
+            }
+
+            sca->nominal_los_table = table;
+            table_count += sca->detectors;
+        }
+    }
+
+    IAS_LOG_DEBUG("Built the nominal LOS tables for %lld detectors",
+            table_count);
+
+    return SUCCESS;
+}
@@ -52,6 +52,17 @@ int ias_sensor_find_los_vector
 
     IAS_SENSOR_SCA_MODEL *sca = &band->scas[sca_index];
 
+    /* Whole NOMINAL detectors are looked up in the table when it is built */
+    if (type == IAS_NOMINAL_DETECTOR && sca->nominal_los_table)
+    {
+        ndet = (int)detector;
+        if (ndet == detector && ndet >= 0 && ndet < sca->detectors)
+        {
+            *losv = sca->nominal_los_table[ndet];
+            return SUCCESS;
+        }
+    }
+
     /* Compute the normalized detector number */
     norm_det = 2.0 * detector / ((double)sca->detectors - 1) - 1.0;
 
@@ -161,6 +161,9 @@ typedef struct ias_sensor_sca_model
          sensor coordinate system where the y direction is perpendicular to
          the plane formed by the x axis (satellite motion) and the z axis
          pointing to the earth's center. (radians) */
+    IAS_VECTOR *nominal_los_table; /* 1D array of the NOMINAL LOS vector of
+        each detector, built by ias_sensor_build_los_table from the Legendre
+        coefficients above. NULL until built. */
 } IAS_SENSOR_SCA_MODEL;
 
 typedef struct ias_sensor_band_model
@@ -238,6 +241,11 @@ int ias_sensor_check_ssm_encoder_data
                                               corrected */
 );
 
+int ias_sensor_build_los_table
+(
+    IAS_SENSOR_MODEL *sensor    /* I/O: Sensor model to add the tables to */
+);
+
 int ias_sensor_find_los_vector
 (
     int sca_index,                     /* I: Input point SCA index (0-based) */
@@ -0,0 +1,182 @@
+/******************************************************************************
+NAME: ias_sc_model_init_ephemeris_interpolator
+      ias_sc_model_interpolate_ephemeris
+      ias_sc_model_interpolate_ephemeris_batch
+
+PURPOSE: Package of routines to interpolate the spacecraft position and
+    velocity with the same IAS_LAGRANGE_PTS point Lagrange polynomial as
+    ias_geo_lagrange_interpolate, but keeping the polynomial of the current
+    window of ephemeris records. The polynomial is kept in Newton form, built
+    from divided differences when the window changes, so evaluating it is
+    IAS_LAGRANGE_PTS - 1 multiply-adds per coordinate.
+
+NOTES:
+    - Frame times arrive in increasing order, so consecutive calls almost
+      always use the same window and the polynomial is reused.
+    - The interpolator is modified by every call, so each thread needs its
+      own.
+    - The window of records used for a time is the one
+      ias_sc_model_get_position_and_velocity_at_time has always used.
+******************************************************************************/
+#include <math.h>
+#include "ias_const.h"
+#include "ias_spacecraft_model.h"
+
+/* Load the window starting at record 'index' and build its polynomial */
+static void load_window
+(
+    IAS_SC_EPHEMERIS_INTERPOLATOR *interp,  /* I/O: Interpolator */
+    int index                               /* I: First record of window */
+)
+{
+    const IAS_SC_EPHEMERIS_MODEL *eph = interp->eph;
+    double (*coef)[IAS_EPHEMERIS_COMPONENTS] = interp->coefficients;
+    int i;
+    int j;
+    int k;
+
+    for (i = 0; i < IAS_LAGRANGE_PTS; i++)
+    {
+        const IAS_SC_EPHEMERIS_RECORD *current
+                = &eph->sample_records[index + i];
+        const IAS_VECTOR *position;
+        const IAS_VECTOR *velocity;
+
+        /* If acquisition is earth based used earth-fixed ephemeris.
+           If acquisition is stellar or lunar based then use ECI ephemeris. */
+        if (interp->acq_type == IAS_EARTH)
+        {
+            position = &current->precision_ecef_position;
+            velocity = &current->precision_ecef_velocity;
+        }
+        else
+        {
+            position = &current->precision_eci_position;
+            velocity = &current->precision_eci_velocity;
+        }
+
+        interp->times[i] = current->seconds_from_epoch;
+        coef[i][0] = position->x;
+        coef[i][1] = position->y;
+        coef[i][2] = position->z;
+        coef[i][3] = velocity->x;
+        coef[i][4] = velocity->y;
+        coef[i][5] = velocity->z;
+    }
+
+    /* Divided differences, in place: coef[i] becomes f[t0, ..., ti] */
+    for (j = 1; j < IAS_LAGRANGE_PTS; j++)
+    {
+        for (i = IAS_LAGRANGE_PTS - 1; i >= j; i--)
+        {
+            double scale = 1.0 / (interp->times[i] - interp->times[i - j]);
+
+            for (k = 0; k < IAS_EPHEMERIS_COMPONENTS; k++)
+                coef[i][k] = (coef[i][k] - coef[i - 1][k]) * scale;
+        }
+    }
+
+    interp->index = index;
+}
+
+/*************************************************************************
+Name: ias_sc_model_init_ephemeris_interpolator
+
+Purpose: Sets up an interpolator for an ephemeris model. No window is loaded
+    until the first interpolation.
+
+Returns:
+    nothing
+**************************************************************************/
+void ias_sc_model_init_ephemeris_interpolator
+(
+    const IAS_SC_EPHEMERIS_MODEL *eph,      /* I: Ephemeris to interpolate */
+    IAS_ACQUISITION_TYPE acq_type,          /* I: Image acquisition type */
+    IAS_SC_EPHEMERIS_INTERPOLATOR *interp   /* O: Interpolator */
+)
+{
+    interp->eph = eph;
+    interp->acq_type = acq_type;
+    interp->index = -1;
+}
+
+/*************************************************************************
+Name: ias_sc_model_interpolate_ephemeris
+
+Purpose: Interpolates the spacecraft position and velocity at a time,
+    loading the window of records of that time if it is not the current one.
+
+Returns:
+    nothing
+**************************************************************************/
+void ias_sc_model_interpolate_ephemeris
+(
+    IAS_SC_EPHEMERIS_INTERPOLATOR *interp,  /* I/O: Interpolator */
+    double eph_time,         /* I: Delta time from the reference time */
+    IAS_VECTOR *satpos,      /* O: Satellite position at eph_time */
+    IAS_VECTOR *satvel       /* O: Satellite velocity at eph_time */
+)
+{
+    const IAS_SC_EPHEMERIS_MODEL *eph = interp->eph;
+    double (*coef)[IAS_EPHEMERIS_COMPONENTS] = interp->coefficients;
+    double value[IAS_EPHEMERIS_COMPONENTS];
+    int index;
+    int i;
+    int k;
+
+    /* Compute the starting Lagrange index, limiting the index to fall within
+       the available data */
+    index = (int)floor(eph_time/eph->nominal_sample_time - IAS_LAGRANGE_PTS/2);
+    if (index < 0)
+        index = 0;
+    if (index > eph->sample_count - IAS_LAGRANGE_PTS)
+        index = eph->sample_count - IAS_LAGRANGE_PTS;
+
+    if (index != interp->index)
+        load_window(interp, index);
+
+    /* Evaluate the Newton form from the highest order term down */
+    for (k = 0; k < IAS_EPHEMERIS_COMPONENTS; k++)
+        value[k] = coef[IAS_LAGRANGE_PTS - 1][k];
+    for (i = IAS_LAGRANGE_PTS - 2; i >= 0; i--)
+    {
+        double offset = eph_time - interp->times[i];
+
+        for (k = 0; k < IAS_EPHEMERIS_COMPONENTS; k++)
+            value[k] = value[k] * offset + coef[i][k];
+    }
+
+    satpos->x = value[0];
+    satpos->y = value[1];
+    satpos->z = value[2];
+    satvel->x = value[3];
+    satvel->y = value[4];
+    satvel->z = value[5];
+}
+
+/*************************************************************************
+Name: ias_sc_model_interpolate_ephemeris_batch
+
+Purpose: Interpolates the spacecraft position and velocity at an array of
+    times. Sorted times load each window once.
+
+Returns:
+    nothing
+**************************************************************************/
+void ias_sc_model_interpolate_ephemeris_batch
+(
+    IAS_SC_EPHEMERIS_INTERPOLATOR *interp,  /* I/O: Interpolator */
+    int count,               /* I: Number of times */
+    const double *eph_time,  /* I: Delta times from the reference time */
+    IAS_VECTOR *satpos,      /* O: Satellite position at each time */
+    IAS_VECTOR *satvel       /* O: Satellite velocity at each time */
+)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        ias_sc_model_interpolate_ephemeris(interp, eph_time[i], &satpos[i],
+                &satvel[i]);
+    }
+}
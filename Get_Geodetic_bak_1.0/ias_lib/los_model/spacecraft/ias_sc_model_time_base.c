@@ -0,0 +1,209 @@
+/******************************************************************************
+NAME: ias_sc_model_init_time_base
+      ias_sc_model_get_time_from_epoch
+      ias_sc_model_get_times_from_epoch
+
+PURPOSE: Package of routines to convert raw frame times, in UTC milliseconds
+    since 1970, to seconds from a year/doy/sod epoch such as the ephemeris
+    epoch. The epoch is converted once when the time base is initialized, so
+    converting a frame time is a subtraction plus the leap seconds inserted
+    between the epoch and the frame, instead of a gmtime_r call and a
+    calendar difference per frame.
+
+NOTES:
+    - UTC milliseconds since 1970 do not count leap seconds, so the leap
+      seconds that take effect between the epoch and a frame are added to
+      the difference. They are taken from the time system of the ephemeris,
+      the one leap second table of a scene, which is initialized from the
+      CPF.
+    - Assumes imaging will not occur during a leap second.
+******************************************************************************/
+#include <math.h>
+#include <string.h>
+#include "ias_logging.h"
+#include "ias_const.h"
+#include "ias_math.h"
+#include "ias_spacecraft_model.h"
+
+#define MS_PER_DAY (IAS_SEC_PER_DAY * 1000LL)
+
+/* Days from 1970-01-01 to year/month/day in the proleptic Gregorian
+   calendar */
+static long long get_days_from_1970(int year, int month, int day)
+{
+    long long era;
+    long long year_of_era;
+    long long day_of_year;
+    long long day_of_era;
+
+    year -= month <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    year_of_era = year - era * 400;
+    day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100
+        + day_of_year;
+
+    return era * 146097 + day_of_era - 719468;
+}
+
+/*************************************************************************
+Name: ias_sc_model_init_time_base
+
+Purpose: Initializes a time base for an epoch with the leap seconds of the
+    time system of the data span.
+
+Returns:
+    SUCCESS or ERROR
+**************************************************************************/
+int ias_sc_model_init_time_base
+(
+    const double *utc_epoch_time,       /* I: Epoch (year/doy/sod array) */
+    const IAS_MATH_TIME_SYSTEM *time_system,
+                                        /* I: Time system of the span of the
+                                              data */
+    IAS_SC_TIME_BASE *time_base         /* O: Time base to initialize */
+)
+{
+    int year = (int)(utc_epoch_time[0] + 0.5);
+    int doy = (int)(utc_epoch_time[1] + 0.5);
+    double epoch_ms_of_day;
+    int previous_adjustment;
+    int i;
+
+    memset(time_base, 0, sizeof(*time_base));
+
+    if (!time_system->initialized)
+    {
+        IAS_LOG_ERROR("The time system of the time base is not initialized");
+        return ERROR;
+    }
+    if (doy < 1 || doy > 366 || utc_epoch_time[2] < 0.0
+            || utc_epoch_time[2] > IAS_SEC_PER_DAY + 1)
+    {
+        IAS_LOG_ERROR("Invalid epoch: year %f DOY %f SOD %f",
+                utc_epoch_time[0], utc_epoch_time[1], utc_epoch_time[2]);
+        return ERROR;
+    }
+
+    /* January 1st plus the day of year */
+    epoch_ms_of_day = floor(utc_epoch_time[2] * 1000.0);
+    time_base->epoch_ms = (get_days_from_1970(year, 1, 1) + doy - 1)
+        * MS_PER_DAY + (long long)epoch_ms_of_day;
+    time_base->epoch_fraction = utc_epoch_time[2] - epoch_ms_of_day / 1000.0;
+
+    /* The time system keeps the leap seconds inserted within its span, with
+       the leap seconds since J2000 from each one on */
+    previous_adjustment = time_system->base_adjustment;
+    for (i = 0; i < time_system->leap_count; i++)
+    {
+        double leap_time[3];    /* UTC year, doy, sod of the leap second */
+
+        if (ias_math_time_system_convert_j2000_seconds_to_year_doy_sod(
+                time_system, time_system->leap_utc_j2secs[i]
+                + time_system->leap_adjustment[i], leap_time) != SUCCESS)
+        {
+            IAS_LOG_ERROR("Converting the time of leap second %d", i);
+            return ERROR;
+        }
+
+        time_base->leap_ms[i] = (get_days_from_1970(
+                (int)(leap_time[0] + 0.5), 1, 1)
+                + (int)(leap_time[1] + 0.5) - 1) * MS_PER_DAY
+                + llround(leap_time[2] * 1000.0);
+        time_base->leap_seconds[i] = time_system->leap_adjustment[i]
+            - previous_adjustment;
+        previous_adjustment = time_system->leap_adjustment[i];
+    }
+    time_base->leap_count = time_system->leap_count;
+
+    time_base->initialized = 1;
+
+    IAS_LOG_DEBUG("Time base epoch %lld ms + %.6f s, %d leap seconds kept",
+            time_base->epoch_ms, time_base->epoch_fraction,
+            time_base->leap_count);
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: ias_sc_model_get_time_from_epoch
+
+Purpose: Converts a frame time to seconds from the epoch of a time base.
+
+Returns:
+    Seconds from the epoch
+**************************************************************************/
+double ias_sc_model_get_time_from_epoch
+(
+    const IAS_SC_TIME_BASE *time_base,  /* I: Time base to use */
+    long long frame_time                /* I: Frame time (ms since 1970) */
+)
+{
+    double seconds = (double)(frame_time - time_base->epoch_ms) / 1000.0
+        - time_base->epoch_fraction;
+    int i;
+
+    for (i = 0; i < time_base->leap_count; i++)
+    {
+        if (time_base->epoch_ms < time_base->leap_ms[i])
+        {
+            if (frame_time >= time_base->leap_ms[i])
+                seconds += time_base->leap_seconds[i];
+        }
+        else if (frame_time < time_base->leap_ms[i])
+        {
+            seconds -= time_base->leap_seconds[i];
+        }
+    }
+
+    return seconds;
+}
+
+/*************************************************************************
+Name: ias_sc_model_get_times_from_epoch
+
+Purpose: Converts an array of frame times to seconds from the epoch of a time
+    base. The leap second adjustments are applied in separate passes so the
+    conversion loop stays free of branches.
+
+Returns:
+    nothing
+**************************************************************************/
+void ias_sc_model_get_times_from_epoch
+(
+    const IAS_SC_TIME_BASE *time_base,  /* I: Time base to use */
+    int count,                          /* I: Number of frame times */
+    const long long *frame_time,        /* I: Frame times (ms since 1970) */
+    double *seconds_from_epoch          /* O: Seconds from the epoch */
+)
+{
+    long long epoch_ms = time_base->epoch_ms;
+    double epoch_fraction = time_base->epoch_fraction;
+    int leap;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        seconds_from_epoch[i] = (double)(frame_time[i] - epoch_ms) / 1000.0
+            - epoch_fraction;
+    }
+
+    for (leap = 0; leap < time_base->leap_count; leap++)
+    {
+        long long leap_ms = time_base->leap_ms[leap];
+        double leap_seconds = time_base->leap_seconds[leap];
+
+        if (epoch_ms < leap_ms)
+        {
+            for (i = 0; i < count; i++)
+                seconds_from_epoch[i] += (frame_time[i] >= leap_ms)
+                    * leap_seconds;
+        }
+        else
+        {
+            for (i = 0; i < count; i++)
+                seconds_from_epoch[i] -= (frame_time[i] < leap_ms)
+                    * leap_seconds;
+        }
+    }
+}
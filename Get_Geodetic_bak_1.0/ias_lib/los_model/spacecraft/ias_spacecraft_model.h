@@ -6,6 +6,7 @@
 #include "ias_structures.h"
 #include "ias_satellite_attributes.h"
 #include "ias_ancillary_io.h"
+#include "ias_math.h"
 
 #define IAS_PRECISION_MAX_POLY_COEFF 3
 
@@ -50,6 +51,24 @@ typedef struct ias_sc_ephemeris_record
     IAS_VECTOR precision_ecef_velocity;    /* Vx, Vy, Vz (meters/sec) */
 } IAS_SC_EPHEMERIS_RECORD;
 
+/* Maps raw frame times (UTC milliseconds since 1970) to seconds from an
+   epoch with one subtraction. The leap seconds are those of the time system
+   of the span of the data. */
+typedef struct ias_sc_time_base
+{
+    int initialized;                 /* 1 once ias_sc_model_init_time_base
+                                        has been called */
+    long long epoch_ms;              /* Epoch truncated to the millisecond,
+                                        in ms since 1970 */
+    double epoch_fraction;           /* Seconds of the epoch past epoch_ms */
+    int leap_count;                  /* Number of leap seconds kept */
+    long long leap_ms[IAS_MATH_TIME_SYSTEM_MAX_LEAPS]; /* Time each leap
+                                        second takes effect, in ms since
+                                        1970 */
+    int leap_seconds[IAS_MATH_TIME_SYSTEM_MAX_LEAPS];  /* Seconds added
+                                        then */
+} IAS_SC_TIME_BASE;
+
 typedef struct ias_sc_ephemeris_model
 {
     double utc_epoch_time[3];        /* Year, day of year, seconds of day for
@@ -59,8 +78,26 @@ typedef struct ias_sc_ephemeris_model
     double nominal_sample_time;      /* Seconds */
     int sample_count;                /* Number of ephemeris sample records */
     IAS_SC_EPHEMERIS_RECORD *sample_records;/* Ptr to ephemeris sample records*/
+    IAS_SC_TIME_BASE time_base;      /* Maps frame times to seconds from
+                                        utc_epoch_time */
 } IAS_SC_EPHEMERIS_MODEL;
 
+/* Position x/y/z and velocity x/y/z interpolated together */
+#define IAS_EPHEMERIS_COMPONENTS 6
+
+/* Lagrange interpolator keeping the polynomial of the current window of
+   ephemeris records, see ias_sc_model_init_ephemeris_interpolator */
+typedef struct ias_sc_ephemeris_interpolator
+{
+    const IAS_SC_EPHEMERIS_MODEL *eph;  /* Ephemeris interpolated */
+    IAS_ACQUISITION_TYPE acq_type;      /* Selects ECEF or ECI records */
+    int index;                          /* First record of the window,
+                                           -1 if no window is loaded */
+    double times[IAS_LAGRANGE_PTS];     /* Record times of the window */
+    double coefficients[IAS_LAGRANGE_PTS][IAS_EPHEMERIS_COMPONENTS];
+                                        /* Newton form of the polynomial */
+} IAS_SC_EPHEMERIS_INTERPOLATOR;
+
 typedef struct ias_sc_precision_model
 {
     double seconds_from_image_epoch;  /* Seconds from epoch */
@@ -125,6 +162,20 @@ int ias_sc_model_correct_ephem_convert_ecef2eci
     IAS_SC_EPHEMERIS_MODEL *ephem_model         /* IO: Ephemeris to convert */
 );
 
+double ias_sc_model_get_time_from_epoch
+(
+    const IAS_SC_TIME_BASE *time_base,  /* I: Time base to use */
+    long long frame_time                /* I: Frame time (ms since 1970) */
+);
+
+void ias_sc_model_get_times_from_epoch
+(
+    const IAS_SC_TIME_BASE *time_base,  /* I: Time base to use */
+    int count,                          /* I: Number of frame times */
+    const long long *frame_time,        /* I: Frame times (ms since 1970) */
+    double *seconds_from_epoch          /* O: Seconds from the epoch */
+);
+
 int ias_sc_model_find_attitude_at_time
 (
    const IAS_SC_ATTITUDE_MODEL *att,    /* I: Attitude structure */
@@ -157,11 +208,44 @@ void ias_sc_model_get_position_and_velocity_at_time
    IAS_VECTOR *satvel       /* O: New satellite velocity at "dtime" */
 );
 
+int ias_sc_model_init_time_base
+(
+    const double *utc_epoch_time,       /* I: Epoch (year/doy/sod array) */
+    const IAS_MATH_TIME_SYSTEM *time_system,
+                                        /* I: Time system of the span of the
+                                              data */
+    IAS_SC_TIME_BASE *time_base         /* O: Time base to initialize */
+);
+
+void ias_sc_model_init_ephemeris_interpolator
+(
+    const IAS_SC_EPHEMERIS_MODEL *eph,      /* I: Ephemeris to interpolate */
+    IAS_ACQUISITION_TYPE acq_type,          /* I: Image acquisition type */
+    IAS_SC_EPHEMERIS_INTERPOLATOR *interp   /* O: Interpolator */
+);
+
 void ias_sc_model_initialize_attitude
 (
     IAS_SC_ATTITUDE_MODEL *att      /* I: Attitude structure to initialize */
 );
 
+void ias_sc_model_interpolate_ephemeris
+(
+    IAS_SC_EPHEMERIS_INTERPOLATOR *interp,  /* I/O: Interpolator */
+    double eph_time,         /* I: Delta time from the reference time */
+    IAS_VECTOR *satpos,      /* O: Satellite position at eph_time */
+    IAS_VECTOR *satvel       /* O: Satellite velocity at eph_time */
+);
+
+void ias_sc_model_interpolate_ephemeris_batch
+(
+    IAS_SC_EPHEMERIS_INTERPOLATOR *interp,  /* I/O: Interpolator */
+    int count,               /* I: Number of times */
+    const double *eph_time,  /* I: Delta times from the reference time */
+    IAS_VECTOR *satpos,      /* O: Satellite position at each time */
+    IAS_VECTOR *satvel       /* O: Satellite velocity at each time */
+);
+
 int ias_sc_model_remez_filter_attitude
 (
     const IAS_SC_ATTITUDE_MODEL *orig_att,  /* I: Original satellite attitude */
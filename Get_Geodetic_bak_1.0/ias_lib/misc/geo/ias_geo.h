@@ -3,6 +3,7 @@
 
 #include "ias_structures.h"
 #include "ias_cpf.h"
+#include "ias_math.h"          /* for IAS_MATH_TIME_SYSTEM */
 #include "ias_l1g.h"            /* for the L1G_BAND_IO definition */
 #include "ias_los_model.h"      /* for IAS_EARTH_CHARACTERISTICS */
 
@@ -14,6 +15,36 @@
 
 #define WGS84_SPHEROID 12
 
+/* Number of points processed together by ias_geo_find_target_position_batch */
+#define IAS_GEO_BATCH_SIZE 64
+
+/* Default seconds between the nodes of an Earth orientation cache */
+#define IAS_GEO_EARTH_ORIENTATION_SPACING 60.0
+
+/* Earth orientation at a node of an Earth orientation cache */
+typedef struct ias_geo_earth_orientation_node
+{
+    double gast;            /* Greenwich apparent sidereal time, in rad,
+                               unwrapped to increase along the nodes */
+    double omega_star;      /* Earth rotation rate in precessing frame, in
+                               rad/sec */
+    double wobble[3][3];    /* Polar motion, mean pole ECEF to true pole */
+    double tod2j2k[3][3];   /* Nutation and precession, ECI true of date to
+                               J2000 */
+} IAS_GEO_EARTH_ORIENTATION_NODE;
+
+/* Earth orientation on a time grid, see ias_geo_earth_orientation_cache.c.
+   It is only read once created, so threads can share it. */
+typedef struct ias_geo_earth_orientation_cache
+{
+    double start_time;      /* Time of the first node, seconds since J2000 */
+    double node_spacing;    /* Seconds between nodes */
+    int node_count;         /* Number of nodes */
+    IAS_MATH_TIME_SYSTEM time_system; /* Time system the cache was built
+                                         with */
+    IAS_GEO_EARTH_ORIENTATION_NODE *nodes;
+} IAS_GEO_EARTH_ORIENTATION_CACHE;
+
 /* Type defines for projection related structures */
 typedef struct ias_geo_proj_transformation IAS_GEO_PROJ_TRANSFORMATION;
 /* The ias_projection structure matches the gctp_projection structure
@@ -270,6 +301,15 @@ void ias_geo_convert_sph2cart
     IAS_VECTOR *vec  /* O: Vector containing Cartesian coords */ 
 );
 
+int ias_geo_convert_j2000_to_times
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    double j2secs,      /* I: TAI seconds since J2000 */
+    double *ut1,        /* O: Univeral Time (UT1) Time */
+    double *tdb,        /* O: Barycentric Dynamical Time (TDB) */
+    double *tt          /* O: Terrestrial Time (TT) */
+);
+
 int ias_geo_convert_utc2times
 (
     double ut1_utc,     /* I: UT1-UTC, in seconds, due to variation of Earth's 
@@ -310,6 +350,15 @@ int ias_geo_correct_for_velocity_aberration
    IAS_VECTOR *vlos             /* O: New LOS vector adjusted for aberration */
 );
 
+IAS_GEO_EARTH_ORIENTATION_CACHE *ias_geo_create_earth_orientation_cache
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system with the
+                              Earth orientation parameters of the span */
+    double start_time,  /* I: Start of the span, seconds since J2000 */
+    double end_time,    /* I: End of the span, seconds since J2000 */
+    double node_spacing /* I: Seconds between nodes */
+);
+
 /* defined in ias_geo_transformation_matrix.c */
 int  ias_geo_create_transformation_matrix
 (
@@ -344,6 +393,16 @@ int ias_geo_eci2ecef
     IAS_VECTOR *fe_satvel        /* O: Satellite velocity in ECR */
 );
 
+int ias_geo_eci2ecef_cached
+(
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *cache, /* I: Cache to use */
+    double j2secs,                  /* I: Time, seconds since J2000 */
+    const IAS_VECTOR *craft_pos,    /* I: Satellite position in ECI */
+    const IAS_VECTOR *craft_vel,    /* I: Satellite velocity in ECI */
+    IAS_VECTOR *fe_satpos,          /* O: Satellite position in ECEF */
+    IAS_VECTOR *fe_satvel           /* O: Satellite velocity in ECEF */
+);
+
 int ias_geo_extract_window
 (
     int image_nl,           /* I: # of lines in the 1G image */
@@ -416,12 +475,54 @@ int ias_geo_find_target_position
     double *tarrad          /* O: Radius of the target */
 );
 
+int ias_geo_find_target_position_batch
+(
+    int count,                  /* I: Number of points */
+    const double *satpos_x,     /* I: Satellite position X of each point */
+    const double *satpos_y,     /* I: Satellite position Y of each point */
+    const double *satpos_z,     /* I: Satellite position Z of each point */
+    const double *los_x,        /* I: Line of sight X of each point */
+    const double *los_y,        /* I: Line of sight Y of each point */
+    const double *los_z,        /* I: Line of sight Z of each point */
+    const IAS_EARTH_CHARACTERISTICS *earth, /* I: Earth parameters */
+    double tarelev,             /* I: Elevation of target above the ellipsoid */
+    int correct_light_travel,   /* I: 1 to correct for the light travel time */
+    double *target_x,           /* O: Target vector X of each point */
+    double *target_y,           /* O: Target vector Y of each point */
+    double *target_z,           /* O: Target vector Z of each point */
+    double *target_latd,        /* O: Geodetic latitude of each point, or
+                                      NULL to skip the geodetic conversion */
+    double *target_long,        /* O: Longitude of each point, or NULL */
+    int *lane_status            /* O: SUCCESS or ERROR for each point */
+);
+
+void ias_geo_free_earth_orientation_cache
+(
+    IAS_GEO_EARTH_ORIENTATION_CACHE *cache  /* I: Cache to free, or NULL */
+);
+
+int ias_geo_get_earth_orientation
+(
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *cache, /* I: Cache to use */
+    double j2secs,                  /* I: Time, seconds since J2000 */
+    double ecef2j2k[3][3],          /* O: ECEF to J2000 rotation */
+    double ecef2j2k_rate[3][3]      /* O: Rate of the rotation, or NULL */
+);
+
 int ias_geo_get_units 
 (
     const char *unit_name,   /* I: Units name */
     int *unit_num            /* O: Units number */
 );
 
+int ias_geo_init_time_system
+(
+    IAS_CPF *cpf,               /* I: CPF structure */
+    double start_j2secs,        /* I: Start of the span, seconds since J2000 */
+    double end_j2secs,          /* I: End of the span, seconds since J2000 */
+    IAS_MATH_TIME_SYSTEM *time_system /* O: Time system of the span */
+);
+
 int ias_geo_does_cross_180
 (
     int unit,             /* I: The angular unit of the angles passed in */
@@ -467,6 +568,16 @@ int ias_geo_transform_ecef2j2k
     IAS_VECTOR *eci_satvel       /* O: Satellite velocity in ECI */
 );
 
+int ias_geo_transform_ecef2j2k_cached
+(
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *cache, /* I: Cache to use */
+    double j2secs,                  /* I: Time, seconds since J2000 */
+    const IAS_VECTOR *craft_pos,    /* I: Satellite position in ECEF */
+    const IAS_VECTOR *craft_vel,    /* I: Satellite velocity in ECEF */
+    IAS_VECTOR *eci_satpos,         /* O: Satellite position in ECI */
+    IAS_VECTOR *eci_satvel          /* O: Satellite velocity in ECI */
+);
+
 void ias_geo_transform_nutation_mod2tod
 (
     const IAS_VECTOR *r_old, /* I: coordinates (x, y, z) in the mean-of-date
@@ -0,0 +1,408 @@
+/******************************************************************************
+NAME: ias_geo_create_earth_orientation_cache
+      ias_geo_free_earth_orientation_cache
+      ias_geo_get_earth_orientation
+      ias_geo_transform_ecef2j2k_cached
+      ias_geo_eci2ecef_cached
+
+PURPOSE: Package of routines to transform between ECEF and ECI J2000 through
+    Earth orientation computed once on a coarse time grid, instead of running
+    the time conversions, polar motion, sidereal time, nutation and precession
+    for every vector.
+
+NOTES:
+    - The ECEF to J2000 rotation of ias_geo_transform_ecef2j2k is
+      tod2j2k * Rz(-gast) * wobble. At each node the cache keeps the
+      Greenwich apparent sidereal time (GAST), the Earth rotation rate and the
+      wobble (polar motion) and tod2j2k (nutation and precession) matrices.
+      Between nodes the GAST is interpolated with a cubic Hermite polynomial
+      using the rates, and the slowly varying matrices linearly, so the
+      rotation keeps the full Earth rotation of the routines it replaces.
+    - The cache is built with the NOVAS wrapper, which is not thread-safe,
+      but once built it is only read, so any number of threads can transform
+      through the same cache.
+    - The times are converted through the time system the cache is built
+      with rather than the leap seconds initialized by
+      ias_math_init_leap_seconds, so caches of different spans can be built
+      concurrently and the span may cross a leap second.  Like the routines
+      it replaces, the cache assumes the pole wander and UT1-UTC of its span
+      are constant.
+
+******************************************************************************/
+#include <stdlib.h>
+#include <math.h>
+#include "ias_const.h"
+#include "ias_math.h"
+#include "ias_logging.h"
+#include "ias_geo.h"
+
+/* Seconds between the two sidereal times giving the Earth rotation rate, as
+   in ias_geo_transform_sidereal */
+#define RATE_DELTA 1.0
+
+/* Nominal Earth rotation rate in the precessing frame, in rad/sec, and the
+   relative tolerance of the rate computed at a node */
+#define NOMINAL_OMEGA_STAR 7.2921158553e-5
+#define OMEGA_STAR_TOLERANCE 1.0e-4
+
+/* Compute the Earth orientation at a node */
+static int compute_node
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system of the span */
+    double j2secs,          /* I: Time of the node, seconds since J2000 */
+    IAS_GEO_EARTH_ORIENTATION_NODE *node /* O: Earth orientation */
+)
+{
+    double jd_tdb;          /* TDB Julian date of the node */
+    double jd_tt;           /* TT Julian date of the node */
+    double jd_ut1;          /* UT1 Julian date of the node */
+    double gast_at_delta;   /* GAST RATE_DELTA seconds later */
+    double delta_gast;      /* GAST change over RATE_DELTA seconds */
+    double delta_days = RATE_DELTA / IAS_SEC_PER_DAY;
+    double pi = ias_math_get_pi();
+    IAS_VECTOR axis;        /* Axis of the ECEF or true of date frame */
+    IAS_VECTOR mod;         /* Axis in the mean of date frame */
+    IAS_VECTOR out;         /* Transformed axis */
+    int i;
+
+    if (ias_geo_convert_j2000_to_times(time_system, j2secs, &jd_ut1, &jd_tdb,
+        &jd_tt) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Unable to convert UTC time to other time standards");
+        return ERROR;
+    }
+
+    if (ias_geo_get_sidereal_time(jd_ut1, jd_tt, &node->gast) != SUCCESS
+        || ias_geo_get_sidereal_time(jd_ut1 + delta_days, jd_tt + delta_days,
+            &gast_at_delta) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Unable to get Greenwich sidereal time");
+        return ERROR;
+    }
+
+    /* The GAST wraps at 2 pi, so a node just before the wrap sees the later
+       GAST near 0.  Bring the difference back into (-pi, pi] */
+    delta_gast = gast_at_delta - node->gast;
+    delta_gast -= 2.0 * pi * ceil((delta_gast - pi) / (2.0 * pi));
+    node->omega_star = delta_gast / RATE_DELTA;
+    if (fabs(node->omega_star - NOMINAL_OMEGA_STAR)
+        > OMEGA_STAR_TOLERANCE * NOMINAL_OMEGA_STAR)
+    {
+        IAS_LOG_ERROR("Earth rotation rate %e rad/sec at %f seconds is not "
+            "near the nominal rate", node->omega_star, j2secs);
+        return ERROR;
+    }
+
+    /* The matrices are the images of the axes, stored as columns */
+    for (i = 0; i < 3; i++)
+    {
+        axis.x = (i == 0);
+        axis.y = (i == 1);
+        axis.z = (i == 2);
+
+        ias_geo_transform_polar_motion_mean_pole_to_true(&axis,
+            time_system->pole_wander_x, time_system->pole_wander_y, jd_tdb,
+            &out);
+        node->wobble[0][i] = out.x;
+        node->wobble[1][i] = out.y;
+        node->wobble[2][i] = out.z;
+
+        ias_geo_transform_nutation_tod2mod(&axis, jd_tdb, &mod);
+        if (ias_geo_transform_precession_mod2j2k(&mod, jd_tdb, &out)
+            != SUCCESS)
+        {
+            IAS_LOG_ERROR("Failed performing the precession tranformation");
+            return ERROR;
+        }
+        node->tod2j2k[0][i] = out.x;
+        node->tod2j2k[1][i] = out.y;
+        node->tod2j2k[2][i] = out.z;
+    }
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: ias_geo_create_earth_orientation_cache
+
+Purpose: Computes the Earth orientation at nodes node_spacing seconds apart
+    covering a time span.
+
+Returns:
+    Pointer to the cache or NULL on error
+**************************************************************************/
+IAS_GEO_EARTH_ORIENTATION_CACHE *ias_geo_create_earth_orientation_cache
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system with the
+                              Earth orientation parameters of the span */
+    double start_time,  /* I: Start of the span, seconds since J2000 */
+    double end_time,    /* I: End of the span, seconds since J2000 */
+    double node_spacing /* I: Seconds between nodes */
+)
+{
+    IAS_GEO_EARTH_ORIENTATION_CACHE *cache;
+    double two_pi = 2.0 * ias_math_get_pi();
+    int index;
+
+    if (end_time < start_time || node_spacing <= 0.0)
+    {
+        IAS_LOG_ERROR("Invalid Earth orientation span %f to %f by %f seconds",
+            start_time, end_time, node_spacing);
+        return NULL;
+    }
+
+    cache = malloc(sizeof(*cache));
+    if (cache == NULL)
+    {
+        IAS_LOG_ERROR("Allocating the Earth orientation cache");
+        return NULL;
+    }
+
+    /* Nodes up to or past the end of the span */
+    cache->time_system = *time_system;
+    cache->start_time = start_time;
+    cache->node_spacing = node_spacing;
+    cache->node_count = (int)ceil((end_time - start_time) / node_spacing) + 1;
+    if (cache->node_count < 2)
+        cache->node_count = 2;
+    cache->nodes = malloc(cache->node_count * sizeof(*cache->nodes));
+    if (cache->nodes == NULL)
+    {
+        IAS_LOG_ERROR("Allocating %d Earth orientation nodes",
+            cache->node_count);
+        free(cache);
+        return NULL;
+    }
+
+    for (index = 0; index < cache->node_count; index++)
+    {
+        IAS_GEO_EARTH_ORIENTATION_NODE *node = &cache->nodes[index];
+
+        if (compute_node(time_system, start_time + index * node_spacing,
+            node) != SUCCESS)
+        {
+            IAS_LOG_ERROR("Computing the Earth orientation of node %d",
+                index);
+            ias_geo_free_earth_orientation_cache(cache);
+            return NULL;
+        }
+
+        /* Unwrap the GAST so it increases continuously along the nodes */
+        if (index > 0)
+        {
+            const IAS_GEO_EARTH_ORIENTATION_NODE *previous = node - 1;
+            double predicted = previous->gast
+                + previous->omega_star * node_spacing;
+
+            node->gast += two_pi * floor((predicted - node->gast) / two_pi
+                + 0.5);
+        }
+    }
+
+    IAS_LOG_DEBUG("Earth orientation cache of %d nodes from %f seconds",
+        cache->node_count, start_time);
+
+    return cache;
+}
+
+/*************************************************************************
+Name: ias_geo_free_earth_orientation_cache
+
+Purpose: Frees an Earth orientation cache.
+
+Returns:
+    nothing
+**************************************************************************/
+void ias_geo_free_earth_orientation_cache
+(
+    IAS_GEO_EARTH_ORIENTATION_CACHE *cache  /* I: Cache to free, or NULL */
+)
+{
+    if (cache == NULL)
+        return;
+
+    free(cache->nodes);
+    free(cache);
+}
+
+/*************************************************************************
+Name: ias_geo_get_earth_orientation
+
+Purpose: Interpolates the ECEF to J2000 rotation and its rate at a time. A
+    position and velocity transform as
+        eci_pos = ecef2j2k * ecef_pos
+        eci_vel = ecef2j2k * ecef_vel + ecef2j2k_rate * ecef_pos
+    which is what ias_geo_transform_ecef2j2k computes.
+
+Returns:
+    SUCCESS or ERROR if the time is outside the cache
+**************************************************************************/
+int ias_geo_get_earth_orientation
+(
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *cache, /* I: Cache to use */
+    double j2secs,                  /* I: Time, seconds since J2000 */
+    double ecef2j2k[3][3],          /* O: ECEF to J2000 rotation */
+    double ecef2j2k_rate[3][3]      /* O: Rate of the rotation, or NULL */
+)
+{
+    const IAS_GEO_EARTH_ORIENTATION_NODE *node0;
+    const IAS_GEO_EARTH_ORIENTATION_NODE *node1;
+    double h = cache->node_spacing;
+    double offset = (j2secs - cache->start_time) / h;
+    double s;               /* Fraction of the node interval */
+    double s2, s3;
+    double gast;
+    double omega_star;
+    double c, sn;
+    double wobble[3][3];
+    double tod2j2k[3][3];
+    double spin[3][3];      /* Rz(-gast), ECEF to ECI true of date */
+    double rate[3][3];      /* Rate term of the sidereal rotation */
+    double tmp[3][3];
+    double tmp2[3][3];
+    int index;
+    int i;
+    int j;
+
+    index = (int)floor(offset);
+    if (index < 0 || index > cache->node_count - 1
+        || (index == cache->node_count - 1 && offset > index))
+    {
+        IAS_LOG_ERROR("Time %f is outside the Earth orientation cache",
+            j2secs);
+        return ERROR;
+    }
+    if (index == cache->node_count - 1)
+        index--;
+    s = offset - index;
+    node0 = &cache->nodes[index];
+    node1 = node0 + 1;
+
+    /* Hermite interpolation of the sidereal time */
+    s2 = s * s;
+    s3 = s2 * s;
+    gast = (2.0 * s3 - 3.0 * s2 + 1.0) * node0->gast
+        + (s3 - 2.0 * s2 + s) * h * node0->omega_star
+        + (-2.0 * s3 + 3.0 * s2) * node1->gast
+        + (s3 - s2) * h * node1->omega_star;
+    omega_star = node0->omega_star
+        + (node1->omega_star - node0->omega_star) * s;
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            wobble[i][j] = node0->wobble[i][j]
+                + (node1->wobble[i][j] - node0->wobble[i][j]) * s;
+            tod2j2k[i][j] = node0->tod2j2k[i][j]
+                + (node1->tod2j2k[i][j] - node0->tod2j2k[i][j]) * s;
+        }
+    }
+
+    c = cos(gast);
+    sn = sin(gast);
+    spin[0][0] = c;   spin[0][1] = -sn; spin[0][2] = 0.0;
+    spin[1][0] = sn;  spin[1][1] = c;   spin[1][2] = 0.0;
+    spin[2][0] = 0.0; spin[2][1] = 0.0; spin[2][2] = 1.0;
+
+    ias_math_multiply_3x3_matrix(spin, wobble, tmp);
+    ias_math_multiply_3x3_matrix(tod2j2k, tmp, ecef2j2k);
+
+    if (ecef2j2k_rate)
+    {
+        /* The velocity correction of ias_geo_transform_sidereal_ecef2eci
+           subtracts rate * (spin * wobble * pos) before the spin */
+        rate[0][0] = -omega_star * sn; rate[0][1] = omega_star * c;
+        rate[0][2] = 0.0;
+        rate[1][0] = -omega_star * c;  rate[1][1] = -omega_star * sn;
+        rate[1][2] = 0.0;
+        rate[2][0] = 0.0; rate[2][1] = 0.0; rate[2][2] = 0.0;
+
+        ias_math_multiply_3x3_matrix(rate, tmp, tmp2);
+        ias_math_multiply_3x3_matrix(spin, tmp2, tmp);
+        ias_math_multiply_3x3_matrix(tod2j2k, tmp, ecef2j2k_rate);
+        for (i = 0; i < 3; i++)
+        {
+            for (j = 0; j < 3; j++)
+                ecef2j2k_rate[i][j] = -ecef2j2k_rate[i][j];
+        }
+    }
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: ias_geo_transform_ecef2j2k_cached
+
+Purpose: Transforms an ECEF position and velocity to ECI J2000 at a time, as
+    ias_geo_transform_ecef2j2k does, through an Earth orientation cache.
+
+Returns:
+    SUCCESS or ERROR
+**************************************************************************/
+int ias_geo_transform_ecef2j2k_cached
+(
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *cache, /* I: Cache to use */
+    double j2secs,                  /* I: Time, seconds since J2000 */
+    const IAS_VECTOR *craft_pos,    /* I: Satellite position in ECEF */
+    const IAS_VECTOR *craft_vel,    /* I: Satellite velocity in ECEF */
+    IAS_VECTOR *eci_satpos,         /* O: Satellite position in ECI */
+    IAS_VECTOR *eci_satvel          /* O: Satellite velocity in ECI */
+)
+{
+    double ecef2j2k[3][3];
+    double ecef2j2k_rate[3][3];
+    IAS_VECTOR rotated_vel;
+    IAS_VECTOR rate_vel;
+
+    if (ias_geo_get_earth_orientation(cache, j2secs, ecef2j2k, ecef2j2k_rate)
+        != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    ias_math_transform_3dvec(craft_vel, ecef2j2k, &rotated_vel);
+    ias_math_transform_3dvec(craft_pos, ecef2j2k_rate, &rate_vel);
+    ias_math_transform_3dvec(craft_pos, ecef2j2k, eci_satpos);
+    eci_satvel->x = rotated_vel.x + rate_vel.x;
+    eci_satvel->y = rotated_vel.y + rate_vel.y;
+    eci_satvel->z = rotated_vel.z + rate_vel.z;
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: ias_geo_eci2ecef_cached
+
+Purpose: Transforms an ECI J2000 position and velocity to ECEF at a time, as
+    ias_geo_eci2ecef does, through an Earth orientation cache. Like
+    ias_geo_eci2ecef, the velocity is only rotated.
+
+Returns:
+    SUCCESS or ERROR
+**************************************************************************/
+int ias_geo_eci2ecef_cached
+(
+    const IAS_GEO_EARTH_ORIENTATION_CACHE *cache, /* I: Cache to use */
+    double j2secs,                  /* I: Time, seconds since J2000 */
+    const IAS_VECTOR *craft_pos,    /* I: Satellite position in ECI */
+    const IAS_VECTOR *craft_vel,    /* I: Satellite velocity in ECI */
+    IAS_VECTOR *fe_satpos,          /* O: Satellite position in ECEF */
+    IAS_VECTOR *fe_satvel           /* O: Satellite velocity in ECEF */
+)
+{
+    double j2k2ecef[3][3];
+
+    if (ias_geo_get_earth_orientation(cache, j2secs, j2k2ecef, NULL)
+        != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    /* The rotation is orthonormal, so its inverse is its transpose */
+    ias_math_transpose_3x3_matrix(j2k2ecef);
+    ias_math_transform_3dvec(craft_pos, j2k2ecef, fe_satpos);
+    ias_math_transform_3dvec(craft_vel, j2k2ecef, fe_satvel);
+
+    return SUCCESS;
+}
@@ -0,0 +1,301 @@
+/******************************************************************************
+Name: ias_geo_find_target_position_batch
+
+Purpose: Find the positions where an array of line of sight vectors intersect
+    the Earth's surface, optionally correct them for the light travel time
+    and convert them to geodetic coordinates. Each point gets the answer of
+    ias_geo_find_target_position, ias_geo_correct_for_light_travel_time and
+    ias_geo_convert_geocentric_height_to_geodetic.
+
+Returns:
+    SUCCESS if all the points were located, ERROR if any of them failed
+    (lane_status tells which)
+
+Notes:
+    - The points are processed in blocks of IAS_GEO_BATCH_SIZE lanes kept in
+      structure-of-arrays layout. The iterative steps (the target elevation
+      search and the geodetic latitude search) run every lane of a block
+      together, each lane carrying a mask telling whether it has converged,
+      so the loops have no early exits and the compiler can vectorize them
+      for the instruction set it is building for (SSE2, AVX2, AVX-512 with
+      a vector math library for the trig calls, scalar code otherwise).
+    - The iteration limits and tolerances are the ones of the scalar
+      routines.
+
+******************************************************************************/
+#include <math.h>
+#include "ias_logging.h"
+#include "ias_geo.h"
+
+#define NUM_ITERATIONS 10   /* number of iterations for converging
+                               LOS intersection */
+#define CONV_TOLERANCE 0.01 /* convergence tolerance */
+#define GEODETIC_ITERATIONS 20  /* iterations of the geodetic latitude */
+#define EPSILON 0.0001      /* tolerance to terminate height calculation */
+
+/* Geocentric latitude, longitude and radius of the targets of a block, as in
+   ias_geo_convert_cart2sph. Lanes with a zero radius are failed. */
+static void convert_cart2sph_lanes
+(
+    int count,
+    const double *x, const double *y, const double *z,
+    double *latc, double *longs, double *radius,
+    int *ok
+)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        double r = sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+
+        ok[i] &= (r != 0.0);
+        radius[i] = r;
+        latc[i] = asin(z[i] / (r != 0.0 ? r : 1.0));
+        longs[i] = atan2(y[i], x[i]);
+    }
+}
+
+/* Geodetic latitude and height of the targets of a block, as in
+   ias_geo_convert_geocentric_height_to_geodetic. A lane stops updating once
+   its height has converged. */
+static void convert_geocentric_height_to_geodetic_lanes
+(
+    int count,
+    const double *latc, const double *radius,
+    const IAS_EARTH_CHARACTERISTICS *earth,
+    double *latd, double *height,
+    int *ok
+)
+{
+    double one_minus_ecc = 1.0 - earth->eccentricity;
+    double polar_scale = earth->semi_major_axis * sqrt(one_minus_ecc);
+    double phip[IAS_GEO_BATCH_SIZE];
+    double last_height[IAS_GEO_BATCH_SIZE];
+    int active[IAS_GEO_BATCH_SIZE];
+    int remaining = 0;
+    int iter;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        ok[i] &= (radius[i] > 0.0);
+        active[i] = ok[i];
+        remaining += active[i];
+        phip[i] = latc[i];
+        last_height[i] = 0.0;
+        latd[i] = latc[i];
+        height[i] = 0.0;
+    }
+
+    for (iter = 0; iter < GEODETIC_ITERATIONS && remaining > 0; iter++)
+    {
+        remaining = 0;
+        for (i = 0; i < count; i++)
+        {
+            double cos_phip = cos(phip[i]);
+            double tmp2 = 1.0 - earth->eccentricity * cos_phip * cos_phip;
+            double radius2 = polar_scale / sqrt(tmp2 > 0.0 ? tmp2 : 1.0);
+            double phis = atan2(tan(phip[i]), one_minus_ecc);
+            double dphis = phis - phip[i];
+            double sin_dphis = sin(dphis);
+            double radius1 = radius[i] * radius[i]
+                - radius2 * radius2 * sin_dphis * sin_dphis;
+            double height2 = sqrt(radius1 > 0.0 ? radius1 : 0.0)
+                - radius2 * cos(dphis);
+            int valid = (tmp2 > 0.0 && radius1 >= 0.0);
+            int converged = (fabs(height2 - last_height[i]) <= EPSILON);
+            double next_phip = latc[i]
+                - asin(height2 / (radius[i] > 0.0 ? radius[i] : 1.0)
+                        * sin_dphis);
+
+            if (active[i])
+            {
+                ok[i] = valid;
+                latd[i] = phis;
+                height[i] = height2;
+                last_height[i] = height2;
+                phip[i] = next_phip;
+                active[i] = valid && !converged;
+            }
+            remaining += active[i];
+        }
+    }
+}
+
+int ias_geo_find_target_position_batch
+(
+    int count,                  /* I: Number of points */
+    const double *satpos_x,     /* I: Satellite position X of each point */
+    const double *satpos_y,     /* I: Satellite position Y of each point */
+    const double *satpos_z,     /* I: Satellite position Z of each point */
+    const double *los_x,        /* I: Line of sight X of each point */
+    const double *los_y,        /* I: Line of sight Y of each point */
+    const double *los_z,        /* I: Line of sight Z of each point */
+    const IAS_EARTH_CHARACTERISTICS *earth, /* I: Earth parameters */
+    double tarelev,             /* I: Elevation of target above the ellipsoid */
+    int correct_light_travel,   /* I: 1 to correct for the light travel time */
+    double *target_x,           /* O: Target vector X of each point */
+    double *target_y,           /* O: Target vector Y of each point */
+    double *target_z,           /* O: Target vector Z of each point */
+    double *target_latd,        /* O: Geodetic latitude of each point, or
+                                      NULL to skip the geodetic conversion */
+    double *target_long,        /* O: Longitude of each point, or NULL */
+    int *lane_status            /* O: SUCCESS or ERROR for each point */
+)
+{
+    double a = earth->semi_major_axis;
+    double b = earth->semi_minor_axis;
+    double latc[IAS_GEO_BATCH_SIZE];
+    double longs[IAS_GEO_BATCH_SIZE];
+    double radius[IAS_GEO_BATCH_SIZE];
+    double latd[IAS_GEO_BATCH_SIZE];
+    double height[IAS_GEO_BATCH_SIZE];
+    int ok[IAS_GEO_BATCH_SIZE];
+    int active[IAS_GEO_BATCH_SIZE];
+    int failures = 0;
+    int start;
+    int n;
+    int iter;
+    int i;
+
+    for (start = 0; start < count; start += IAS_GEO_BATCH_SIZE)
+    {
+        const double *sx = &satpos_x[start];
+        const double *sy = &satpos_y[start];
+        const double *sz = &satpos_z[start];
+        const double *lx = &los_x[start];
+        const double *ly = &los_y[start];
+        const double *lz = &los_z[start];
+        double *tx = &target_x[start];
+        double *ty = &target_y[start];
+        double *tz = &target_z[start];
+
+        n = count - start;
+        if (n > IAS_GEO_BATCH_SIZE)
+            n = IAS_GEO_BATCH_SIZE;
+
+        /* Intersect the LOS with the ellipsoid scaled to a unit sphere */
+        for (i = 0; i < n; i++)
+        {
+            double ux = lx[i] / a;
+            double uy = ly[i] / a;
+            double uz = lz[i] / b;
+            double px = sx[i] / a;
+            double py = sy[i] / a;
+            double pz = sz[i] / b;
+            double up = ux * px + uy * py + uz * pz;
+            double uu = ux * ux + uy * uy + uz * uz;
+            double pp = px * px + py * py + pz * pz;
+            double disc = up * up - uu * (pp - 1.0);
+            double d;
+
+            /* Not viewing the earth */
+            ok[i] = (up <= 0.0 && disc >= 0.0 && uu > 0.0);
+            d = (-up - sqrt(disc >= 0.0 ? disc : 0.0)) / (uu > 0.0 ? uu : 1.0);
+
+            tx[i] = (px + d * ux) * a;
+            ty[i] = (py + d * uy) * a;
+            tz[i] = (pz + d * uz) * b;
+        }
+
+        /* Slide each target along its LOS to the wanted elevation */
+        if (tarelev != 0.0)
+        {
+            convert_cart2sph_lanes(n, tx, ty, tz, latc, longs, radius, ok);
+            convert_geocentric_height_to_geodetic_lanes(n, latc, radius,
+                    earth, latd, height, ok);
+
+            for (iter = 0; iter <= NUM_ITERATIONS + 1; iter++)
+            {
+                int remaining = 0;
+
+                for (i = 0; i < n; i++)
+                {
+                    double dh = height[i] - tarelev;
+                    double dist_x = tx[i] - sx[i];
+                    double dist_y = ty[i] - sy[i];
+                    double dist_z = tz[i] - sz[i];
+                    double d = sqrt(dist_x * dist_x + dist_y * dist_y
+                            + dist_z * dist_z);
+                    double cos_lat = cos(latd[i]);
+                    double q = -(lx[i] * cos_lat * cos(longs[i])
+                            + ly[i] * cos_lat * sin(longs[i])
+                            + lz[i] * sin(latd[i]));
+
+                    active[i] = ok[i] && fabs(dh) >= CONV_TOLERANCE;
+                    if (active[i])
+                    {
+                        d = d + dh / q;
+                        tx[i] = sx[i] + d * lx[i];
+                        ty[i] = sy[i] + d * ly[i];
+                        tz[i] = sz[i] + d * lz[i];
+                    }
+                    remaining += active[i];
+                }
+                if (remaining == 0)
+                    break;
+
+                convert_cart2sph_lanes(n, tx, ty, tz, latc, longs, radius,
+                        ok);
+                convert_geocentric_height_to_geodetic_lanes(n, latc, radius,
+                        earth, latd, height, ok);
+
+                /* The scalar routine gives up after this many updates */
+                if (iter > NUM_ITERATIONS)
+                {
+                    for (i = 0; i < n; i++)
+                        ok[i] &= !active[i];
+                }
+            }
+        }
+
+        /* Rotate each target by the Earth rotation during the light travel
+           time from the target to the satellite */
+        if (correct_light_travel)
+        {
+            double rate = earth->earth_angular_velocity
+                / earth->speed_of_light;
+
+            for (i = 0; i < n; i++)
+            {
+                double dx = sx[i] - tx[i];
+                double dy = sy[i] - ty[i];
+                double dz = sz[i] - tz[i];
+                double da = sqrt(dx * dx + dy * dy + dz * dz) * rate;
+                double cda = cos(da);
+                double sda = sin(da);
+                double x = tx[i];
+                double y = ty[i];
+
+                tx[i] = cda * x - sda * y;
+                ty[i] = sda * x + cda * y;
+            }
+        }
+
+        /* Geodetic coordinates of the final targets */
+        if (target_latd)
+        {
+            convert_cart2sph_lanes(n, tx, ty, tz, latc, longs, radius, ok);
+            convert_geocentric_height_to_geodetic_lanes(n, latc, radius,
+                    earth, &target_latd[start], height, ok);
+            for (i = 0; i < n; i++)
+                target_long[start + i] = longs[i];
+        }
+
+        for (i = 0; i < n; i++)
+        {
+            lane_status[start + i] = ok[i] ? SUCCESS : ERROR;
+            failures += !ok[i];
+        }
+    }
+
+    if (failures)
+    {
+        IAS_LOG_DEBUG("%d of %d LOS vectors did not target Earth", failures,
+                count);
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
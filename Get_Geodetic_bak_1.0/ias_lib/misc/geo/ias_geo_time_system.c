@@ -0,0 +1,131 @@
+/******************************************************************************
+NAME: ias_geo_init_time_system
+      ias_geo_convert_j2000_to_times
+
+PURPOSE: Routines to set up the time system of a span of data from the CPF
+    and to convert times through it, instead of through the leap seconds
+    initialized by ias_math_init_leap_seconds.
+
+NOTES:
+    - Like ias_geo_compute_getmjdcoords callers, the pole wander and UT1-UTC
+      are taken at the start of the span and assumed constant over it.
+
+******************************************************************************/
+#include "ias_const.h"
+#include "ias_logging.h"
+#include "ias_math.h"
+#include "ias_cpf.h"
+#include "ias_geo.h"
+#include "local_novas_wrapper.h"
+
+/*************************************************************************
+Name: ias_geo_init_time_system
+
+Purpose: Initializes the time system of a span from the CPF leap seconds and
+    Earth orientation parameters.
+
+Returns:
+    SUCCESS or ERROR
+**************************************************************************/
+int ias_geo_init_time_system
+(
+    IAS_CPF *cpf,               /* I: CPF structure */
+    double start_j2secs,        /* I: Start of the span, seconds since J2000 */
+    double end_j2secs,          /* I: End of the span, seconds since J2000 */
+    IAS_MATH_TIME_SYSTEM *time_system /* O: Time system of the span */
+)
+{
+    const struct IAS_CPF_EARTH_CONSTANTS *earth_constants;
+    double start_time[3];       /* UTC year, doy, sod of the start */
+
+    earth_constants = ias_cpf_get_earth_const(cpf);
+    if (earth_constants == NULL)
+    {
+        IAS_LOG_ERROR("Reading Earth constants from the CPF");
+        return ERROR;
+    }
+
+    if (ias_math_init_time_system(start_j2secs, end_j2secs,
+        &earth_constants->leap_seconds_data, time_system) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Initializing the leap seconds from %f to %f",
+            start_j2secs, end_j2secs);
+        return ERROR;
+    }
+
+    if (ias_math_time_system_convert_j2000_seconds_to_year_doy_sod(
+        time_system, start_j2secs, start_time) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Converting J2000 seconds %lf to Year, DOY, SOD format",
+            start_j2secs);
+        return ERROR;
+    }
+
+    /* get x and y shift pole wander and UT1-UTC time difference */
+    if (ias_geo_compute_getmjdcoords(start_time, cpf,
+        &time_system->modified_julian_date, &time_system->pole_wander_x,
+        &time_system->pole_wander_y, &time_system->ut1_utc_correction)
+        != SUCCESS)
+    {
+        IAS_LOG_ERROR("Establishing Earth Model");
+        return ERROR;
+    }
+    time_system->earth_orientation_set = 1;
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: ias_geo_convert_j2000_to_times
+
+Purpose: Converts TAI seconds since J2000 to Universal Time (UT1),
+    Terrestrial Time (TT) and Barycentric Dynamical Time (TDB) Julian dates,
+    as ias_geo_convert_utc2times does, through a time system.
+
+Returns:
+    SUCCESS or ERROR
+**************************************************************************/
+int ias_geo_convert_j2000_to_times
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    double j2secs,      /* I: TAI seconds since J2000 */
+    double *ut1,        /* O: Univeral Time (UT1) Time */
+    double *tdb,        /* O: Barycentric Dynamical Time (TDB) */
+    double *tt          /* O: Terrestrial Time (TT) */
+)
+{
+    double ephem_time[3];/* UTC year, doy, sod of the time */
+    double jd_tt;        /* Julian date (TT) for ephemeris time */
+    double secdiff;      /* Difference between TDB and TT in seconds. */
+    double jd_utc;       /* Julian date (UTC) at start of year */
+    double dummy;
+
+    if (!time_system->earth_orientation_set)
+    {
+        IAS_LOG_ERROR("Time system Earth orientation not set");
+        return ERROR;
+    }
+
+    if (ias_math_time_system_convert_j2000_seconds_to_year_doy_sod(
+        time_system, j2secs, ephem_time) != SUCCESS)
+    {
+        IAS_LOG_ERROR("Converting J2000 seconds %lf to Year, DOY, SOD format",
+            j2secs);
+        return ERROR;
+    }
+
+    /* The TAI seconds since J2000 give the Terrestrial Time directly */
+    jd_tt = IAS_EPOCH_2000 + j2secs / IAS_SEC_PER_DAY;
+    NOVAS_TDB2TT(jd_tt, &dummy, &secdiff);
+
+    /* Note ephem_time[1] and ephem_time[2] is UTC and will contain leap
+       seconds */
+    jd_utc = ias_math_compute_full_julian_date(ephem_time[0], 1, 1, 0);
+    *ut1 = jd_utc + (ephem_time[1] - 1.0)
+        + (time_system->ut1_utc_correction + ephem_time[2]) / IAS_SEC_PER_DAY;
+
+    *tt  = jd_tt;
+    *tdb = jd_tt + secdiff / IAS_SEC_PER_DAY;
+
+    return SUCCESS;
+}
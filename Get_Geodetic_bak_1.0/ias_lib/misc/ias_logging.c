@@ -315,10 +315,11 @@ static void log_message
         fprintf(file_ptr, "%19s  %s  %7d %-20s  %6d  %s %s\n",
                 time_stamp, program_name, pid, filename, 
                 line_number, log_level_message[log_level], temp_string);     
-    }
 
-    if(get_mq_init_success())
-    	MQSend(log_level,temp_string);
+        /* queued, the broker is never waited on */
+        if(get_mq_init_success())
+            MQSend(log_level,temp_string);
+    }
 }
 
 /*************************************************************************
@@ -31,6 +31,42 @@ typedef struct ias_math_leap_seconds_data
                                        time */
 } IAS_MATH_LEAP_SECONDS_DATA;
 
+/* Maximum number of leap seconds a time system can hold within its span */
+#define IAS_MATH_TIME_SYSTEM_MAX_LEAPS 8
+
+/* Time system of a data span: the leap seconds that apply over the span and
+   the Earth orientation parameters at its start.  Unlike the leap seconds
+   initialized by ias_math_init_leap_seconds, it is passed to the
+   conversions explicitly, so spans with different epochs can be converted
+   concurrently.  It is only read once initialized, so threads can share
+   it. */
+typedef struct ias_math_time_system
+{
+    int initialized;                /* Flag set once initialized */
+    double start_j2secs;            /* Start of the span, TAI seconds since
+                                       J2000 */
+    double end_j2secs;              /* End of the span, TAI seconds since
+                                       J2000 */
+    int base_adjustment;            /* Leap seconds since the J2000 epoch at
+                                       the start of the span */
+    int leap_count;                 /* Number of leap seconds in the span */
+    double leap_utc_j2secs[IAS_MATH_TIME_SYSTEM_MAX_LEAPS];
+                                    /* UTC seconds since J2000, without leap
+                                       seconds, from which each leap second
+                                       applies */
+    int leap_adjustment[IAS_MATH_TIME_SYSTEM_MAX_LEAPS];
+                                    /* Leap seconds since the J2000 epoch from
+                                       each leap second on */
+
+    /* Earth orientation at the start of the span, set by
+       ias_geo_init_time_system */
+    int earth_orientation_set;      /* Flag set once the following are set */
+    double modified_julian_date;    /* Modified Julian date of the start */
+    double pole_wander_x;           /* X shift pole wander, in arc second */
+    double pole_wander_y;           /* Y shift pole wander, in arc second */
+    double ut1_utc_correction;      /* UT1-UTC, in seconds */
+} IAS_MATH_TIME_SYSTEM;
+
 void ias_math_add_seconds_to_year_doy_sod
 (
     double seconds,     /* I: Seconds to add to date given */
@@ -584,6 +620,38 @@ int ias_math_convert_j2000_seconds_to_year_doy_sod
     double *time    /* O: Year, day of year, seconds of day output array */
 );
 
+int ias_math_init_time_system
+(
+    double start_j2secs,    /* I: Start of the span, seconds since J2000 */
+    double end_j2secs,      /* I: End of the span, seconds since J2000 */
+    const IAS_MATH_LEAP_SECONDS_DATA *cpf_leap_seconds,
+                            /* I: Leap seconds info from CPF */
+    IAS_MATH_TIME_SYSTEM *time_system /* O: Time system of the span */
+);
+
+int ias_math_get_time_system_leap_adjustment
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    double j2secs           /* I: TAI seconds since J2000 */
+);
+
+int ias_math_time_system_convert_year_doy_sod_to_j2000_seconds
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    const double *time,     /* I: Year, DOY, SOD to convert to J2000 epoch
+                                  time */
+    double *j2secs          /* O: Seconds from epoch */
+);
+
+int ias_math_time_system_convert_j2000_seconds_to_year_doy_sod
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    double j2secs,          /* I: seconds since J2000 to convert to Year,
+                                  DOY, SOD */
+    double *time            /* O: Year, day of year, seconds of day output
+                                  array */
+);
+
 double ias_math_cubic_convolution
 (
    double alpha,   /* I: Cubic convolution alpha parameter     */
@@ -3,6 +3,10 @@ NAME: ias_math_init_leap_seconds
       ias_math_get_leap_seconds
       ias_math_convert_year_doy_sod_to_j2000_seconds
       ias_math_convert_j2000_seconds_to_year_doy_sod
+      ias_math_init_time_system
+      ias_math_get_time_system_leap_adjustment
+      ias_math_time_system_convert_year_doy_sod_to_j2000_seconds
+      ias_math_time_system_convert_j2000_seconds_to_year_doy_sod
 
 PURPOSE: Package of routines to convert between J2000 TAI time (in seconds) and
          UTC year, day of year, and seconds of day date/time notation.
@@ -23,9 +27,15 @@ NOTES:
       since UTC has extra seconds inserted relative to TAI, a clock based on
       TAI time is ahead of a UTC clock.
     - Assumes imaging will not occur during a leap second
+    - The time system routines keep the leap seconds of a span in an
+      IAS_MATH_TIME_SYSTEM instead of the module statics.  The leap seconds
+      falling within the span are looked up by time, so the span may cross
+      a leap second, and spans with different epochs can be converted
+      concurrently.
 
 ******************************************************************************/
 #include <math.h>
+#include <string.h>
 #include "ias_math.h"
 #include "ias_const.h"
 #include "ias_logging.h"
@@ -298,24 +308,21 @@ int ias_math_get_leap_second_adjustment
 }
 
 /*************************************************************************
-Name: ias_math_convert_year_doy_sod_to_j2000_seconds
+Name: year_doy_sod_to_j2000_seconds
 
 Purpose: Converts a UTC date/time value in calendar year, day of year, seconds
-    of day format to a value of TAI seconds since J2000.
+    of day format to a value of TAI seconds since J2000, applying a given
+    leap seconds adjustment.
 
 Returns:
-    SUCCESS
-    ERROR
-
-Notes:
-    - This routine applies the number of leaps seconds to the conversion
-      that are determined by the time passed to the init routine.
+    nothing
 
 **************************************************************************/
-int ias_math_convert_year_doy_sod_to_j2000_seconds
+static void year_doy_sod_to_j2000_seconds
 (
     const double *time, /* I: Year, day of year, seconds of day to convert to
                               J2000 epoch time */
+    int adjustment,     /* I: Leap seconds since the J2000 epoch */
     double *j2secs      /* O: TAI seconds from J2000 */
 )
 {
@@ -325,19 +332,12 @@ int ias_math_convert_year_doy_sod_to_j2000_seconds
     double total_secs;
     double secs_from_begin_calendar_year;
 
-    /* Error if the leap seconds have not been initialized yet. */
-    if (!leap_init_flag)
-    {
-        IAS_LOG_ERROR("Leap seconds not initialized");
-        return ERROR;
-    }
-
     /* Round the year to the nearest whole year in case it contains a
        fractional portion */
     calendar_year = (int)(time[0] + 0.5);
     secs_from_begin_calendar_year = (time[1] - 1.0) * IAS_SEC_PER_DAY + time[2]
         - ((double)(J2_EPOCH_DOY - 1) * IAS_SEC_PER_DAY + J2_EPOCH_SOD)
-        + leap_seconds_adjustment;
+        + adjustment;
 
     /* Count the number of days in the years from J2000 epoch year to
        the given year */
@@ -372,30 +372,58 @@ int ias_math_convert_year_doy_sod_to_j2000_seconds
         + (double)(days_from_j2000 * IAS_SEC_PER_DAY);
 
     *j2secs = total_secs;
-
-    return SUCCESS;
 }
 
 /*************************************************************************
-Name: ias_math_convert_j2000_seconds_to_year_doy_sod
+Name: ias_math_convert_year_doy_sod_to_j2000_seconds
 
-Purpose: Converts a value of total seconds from J2000 (TAI) to calendar year,
-    day of year, and seconds of day (UTC). Assumes the total seconds from
-    J2000 contains the leap seconds, so will remove those, as appropriate for
-    the new format converting to.
+Purpose: Converts a UTC date/time value in calendar year, day of year, seconds
+    of day format to a value of TAI seconds since J2000.
 
 Returns:
-    nothing
+    SUCCESS
+    ERROR
 
 Notes:
     - This routine applies the number of leaps seconds to the conversion
       that are determined by the time passed to the init routine.
 
 **************************************************************************/
-int ias_math_convert_j2000_seconds_to_year_doy_sod
+int ias_math_convert_year_doy_sod_to_j2000_seconds
+(
+    const double *time, /* I: Year, day of year, seconds of day to convert to
+                              J2000 epoch time */
+    double *j2secs      /* O: TAI seconds from J2000 */
+)
+{
+    /* Error if the leap seconds have not been initialized yet. */
+    if (!leap_init_flag)
+    {
+        IAS_LOG_ERROR("Leap seconds not initialized");
+        return ERROR;
+    }
+
+    year_doy_sod_to_j2000_seconds(time, leap_seconds_adjustment, j2secs);
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: j2000_seconds_to_year_doy_sod
+
+Purpose: Converts a value of total seconds from J2000 (TAI) to calendar year,
+    day of year, and seconds of day (UTC), removing a given leap seconds
+    adjustment.
+
+Returns:
+    nothing
+
+**************************************************************************/
+static void j2000_seconds_to_year_doy_sod
 (
     double j2secs,  /* I: TAI seconds since J2000 to convert to Year, day of
                        year, seconds of day */
+    int adjustment, /* I: Leap seconds since the J2000 epoch */
     double *time    /* O: UTC Year, day of year, seconds of day output array */
 )
 {
@@ -405,13 +433,6 @@ int ias_math_convert_j2000_seconds_to_year_doy_sod
     int days_remaining;
     int days_in_year;
 
-    /* Error if leap seconds have not been initialized. */
-    if (!leap_init_flag)
-    {
-        IAS_LOG_ERROR("Leap seconds not initialized");
-        return ERROR;
-    }
-
     /* initialize the year to the j2000 base year */
     year = J2_EPOCH_YEAR;
 
@@ -422,7 +443,7 @@ int ias_math_convert_j2000_seconds_to_year_doy_sod
        leap_seconds_adjustment is 0 */
     j2_epoch_total_secs = j2secs
         + ((double)(J2_EPOCH_DOY - 1) * IAS_SEC_PER_DAY + J2_EPOCH_SOD)
-        - leap_seconds_adjustment;
+        - adjustment;
 
     /* find out how many complete days are in our seconds since j2000 */
     full_days_from_j2000 = (int)floor(j2_epoch_total_secs / IAS_SEC_PER_DAY);
@@ -467,6 +488,40 @@ int ias_math_convert_j2000_seconds_to_year_doy_sod
     /* Save the final year and day of current year */
     time[0] = (double)year;
     time[1] = (double)(days_remaining + 1);
+}
+
+/*************************************************************************
+Name: ias_math_convert_j2000_seconds_to_year_doy_sod
+
+Purpose: Converts a value of total seconds from J2000 (TAI) to calendar year,
+    day of year, and seconds of day (UTC). Assumes the total seconds from
+    J2000 contains the leap seconds, so will remove those, as appropriate for
+    the new format converting to.
+
+Returns:
+    SUCCESS
+    ERROR if the leap seconds have not been initialized
+
+Notes:
+    - This routine applies the number of leaps seconds to the conversion
+      that are determined by the time passed to the init routine.
+
+**************************************************************************/
+int ias_math_convert_j2000_seconds_to_year_doy_sod
+(
+    double j2secs,  /* I: TAI seconds since J2000 to convert to Year, day of
+                       year, seconds of day */
+    double *time    /* O: UTC Year, day of year, seconds of day output array */
+)
+{
+    /* Error if leap seconds have not been initialized. */
+    if (!leap_init_flag)
+    {
+        IAS_LOG_ERROR("Leap seconds not initialized");
+        return ERROR;
+    }
+
+    j2000_seconds_to_year_doy_sod(j2secs, leap_seconds_adjustment, time);
 
     return SUCCESS;
 }
@@ -577,3 +632,256 @@ static int get_leap_seconds_at_year_doy_sod
 
      return SUCCESS;
 }
+
+/*************************************************************************
+Name: ias_math_init_time_system
+
+Purpose: Initializes the time system of a span of data: the leap seconds
+    since the J2000 epoch at the start of the span, as
+    ias_math_init_leap_seconds finds them, and the leap seconds inserted
+    after it.
+
+Returns:
+    SUCCESS if the time system was initialized
+    ERROR if unsuccessful at determining the leap seconds
+
+Notes:
+    - The Earth orientation parameters of the time system are not set here
+      since they come from the CPF, see ias_geo_init_time_system.
+    - The leap seconds up to a day past the end of the span are kept, so
+      times slightly past the span still convert correctly.
+
+**************************************************************************/
+int ias_math_init_time_system
+(
+    double start_j2secs,    /* I: Start of the span, seconds since J2000 */
+    double end_j2secs,      /* I: End of the span, seconds since J2000 */
+    const IAS_MATH_LEAP_SECONDS_DATA *cpf_leap_seconds,
+                            /* I: Leap seconds info from CPF */
+    IAS_MATH_TIME_SYSTEM *time_system /* O: Time system of the span */
+)
+{
+    double time[3];         /* Year, doy, sod of the start of the span */
+    int j2_epoch_leap_secs;
+    int curr_leap_secs;
+    int count;
+    int status;
+
+    memset(time_system, 0, sizeof(*time_system));
+
+    if (end_j2secs < start_j2secs)
+    {
+        IAS_LOG_ERROR("Invalid time system span %f to %f", start_j2secs,
+                end_j2secs);
+        return ERROR;
+    }
+
+    /* Compute the number of leap seconds at the epoch time */
+    status = get_leap_seconds_at_year_doy_sod(J2_EPOCH_YEAR, J2_EPOCH_DOY,
+                J2_EPOCH_SOD, 0, cpf_leap_seconds, &j2_epoch_leap_secs);
+    if (status != SUCCESS)
+    {
+        IAS_LOG_ERROR("Initializing time system. Computing leap seconds "
+                "at epoch time");
+        return ERROR;
+    }
+
+    /* Compute the number of leap seconds at the start of the span.  Note
+       that this time is TAI and calls the routine with that indication. */
+    j2000_seconds_to_year_doy_sod(start_j2secs, 0, time);
+    status = get_leap_seconds_at_year_doy_sod((int)(time[0] + 0.5),
+                (int)(time[1] + 0.5), time[2], 1, cpf_leap_seconds,
+                &curr_leap_secs);
+    if (status != SUCCESS)
+    {
+        IAS_LOG_ERROR("Initializing time system. Computing leap seconds "
+                "at start time");
+        return ERROR;
+    }
+    time_system->base_adjustment = curr_leap_secs - j2_epoch_leap_secs;
+
+    /* Keep the leap seconds inserted after the start of the span.  The leap
+       seconds in the CPF are from oldest to newest. */
+    for (count = 0; count < cpf_leap_seconds->leap_seconds_count; count++)
+    {
+        double leap_time[3];    /* UTC year, doy, sod of the leap second */
+        double leap_utc_j2secs; /* UTC seconds since J2000 of it */
+        int year = cpf_leap_seconds->leap_years[count];
+        int doy;
+        int adjustment;
+        int previous_adjustment;
+
+        status = ias_math_convert_month_day_to_doy(
+                    cpf_leap_seconds->leap_months[count],
+                    cpf_leap_seconds->leap_days[count], year, &doy);
+        if (status != SUCCESS)
+        {
+            IAS_LOG_ERROR("Converting the date of leap second %d to day of "
+                    "year", count);
+            return ERROR;
+        }
+
+        status = get_leap_seconds_at_year_doy_sod(year, doy, 0.0, 0,
+                    cpf_leap_seconds, &curr_leap_secs);
+        if (status != SUCCESS)
+        {
+            IAS_LOG_ERROR("Initializing time system. Computing leap seconds "
+                    "at year %d, day %d", year, doy);
+            return ERROR;
+        }
+        adjustment = curr_leap_secs - j2_epoch_leap_secs;
+
+        leap_time[0] = year;
+        leap_time[1] = doy;
+        leap_time[2] = 0.0;
+        year_doy_sod_to_j2000_seconds(leap_time, 0, &leap_utc_j2secs);
+
+        if (time_system->leap_count > 0)
+        {
+            previous_adjustment =
+                time_system->leap_adjustment[time_system->leap_count - 1];
+        }
+        else
+            previous_adjustment = time_system->base_adjustment;
+
+        if (adjustment == previous_adjustment
+            || leap_utc_j2secs + adjustment <= start_j2secs
+            || leap_utc_j2secs + adjustment > end_j2secs + IAS_SEC_PER_DAY)
+        {
+            continue;
+        }
+
+        if (time_system->leap_count == IAS_MATH_TIME_SYSTEM_MAX_LEAPS)
+        {
+            IAS_LOG_ERROR("More than %d leap seconds within the time system "
+                    "span", IAS_MATH_TIME_SYSTEM_MAX_LEAPS);
+            return ERROR;
+        }
+        time_system->leap_utc_j2secs[time_system->leap_count]
+            = leap_utc_j2secs;
+        time_system->leap_adjustment[time_system->leap_count] = adjustment;
+        time_system->leap_count++;
+    }
+
+    time_system->start_j2secs = start_j2secs;
+    time_system->end_j2secs = end_j2secs;
+    time_system->initialized = 1;
+
+    IAS_LOG_DEBUG("Time system leap seconds adjustment %d, %d leap seconds "
+            "within the span", time_system->base_adjustment,
+            time_system->leap_count);
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: ias_math_get_time_system_leap_adjustment
+
+Purpose: Looks up the leap seconds since the J2000 epoch that apply at a TAI
+    time in a time system.
+
+Returns:
+    The leap seconds adjustment
+
+**************************************************************************/
+int ias_math_get_time_system_leap_adjustment
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    double j2secs           /* I: TAI seconds since J2000 */
+)
+{
+    int adjustment = time_system->base_adjustment;
+    int count;
+
+    /* A leap second applies once the inserted second has elapsed */
+    for (count = 0; count < time_system->leap_count; count++)
+    {
+        if (j2secs < time_system->leap_utc_j2secs[count]
+                + time_system->leap_adjustment[count])
+        {
+            break;
+        }
+        adjustment = time_system->leap_adjustment[count];
+    }
+
+    return adjustment;
+}
+
+/*************************************************************************
+Name: ias_math_time_system_convert_year_doy_sod_to_j2000_seconds
+
+Purpose: Converts a UTC date/time value in calendar year, day of year, seconds
+    of day format to a value of TAI seconds since J2000, applying the leap
+    seconds of a time system at that time.
+
+Returns:
+    SUCCESS
+    ERROR if the time system has not been initialized
+
+**************************************************************************/
+int ias_math_time_system_convert_year_doy_sod_to_j2000_seconds
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    const double *time,     /* I: Year, day of year, seconds of day to convert
+                                  to J2000 epoch time */
+    double *j2secs          /* O: TAI seconds from J2000 */
+)
+{
+    double utc_j2secs;      /* UTC seconds since J2000, without leap seconds */
+    int adjustment;
+    int count;
+
+    if (!time_system->initialized)
+    {
+        IAS_LOG_ERROR("Time system not initialized");
+        return ERROR;
+    }
+
+    year_doy_sod_to_j2000_seconds(time, 0, &utc_j2secs);
+
+    adjustment = time_system->base_adjustment;
+    for (count = 0; count < time_system->leap_count; count++)
+    {
+        if (utc_j2secs < time_system->leap_utc_j2secs[count])
+            break;
+        adjustment = time_system->leap_adjustment[count];
+    }
+
+    *j2secs = utc_j2secs + adjustment;
+
+    return SUCCESS;
+}
+
+/*************************************************************************
+Name: ias_math_time_system_convert_j2000_seconds_to_year_doy_sod
+
+Purpose: Converts a value of total seconds from J2000 (TAI) to calendar year,
+    day of year, and seconds of day (UTC), removing the leap seconds of a
+    time system at that time.
+
+Returns:
+    SUCCESS
+    ERROR if the time system has not been initialized
+
+**************************************************************************/
+int ias_math_time_system_convert_j2000_seconds_to_year_doy_sod
+(
+    const IAS_MATH_TIME_SYSTEM *time_system, /* I: Time system to use */
+    double j2secs,          /* I: TAI seconds since J2000 to convert to Year,
+                                  day of year, seconds of day */
+    double *time            /* O: UTC Year, day of year, seconds of day output
+                                  array */
+)
+{
+    if (!time_system->initialized)
+    {
+        IAS_LOG_ERROR("Time system not initialized");
+        return ERROR;
+    }
+
+    j2000_seconds_to_year_doy_sod(j2secs,
+            ias_math_get_time_system_leap_adjustment(time_system, j2secs),
+            time);
+
+    return SUCCESS;
+}
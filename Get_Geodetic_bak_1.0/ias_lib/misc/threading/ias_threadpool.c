@@ -599,7 +599,11 @@ int ias_threadpool_run_function
 
     if (pool->threadpool_size == 0)
     {
-        return pool->work_func(pool->worker_params, 1);
+        /* no threads to wait for, so the pool can run the next function as
+           soon as this one returns */
+        status = pool->work_func(pool->worker_params, 1);
+        pool->threads_are_running = 0;
+        return status;
     }
 
     /* if a work queue is being used, wait for messages and process them */
@@ -13,13 +13,10 @@
 #include "ias_logging.h"
 #include "ias_ancillary.h"
 #include "read_parameter.h"
-#include "read_ephemeris_data.h"
-#include "read_write_mwdImage.h"
-#include "threadpool.h"
-#include "update_longitude_latitude.h"
+#include "mwd_scene.h"
+#include "mwd_daemon.h"
 
 #define DEBUG_GENERATE_DATA_FILES 1
-#define NUM_THREAD 3
 
 
 
@@ -27,6 +24,16 @@
 
 int main(int argc, char **argv)
 {
+	/* Service mode: Get_Geodetic -d <spool directory> [number of scenes] */
+	if (argc >= 3 && argc <= 4 && strcmp(argv[1],"-d") == 0)
+	{
+		int num_scenes = (argc == 4) ? atoi(argv[3]) : 1;
+
+		if (run_mwd_daemon(argv[2],num_scenes) != SUCCESS)
+			return ERROR;
+		return SUCCESS;
+	}
+
 	/* check the number of argument */
 	if (argc != 2)
 	{
@@ -36,24 +43,15 @@ int main(int argc, char **argv)
 
 	/* declare some parameters */
 	PARAMETERS parameters;			//structure of parameters
-	MQ_PARAMS mq_params;			//structure of MQ parameters
-	IAS_L0R_EPHEMERIS *l0r_ephemeris = NULL;   //pointer to L0R ephemeris data structure
-	long long num_frame_of_ephemeris;			// number of ephemeris frames
-	IAS_LOS_MODEL *model;						//pointer to the model structure
 	IAS_CPF *cpf = NULL;          				/* Structure for CPF */
-	double ephemeris_start_time;	//start time of ephemeris data
-	double ephemeris_end_time;		//end time of ephemeris data
-	IAS_ANC_EPHEMERIS_DATA *anc_ephemeris_data = NULL;
-	int invalid_ephemeris_count = 0;
-	MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info;
-	size_t process_times_needed;
+	MWD_SCENE_MODEL *scene_model;	//LOS model of the scene
 	int status = ERROR;
-	int i,j;
 
 
 	memset(&parameters, 0, sizeof(parameters));
 	memset(&mq_params, 0, sizeof(mq_params));
-	/* Read parameters and MQ params from ODL */
+	/* Read parameters and MQ params from ODL, the MQ params into the ones
+	 * MQ_Init and MQSend use */
 	status = read_parameters(argv[1],&parameters,&mq_params);
 	if(status != SUCCESS)
 	{
@@ -84,108 +82,32 @@ int main(int argc, char **argv)
 	}
 
 
-	/* Initialize the model structure */
-	IAS_ACQUISITION_TYPE acquisition_type = IAS_EARTH;
-	model = ias_los_model_initialize(acquisition_type);
-	if (!model)
-	{
-		IAS_LOG_ERROR("Initializing model");
-		return EXIT_FAILURE;
-	}
-
-
-	/* read information from cpf, and set it into model*/
+	/* read information from cpf, and build the model of the scene */
 	cpf = ias_cpf_read(parameters.cpf_filename);
-
-	if(ias_los_model_set_cpf_for_MWD(cpf,model) != SUCCESS)
+	if(cpf == NULL)
 	{
-		IAS_LOG_ERROR("Copy cpf value into model");
+		IAS_LOG_ERROR("Reading the CPF");
 		return ERROR;
 	}
 
-
-	/* read ephemeris file into lor_ephemeris */
-	status = read_ephemeris_data_for_MWD(&parameters,&l0r_ephemeris,&num_frame_of_ephemeris);
-	if(status != SUCCESS )
+	scene_model = create_scene_model(&parameters,cpf);
+	ias_cpf_free(cpf);
+	if(scene_model == NULL)
 	{
-		IAS_LOG_ERROR("Could not read ephemeris file into lor_ephemeris.\n");
-		exit(EXIT_FAILURE);
-	}
-
-
-
-	long long l0r_ephemeris_count = num_frame_of_ephemeris;
-	/* Preprocess the ephemeris data. */
-	if (ias_ancillary_preprocess_ephemeris_for_MWD(cpf, l0r_ephemeris,
-			l0r_ephemeris_count,acquisition_type,&anc_ephemeris_data,
-			&invalid_ephemeris_count,
-			&ephemeris_start_time,&ephemeris_end_time) != SUCCESS)
-	{
-		IAS_LOG_ERROR("Processing ephemeris data");
-		return ERROR;
-	}
-
-
-	if(ias_sc_model_set_ancillary_ephemeris(anc_ephemeris_data,
-			&model->spacecraft) != SUCCESS)
-	{
-		IAS_LOG_ERROR("Setting ephemeris data into model");
+		IAS_LOG_ERROR("Building the scene model");
 		return ERROR;
 	}
 
 
-	mwdImage_buffer_info = malloc(sizeof(*mwdImage_buffer_info));
-	memset(mwdImage_buffer_info,0,sizeof(*mwdImage_buffer_info));
-
-	UPDATE_LONGITUDE_LATITUDE_ARGS *update_longitude_latitude_args;
-	update_longitude_latitude_args = (UPDATE_LONGITUDE_LATITUDE_ARGS*)malloc
-										(sizeof(UPDATE_LONGITUDE_LATITUDE_ARGS));
-	/* Read mwdImage through several times */
-
-	/* Decide how many times to read file to the buffer */
-	status = get_process_time_needed(&parameters,&process_times_needed);
+	/* Update the frames of the mwdImage */
+	status = update_mwdImage_scene(&parameters,scene_model,
+			mq_params.OrderId);
+	free_scene_model(scene_model);
 	if(status != SUCCESS)
 	{
-		IAS_LOG_ERROR("failed to get the process times needed!\n");
 		return ERROR;
 	}
 
-
-	for(i = 0; i < process_times_needed; i++)
-	{
-		status = read_mwdImage(&parameters,i,mwdImage_buffer_info,
-				ephemeris_start_time,ephemeris_end_time);
-
-		threadpool_t* pool;
-		pool = threadpool_create(NUM_THREAD);
-		for(j = 0; j < NUM_THREAD; j++)
-		{
-			update_longitude_latitude_args->start_oli_frame_to_update = j*mwdImage_buffer_info->num_oli_frame/NUM_THREAD;
-			if(j == NUM_THREAD-1)
-			{
-				update_longitude_latitude_args->end_oli_frame_to_update = mwdImage_buffer_info->num_oli_frame;
-			}
-			else
-			{
-				update_longitude_latitude_args->end_oli_frame_to_update = j*mwdImage_buffer_info->num_oli_frame/NUM_THREAD
-																			+mwdImage_buffer_info->num_oli_frame/NUM_THREAD;
-			}
-			update_longitude_latitude_args->model = model;
-			update_longitude_latitude_args->mwdImage_buffer_info = mwdImage_buffer_info;
-
-			threadpool_add(pool,(void*)&update_longitude_latitude,(void*)update_longitude_latitude_args);
-		}
-
-//		/* Added the remain data to the last thread */
-//		update_longitude_latitude_args->start_oli_frame_to_update = j*(mwdImage_buffer_info->num_oli_frame/(NUM_THREAD-1))*(NUM_THREAD-2);
-//		update_longitude_latitude_args->end_oli_frame_to_update = j*mwdImage_buffer_info->num_oli_frame;
-//		threadpool_add(pool,(void*)&update_longitude_latitude,(void*)update_longitude_latitude_args);
-
-		threadpool_destroy(pool);
-
-		status = write_mwdImage(&parameters,i,mwdImage_buffer_info);
-	}
-
 //
 //
 //	IAS_SATELLITE_ID satellite_id;
@@ -0,0 +1,427 @@
+/*
+ * mwdImage_frame_index.c
+ *
+ *  Build, save and load the frame index of a mwdImage file.
+ */
+
+
+#include "read_write_mwdImage.h"
+#include "mwdImage_frame_index.h"
+
+
+/* *********************************************************************************
+ * NAME:			add_frame_index_entry
+ *
+ * PURPOSE:	append an entry to the index, growing it as needed
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int add_frame_index_entry(MWD_FRAME_INDEX *frame_index,
+						const MWD_FRAME_INDEX_ENTRY *entry)
+{
+	MWD_FRAME_INDEX_ENTRY *entries;
+	long long capacity;
+
+	if(frame_index->num_entries == frame_index->capacity)
+	{
+		capacity = (frame_index->capacity == 0) ? FRAME_INDEX_INITIAL_CAPACITY
+				: frame_index->capacity * 2;
+		entries = realloc(frame_index->entries,capacity*sizeof(*entries));
+		if(entries == NULL)
+		{
+			IAS_LOG_ERROR("failed to allocate memory for the frame index!\n");
+			return ERROR;
+		}
+		frame_index->entries = entries;
+		frame_index->capacity = capacity;
+	}
+
+	frame_index->entries[frame_index->num_entries++] = *entry;
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			free_frame_index
+ *
+ * PURPOSE:	free the entries of the index
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void free_frame_index(MWD_FRAME_INDEX *frame_index)
+{
+	free(frame_index->entries);
+	memset(frame_index,0,sizeof(*frame_index));
+}
+
+
+/* *********************************************************************************
+ * NAME:			build_frame_index
+ *
+ * PURPOSE:	walk all the frame headers of the file once, from the first synced
+ * 			frame to the end of the file, through sliding read-only windows
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int build_frame_index(int fd, long long file_size, MWD_FRAME_INDEX *frame_index)
+{
+	char* memblock;
+	long long map_offset;
+	long long map_length;
+	long long block_index;
+	long long next_frame_offset;
+	long long page_size = sysconf(_SC_PAGESIZE);
+	size_t start_sync_position;
+	MWD_FRAME_INDEX_ENTRY entry;
+	int synced = 0;
+	int status;
+
+	memset(frame_index,0,sizeof(*frame_index));
+	if(file_size < FRAME_HEADER_SIZE)
+	{
+		IAS_LOG_WARNING("No frame in the mwdImage file.\n");
+		return SUCCESS;
+	}
+
+	next_frame_offset = 0;
+	while(next_frame_offset + FRAME_HEADER_SIZE <= file_size)
+	{
+		/* The mapping must start on a page boundary */
+		map_offset = next_frame_offset & ~(page_size - 1);
+		map_length = file_size - map_offset;
+		if(map_length > MWD_WINDOW_SIZE)
+		{
+			map_length = MWD_WINDOW_SIZE;
+		}
+
+		memblock = mmap(NULL,map_length,PROT_READ,MAP_SHARED,fd,map_offset);
+		if(memblock == MAP_FAILED)
+		{
+			IAS_LOG_ERROR("failed to map the mwdImage file at %lld!\n",
+					map_offset);
+			free_frame_index(frame_index);
+			return ERROR;
+		}
+
+		/* Sync the first frame */
+		if(!synced)
+		{
+			status = frame_header_sync(memblock,map_length,&start_sync_position);
+			if(status != SUCCESS)
+			{
+				IAS_LOG_ERROR("Cann't sync the frame header!\n");
+				munmap(memblock,map_length);
+				return ERROR;
+			}
+			next_frame_offset = start_sync_position;
+			synced = 1;
+		}
+
+		block_index = next_frame_offset - map_offset;
+		while(block_index + FRAME_HEADER_SIZE <= map_length)
+		{
+			if(memblock[block_index] != 'L' || memblock[block_index+1] != '8')
+			{
+				IAS_LOG_ERROR("lost the frame sync at %lld!\n",
+						map_offset+block_index);
+				munmap(memblock,map_length);
+				free_frame_index(frame_index);
+				return ERROR;
+			}
+
+			entry.offset = map_offset + block_index;
+			memcpy(&entry.length,memblock+block_index+FRAME_LENGTH_OFFSET,
+					sizeof(int));
+			memcpy(&entry.time,memblock+block_index+FRAME_TIME_OFFSET,
+					sizeof(long long));
+			memcpy(entry.mode,memblock+block_index+FRAME_MODE_OFFSET,
+					sizeof(entry.mode));
+			if(entry.length < FRAME_HEADER_SIZE)
+			{
+				IAS_LOG_ERROR("invalid frame length %d at %lld!\n",
+						entry.length,entry.offset);
+				munmap(memblock,map_length);
+				free_frame_index(frame_index);
+				return ERROR;
+			}
+
+			if(add_frame_index_entry(frame_index,&entry) != SUCCESS)
+			{
+				munmap(memblock,map_length);
+				free_frame_index(frame_index);
+				return ERROR;
+			}
+			block_index += entry.length;
+		}
+		next_frame_offset = map_offset + block_index;
+
+		munmap(memblock,map_length);
+	}
+
+	IAS_LOG_INFO("Indexed %lld frames of the mwdImage file",
+			frame_index->num_entries);
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			check_frame_index
+ *
+ * PURPOSE:	spot check evenly spaced entries of a loaded index against the
+ * 			file, so a stale sidecar file is not used. The lat/lon written by
+ * 			a previous run are not checked since they do not move frames.
+ *
+ * RETURN: SUCCESS if the index matches the file, ERROR otherwise
+ * *********************************************************************************/
+static int check_frame_index(int fd, const MWD_FRAME_INDEX *frame_index)
+{
+	char header[FRAME_HEADER_SIZE];
+	const MWD_FRAME_INDEX_ENTRY *entry;
+	long long step;
+	long long i;
+	int length;
+
+	step = frame_index->num_entries / FRAME_INDEX_NUM_CHECKS;
+	if(step < 1)
+	{
+		step = 1;
+	}
+
+	for(i = 0; i < frame_index->num_entries; i += step)
+	{
+		/* Always check the last frame */
+		if(i + step >= frame_index->num_entries)
+		{
+			i = frame_index->num_entries - 1;
+		}
+		entry = &frame_index->entries[i];
+		if(pread(fd,header,sizeof(header),entry->offset) != sizeof(header))
+		{
+			return ERROR;
+		}
+		memcpy(&length,header+FRAME_LENGTH_OFFSET,sizeof(int));
+		if(header[0] != 'L' || header[1] != '8' || length != entry->length
+				|| memcmp(header+FRAME_MODE_OFFSET,entry->mode,
+						sizeof(entry->mode)) != 0)
+		{
+			return ERROR;
+		}
+	}
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			read_frame_index_file
+ *
+ * PURPOSE:	load the index saved by a previous run on the same file
+ *
+ * RETURN: SUCCESS, WARNING if there is no usable index file, ERROR
+ * *********************************************************************************/
+int read_frame_index_file(const char *index_filename, int fd,
+						long long file_size, MWD_FRAME_INDEX *frame_index)
+{
+	FILE *fp;
+	MWD_FRAME_INDEX_FILE_HEADER header;
+
+	memset(frame_index,0,sizeof(*frame_index));
+
+	fp = fopen(index_filename,"rb");
+	if(fp == NULL)
+	{
+		return WARNING;
+	}
+
+	if(fread(&header,sizeof(header),1,fp) != 1
+			|| strncmp(header.magic,FRAME_INDEX_FILE_MAGIC,sizeof(header.magic)) != 0
+			|| header.version != FRAME_INDEX_FILE_VERSION
+			|| header.entry_size != sizeof(MWD_FRAME_INDEX_ENTRY)
+			|| header.file_size != file_size
+			|| header.num_entries < 0)
+	{
+		IAS_LOG_WARNING("Ignoring the frame index file %s",index_filename);
+		fclose(fp);
+		return WARNING;
+	}
+
+	if(header.num_entries > 0)
+	{
+		frame_index->entries = malloc(header.num_entries
+				*sizeof(*frame_index->entries));
+		if(frame_index->entries == NULL)
+		{
+			IAS_LOG_ERROR("failed to allocate memory for the frame index!\n");
+			fclose(fp);
+			return ERROR;
+		}
+		frame_index->capacity = header.num_entries;
+		if(fread(frame_index->entries,sizeof(*frame_index->entries),
+				header.num_entries,fp) != (size_t)header.num_entries)
+		{
+			IAS_LOG_WARNING("Ignoring the truncated frame index file %s",
+					index_filename);
+			free_frame_index(frame_index);
+			fclose(fp);
+			return WARNING;
+		}
+		frame_index->num_entries = header.num_entries;
+	}
+	fclose(fp);
+
+	if(check_frame_index(fd,frame_index) != SUCCESS)
+	{
+		IAS_LOG_WARNING("The frame index file %s does not match the mwdImage",
+				index_filename);
+		free_frame_index(frame_index);
+		return WARNING;
+	}
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			write_frame_index_file
+ *
+ * PURPOSE:	save the index next to the mwdImage file
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int write_frame_index_file(const char *index_filename, long long file_size,
+						const MWD_FRAME_INDEX *frame_index)
+{
+	FILE *fp;
+	MWD_FRAME_INDEX_FILE_HEADER header;
+
+	memset(&header,0,sizeof(header));
+	strncpy(header.magic,FRAME_INDEX_FILE_MAGIC,sizeof(header.magic));
+	header.version = FRAME_INDEX_FILE_VERSION;
+	header.entry_size = sizeof(MWD_FRAME_INDEX_ENTRY);
+	header.file_size = file_size;
+	header.num_entries = frame_index->num_entries;
+
+	fp = fopen(index_filename,"wb");
+	if(fp == NULL)
+	{
+		IAS_LOG_ERROR("failed to open the frame index file %s!\n",
+				index_filename);
+		return ERROR;
+	}
+
+	if(fwrite(&header,sizeof(header),1,fp) != 1
+			|| fwrite(frame_index->entries,sizeof(*frame_index->entries),
+					frame_index->num_entries,fp)
+				!= (size_t)frame_index->num_entries)
+	{
+		IAS_LOG_ERROR("failed to write the frame index file %s!\n",
+				index_filename);
+		fclose(fp);
+		unlink(index_filename);
+		return ERROR;
+	}
+
+	if(fclose(fp) != 0)
+	{
+		IAS_LOG_ERROR("failed to close the frame index file %s!\n",
+				index_filename);
+		unlink(index_filename);
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			get_frame_index
+ *
+ * PURPOSE:	get the index of the frames of the mwdImage file from its sidecar
+ * 			file if a previous run saved one, scan the file otherwise
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int get_frame_index(PARAMETERS* param, int fd, long long file_size,
+						MWD_FRAME_INDEX *frame_index)
+{
+	char index_filename[PATH_MAX];
+	int status;
+
+	if(snprintf(index_filename,sizeof(index_filename),"%s%s",
+			param->mwdImage_filename,FRAME_INDEX_FILE_SUFFIX)
+			>= (int)sizeof(index_filename))
+	{
+		IAS_LOG_ERROR("The frame index file name is too long!\n");
+		return ERROR;
+	}
+
+	status = read_frame_index_file(index_filename,fd,file_size,frame_index);
+	if(status == SUCCESS)
+	{
+		IAS_LOG_INFO("Read %lld frames from the frame index file %s",
+				frame_index->num_entries,index_filename);
+		return SUCCESS;
+	}
+	else if(status == ERROR)
+	{
+		return ERROR;
+	}
+
+	status = build_frame_index(fd,file_size,frame_index);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("failed to index the frames of the mwdImage file!\n");
+		return ERROR;
+	}
+
+	/* The index is only a cache, keep going when it can not be saved */
+	if(param->save_frame_index
+			&& write_frame_index_file(index_filename,file_size,frame_index)
+				!= SUCCESS)
+	{
+		IAS_LOG_WARNING("The frame index is not saved");
+	}
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			select_oli_frames
+ *
+ * PURPOSE:	select the OLI frames whose image time is covered by the ephemeris
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int select_oli_frames(const MWD_FRAME_INDEX *frame_index,
+						double ephemeris_start_time, double ephemeris_end_time,
+						MWD_FRAME_INDEX *oli_frame_index)
+{
+	const MWD_FRAME_INDEX_ENTRY *entry;
+	long long frame_time;
+	long long i;
+
+	memset(oli_frame_index,0,sizeof(*oli_frame_index));
+	for(i = 0; i < frame_index->num_entries; i++)
+	{
+		entry = &frame_index->entries[i];
+		if(entry->mode[0] != 'O' || entry->mode[1] != 'L'
+				|| entry->mode[2] != 'I')
+		{
+			continue;
+		}
+
+		frame_time = entry->time - J2000_SUB_UTC_EPOCH;
+		if(frame_time >= ephemeris_start_time*1000
+				&& frame_time <= ephemeris_end_time*1000)
+		{
+			if(add_frame_index_entry(oli_frame_index,entry) != SUCCESS)
+			{
+				free_frame_index(oli_frame_index);
+				return ERROR;
+			}
+		}
+	}
+
+	return SUCCESS;
+}
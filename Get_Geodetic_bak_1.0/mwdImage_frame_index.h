@@ -0,0 +1,99 @@
+/*
+ * mwdImage_frame_index.h
+ *
+ *  Index of the frames of a mwdImage file, built once per file by a single
+ *  sequential scan and optionally kept in a sidecar file next to the
+ *  mwdImage so a rerun on the same file does not scan it again.
+ */
+
+#ifndef MWDIMAGE_FRAME_INDEX_H_
+#define MWDIMAGE_FRAME_INDEX_H_
+
+#include "read_parameter.h"
+
+#define FRAME_INDEX_FILE_SUFFIX ".idx"
+#define FRAME_INDEX_FILE_MAGIC "MWDFIDX"
+#define FRAME_INDEX_FILE_VERSION 1
+#define FRAME_INDEX_INITIAL_CAPACITY 65536
+/* Number of entries of a loaded index checked against the file */
+#define FRAME_INDEX_NUM_CHECKS 64
+
+
+typedef struct mwd_frame_index_entry
+{
+	long long offset;			//file offset of the frame
+	long long time;				//image time of the frame (ms since 1970)
+	int length;					//length of the frame in bytes
+	char mode[4];				//frame mode, "OLI", "TIRS" or "PAN"
+}MWD_FRAME_INDEX_ENTRY;
+
+
+typedef struct mwd_frame_index
+{
+	MWD_FRAME_INDEX_ENTRY *entries;	//frames in file order
+	long long num_entries;			//number of frames in the index
+	long long capacity;				//number of entries allocated
+}MWD_FRAME_INDEX;
+
+
+/* header of the sidecar index file, followed by the entries */
+typedef struct mwd_frame_index_file_header
+{
+	char magic[8];
+	int version;
+	int entry_size;
+	long long file_size;		//size of the indexed mwdImage file
+	long long num_entries;
+}MWD_FRAME_INDEX_FILE_HEADER;
+
+
+int get_frame_index
+(
+	PARAMETERS* param,				//I:parameters
+	int fd,							//I:descriptor of the mwdImage file
+	long long file_size,			//I:size of the mwdImage file
+	MWD_FRAME_INDEX *frame_index	//O:index of all the frames of the file
+);
+
+int build_frame_index
+(
+	int fd,							//I:descriptor of the mwdImage file
+	long long file_size,			//I:size of the mwdImage file
+	MWD_FRAME_INDEX *frame_index	//O:index of all the frames of the file
+);
+
+int read_frame_index_file
+(
+	const char *index_filename,		//I:sidecar index file name
+	int fd,							//I:descriptor of the mwdImage file
+	long long file_size,			//I:size of the mwdImage file
+	MWD_FRAME_INDEX *frame_index	//O:index read from the sidecar file
+);
+
+int write_frame_index_file
+(
+	const char *index_filename,			//I:sidecar index file name
+	long long file_size,				//I:size of the mwdImage file
+	const MWD_FRAME_INDEX *frame_index	//I:index to save
+);
+
+int select_oli_frames
+(
+	const MWD_FRAME_INDEX *frame_index,	//I:index of all the frames
+	double ephemeris_start_time,		//I:first valid ephemeris time
+	double ephemeris_end_time,			//I:last valid ephemeris time
+	MWD_FRAME_INDEX *oli_frame_index	//O:OLI frames covered by ephemeris
+);
+
+int add_frame_index_entry
+(
+	MWD_FRAME_INDEX *frame_index,			//I/O:index to grow
+	const MWD_FRAME_INDEX_ENTRY *entry		//I:entry to append
+);
+
+void free_frame_index
+(
+	MWD_FRAME_INDEX *frame_index	//I/O:index to free
+);
+
+#endif /* MWDIMAGE_FRAME_INDEX_H_ */
@@ -0,0 +1,430 @@
+/*
+ * mwd_daemon.c
+ *
+ *  Scene workers claiming the work orders of a spool directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include "ias_logging.h"
+#include "ias_satellite_attributes.h"
+#include "ias_cpf.h"
+#include "read_parameter.h"
+#include "scene_cache.h"
+#include "mwd_scene.h"
+#include "mwd_daemon.h"
+
+
+typedef struct mwd_daemon
+{
+	const char *spool_directory;		//directory of the work orders
+	pthread_mutex_t claim_lock;			//serializes the claims
+	pthread_mutex_t load_lock;			//serializes the parameter file and
+										//CPF parsing and the model builds,
+										//the ODL and NOVAS routines are not
+										//thread-safe
+	SCENE_CACHE cpf_cache;				//parsed CPFs
+	SCENE_CACHE model_cache;			//scene models
+	int satellite_initialized;			//satellite attributes initialized
+	IAS_SATELLITE_ID satellite_id;		//satellite of the attributes
+	int mq_initialized;					//MQ connection attempted
+	long long num_done;					//work orders processed
+	long long num_failed;				//work orders failed
+}MWD_DAEMON;
+
+typedef struct scene_worker
+{
+	MWD_DAEMON *daemon;
+	pthread_t thread;
+	int index;
+}SCENE_WORKER;
+
+/* set by the signal handler or the stop file */
+static volatile sig_atomic_t daemon_stop = 0;
+
+
+static void handle_stop_signal(int signal_number)
+{
+	(void)signal_number;
+	daemon_stop = 1;
+}
+
+static void free_cpf_value(void *value)
+{
+	ias_cpf_free(value);
+}
+
+static void free_scene_model_value(void *value)
+{
+	free_scene_model(value);
+}
+
+
+/* *********************************************************************************
+ * NAME:			claim_work_order
+ *
+ * PURPOSE:	claim the work order of the spool directory first in name order
+ * 			by renaming it with the working suffix. The rename is atomic, so
+ * 			a work order is claimed once even by several daemons.
+ *
+ * RETURN: 1 if a work order was claimed, 0 if none is waiting
+ * *********************************************************************************/
+static int claim_work_order(MWD_DAEMON *daemon, char *working_filename,
+		size_t size)
+{
+	DIR *directory;
+	struct dirent *dirent;
+	char name[NAME_MAX + 1];
+	char filename[PATH_MAX];
+	size_t suffix_length = strlen(DAEMON_WORK_ORDER_SUFFIX);
+	int claimed = 0;
+
+	pthread_mutex_lock(&daemon->claim_lock);
+	while(!claimed)
+	{
+		directory = opendir(daemon->spool_directory);
+		if(directory == NULL)
+		{
+			IAS_LOG_ERROR("failed to open the spool directory %s!\n",
+					daemon->spool_directory);
+			break;
+		}
+
+		name[0] = '\0';
+		while((dirent = readdir(directory)) != NULL)
+		{
+			size_t length = strlen(dirent->d_name);
+
+			if(length <= suffix_length || strcmp(dirent->d_name + length
+					- suffix_length,DAEMON_WORK_ORDER_SUFFIX) != 0)
+			{
+				continue;
+			}
+			if(name[0] == '\0' || strcmp(dirent->d_name,name) < 0)
+			{
+				strncpy(name,dirent->d_name,sizeof(name) - 1);
+				name[sizeof(name) - 1] = '\0';
+			}
+		}
+		closedir(directory);
+		if(name[0] == '\0')
+			break;
+
+		snprintf(filename,sizeof(filename),"%s/%s",daemon->spool_directory,
+				name);
+		snprintf(working_filename,size,"%s%s",filename,DAEMON_WORKING_SUFFIX);
+		if(rename(filename,working_filename) == 0)
+			claimed = 1;
+		/* otherwise another daemon claimed it first, look again */
+	}
+	pthread_mutex_unlock(&daemon->claim_lock);
+
+	return claimed;
+}
+
+
+/* *********************************************************************************
+ * NAME:			acquire_scene_model
+ *
+ * PURPOSE:	get the model of a scene from the cache, or build it from the
+ * 			CPF, itself from the cache or parsed, and add it to the cache.
+ * 			The caller holds the load lock.
+ *
+ * RETURN: the model, acquired under model_key, or NULL on error
+ * *********************************************************************************/
+static MWD_SCENE_MODEL *acquire_scene_model(MWD_DAEMON *daemon,
+		PARAMETERS *param, char *model_key)
+{
+	char cpf_key[SCENE_CACHE_KEY_SIZE];
+	MWD_SCENE_MODEL *scene_model;
+	IAS_CPF *cpf;
+
+	cpf_key[0] = '\0';
+	if(scene_cache_append_file_key(param->cpf_filename,cpf_key,
+			sizeof(cpf_key)) != SUCCESS)
+	{
+		return NULL;
+	}
+	strcpy(model_key,cpf_key);
+	if(scene_cache_append_file_key(param->ephemeris_filename,model_key,
+			SCENE_CACHE_KEY_SIZE) != SUCCESS)
+	{
+		return NULL;
+	}
+
+	scene_model = scene_cache_acquire(&daemon->model_cache,model_key);
+	if(scene_model != NULL)
+		return scene_model;
+
+	cpf = scene_cache_acquire(&daemon->cpf_cache,cpf_key);
+	if(cpf == NULL)
+	{
+		cpf = ias_cpf_read(param->cpf_filename);
+		if(cpf == NULL)
+		{
+			IAS_LOG_ERROR("failed to read the CPF %s!\n",param->cpf_filename);
+			return NULL;
+		}
+		if(scene_cache_insert(&daemon->cpf_cache,cpf_key,cpf) != SUCCESS)
+		{
+			ias_cpf_free(cpf);
+			return NULL;
+		}
+	}
+
+	scene_model = create_scene_model(param,cpf);
+	scene_cache_release(&daemon->cpf_cache,cpf_key);
+	if(scene_model == NULL)
+		return NULL;
+
+	if(scene_cache_insert(&daemon->model_cache,model_key,scene_model)
+			!= SUCCESS)
+	{
+		free_scene_model(scene_model);
+		return NULL;
+	}
+
+	return scene_model;
+}
+
+
+/* *********************************************************************************
+ * NAME:			process_work_order
+ *
+ * PURPOSE:	read the parameters of a claimed work order and update its
+ * 			mwdImage
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+static int process_work_order(MWD_DAEMON *daemon,
+		const char *working_filename)
+{
+	PARAMETERS param;
+	MQ_PARAMS order_mq_params;
+	char model_key[SCENE_CACHE_KEY_SIZE];
+	MWD_SCENE_MODEL *scene_model = NULL;
+	int status = SUCCESS;
+
+	memset(&param,0,sizeof(param));
+	memset(&order_mq_params,0,sizeof(order_mq_params));
+
+	pthread_mutex_lock(&daemon->load_lock);
+	if(read_parameters(working_filename,&param,&order_mq_params) != SUCCESS)
+	{
+		IAS_LOG_ERROR("failed to read the work order %s!\n",working_filename);
+		status = ERROR;
+	}
+
+	/* The satellite attributes and the MQ connection are process-wide */
+	if(status == SUCCESS && !daemon->satellite_initialized)
+	{
+		if(ias_sat_attr_initialize(param.satellite_id) != SUCCESS)
+		{
+			IAS_LOG_ERROR("Initializing IAS Satellite Attributes Library");
+			status = ERROR;
+		}
+		else
+		{
+			daemon->satellite_id = param.satellite_id;
+			daemon->satellite_initialized = 1;
+		}
+	}
+	else if(status == SUCCESS && param.satellite_id != daemon->satellite_id)
+	{
+		IAS_LOG_ERROR("the work order %s is for another satellite!\n",
+				working_filename);
+		status = ERROR;
+	}
+	if(status == SUCCESS && !daemon->mq_initialized)
+	{
+		mq_params = order_mq_params;
+		if(MQ_Init() != SUCCESS)
+			IAS_LOG_WARNING("MQ connect Error !\n");
+		daemon->mq_initialized = 1;
+	}
+
+	if(status == SUCCESS)
+	{
+		scene_model = acquire_scene_model(daemon,&param,model_key);
+		if(scene_model == NULL)
+		{
+			IAS_LOG_ERROR("failed to get the scene model of %s!\n",
+					working_filename);
+			status = ERROR;
+		}
+	}
+	pthread_mutex_unlock(&daemon->load_lock);
+
+	if(status != SUCCESS)
+		return ERROR;
+
+	if(MQSendOrder(order_mq_params.OrderId,4,"ADP module started !\n")
+			!= SUCCESS)
+	{
+		IAS_LOG_WARNING("module started , MQSend Error !\n");
+	}
+
+	status = update_mwdImage_scene(&param,scene_model,
+			order_mq_params.OrderId);
+	scene_cache_release(&daemon->model_cache,model_key);
+
+	if(status == SUCCESS)
+		MQSendOrder(order_mq_params.OrderId,5,"ADP module completed !\n");
+	else
+		MQSendOrder(order_mq_params.OrderId,3,"ADP module failed !\n");
+
+	return status;
+}
+
+
+/* *********************************************************************************
+ * NAME:			scene_worker_main
+ *
+ * PURPOSE:	claim and process work orders until the daemon stops
+ *
+ * RETURN: NULL
+ * *********************************************************************************/
+static void *scene_worker_main(void *arg)
+{
+	SCENE_WORKER *worker = arg;
+	MWD_DAEMON *daemon = worker->daemon;
+	char working_filename[PATH_MAX];
+	char final_filename[PATH_MAX];
+	size_t length;
+	int status;
+
+	while(!daemon_stop)
+	{
+		if(!claim_work_order(daemon,working_filename,
+				sizeof(working_filename)))
+		{
+			sleep(DAEMON_POLL_SECONDS);
+			continue;
+		}
+
+		IAS_LOG_INFO("Scene worker %d processing %s",worker->index,
+				working_filename);
+		status = process_work_order(daemon,working_filename);
+
+		/* Replace the working suffix by the outcome */
+		length = strlen(working_filename) - strlen(DAEMON_WORKING_SUFFIX);
+		snprintf(final_filename,sizeof(final_filename),"%.*s%s",(int)length,
+				working_filename,(status == SUCCESS) ? DAEMON_DONE_SUFFIX
+				: DAEMON_FAILED_SUFFIX);
+		if(rename(working_filename,final_filename) != 0)
+		{
+			IAS_LOG_WARNING("failed to rename %s to %s",working_filename,
+					final_filename);
+		}
+
+		pthread_mutex_lock(&daemon->claim_lock);
+		if(status == SUCCESS)
+			daemon->num_done++;
+		else
+			daemon->num_failed++;
+		pthread_mutex_unlock(&daemon->claim_lock);
+		IAS_LOG_INFO("Scene worker %d finished %s",worker->index,
+				final_filename);
+	}
+
+	return NULL;
+}
+
+
+/* *********************************************************************************
+ * NAME:			run_mwd_daemon
+ *
+ * PURPOSE:	process the work orders of a spool directory with several scene
+ * 			workers until asked to stop
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int run_mwd_daemon(const char *spool_directory, int num_scenes)
+{
+	MWD_DAEMON daemon;
+	SCENE_WORKER *workers;
+	struct sigaction action;
+	char stop_filename[PATH_MAX];
+	int num_started;
+	int i;
+
+	if(num_scenes < 1 || num_scenes > DAEMON_MAX_SCENES)
+	{
+		IAS_LOG_ERROR("the number of scenes must be from 1 to %d!\n",
+				DAEMON_MAX_SCENES);
+		return ERROR;
+	}
+
+	memset(&daemon,0,sizeof(daemon));
+	daemon.spool_directory = spool_directory;
+	pthread_mutex_init(&daemon.claim_lock,NULL);
+	pthread_mutex_init(&daemon.load_lock,NULL);
+	if(scene_cache_init(&daemon.cpf_cache,DAEMON_CPF_CACHE_SIZE,
+			free_cpf_value) != SUCCESS
+		|| scene_cache_init(&daemon.model_cache,DAEMON_MODEL_CACHE_SIZE,
+			free_scene_model_value) != SUCCESS)
+	{
+		return ERROR;
+	}
+
+	memset(&action,0,sizeof(action));
+	action.sa_handler = handle_stop_signal;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT,&action,NULL);
+	sigaction(SIGTERM,&action,NULL);
+
+	workers = calloc(num_scenes,sizeof(*workers));
+	if(workers == NULL)
+	{
+		IAS_LOG_ERROR("failed to allocate the scene workers!\n");
+		return ERROR;
+	}
+	for(num_started = 0; num_started < num_scenes; num_started++)
+	{
+		workers[num_started].daemon = &daemon;
+		workers[num_started].index = num_started;
+		if(pthread_create(&workers[num_started].thread,NULL,
+				scene_worker_main,&workers[num_started]) != 0)
+		{
+			IAS_LOG_ERROR("failed to start scene worker %d!\n",num_started);
+			daemon_stop = 1;
+			break;
+		}
+	}
+	IAS_LOG_INFO("Processing the work orders of %s with %d scene workers",
+			spool_directory,num_started);
+
+	snprintf(stop_filename,sizeof(stop_filename),"%s/%s",spool_directory,
+			DAEMON_STOP_FILENAME);
+	while(!daemon_stop)
+	{
+		if(access(stop_filename,F_OK) == 0)
+		{
+			IAS_LOG_INFO("Found %s, stopping",stop_filename);
+			daemon_stop = 1;
+			break;
+		}
+		sleep(DAEMON_POLL_SECONDS);
+	}
+
+	/* The scenes in progress are finished before stopping */
+	for(i = 0; i < num_started; i++)
+		pthread_join(workers[i].thread,NULL);
+	free(workers);
+
+	IAS_LOG_INFO("%lld work orders processed, %lld failed",daemon.num_done,
+			daemon.num_failed);
+	scene_cache_destroy(&daemon.model_cache);
+	scene_cache_destroy(&daemon.cpf_cache);
+	pthread_mutex_destroy(&daemon.claim_lock);
+	pthread_mutex_destroy(&daemon.load_lock);
+
+	return (num_started == num_scenes) ? SUCCESS : ERROR;
+}
@@ -0,0 +1,36 @@
+/*
+ * mwd_daemon.h
+ *
+ *  Service mode processing the work orders dropped in a spool directory.
+ *  A work order is the parameter file of a scene, named *.odl. It is
+ *  claimed by renaming it to *.odl.working, and renamed to *.odl.done or
+ *  *.odl.failed once processed. Several scenes are processed at once, and
+ *  the parsed CPFs and scene models are kept between the work orders in
+ *  LRU caches keyed by the identity of their files. The daemon stops once
+ *  the scenes in progress are done when a file named "stop" appears in the
+ *  spool directory or on SIGINT or SIGTERM.
+ */
+
+#ifndef MWD_DAEMON_H_
+#define MWD_DAEMON_H_
+
+#define DAEMON_WORK_ORDER_SUFFIX ".odl"
+#define DAEMON_WORKING_SUFFIX ".working"
+#define DAEMON_DONE_SUFFIX ".done"
+#define DAEMON_FAILED_SUFFIX ".failed"
+#define DAEMON_STOP_FILENAME "stop"
+/* seconds between the scans of an idle spool directory */
+#define DAEMON_POLL_SECONDS 1
+/* parsed CPFs and scene models kept when not in use */
+#define DAEMON_CPF_CACHE_SIZE 4
+#define DAEMON_MODEL_CACHE_SIZE 8
+#define DAEMON_MAX_SCENES 64
+
+
+int run_mwd_daemon
+(
+	const char *spool_directory,		//I:directory of the work orders
+	int num_scenes						//I:scenes processed at once
+);
+
+#endif /* MWD_DAEMON_H_ */
@@ -0,0 +1,366 @@
+/*
+ * mwd_metrics.c
+ *
+ *  Stage metrics of a scene, reported over MQ and written as JSON.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "ias_const.h"
+#include "ias_logging.h"
+#include "MQSend.h"
+#include "mwd_metrics.h"
+
+static const char *stage_names[MWD_NUM_STAGES] = {"read", "geolocate", "write"};
+
+
+long long mwd_metrics_now_ns()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+
+/* Write a string as a quoted JSON string, escaping the quotes, backslashes
+ * and control characters */
+static void write_json_string(FILE *fp, const char *string)
+{
+	const unsigned char *c;
+
+	fputc('"',fp);
+	for(c = (const unsigned char *)string; *c != '\0'; c++)
+	{
+		if(*c == '"' || *c == '\\')
+			fprintf(fp,"\\%c",*c);
+		else if(*c < 0x20)
+			fprintf(fp,"\\u%04x",*c);
+		else
+			fputc(*c,fp);
+	}
+	fputc('"',fp);
+}
+
+
+/* Copy the counters of a stage, updated concurrently by the workers */
+static void snapshot_stage(MWD_STAGE_METRICS *stage, MWD_STAGE_METRICS *copy)
+{
+	int i;
+
+	copy->count = __sync_fetch_and_add(&stage->count,0);
+	copy->frames = __sync_fetch_and_add(&stage->frames,0);
+	copy->bytes = __sync_fetch_and_add(&stage->bytes,0);
+	copy->total_ns = __sync_fetch_and_add(&stage->total_ns,0);
+	copy->max_ns = __sync_fetch_and_add(&stage->max_ns,0);
+	for(i = 0; i < MWD_METRICS_NUM_BUCKETS; i++)
+		copy->histogram[i] = __sync_fetch_and_add(&stage->histogram[i],0);
+}
+
+
+/* Upper bound in microseconds of the bucket holding a percentile */
+static double stage_percentile_us(const MWD_STAGE_METRICS *stage,
+		double percentile)
+{
+	long long target = (long long)(percentile * stage->count / 100.0 + 0.5);
+	long long cumulative = 0;
+	int i;
+
+	if(stage->count == 0)
+		return 0.0;
+	if(target < 1)
+		target = 1;
+	for(i = 0; i < MWD_METRICS_NUM_BUCKETS; i++)
+	{
+		cumulative += stage->histogram[i];
+		if(cumulative >= target)
+			break;
+	}
+	if(i == MWD_METRICS_NUM_BUCKETS)
+		i--;
+	return (double)(2LL << i);
+}
+
+
+/* *********************************************************************************
+ * NAME:			send_summary
+ *
+ * PURPOSE:	send a one-line summary of the metrics over MQ as a progress
+ * 			message, which the publisher may coalesce under load
+ *
+ * RETURN: void
+ * *********************************************************************************/
+static void send_summary(MWD_METRICS *metrics)
+{
+	MWD_STAGE_METRICS stages[MWD_NUM_STAGES];
+	char message[NAME_MAX];
+	double elapsed;
+	double busy = 0.0;
+	int num_threads;
+	int i;
+
+	for(i = 0; i < MWD_NUM_STAGES; i++)
+		snapshot_stage(&metrics->stages[i],&stages[i]);
+	elapsed = (mwd_metrics_now_ns() - metrics->start_ns) / 1e9;
+	if(elapsed <= 0.0)
+		elapsed = 1e-9;
+	num_threads = frame_executor_get_thread_count(metrics->executor);
+	for(i = 0; i < num_threads; i++)
+		busy += frame_executor_get_busy_seconds(metrics->executor,i);
+
+	snprintf(message,sizeof(message),"metrics frames=%lld/%lld fps=%.1f "
+			"read_MBps=%.1f write_MBps=%.1f p99_us read=%.0f geo=%.0f "
+			"write=%.0f depth=%lld util=%.0f%%",
+			stages[MWD_STAGE_GEOLOCATE].frames,metrics->num_frames,
+			stages[MWD_STAGE_GEOLOCATE].frames / elapsed,
+			stages[MWD_STAGE_READ].bytes / elapsed / 1e6,
+			stages[MWD_STAGE_WRITE].bytes / elapsed / 1e6,
+			stage_percentile_us(&stages[MWD_STAGE_READ],99.0),
+			stage_percentile_us(&stages[MWD_STAGE_GEOLOCATE],99.0),
+			stage_percentile_us(&stages[MWD_STAGE_WRITE],99.0),
+			frame_executor_get_pending_chunks(metrics->executor),
+			100.0 * busy / (elapsed * num_threads));
+	MQSendOrder(metrics->order_id,1,message);
+}
+
+
+/* *********************************************************************************
+ * NAME:			metrics_reporter
+ *
+ * PURPOSE:	send a summary every MWD_METRICS_REPORT_SECONDS until stopped
+ *
+ * RETURN: NULL
+ * *********************************************************************************/
+static void *metrics_reporter(void *arg)
+{
+	MWD_METRICS *metrics = arg;
+	struct timespec deadline;
+
+	pthread_mutex_lock(&metrics->lock);
+	while(!metrics->stopping)
+	{
+		clock_gettime(CLOCK_REALTIME,&deadline);
+		deadline.tv_sec += MWD_METRICS_REPORT_SECONDS;
+		while(!metrics->stopping && pthread_cond_timedwait(&metrics->cond,
+				&metrics->lock,&deadline) != ETIMEDOUT)
+		{
+			;
+		}
+		if(metrics->stopping)
+			break;
+		pthread_mutex_unlock(&metrics->lock);
+		send_summary(metrics);
+		pthread_mutex_lock(&metrics->lock);
+	}
+	pthread_mutex_unlock(&metrics->lock);
+
+	return NULL;
+}
+
+
+/* *********************************************************************************
+ * NAME:			mwd_metrics_start
+ *
+ * PURPOSE:	clear the metrics of a scene and start reporting them
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int mwd_metrics_start(MWD_METRICS *metrics, const char *order_id,
+		FRAME_EXECUTOR *executor, long long num_frames)
+{
+	memset(metrics,0,sizeof(*metrics));
+	snprintf(metrics->order_id,sizeof(metrics->order_id),"%s",order_id);
+	metrics->executor = executor;
+	metrics->num_frames = num_frames;
+	metrics->start_ns = mwd_metrics_now_ns();
+	pthread_mutex_init(&metrics->lock,NULL);
+	pthread_cond_init(&metrics->cond,NULL);
+
+	if(pthread_create(&metrics->reporter,NULL,metrics_reporter,metrics) != 0)
+	{
+		IAS_LOG_ERROR("failed to start the metrics reporter!\n");
+		pthread_mutex_destroy(&metrics->lock);
+		pthread_cond_destroy(&metrics->cond);
+		return ERROR;
+	}
+	metrics->reporter_started = 1;
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			mwd_metrics_record_stage
+ *
+ * PURPOSE:	add an operation of a stage ending now, from any thread
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void mwd_metrics_record_stage(MWD_METRICS *metrics, MWD_STAGE stage,
+		long long start_ns, long long frames, long long bytes)
+{
+	MWD_STAGE_METRICS *stage_metrics = &metrics->stages[stage];
+	long long latency_ns = mwd_metrics_now_ns() - start_ns;
+	long long latency_us = latency_ns / 1000;
+	long long max_ns;
+	int bucket = 0;
+
+	while(bucket < MWD_METRICS_NUM_BUCKETS - 1 && (latency_us >> (bucket + 1)))
+		bucket++;
+
+	__sync_fetch_and_add(&stage_metrics->count,1);
+	__sync_fetch_and_add(&stage_metrics->frames,frames);
+	__sync_fetch_and_add(&stage_metrics->bytes,bytes);
+	__sync_fetch_and_add(&stage_metrics->total_ns,latency_ns);
+	__sync_fetch_and_add(&stage_metrics->histogram[bucket],1);
+	max_ns = stage_metrics->max_ns;
+	while(latency_ns > max_ns && !__sync_bool_compare_and_swap(
+			&stage_metrics->max_ns,max_ns,latency_ns))
+	{
+		max_ns = stage_metrics->max_ns;
+	}
+}
+
+
+/* *********************************************************************************
+ * NAME:			mwd_metrics_record_queue_depth
+ *
+ * PURPOSE:	add a sample of the chunks left when the I/O of a window is done,
+ * 			how far the geolocation is behind the I/O. Called by the thread
+ * 			driving the windows only.
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void mwd_metrics_record_queue_depth(MWD_METRICS *metrics,
+		long long pending_chunks)
+{
+	metrics->queue_depth_samples++;
+	metrics->queue_depth_sum += pending_chunks;
+	if(pending_chunks > metrics->queue_depth_max)
+		metrics->queue_depth_max = pending_chunks;
+}
+
+
+/* *********************************************************************************
+ * NAME:			write_metrics_file
+ *
+ * PURPOSE:	write the metrics of the scene as a JSON document
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+static int write_metrics_file(MWD_METRICS *metrics, const char *filename)
+{
+	MWD_STAGE_METRICS stage;
+	FILE *fp;
+	double elapsed;
+	double busy;
+	long long geolocated_frames;
+	long long read_bytes;
+	int num_threads;
+	int i;
+	int j;
+
+	fp = fopen(filename,"w");
+	if(fp == NULL)
+	{
+		IAS_LOG_ERROR("failed to open the metrics file %s!\n",filename);
+		return ERROR;
+	}
+
+	elapsed = (mwd_metrics_now_ns() - metrics->start_ns) / 1e9;
+	if(elapsed <= 0.0)
+		elapsed = 1e-9;
+	geolocated_frames = metrics->stages[MWD_STAGE_GEOLOCATE].frames;
+	read_bytes = metrics->stages[MWD_STAGE_READ].bytes;
+
+	fprintf(fp,"{\n");
+	fprintf(fp,"  \"order_id\": ");
+	write_json_string(fp,metrics->order_id);
+	fprintf(fp,",\n");
+	fprintf(fp,"  \"elapsed_seconds\": %.6f,\n",elapsed);
+	fprintf(fp,"  \"scene_frames\": %lld,\n",metrics->num_frames);
+	fprintf(fp,"  \"frames\": %lld,\n",geolocated_frames);
+	fprintf(fp,"  \"frames_per_second\": %.3f,\n",geolocated_frames / elapsed);
+	fprintf(fp,"  \"bytes_per_second\": %.3f,\n",read_bytes / elapsed);
+	fprintf(fp,"  \"stages\": {\n");
+	for(i = 0; i < MWD_NUM_STAGES; i++)
+	{
+		snapshot_stage(&metrics->stages[i],&stage);
+		fprintf(fp,"    ");
+		write_json_string(fp,stage_names[i]);
+		fprintf(fp,": {\n");
+		fprintf(fp,"      \"count\": %lld,\n",stage.count);
+		fprintf(fp,"      \"frames\": %lld,\n",stage.frames);
+		fprintf(fp,"      \"bytes\": %lld,\n",stage.bytes);
+		fprintf(fp,"      \"total_seconds\": %.6f,\n",stage.total_ns / 1e9);
+		fprintf(fp,"      \"max_seconds\": %.6f,\n",stage.max_ns / 1e9);
+		fprintf(fp,"      \"p50_us\": %.0f,\n",stage_percentile_us(&stage,50.0));
+		fprintf(fp,"      \"p90_us\": %.0f,\n",stage_percentile_us(&stage,90.0));
+		fprintf(fp,"      \"p99_us\": %.0f,\n",stage_percentile_us(&stage,99.0));
+		fprintf(fp,"      \"histogram_upper_us\": [");
+		for(j = 0; j < MWD_METRICS_NUM_BUCKETS; j++)
+			fprintf(fp,"%s%lld",(j == 0) ? "" : ", ",2LL << j);
+		fprintf(fp,"],\n      \"histogram_counts\": [");
+		for(j = 0; j < MWD_METRICS_NUM_BUCKETS; j++)
+			fprintf(fp,"%s%lld",(j == 0) ? "" : ", ",stage.histogram[j]);
+		fprintf(fp,"]\n    }%s\n",(i == MWD_NUM_STAGES - 1) ? "" : ",");
+	}
+	fprintf(fp,"  },\n");
+	fprintf(fp,"  \"queue_depth\": {\"samples\": %lld, \"mean\": %.3f, "
+			"\"max\": %lld},\n",metrics->queue_depth_samples,
+			(metrics->queue_depth_samples == 0) ? 0.0
+			: (double)metrics->queue_depth_sum / metrics->queue_depth_samples,
+			metrics->queue_depth_max);
+	fprintf(fp,"  \"threads\": [\n");
+	num_threads = frame_executor_get_thread_count(metrics->executor);
+	for(i = 0; i < num_threads; i++)
+	{
+		busy = frame_executor_get_busy_seconds(metrics->executor,i);
+		fprintf(fp,"    {\"index\": %d, \"busy_seconds\": %.6f, "
+				"\"utilization\": %.4f}%s\n",i,busy,busy / elapsed,
+				(i == num_threads - 1) ? "" : ",");
+	}
+	fprintf(fp,"  ]\n}\n");
+
+	if(fclose(fp) != 0)
+	{
+		IAS_LOG_ERROR("failed to write the metrics file %s!\n",filename);
+		return ERROR;
+	}
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			mwd_metrics_stop
+ *
+ * PURPOSE:	stop the reporter, send a last summary and write the metrics
+ * 			file if one is given. The executor must still exist.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int mwd_metrics_stop(MWD_METRICS *metrics, const char *metrics_filename)
+{
+	int status = SUCCESS;
+
+	if(!metrics->reporter_started)
+		return SUCCESS;
+
+	pthread_mutex_lock(&metrics->lock);
+	metrics->stopping = 1;
+	pthread_cond_broadcast(&metrics->cond);
+	pthread_mutex_unlock(&metrics->lock);
+	pthread_join(metrics->reporter,NULL);
+	metrics->reporter_started = 0;
+
+	send_summary(metrics);
+	if(metrics_filename != NULL && metrics_filename[0] != '\0')
+		status = write_metrics_file(metrics,metrics_filename);
+
+	pthread_mutex_destroy(&metrics->lock);
+	pthread_cond_destroy(&metrics->cond);
+	return status;
+}
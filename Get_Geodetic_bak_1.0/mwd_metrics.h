@@ -0,0 +1,89 @@
+/*
+ * mwd_metrics.h
+ *
+ *  Throughput and latency metrics of the read, geolocate and write stages
+ *  of a scene. A reporter thread sends a summary over MQ periodically, and
+ *  the full metrics are written as JSON when the scene is done.
+ */
+
+#ifndef MWD_METRICS_H_
+#define MWD_METRICS_H_
+
+#include <limits.h>
+#include <pthread.h>
+
+#include "frame_executor.h"
+
+/* latency buckets, bucket i counts the latencies below 2^(i+1) microseconds */
+#define MWD_METRICS_NUM_BUCKETS 32
+/* seconds between the summaries sent over MQ */
+#define MWD_METRICS_REPORT_SECONDS 10
+
+typedef enum mwd_stage
+{
+	MWD_STAGE_READ,						//mapping and prefetching a window
+	MWD_STAGE_GEOLOCATE,				//locating a chunk of frames
+	MWD_STAGE_WRITE,					//writing a window back
+	MWD_NUM_STAGES
+}MWD_STAGE;
+
+typedef struct mwd_stage_metrics
+{
+	long long count;					//number of operations
+	long long frames;					//frames of the operations
+	long long bytes;					//bytes of the operations
+	long long total_ns;					//time of the operations
+	long long max_ns;					//longest operation
+	long long histogram[MWD_METRICS_NUM_BUCKETS];	//latencies
+}MWD_STAGE_METRICS;
+
+typedef struct mwd_metrics
+{
+	pthread_mutex_t lock;				//protects stopping
+	pthread_cond_t cond;				//signaled on stop
+	pthread_t reporter;					//thread sending the summaries
+	int reporter_started;				//1 if the reporter is running
+	int stopping;						//set to stop the reporter
+	char order_id[NAME_MAX];			//routing key of the summaries
+	FRAME_EXECUTOR *executor;			//workers of the geolocation
+	long long num_frames;				//frames of the scene to locate
+	long long start_ns;					//start of the scene
+	MWD_STAGE_METRICS stages[MWD_NUM_STAGES];	//updated atomically
+	long long queue_depth_samples;		//chunks left when the I/O of a
+	long long queue_depth_sum;			//window is done
+	long long queue_depth_max;
+}MWD_METRICS;
+
+
+long long mwd_metrics_now_ns();
+
+int mwd_metrics_start
+(
+	MWD_METRICS *metrics,				//O:metrics to start
+	const char *order_id,				//I:order the summaries are sent for
+	FRAME_EXECUTOR *executor,			//I:workers of the geolocation
+	long long num_frames				//I:frames of the scene to locate
+);
+
+void mwd_metrics_record_stage
+(
+	MWD_METRICS *metrics,				//I/O:metrics to update
+	MWD_STAGE stage,					//I:stage of the operation
+	long long start_ns,					//I:start of the operation
+	long long frames,					//I:frames of the operation
+	long long bytes						//I:bytes of the operation
+);
+
+void mwd_metrics_record_queue_depth
+(
+	MWD_METRICS *metrics,				//I/O:metrics to update
+	long long pending_chunks			//I:chunks left in the executor
+);
+
+int mwd_metrics_stop
+(
+	MWD_METRICS *metrics,				//I/O:metrics to stop
+	const char *metrics_filename		//I:JSON output, empty for none
+);
+
+#endif /* MWD_METRICS_H_ */
@@ -0,0 +1,384 @@
+/*
+ * mwd_scene.c
+ *
+ *  Build the model of a scene and update the frames of its mwdImage.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ias_logging.h"
+#include "ias_ancillary.h"
+#include "read_ephemeris_data.h"
+#include "read_write_mwdImage.h"
+#include "frame_executor.h"
+#include "update_longitude_latitude.h"
+#include "mwd_metrics.h"
+#include "mwd_scene.h"
+
+
+/* *********************************************************************************
+ * NAME:			create_scene_model
+ *
+ * PURPOSE:	build the LOS model of a scene from the CPF and the ephemeris
+ * 			file of the parameters, and save the CPF groups it parsed in the
+ * 			snapshot next to the CPF when asked to
+ *
+ * RETURN: pointer to the model, NULL on error
+ * *********************************************************************************/
+MWD_SCENE_MODEL *create_scene_model(PARAMETERS *param, IAS_CPF *cpf)
+{
+	MWD_SCENE_MODEL *scene_model;
+	IAS_L0R_EPHEMERIS *l0r_ephemeris = NULL;	//L0R ephemeris records
+	long long num_frame_of_ephemeris;			//number of ephemeris records
+	int status;
+
+	/* read ephemeris file into lor_ephemeris */
+	status = read_ephemeris_data_for_MWD(param,&l0r_ephemeris,
+			&num_frame_of_ephemeris);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("Could not read ephemeris file into lor_ephemeris.\n");
+		return NULL;
+	}
+
+	scene_model = create_scene_model_from_ephemeris(l0r_ephemeris,
+			num_frame_of_ephemeris,cpf);
+	free(l0r_ephemeris);
+
+	/* The snapshot is only a cache, keep going when it can not be saved */
+	if(scene_model != NULL && param->save_cpf_snapshot)
+	{
+		char snapshot_filename[PATH_MAX];
+
+		if(snprintf(snapshot_filename,sizeof(snapshot_filename),"%s%s",
+				param->cpf_filename,IAS_CPF_SNAPSHOT_SUFFIX)
+				>= (int)sizeof(snapshot_filename)
+			|| ias_cpf_write_snapshot(cpf,snapshot_filename) != SUCCESS)
+		{
+			IAS_LOG_WARNING("The CPF snapshot is not saved");
+		}
+	}
+
+	return scene_model;
+}
+
+
+/* *********************************************************************************
+ * NAME:			create_scene_model_from_ephemeris
+ *
+ * PURPOSE:	build the LOS model of a scene: the CPF values, the preprocessed
+ * 			ephemeris and the time base converting frame times to ephemeris
+ * 			times. The CPF is only used here, so the model can be shared
+ * 			once built.
+ *
+ * RETURN: pointer to the model, NULL on error
+ * *********************************************************************************/
+MWD_SCENE_MODEL *create_scene_model_from_ephemeris(
+		const IAS_L0R_EPHEMERIS *l0r_ephemeris,
+		long long num_frame_of_ephemeris, IAS_CPF *cpf)
+{
+	MWD_SCENE_MODEL *scene_model;
+	IAS_ANC_EPHEMERIS_DATA *anc_ephemeris_data = NULL;
+	IAS_SC_EPHEMERIS_MODEL *ephemeris;
+	int status;
+
+	scene_model = calloc(1,sizeof(*scene_model));
+	if(scene_model == NULL)
+	{
+		IAS_LOG_ERROR("failed to allocate the scene model!\n");
+		return NULL;
+	}
+
+	/* Initialize the model structure with the CPF values */
+	scene_model->model = ias_los_model_initialize(IAS_EARTH);
+	if(scene_model->model == NULL)
+	{
+		IAS_LOG_ERROR("Initializing model");
+		free(scene_model);
+		return NULL;
+	}
+
+	if(ias_los_model_set_cpf_for_MWD(cpf,scene_model->model) != SUCCESS)
+	{
+		IAS_LOG_ERROR("Copy cpf value into model");
+		free_scene_model(scene_model);
+		return NULL;
+	}
+
+	/* Preprocess the ephemeris data. */
+	status = ias_ancillary_preprocess_ephemeris_for_MWD(cpf,l0r_ephemeris,
+			num_frame_of_ephemeris,IAS_EARTH,&anc_ephemeris_data,
+			&scene_model->invalid_ephemeris_count,
+			&scene_model->ephemeris_start_time,
+			&scene_model->ephemeris_end_time,&scene_model->time_system);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("Processing ephemeris data");
+		free_scene_model(scene_model);
+		return NULL;
+	}
+
+	status = ias_sc_model_set_ancillary_ephemeris(anc_ephemeris_data,
+			&scene_model->model->spacecraft);
+	ias_ancillary_free_ephemeris(anc_ephemeris_data);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("Setting ephemeris data into model");
+		free_scene_model(scene_model);
+		return NULL;
+	}
+
+	/* Frame times are converted to ephemeris times through this time base,
+	   with the leap seconds of the time system of the ephemeris */
+	ephemeris = &scene_model->model->spacecraft.ephemeris;
+	if(ias_sc_model_init_time_base(ephemeris->utc_epoch_time,
+			&scene_model->time_system,&ephemeris->time_base) != SUCCESS)
+	{
+		IAS_LOG_ERROR("Initializing the ephemeris time base");
+		free_scene_model(scene_model);
+		return NULL;
+	}
+
+	return scene_model;
+}
+
+
+/* *********************************************************************************
+ * NAME:			free_scene_model
+ *
+ * PURPOSE:	free a scene model and its LOS model
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void free_scene_model(MWD_SCENE_MODEL *scene_model)
+{
+	if(scene_model == NULL)
+		return;
+
+	ias_los_model_free(scene_model->model);
+	free(scene_model);
+}
+
+
+/* *********************************************************************************
+ * NAME:			update_mwdImage_scene
+ *
+ * PURPOSE:	update the OLI frames of the mwdImage of a scene covered by the
+ * 			ephemeris of its model, and write the geolocation grid when one
+ * 			is asked for. The mwdImage is updated through sliding windows
+ * 			mapped from the file: the workers locate the frames of the
+ * 			current window while the next window is read in and the
+ * 			previous one is written back. The metrics of the stages are
+ * 			reported over MQ for the order and written to the metrics file.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int update_mwdImage_scene(PARAMETERS *param,
+		const MWD_SCENE_MODEL *scene_model, const char *order_id)
+{
+	MWDIMAGE_FILE mwdImage_file;
+	MWD_FRAME_INDEX frame_index;
+	MWD_FRAME_INDEX oli_frame_index;
+	MWDIMAGE_BUFFER_INFO windows[3];
+	MWDIMAGE_BUFFER_INFO *previous_window;
+	MWDIMAGE_BUFFER_INFO *current_window;
+	MWDIMAGE_BUFFER_INFO *next_window;
+	MWDIMAGE_BUFFER_INFO *swap_window;
+	UPDATE_LONGITUDE_LATITUDE_ARGS update_longitude_latitude_args;
+	GEOLOCATION_GRID geolocation_grid;
+	FRAME_EXECUTOR *executor;
+	MWD_METRICS metrics;
+	long long stage_start_ns;
+	long long write_frames;
+	long long write_bytes;
+	int status;
+	int i;
+
+	/* Start the workers once for all the windows */
+	executor = frame_executor_create(param->num_threads);
+	if(executor == NULL)
+	{
+		IAS_LOG_ERROR("failed to create the frame executor!\n");
+		return ERROR;
+	}
+
+	/* Open the file to update, copying the mwdImage to the output if needed */
+	status = open_mwdImage(param,&mwdImage_file);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("failed to open the mwdImage file!\n");
+		frame_executor_destroy(executor);
+		return ERROR;
+	}
+
+	/* Index the frames once, and keep the OLI frames covered by ephemeris */
+	status = get_frame_index(param,mwdImage_file.fd,
+			mwdImage_file.file_size,&frame_index);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("failed to get the frame index!\n");
+		close_mwdImage(&mwdImage_file);
+		frame_executor_destroy(executor);
+		return ERROR;
+	}
+
+	status = select_oli_frames(&frame_index,scene_model->ephemeris_start_time,
+			scene_model->ephemeris_end_time,&oli_frame_index);
+	free_frame_index(&frame_index);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("failed to select the OLI frames!\n");
+		close_mwdImage(&mwdImage_file);
+		frame_executor_destroy(executor);
+		return ERROR;
+	}
+	IAS_LOG_INFO("%lld OLI frames to update",oli_frame_index.num_entries);
+
+	/* Per-pixel geolocation of the same frames, when a grid file is given */
+	update_longitude_latitude_args.grid = NULL;
+	if(param->grid_filename[0] != '\0')
+	{
+		status = geolocation_grid_open(param,scene_model->model,
+				FRAME_LOCATION_BAND_INDEX,&oli_frame_index,&geolocation_grid);
+		if(status != SUCCESS)
+		{
+			IAS_LOG_ERROR("failed to open the geolocation grid!\n");
+			free_frame_index(&oli_frame_index);
+			close_mwdImage(&mwdImage_file);
+			frame_executor_destroy(executor);
+			return ERROR;
+		}
+		update_longitude_latitude_args.grid = &geolocation_grid;
+	}
+
+	/* Report the stages while the frames are updated */
+	update_longitude_latitude_args.metrics = NULL;
+	status = mwd_metrics_start(&metrics,order_id,executor,
+			oli_frame_index.num_entries);
+	if(status == SUCCESS)
+		update_longitude_latitude_args.metrics = &metrics;
+	else
+		IAS_LOG_WARNING("the stage metrics are not reported");
+
+	memset(windows,0,sizeof(windows));
+	previous_window = &windows[0];
+	current_window = &windows[1];
+	next_window = &windows[2];
+	update_longitude_latitude_args.model = scene_model->model;
+
+	stage_start_ns = mwd_metrics_now_ns();
+	status = map_mwdImage_window(&mwdImage_file,&oli_frame_index,
+			current_window);
+	if(status != SUCCESS)
+	{
+		IAS_LOG_ERROR("failed to map the mwdImage window!\n");
+		goto cleanup;
+	}
+	prefetch_mwdImage_window(current_window);
+	if(update_longitude_latitude_args.metrics != NULL
+			&& current_window->num_bytes_in_buffer != 0)
+	{
+		mwd_metrics_record_stage(&metrics,MWD_STAGE_READ,stage_start_ns,
+				current_window->num_oli_frame,
+				current_window->num_bytes_in_buffer);
+	}
+
+	while(current_window->num_bytes_in_buffer != 0)
+	{
+		update_longitude_latitude_args.mwdImage_buffer_info = current_window;
+		status = frame_executor_submit(executor,update_longitude_latitude,
+				&update_longitude_latitude_args,current_window->num_oli_frame,
+				FRAMES_PER_CHUNK);
+		if(status != SUCCESS)
+		{
+			IAS_LOG_ERROR("failed to submit the mwdImage window!\n");
+			goto cleanup;
+		}
+
+		stage_start_ns = mwd_metrics_now_ns();
+		status = map_mwdImage_window(&mwdImage_file,&oli_frame_index,
+				next_window);
+		if(status != SUCCESS)
+			IAS_LOG_ERROR("failed to map the mwdImage window!\n");
+		else
+		{
+			prefetch_mwdImage_window(next_window);
+			if(update_longitude_latitude_args.metrics != NULL
+					&& next_window->num_bytes_in_buffer != 0)
+			{
+				mwd_metrics_record_stage(&metrics,MWD_STAGE_READ,
+						stage_start_ns,next_window->num_oli_frame,
+						next_window->num_bytes_in_buffer);
+			}
+
+			stage_start_ns = mwd_metrics_now_ns();
+			write_frames = previous_window->num_oli_frame;
+			write_bytes = previous_window->num_bytes_in_buffer;
+			status = unmap_mwdImage_window(&mwdImage_file,previous_window);
+			if(status != SUCCESS)
+				IAS_LOG_ERROR("failed to write back the mwdImage window!\n");
+			else if(update_longitude_latitude_args.metrics != NULL
+					&& write_bytes != 0)
+			{
+				mwd_metrics_record_stage(&metrics,MWD_STAGE_WRITE,
+						stage_start_ns,write_frames,write_bytes);
+			}
+		}
+
+		/* How far the geolocation is behind the I/O of the window */
+		if(update_longitude_latitude_args.metrics != NULL)
+		{
+			mwd_metrics_record_queue_depth(&metrics,
+					frame_executor_get_pending_chunks(executor));
+		}
+		frame_executor_wait(executor);
+		if(status != SUCCESS)
+			goto cleanup;
+
+		swap_window = previous_window;
+		previous_window = current_window;
+		current_window = next_window;
+		next_window = swap_window;
+	}
+
+	stage_start_ns = mwd_metrics_now_ns();
+	write_frames = previous_window->num_oli_frame;
+	write_bytes = previous_window->num_bytes_in_buffer;
+	status = unmap_mwdImage_window(&mwdImage_file,previous_window);
+	if(status != SUCCESS)
+		IAS_LOG_ERROR("failed to write back the mwdImage window!\n");
+	else if(update_longitude_latitude_args.metrics != NULL && write_bytes != 0)
+	{
+		mwd_metrics_record_stage(&metrics,MWD_STAGE_WRITE,stage_start_ns,
+				write_frames,write_bytes);
+	}
+
+cleanup:
+	/* After an error the workers may still use a window, and any window
+	 * can still be mapped */
+	frame_executor_wait(executor);
+	for(i = 0; i < 3; i++)
+	{
+		if(unmap_mwdImage_window(&mwdImage_file,&windows[i]) != SUCCESS)
+			status = ERROR;
+	}
+
+	/* The metrics read the worker times, so they stop first */
+	if(update_longitude_latitude_args.metrics != NULL
+			&& mwd_metrics_stop(&metrics,param->metrics_filename) != SUCCESS)
+	{
+		IAS_LOG_WARNING("failed to write the stage metrics");
+	}
+	frame_executor_destroy(executor);
+	if(update_longitude_latitude_args.grid != NULL
+			&& geolocation_grid_close(&geolocation_grid) != SUCCESS)
+	{
+		status = ERROR;
+	}
+	free_frame_index(&oli_frame_index);
+	if(close_mwdImage(&mwdImage_file) != SUCCESS)
+		status = ERROR;
+
+	return status;
+}
@@ -0,0 +1,55 @@
+/*
+ * mwd_scene.h
+ *
+ *  Processing of one mwdImage scene: the model built from the CPF and the
+ *  ephemeris, and the update of the frames of the mwdImage with it. The
+ *  model is only read once built, so several scenes can share it.
+ */
+
+#ifndef MWD_SCENE_H_
+#define MWD_SCENE_H_
+
+#include "ias_los_model.h"
+#include "ias_cpf.h"
+#include "ias_math.h"
+#include "ias_l0r.h"
+#include "read_parameter.h"
+
+
+/* LOS model of a scene and the ephemeris span it covers */
+typedef struct mwd_scene_model
+{
+	IAS_LOS_MODEL *model;				//LOS model with the ephemeris set
+	IAS_MATH_TIME_SYSTEM time_system;	//time system of the ephemeris span
+	double ephemeris_start_time;		//first valid ephemeris time
+	double ephemeris_end_time;			//last valid ephemeris time
+	int invalid_ephemeris_count;		//ephemeris records screened out
+}MWD_SCENE_MODEL;
+
+
+MWD_SCENE_MODEL *create_scene_model
+(
+	PARAMETERS *param,					//I:parameters, for the ephemeris file
+	IAS_CPF *cpf						//I:CPF of the scene
+);
+
+MWD_SCENE_MODEL *create_scene_model_from_ephemeris
+(
+	const IAS_L0R_EPHEMERIS *l0r_ephemeris,	//I:L0R ephemeris records
+	long long num_frame_of_ephemeris,	//I:number of ephemeris records
+	IAS_CPF *cpf						//I:CPF of the scene
+);
+
+void free_scene_model
+(
+	MWD_SCENE_MODEL *scene_model		//I:model to free, or NULL
+);
+
+int update_mwdImage_scene
+(
+	PARAMETERS *param,					//I:parameters of the scene
+	const MWD_SCENE_MODEL *scene_model,	//I:model of the scene
+	const char *order_id				//I:order the metrics are sent for
+);
+
+#endif /* MWD_SCENE_H_ */
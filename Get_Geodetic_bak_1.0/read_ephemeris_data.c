@@ -6,100 +6,304 @@
  */
 
 
+#include <math.h>
 #include "read_ephemeris_data.h"
 
 
-int read_ephemeris_data_for_MWD(PARAMETERS* param,
-		IAS_L0R_EPHEMERIS** l0r_ephemeris, long long *num_frame_of_ephemeris)
+/* *********************************************************************************
+ * NAME:			decode_ephemeris_record
+ *
+ * PURPOSE:	decode a packed record of the ephemeris file. The fields are
+ * 			copied one by one since they are not aligned in the file.
+ *
+ * RETURN: void
+ * *********************************************************************************/
+static void decode_ephemeris_record(const char *record,
+		IAS_L0R_EPHEMERIS *ephemeris)
+{
+	memset(ephemeris,0,sizeof(*ephemeris));
+	memcpy(&ephemeris->l0r_time.days_from_J2000,
+			record+EPHEMERIS_DAYS_OFFSET,
+			sizeof(ephemeris->l0r_time.days_from_J2000));
+	memcpy(&ephemeris->l0r_time.seconds_of_day,
+			record+EPHEMERIS_SECONDS_OFFSET,
+			sizeof(ephemeris->l0r_time.seconds_of_day));
+	memcpy(&ephemeris->time_tag_sec_orig,record+EPHEMERIS_TIME_TAG_OFFSET,
+			sizeof(ephemeris->time_tag_sec_orig));
+	memcpy(&ephemeris->ecef_position_meters.x,
+			record+EPHEMERIS_POSITION_OFFSET,sizeof(double));
+	memcpy(&ephemeris->ecef_position_meters.y,
+			record+EPHEMERIS_POSITION_OFFSET+sizeof(double),sizeof(double));
+	memcpy(&ephemeris->ecef_position_meters.z,
+			record+EPHEMERIS_POSITION_OFFSET+2*sizeof(double),sizeof(double));
+	memcpy(&ephemeris->ecef_velocity_meters_per_sec.x,
+			record+EPHEMERIS_VELOCITY_OFFSET,sizeof(double));
+	memcpy(&ephemeris->ecef_velocity_meters_per_sec.y,
+			record+EPHEMERIS_VELOCITY_OFFSET+sizeof(double),sizeof(double));
+	memcpy(&ephemeris->ecef_velocity_meters_per_sec.z,
+			record+EPHEMERIS_VELOCITY_OFFSET+2*sizeof(double),sizeof(double));
+	memcpy(&ephemeris->warning_flag,record+EPHEMERIS_WARNING_FLAG_OFFSET,
+			sizeof(ephemeris->warning_flag));
+}
+
+
+/* *********************************************************************************
+ * NAME:			check_ephemeris_record
+ *
+ * PURPOSE:	check that a decoded record holds finite values, a valid time of
+ * 			day and a time after the last record kept, but not more than
+ * 			EPHEMERIS_MAX_STEP after it. A record too far ahead only moves
+ * 			the reference time once EPHEMERIS_GAP_RECORDS such records in a
+ * 			row confirm a gap, so a single corrupt time can not hide the
+ * 			valid records after it.
+ *
+ * RETURN: 1 if the record is valid, 0 if not
+ * *********************************************************************************/
+static int check_ephemeris_record(EPHEMERIS_READER *reader,
+		const IAS_L0R_EPHEMERIS *ephemeris, long long record_index)
 {
-	int i;
-	int Num_Byte_Per_Frame_Of_ephemeris = 69;
+	const IAS_VECTOR *pos = &ephemeris->ecef_position_meters;
+	const IAS_VECTOR *vel = &ephemeris->ecef_velocity_meters_per_sec;
+	double seconds;
 
-	/***********************************************************************
-	 * read ephemeris file data into a buffer
-	 ***********************************************************************/
-	char *ephemeris_data = NULL;
+	if(!isfinite(ephemeris->l0r_time.seconds_of_day)
+			|| ephemeris->l0r_time.seconds_of_day < 0.0
+			|| ephemeris->l0r_time.seconds_of_day >= IAS_SEC_PER_DAY + 1.0
+			|| !isfinite(pos->x) || !isfinite(pos->y) || !isfinite(pos->z)
+			|| !isfinite(vel->x) || !isfinite(vel->y) || !isfinite(vel->z))
+	{
+		IAS_LOG_DEBUG("Invalid ephemeris record %lld",record_index);
+		return 0;
+	}
+
+	seconds = IAS_L0R_CONVERT_TIME_TO_SECONDS_SINCE_J2000(ephemeris->l0r_time);
+	if(reader->num_records > 0 && seconds <= reader->last_time)
+	{
+		IAS_LOG_DEBUG("Ephemeris record %lld at %f is not after %f",
+				record_index,seconds,reader->last_time);
+		return 0;
+	}
 
-	FILE *fp = fopen(param->ephemeris_filename,"r");
-	if(fp != NULL)
+	if(reader->num_records > 0
+			&& seconds - reader->last_time > EPHEMERIS_MAX_STEP)
 	{
-		//go to the end of the file
-		if(fseek(fp,0L,SEEK_END) == 0)
+		if(reader->num_outliers > 0 && seconds > reader->outlier_time
+				&& seconds - reader->outlier_time <= EPHEMERIS_MAX_STEP)
+			reader->num_outliers++;
+		else
+			reader->num_outliers = 1;
+		reader->outlier_time = seconds;
+
+		if(reader->num_outliers < EPHEMERIS_GAP_RECORDS)
 		{
-			//get the size of the file
-			long long bufsize = ftell(fp);
-			*num_frame_of_ephemeris = bufsize / Num_Byte_Per_Frame_Of_ephemeris;
-			if(bufsize == -1)
-				return ERROR;
-			ephemeris_data = malloc(sizeof(char) * bufsize);
-			//go back to the start of the file
-			if(fseek(fp,0L,SEEK_SET) != 0)
-				return ERROR;
-			size_t newlen = fread(ephemeris_data,sizeof(char),bufsize,fp);
-			if (newlen != bufsize)
-			{
-				IAS_LOG_ERROR("failed to read ephemeris file into buffer.\n");
-				return ERROR;
-			}
+			IAS_LOG_DEBUG("Ephemeris record %lld at %f is too far after %f",
+					record_index,seconds,reader->last_time);
+			return 0;
 		}
-		fclose(fp);
+		IAS_LOG_WARNING("Gap of %f seconds in the ephemeris before record "
+				"%lld",seconds - reader->last_time,record_index);
 	}
+	reader->num_outliers = 0;
+
+	return 1;
+}
 
-	/* Allocate memory for lor_ephemeris */
-	*l0r_ephemeris = calloc(*num_frame_of_ephemeris,sizeof(**l0r_ephemeris));
-	if(*l0r_ephemeris == NULL)
+
+/* *********************************************************************************
+ * NAME:			ephemeris_reader_open
+ *
+ * PURPOSE:	open an ephemeris file for reading. No record is decoded until
+ * 			the first update.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int ephemeris_reader_open(const char *filename, EPHEMERIS_READER *reader)
+{
+	memset(reader,0,sizeof(*reader));
+	reader->fd = open(filename,O_RDONLY);
+	if(reader->fd < 0)
 	{
-		IAS_LOG_ERROR("failed to allocate memory for l0r_ephemeris.\n");
+		IAS_LOG_ERROR("failed to open the ephemeris file %s!\n",filename);
 		return ERROR;
 	}
 
-	/* read ephemeris data stored in ephemeris_data into l0r_ephemeris */
-	size_t l0r_time_size = sizeof((*l0r_ephemeris)->l0r_time);
-	size_t time_tag_sec_orig_size = sizeof((*l0r_ephemeris)->time_tag_sec_orig);
-	size_t ecef_velocity_meters_per_sec_size = sizeof((*l0r_ephemeris)->ecef_velocity_meters_per_sec);
-	size_t ecef_position_meters_size = sizeof((*l0r_ephemeris)->ecef_position_meters);
-	size_t warning_flag_size = sizeof((*l0r_ephemeris)->warning_flag);
+	return SUCCESS;
+}
 
-	for(i = 0; i < *num_frame_of_ephemeris; i++)
-	{
-		memcpy(&((*l0r_ephemeris+i)->l0r_time),
-			   (ephemeris_data + i*Num_Byte_Per_Frame_Of_ephemeris),
-				l0r_time_size );
 
-		memcpy(&((*l0r_ephemeris+i)->time_tag_sec_orig),
-			   (ephemeris_data + i*Num_Byte_Per_Frame_Of_ephemeris + l0r_time_size),
-			   time_tag_sec_orig_size);
+/* *********************************************************************************
+ * NAME:			ephemeris_reader_update
+ *
+ * PURPOSE:	decode the complete records appended to the file since the last
+ * 			update, in a single pass over a read-only mapping of the new
+ * 			part of the file. Records that fail the validation or are not
+ * 			after the last record kept are dropped. A partial record at the
+ * 			end of the file is left for a later update.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int ephemeris_reader_update(EPHEMERIS_READER *reader,
+		long long *num_new_records)
+{
+	struct stat file_stat;
+	long long page_size = sysconf(_SC_PAGESIZE);
+	long long complete_size;
+	long long map_offset;
+	long long map_length;
+	long long record_index;
+	long long num_records;
+	long long num_rejected = 0;
+	long long capacity;
+	long long i;
+	IAS_L0R_EPHEMERIS *records;
+	char *memblock;
 
+	if(num_new_records)
+		*num_new_records = 0;
 
-		memcpy(&((*l0r_ephemeris+i)->ecef_position_meters),
-			   (ephemeris_data + i*Num_Byte_Per_Frame_Of_ephemeris
-					   + l0r_time_size + time_tag_sec_orig_size),
-				ecef_position_meters_size);
+	if(fstat(reader->fd,&file_stat) != 0)
+	{
+		IAS_LOG_ERROR("failed to get the size of the ephemeris file!\n");
+		return ERROR;
+	}
 
-		memcpy(&((*l0r_ephemeris+i)->ecef_velocity_meters_per_sec),
-			   (ephemeris_data + i*Num_Byte_Per_Frame_Of_ephemeris
-					   + l0r_time_size + time_tag_sec_orig_size + ecef_position_meters_size),
-				ecef_velocity_meters_per_sec_size);
+	complete_size = (file_stat.st_size / EPHEMERIS_RECORD_SIZE)
+			* EPHEMERIS_RECORD_SIZE;
+	if(complete_size < reader->decoded_size)
+	{
+		IAS_LOG_ERROR("the ephemeris file was truncated to %lld bytes!\n",
+				(long long)file_stat.st_size);
+		return ERROR;
+	}
+	if(complete_size == reader->decoded_size)
+		return SUCCESS;
 
-		memcpy(&((*l0r_ephemeris+i)->warning_flag),
-			   (ephemeris_data + i*Num_Byte_Per_Frame_Of_ephemeris
-					   + l0r_time_size + time_tag_sec_orig_size + ecef_velocity_meters_per_sec_size + ecef_position_meters_size),
-				warning_flag_size);
+	/* Make room for all the new records */
+	num_records = (complete_size - reader->decoded_size)
+			/ EPHEMERIS_RECORD_SIZE;
+	if(reader->num_records + num_records > reader->capacity)
+	{
+		capacity = (reader->capacity == 0) ? EPHEMERIS_INITIAL_CAPACITY
+				: reader->capacity;
+		while(capacity < reader->num_records + num_records)
+			capacity *= 2;
+		records = realloc(reader->records,capacity*sizeof(*records));
+		if(records == NULL)
+		{
+			IAS_LOG_ERROR("failed to allocate memory for l0r_ephemeris.\n");
+			return ERROR;
+		}
+		reader->records = records;
+		reader->capacity = capacity;
 	}
 
+	/* The mapping must start on a page boundary */
+	map_offset = reader->decoded_size & ~(page_size - 1);
+	map_length = complete_size - map_offset;
+	memblock = mmap(NULL,map_length,PROT_READ,MAP_SHARED,reader->fd,
+			map_offset);
+	if(memblock == MAP_FAILED)
+	{
+		IAS_LOG_ERROR("failed to map the ephemeris file at %lld!\n",
+				map_offset);
+		return ERROR;
+	}
+	madvise(memblock,map_length,MADV_SEQUENTIAL);
+
+	record_index = reader->decoded_size / EPHEMERIS_RECORD_SIZE;
+	for(i = 0; i < num_records; i++, record_index++)
+	{
+		IAS_L0R_EPHEMERIS *ephemeris = &reader->records[reader->num_records];
 
-	//write the buffer to the file to check whether the buffer copy is work properly
-//	#if DEBUG_GENERATE_DATA_FILES == 1
-		FILE *fp1 = fopen("/home/cqw/Desktop/extracted1.dat","wb");
-		if(fp1)
+		decode_ephemeris_record(memblock + reader->decoded_size - map_offset
+				+ i*EPHEMERIS_RECORD_SIZE,ephemeris);
+		if(!check_ephemeris_record(reader,ephemeris,record_index))
 		{
-//			for(i = 0; i < *num_frame_of_ephemeris; i++)
-//			{
-				fwrite(*l0r_ephemeris,sizeof(**l0r_ephemeris),*num_frame_of_ephemeris,fp1);
-//			}
+			num_rejected++;
+			continue;
 		}
-//	#endif
+
+		reader->last_time = IAS_L0R_CONVERT_TIME_TO_SECONDS_SINCE_J2000(
+				ephemeris->l0r_time);
+		reader->num_records++;
+	}
+	munmap(memblock,map_length);
+
+	reader->decoded_size = complete_size;
+	reader->num_rejected += num_rejected;
+	if(num_rejected > 0)
+	{
+		IAS_LOG_WARNING("Rejected %lld of %lld ephemeris records",
+				num_rejected,num_records);
+	}
+	if(num_new_records)
+		*num_new_records = num_records - num_rejected;
 
 	return SUCCESS;
 }
 
+
+/* *********************************************************************************
+ * NAME:			ephemeris_reader_close
+ *
+ * PURPOSE:	close the file of a reader and free its records
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void ephemeris_reader_close(EPHEMERIS_READER *reader)
+{
+	if(reader->fd >= 0)
+		close(reader->fd);
+	free(reader->records);
+	memset(reader,0,sizeof(*reader));
+	reader->fd = -1;
+}
+
+
+/* *********************************************************************************
+ * NAME:			read_ephemeris_data_for_MWD
+ *
+ * PURPOSE:	read all the valid records of the ephemeris file
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int read_ephemeris_data_for_MWD(PARAMETERS* param,
+		IAS_L0R_EPHEMERIS** l0r_ephemeris, long long *num_frame_of_ephemeris)
+{
+	EPHEMERIS_READER reader;
+	struct stat file_stat;
+
+	*l0r_ephemeris = NULL;
+	*num_frame_of_ephemeris = 0;
+
+	if(ephemeris_reader_open(param->ephemeris_filename,&reader) != SUCCESS)
+		return ERROR;
+
+	if(ephemeris_reader_update(&reader,NULL) != SUCCESS)
+	{
+		ephemeris_reader_close(&reader);
+		return ERROR;
+	}
+
+	if(fstat(reader.fd,&file_stat) == 0 && file_stat.st_size > reader.decoded_size)
+	{
+		IAS_LOG_WARNING("Ignoring the %lld bytes of a partial ephemeris record",
+				(long long)file_stat.st_size - reader.decoded_size);
+	}
+
+	if(reader.num_records == 0)
+	{
+		IAS_LOG_ERROR("No valid record in the ephemeris file %s!\n",
+				param->ephemeris_filename);
+		ephemeris_reader_close(&reader);
+		return ERROR;
+	}
+
+	/* The records are handed over to the caller */
+	*l0r_ephemeris = reader.records;
+	*num_frame_of_ephemeris = reader.num_records;
+	reader.records = NULL;
+	ephemeris_reader_close(&reader);
+
+	return SUCCESS;
+}
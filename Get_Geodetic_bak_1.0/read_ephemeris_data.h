@@ -11,10 +11,67 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include "ias_logging.h"
 #include "read_parameter.h"
 
 
+/* The ephemeris file is a sequence of packed records. Byte offsets of the
+ * fields in a record: */
+#define EPHEMERIS_RECORD_SIZE 69
+#define EPHEMERIS_DAYS_OFFSET 0				//int32 days from J2000
+#define EPHEMERIS_SECONDS_OFFSET 4			//double seconds of day
+#define EPHEMERIS_TIME_TAG_OFFSET 12		//double original time tag
+#define EPHEMERIS_POSITION_OFFSET 20		//3 doubles ECEF position (m)
+#define EPHEMERIS_VELOCITY_OFFSET 44		//3 doubles ECEF velocity (m/s)
+#define EPHEMERIS_WARNING_FLAG_OFFSET 68	//uint8 warning flag
+#define EPHEMERIS_INITIAL_CAPACITY 4096
+
+/* A record more than EPHEMERIS_MAX_STEP seconds after the last record kept
+ * is taken for a corrupt time, unless EPHEMERIS_GAP_RECORDS records in a row
+ * follow each other that far ahead, which is a gap in the ephemeris */
+#define EPHEMERIS_NOMINAL_INTERVAL 1.0		//seconds between the records
+#define EPHEMERIS_MAX_STEP (8*EPHEMERIS_NOMINAL_INTERVAL)
+#define EPHEMERIS_GAP_RECORDS 3
+
+
+/* Reader of an ephemeris file. The file may still be growing: every update
+ * decodes the records appended since the previous one. */
+typedef struct ephemeris_reader
+{
+	int fd;								//descriptor of the ephemeris file
+	long long decoded_size;				//bytes of the file decoded so far
+	IAS_L0R_EPHEMERIS *records;			//valid records, in time order
+	long long num_records;				//number of valid records
+	long long capacity;					//number of records allocated
+	long long num_rejected;				//records rejected by the validation
+	double last_time;					//J2000 seconds of the last record
+	double outlier_time;				//J2000 seconds of the last record
+										//too far after last_time
+	int num_outliers;					//such records following each other
+}EPHEMERIS_READER;
+
+
+int ephemeris_reader_open
+(
+	const char *filename,				//I:ephemeris file name
+	EPHEMERIS_READER *reader			//O:reader of the file
+);
+
+int ephemeris_reader_update
+(
+	EPHEMERIS_READER *reader,			//I/O:reader of the file
+	long long *num_new_records			//O:valid records added, or NULL
+);
+
+void ephemeris_reader_close
+(
+	EPHEMERIS_READER *reader			//I/O:reader to close
+);
 
 int read_ephemeris_data_for_MWD
 (
@@ -186,7 +186,7 @@ int read_parameters
     /*-----------------------------------------------------------------*/
     /* This is the table definition for things from the parameter file */
     /*-----------------------------------------------------------------*/
-    IAS_PARM_DECLARE_TABLE( parms, 14 );
+    IAS_PARM_DECLARE_TABLE( parms, 23 );
 
 //    IAS_PARM_WORK_ORDER_ID( parms, blob->work_order_id,
 //        sizeof(blob->work_order_id), 1 );
@@ -255,6 +255,97 @@ int read_parameters
 		 parameters->output_filename, sizeof(parameters->output_filename), 0 );
 
 
+	/* Add the flag to save the frame index of the mwdImage */
+	 int default_save_frame_index = 0;
+	 IAS_PARM_ADD_INT( parms, SAVE_FRAME_INDEX,
+		 "save the frame index next to the mwdImage (0 or 1)",
+		 IAS_PARM_OPTIONAL,
+		 IAS_PARM_NOT_ARRAY, 1, 0, 1, 1, &default_save_frame_index,
+		 &parameters->save_frame_index,
+		 sizeof(parameters->save_frame_index), 0 );
+
+
+	/* Add the number of geolocation threads */
+	 int default_num_threads = 0;
+	 IAS_PARM_ADD_INT( parms, NUM_THREADS,
+		 "number of geolocation threads (0 for one per processor)",
+		 IAS_PARM_OPTIONAL,
+		 IAS_PARM_NOT_ARRAY, 1, 0, 1024, 1, &default_num_threads,
+		 &parameters->num_threads,
+		 sizeof(parameters->num_threads), 0 );
+
+
+	/* Add the per-pixel geolocation grid file name, no grid when empty */
+	 const char *default_grid_filename[] = {""};
+	 IAS_PARM_ADD_STRING( parms, GRID_FILENAME,
+		 "per-pixel geolocation grid file name (empty for none)",
+		 IAS_PARM_OPTIONAL,
+		 0, NULL, /* no restrictions */
+		 1, default_grid_filename, /* Default file name */
+		 parameters->grid_filename, sizeof(parameters->grid_filename), 0 );
+
+
+	/* Add the detectors between the output samples of the grid */
+	 int default_grid_sample_spacing = 1;
+	 IAS_PARM_ADD_INT( parms, GRID_SAMPLE_SPACING,
+		 "detectors between the output samples of the grid (1 for all)",
+		 IAS_PARM_OPTIONAL,
+		 IAS_PARM_NOT_ARRAY, 1, 1, 1024, 1, &default_grid_sample_spacing,
+		 &parameters->grid_sample_spacing,
+		 sizeof(parameters->grid_sample_spacing), 0 );
+
+
+	/* Add the detectors per cell of the grid */
+	 int default_grid_cell_samples = 32;
+	 IAS_PARM_ADD_INT( parms, GRID_CELL_SAMPLES,
+		 "detectors per cell of the geolocation grid",
+		 IAS_PARM_OPTIONAL,
+		 IAS_PARM_NOT_ARRAY, 1, 1, 1024, 1, &default_grid_cell_samples,
+		 &parameters->grid_cell_samples,
+		 sizeof(parameters->grid_cell_samples), 0 );
+
+
+	/* Add the frames per cell of the grid */
+	 int default_grid_cell_frames = 16;
+	 IAS_PARM_ADD_INT( parms, GRID_CELL_FRAMES,
+		 "frames per cell of the geolocation grid",
+		 IAS_PARM_OPTIONAL,
+		 IAS_PARM_NOT_ARRAY, 1, 1, 64, 1, &default_grid_cell_frames,
+		 &parameters->grid_cell_frames,
+		 sizeof(parameters->grid_cell_frames), 0 );
+
+
+	/* Add the flag to write the view angles in the grid */
+	 int default_grid_view_angles = 0;
+	 IAS_PARM_ADD_INT( parms, GRID_VIEW_ANGLES,
+		 "write the view angles in the geolocation grid (0 or 1)",
+		 IAS_PARM_OPTIONAL,
+		 IAS_PARM_NOT_ARRAY, 1, 0, 1, 1, &default_grid_view_angles,
+		 &parameters->grid_view_angles,
+		 sizeof(parameters->grid_view_angles), 0 );
+
+
+	/* Add the stage metrics file name, no file when empty */
+	 const char *default_metrics_filename[] = {""};
+	 IAS_PARM_ADD_STRING( parms, METRICS_FILENAME,
+		 "JSON file of the stage metrics (empty for none)",
+		 IAS_PARM_OPTIONAL,
+		 0, NULL, /* no restrictions */
+		 1, default_metrics_filename, /* Default file name */
+		 parameters->metrics_filename, sizeof(parameters->metrics_filename),
+		 0 );
+
+
+	/* Add the flag to save the snapshot of the parsed CPF groups */
+	 int default_save_cpf_snapshot = 0;
+	 IAS_PARM_ADD_INT( parms, SAVE_CPF_SNAPSHOT,
+		 "save the parsed CPF groups next to the CPF (0 or 1)",
+		 IAS_PARM_OPTIONAL,
+		 IAS_PARM_NOT_ARRAY, 1, 0, 1, 1, &default_save_cpf_snapshot,
+		 &parameters->save_cpf_snapshot,
+		 sizeof(parameters->save_cpf_snapshot), 0 );
+
+
 	 /* Add the MQ Orderid */
 	 const char *default_OutputDir[] = {"rps"};
 	 IAS_PARM_ADD_STRING( parms, OUTPUTDIR, "MQ OutputDir",
@@ -41,6 +41,22 @@ typedef struct parameters
     char mwdImage_filename[PATH_MAX];     	/* mwdImage product location */
     char output_filename[PATH_MAX];     	/* output file location */
     IAS_SATELLITE_ID satellite_id;
+    int save_frame_index;                   /* 1 to save the frame index of
+                                               the mwdImage in a sidecar file */
+    int num_threads;                        /* number of geolocation threads,
+                                               0 for one per processor */
+    char grid_filename[PATH_MAX];           /* per-pixel geolocation grid
+                                               output, empty for none */
+    int grid_sample_spacing;                /* detectors between the output
+                                               samples of the grid */
+    int grid_cell_samples;                  /* detectors per grid cell */
+    int grid_cell_frames;                   /* frames per grid cell */
+    int grid_view_angles;                   /* 1 to add the view angles to
+                                               the grid */
+    char metrics_filename[PATH_MAX];        /* JSON metrics of the stages,
+                                               empty for none */
+    int save_cpf_snapshot;                  /* 1 to save the parsed CPF
+                                               groups next to the CPF */
 } PARAMETERS;
 
 
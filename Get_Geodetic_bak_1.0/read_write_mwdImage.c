@@ -6,280 +6,276 @@
  */
 
 
+#define _GNU_SOURCE		/* sync_file_range */
 #include "read_write_mwdImage.h"
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
 
-int get_process_time_needed(PARAMETERS* param, size_t* process_times_needed)
+
+/* *********************************************************************************
+ * NAME:			copy_mwdImage
+ *
+ * PURPOSE:	copy the input mwdImage file to the output file, sharing the
+ * 			extents (copy-on-write) when the file system supports it
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+static int copy_mwdImage(int in_fd, int out_fd, long long file_size)
 {
-	int fd;
-	int status = ERROR;
-	struct stat file_state;
-	long long ret;
+	off_t offset = 0;
+	ssize_t ret;
 
-	/* To obtain file size */
-	fd = open(param->mwdImage_filename,O_RDWR);
-	IAS_LOG_DEBUG("fd = %d\n", fd);
-	if(fd == -1)
+#ifdef FICLONE
+	/* Reflink the whole file, the kernel only copies the pages we dirty */
+	if(ioctl(out_fd,FICLONE,in_fd) == 0)
 	{
-		IAS_LOG_ERROR("failed to open the file!\n");
-		return ERROR;
-	}
-	status = fstat(fd,&file_state);
-	if(status != SUCCESS)
-	{
-		IAS_LOG_ERROR("failed to obtain the file state.\n");
-		return ERROR;
+		return SUCCESS;
 	}
-	IAS_LOG_DEBUG("Size: %llu\n",(uint64_t)file_state.st_size);
+#endif
 
-	ret = file_state.st_size;
-	*process_times_needed = ret / MEM_BLOCK_SIZE;
-	if((ret % MEM_BLOCK_SIZE) != 0)
+	/* Fall back to an in-kernel copy */
+	while(offset < file_size)
 	{
-		*process_times_needed += 1;
+		ret = sendfile(out_fd,in_fd,&offset,file_size-offset);
+		if(ret <= 0)
+		{
+			IAS_LOG_ERROR("failed to copy the mwdImage file!\n");
+			return ERROR;
+		}
 	}
 
 	return SUCCESS;
 }
 
 
-int read_mwdImage(PARAMETERS* param, int process_times,
-					MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info,
-					double ephemeris_start_time, double ephemeris_end_time)
+/* *********************************************************************************
+ * NAME:			open_mwdImage
+ *
+ * PURPOSE:	open the file whose frame headers will be updated. If the output
+ * 			file is the input file (or is not given) the input is updated in
+ * 			place, otherwise the input is copied to the output first. The
+ * 			files are compared by device and inode, so another path to the
+ * 			input (relative, symbolic or hard link) is not truncated.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int open_mwdImage(PARAMETERS* param, MWDIMAGE_FILE* mwdImage_file)
 {
-	char* memblock;
-	long long mem_block_size;
-	int fd;
-	int status = ERROR;
-	FRAME_HEADER *frame_head;
-	frame_head = (FRAME_HEADER*)malloc(sizeof(FRAME_HEADER));
-	long long start_sync_position = 0;
+	int in_fd;
+	struct stat file_state;
+	struct stat output_state;
+	int status;
+
+	memset(mwdImage_file,0,sizeof(*mwdImage_file));
+	mwdImage_file->fd = -1;
+
+	mwdImage_file->in_place = (param->output_filename[0] == '\0')
+			|| (stat(param->output_filename,&output_state) == 0
+				&& stat(param->mwdImage_filename,&file_state) == 0
+				&& output_state.st_dev == file_state.st_dev
+				&& output_state.st_ino == file_state.st_ino);
+
+	in_fd = open(param->mwdImage_filename,
+			mwdImage_file->in_place ? O_RDWR : O_RDONLY);
+	IAS_LOG_DEBUG("fd = %d\n", in_fd);
+	if(in_fd == -1)
+	{
+		IAS_LOG_ERROR("failed to open the file %s!\n",param->mwdImage_filename);
+		return ERROR;
+	}
 
 	/* To obtain file size */
-	fd = open(param->mwdImage_filename,O_RDWR);
-	IAS_LOG_DEBUG("fd = %d\n", fd);
-	if(fd == -1)
+	if(fstat(in_fd,&file_state) != 0)
 	{
-		IAS_LOG_ERROR("failed to open the file!\n");
+		IAS_LOG_ERROR("failed to obtain the file state.\n");
+		close(in_fd);
 		return ERROR;
 	}
+	IAS_LOG_DEBUG("Size: %llu\n",(unsigned long long)file_state.st_size);
+	mwdImage_file->file_size = file_state.st_size;
 
-	/* If it is the first time to read file */
-	if(process_times == 0)
+	if(mwdImage_file->in_place)
 	{
-		/* Allocate memory for memblock */
-		memblock = (char*)malloc(MEM_BLOCK_SIZE*sizeof(char));
-
-		/* Read file into memblock */
-		mem_block_size = read(fd,memblock,MEM_BLOCK_SIZE*sizeof(char));
-		if(mem_block_size == -1)
-		{
-			IAS_LOG_ERROR("failed in pread!\n");
-			return ERROR;
-		}
-
-		/* check the image time, if image time > ephemeris time,
-		 * move to next oli frame, return the position of the
-		 * oli frame whoes image time < ephemeris time
-		 */
-		long long block_index = 0;
-		long long num_frame = 0;
-		while(block_index < mem_block_size)
-		{
-			memcpy(&(frame_head->frame_length),memblock+6+block_index,
-							sizeof(int));
-			memcpy(&(frame_head->mode),memblock+36+block_index,
-					sizeof(char)*4);
-			if(frame_head->mode[0] == 'O' && frame_head->mode[1] == 'L'
-					&& frame_head->mode[2] == 'I')
-			{
-				if((frame_head->time - J2000_SUB_UTC_EPOCH) < ephemeris_start_time*1000)
-				{
-					mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[num_frame++]
-														 = block_index;
-					block_index += frame_head->frame_length;
-				}
-				else
-				{
-					block_index += frame_head->frame_length;
-				}
-
-			}
-			else //frame mode is TIRS or PAN
-			{
-				block_index += frame_head->frame_length;
-			}
-		}
-		mwdImage_buffer_info->num_oli_frame = num_frame;
+		mwdImage_file->fd = in_fd;
 	}
-	/* If it is the last time to read file */
-	else if(process_times == PROCESS_TIME - 1)
+	else
 	{
-		/* Allocate memory for memblock */
-		memblock = (char*)malloc((MEM_BLOCK_SIZE+REDUNDANCY)*sizeof(char));
-
-		/* Read file into memblock */
-		lseek(fd,MEM_BLOCK_SIZE*process_times-REDUNDANCY,SEEK_SET);
-		mem_block_size = read(fd,memblock,(MEM_BLOCK_SIZE+REDUNDANCY)*sizeof(char));
-		if(mem_block_size == -1)
+		mwdImage_file->fd = open(param->output_filename,
+				O_RDWR|O_CREAT|O_TRUNC,0644);
+		if(mwdImage_file->fd == -1)
 		{
-			IAS_LOG_ERROR("failed in pread!\n");
+			IAS_LOG_ERROR("failed to open the file %s!\n",param->output_filename);
+			close(in_fd);
 			return ERROR;
 		}
 
-		/* Sync the frame */
-		status = frame_header_sync(memblock,mem_block_size,&start_sync_position);
+		status = copy_mwdImage(in_fd,mwdImage_file->fd,mwdImage_file->file_size);
+		close(in_fd);
 		if(status != SUCCESS)
 		{
-			IAS_LOG_ERROR("Cann't sync the frame header!\n");
+			close_mwdImage(mwdImage_file);
 			return ERROR;
 		}
-
-		long long block_index = 0;
-		long long num_frame = 0;
-		while(block_index < mem_block_size)
-		{
-			memcpy(&(frame_head->frame_length),memblock+start_sync_position+6+block_index,
-					sizeof(int));
-			memcpy(&(frame_head->mode),memblock+start_sync_position+36+block_index,
-					sizeof(char)*4);
-			if(frame_head->mode[0] == 'O' && frame_head->mode[1] == 'L'
-					&& frame_head->mode[2] == 'I')
-			{
-				if(frame_head->time - J2000_SUB_UTC_EPOCH < ephemeris_end_time*1000)
-				{
-					mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[num_frame++]
-										 = start_sync_position+block_index;
-					block_index += frame_head->frame_length;
-				}
-				else
-				{
-					break;
-				}
-			}
-			else //frame mode is TIRS or PAN
-			{
-				block_index += frame_head->frame_length;
-			}
-		}
-		mwdImage_buffer_info->num_oli_frame = num_frame;
 	}
-	/* Others time to read the file */
-	else
-	{
-		/* Allocate memory for memblock */
-		memblock = (char*)malloc((MEM_BLOCK_SIZE+REDUNDANCY)*sizeof(char));
 
-		/* Read file into memblock */
-		lseek(fd,MEM_BLOCK_SIZE*process_times-REDUNDANCY,SEEK_SET);
-		mem_block_size = read(fd,memblock,(MEM_BLOCK_SIZE+REDUNDANCY)*sizeof(char));
-		if(mem_block_size == -1)
-		{
-			IAS_LOG_ERROR("failed in pread!\n");
-			return ERROR;
-		}
+	return SUCCESS;
+}
 
-		/* Sync the frame */
-		status = frame_header_sync(memblock,mem_block_size,&start_sync_position);
-		if(status != SUCCESS)
-		{
-			IAS_LOG_ERROR("Cann't sync the frame header!\n");
-			return ERROR;
-		}
 
+/* *********************************************************************************
+ * NAME:			map_mwdImage_window
+ *
+ * PURPOSE:	map the next window of the file, holding the headers of as many
+ * 			of the next OLI frames of the index as fit in MWD_WINDOW_SIZE
+ *
+ * RETURN: SUCCESS or ERROR. num_bytes_in_buffer is 0 when all the frames of
+ * 		   the index have been mapped.
+ * *********************************************************************************/
+int map_mwdImage_window(MWDIMAGE_FILE* mwdImage_file,
+					const MWD_FRAME_INDEX *oli_frame_index,
+					MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info)
+{
+	char* memblock;
+	long long map_offset;
+	long long map_end;
+	long long first_frame = mwdImage_file->next_oli_frame;
+	long long last_frame;
+	long long page_size = sysconf(_SC_PAGESIZE);
+	const MWD_FRAME_INDEX_ENTRY *entries = oli_frame_index->entries;
+
+	mwdImage_buffer_info->mem_mapped_buffer = NULL;
+	mwdImage_buffer_info->num_bytes_in_buffer = 0;
+	mwdImage_buffer_info->oli_frames = NULL;
+	mwdImage_buffer_info->num_oli_frame = 0;
+
+	if(first_frame >= oli_frame_index->num_entries)
+	{
+		return SUCCESS;
+	}
 
-		long long block_index = 0;
-		long long num_frame = 0;
-		while(block_index < mem_block_size)
-		{
-			memcpy(&(frame_head->frame_length),memblock+start_sync_position+6+block_index,
-					sizeof(int));
-			memcpy(&(frame_head->mode),memblock+start_sync_position+36+block_index,
-					sizeof(char)*4);
-			if(frame_head->mode[0] == 'O' && frame_head->mode[1] == 'L'
-					&& frame_head->mode[2] == 'I')
-			{
-				mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[num_frame++]
-									 = start_sync_position+block_index;
-				block_index += frame_head->frame_length;
-			}
-			else //frame mode is TIRS or PAN
-			{
-				block_index += frame_head->frame_length;
-			}
-		}
-		mwdImage_buffer_info->num_oli_frame = num_frame;
+	/* The mapping must start on a page boundary, and holds at least the
+	 * header of the first frame */
+	map_offset = entries[first_frame].offset & ~(page_size - 1);
+	last_frame = first_frame + 1;
+	while(last_frame < oli_frame_index->num_entries
+			&& last_frame - first_frame < INT_MAX
+			&& entries[last_frame].offset + FRAME_HEADER_SIZE - map_offset
+				<= MWD_WINDOW_SIZE)
+	{
+		last_frame++;
 	}
+	map_end = entries[last_frame-1].offset + FRAME_HEADER_SIZE;
 
+	memblock = mmap(NULL,map_end-map_offset,PROT_READ|PROT_WRITE,MAP_SHARED,
+			mwdImage_file->fd,map_offset);
+	if(memblock == MAP_FAILED)
+	{
+		IAS_LOG_ERROR("failed to map the mwdImage file at %lld!\n",map_offset);
+		return ERROR;
+	}
+	mwdImage_file->next_oli_frame = last_frame;
 
 	/* store the buffer information into mwdImage_buffer_info */
 	mwdImage_buffer_info->mem_mapped_buffer = memblock;
-	mwdImage_buffer_info->num_bytes_in_buffer = mem_block_size;
+	mwdImage_buffer_info->num_bytes_in_buffer = map_end - map_offset;
+	mwdImage_buffer_info->file_offset_of_buffer = map_offset;
+	mwdImage_buffer_info->oli_frames = &entries[first_frame];
+	mwdImage_buffer_info->num_oli_frame = last_frame - first_frame;
 
-
-	close(fd);
-	return 0;
+	return SUCCESS;
 }
 
 
-int write_mwdImage(PARAMETERS* param, int process_times,
-					MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info)
+/* *********************************************************************************
+ * NAME:			prefetch_mwdImage_window
+ *
+ * PURPOSE:	fault in the pages holding the frame headers of a window, so they
+ * 			are read while the workers are busy with the previous window
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void prefetch_mwdImage_window(const MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info)
 {
-	char* memblock;
-	long long ret;
-	int fd;
+	long long page_size = sysconf(_SC_PAGESIZE);
+	long long last_page = -1;
+	long long page;
+	volatile char touch;
+	int i;
 
-	/* To obtain file size */
-	fd = open(param->output_filename,O_RDWR|O_CREAT);
-	IAS_LOG_DEBUG("fd = %d\n", fd);
-	if(fd == -1)
+	for(i = 0; i < mwdImage_buffer_info->num_oli_frame; i++)
 	{
-		IAS_LOG_ERROR("failed to open the file!\n");
-		return ERROR;
+		page = (mwdImage_buffer_info->oli_frames[i].offset
+				- mwdImage_buffer_info->file_offset_of_buffer) / page_size;
+		if(page != last_page)
+		{
+			touch = mwdImage_buffer_info->mem_mapped_buffer[page*page_size];
+			last_page = page;
+		}
 	}
+	(void)touch;
+}
 
-	/* Write the buffer into file */
-	memblock = mwdImage_buffer_info->mem_mapped_buffer;
-	/* If it is the first time to read file */
-	if(process_times == 0)
-	{
 
-		/* write  memblock into file*/
-		ret = write(fd,memblock+mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[0],
-					mwdImage_buffer_info->num_bytes_in_buffer-mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[0]);
-		if(ret == -1)
-		{
-			IAS_LOG_ERROR("failed in write!\n");
-			return ERROR;
-		}
+/* *********************************************************************************
+ * NAME:			unmap_mwdImage_window
+ *
+ * PURPOSE:	release a window and start writing its dirty pages back to the
+ * 			file without waiting for the write to complete
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int unmap_mwdImage_window(MWDIMAGE_FILE* mwdImage_file,
+					MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info)
+{
+	if(mwdImage_buffer_info->mem_mapped_buffer == NULL)
+	{
+		return SUCCESS;
 	}
-	/* If it is the last time to read file */
-	else if(process_times == PROCESS_TIME - 1)
+
+	if(munmap(mwdImage_buffer_info->mem_mapped_buffer,
+			mwdImage_buffer_info->num_bytes_in_buffer) != 0)
 	{
-		lseek(fd,MEM_BLOCK_SIZE*process_times-REDUNDANCY,SEEK_SET);
-		/* write  memblock into file*/
-		ret = write(fd,memblock,mwdImage_buffer_info->oli_frame_start_bytes_in_buffer
-				[mwdImage_buffer_info->num_oli_frame]);
-		if(ret == -1)
-		{
-			IAS_LOG_ERROR("failed in write!\n");
-			return ERROR;
-		}
+		IAS_LOG_ERROR("failed to unmap the mwdImage window!\n");
+		return ERROR;
 	}
-	else
+
+	/* Only a hint, the kernel writes the pages back anyway */
+	sync_file_range(mwdImage_file->fd,
+			mwdImage_buffer_info->file_offset_of_buffer,
+			mwdImage_buffer_info->num_bytes_in_buffer,SYNC_FILE_RANGE_WRITE);
+
+	mwdImage_buffer_info->mem_mapped_buffer = NULL;
+	mwdImage_buffer_info->num_bytes_in_buffer = 0;
+	mwdImage_buffer_info->oli_frames = NULL;
+	mwdImage_buffer_info->num_oli_frame = 0;
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			close_mwdImage
+ *
+ * PURPOSE:	close the updated file
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int close_mwdImage(MWDIMAGE_FILE* mwdImage_file)
+{
+	int status = SUCCESS;
+
+	if(mwdImage_file->fd != -1)
 	{
-		lseek(fd,MEM_BLOCK_SIZE*process_times-REDUNDANCY,SEEK_SET);
-		/* write  memblock into file*/
-		ret = write(fd,memblock,mwdImage_buffer_info->num_bytes_in_buffer);
-		if(ret == -1)
+		if(close(mwdImage_file->fd) != 0)
 		{
-			IAS_LOG_ERROR("failed in write!\n");
-			return ERROR;
+			IAS_LOG_ERROR("failed to close the mwdImage file!\n");
+			status = ERROR;
 		}
+		mwdImage_file->fd = -1;
 	}
 
-	free(memblock);
-	close(fd);
-	return 0;
+	return status;
 }
 
 
@@ -291,51 +287,48 @@ int frame_header_sync(char* memblock, size_t block_length,
 	int frame_length1;
 	int frame_length2;
 	char* buffer = memblock;
-	long long buffer_index = 0;
-	FRAME_HEADER* frame_header;
-
-	while(buffer_index < block_length-1)
+	size_t buffer_index = 0;
+	size_t second_frame;
+	size_t third_frame;
+
+	/* A frame head is the "L8" sync followed by two more frames at the
+	 * positions given by the frame lengths. The checks of the following
+	 * frames are skipped when the buffer ends before them. */
+	while(buffer_index + FRAME_HEADER_SIZE <= block_length)
 	{
 		if((buffer[buffer_index] == 'L') && (buffer[buffer_index+1] == '8'))
-			break;
-		else
-			buffer_index++;
-	}
-
-	if(buffer_index >= block_length-1)
-	{
-		IAS_LOG_ERROR("failed to find the fisrt frame head.\n");
-		return ERROR;
-	}
-
-	frame_header = (FRAME_HEADER*)malloc(sizeof(FRAME_HEADER));
-//	memcpy(&(frame_header->satName), buffer+buffer_index,sizeof(char)*2);
-	memcpy(&(frame_header->frame_length),buffer+buffer_index+6,sizeof(int));
-	frame_length1 = frame_header->frame_length;
-
-	if((buffer[buffer_index+frame_length1] == 'L')
-			&& (buffer[buffer_index+frame_length1+1] == '8'))
-	{
-		memcpy(&(frame_header->frame_length),
-				buffer+buffer_index+frame_length1+6,sizeof(int));
-		frame_length2 = frame_header->frame_length;
-		if((buffer[buffer_index+frame_length1+frame_length2] == 'L')
-				&&(buffer[buffer_index+frame_length1+frame_length2+1] == '8'))
 		{
-			*start_sync_position = buffer_index;
-			return SUCCESS;
-		}
-		else
-		{
-			IAS_LOG_ERROR("failed to sync third frame.\n");
-			return ERROR;
+			memcpy(&frame_length1,buffer+buffer_index+FRAME_LENGTH_OFFSET,
+					sizeof(int));
+			second_frame = buffer_index + frame_length1;
+			if(frame_length1 >= FRAME_HEADER_SIZE)
+			{
+				if(second_frame + FRAME_HEADER_SIZE > block_length)
+				{
+					*start_sync_position = buffer_index;
+					return SUCCESS;
+				}
+
+				if((buffer[second_frame] == 'L')
+						&& (buffer[second_frame+1] == '8'))
+				{
+					memcpy(&frame_length2,buffer+second_frame
+							+FRAME_LENGTH_OFFSET,sizeof(int));
+					third_frame = second_frame + frame_length2;
+					if((frame_length2 >= FRAME_HEADER_SIZE)
+						&& ((third_frame + 1 >= block_length)
+							|| ((buffer[third_frame] == 'L')
+								&& (buffer[third_frame+1] == '8'))))
+					{
+						*start_sync_position = buffer_index;
+						return SUCCESS;
+					}
+				}
+			}
 		}
+		buffer_index++;
 	}
-	else
-	{
-		IAS_LOG_ERROR("failed to sync second frame.\n");
-		return ERROR;
-	}
-}
-
 
+	IAS_LOG_ERROR("failed to find the fisrt frame head.\n");
+	return ERROR;
+}
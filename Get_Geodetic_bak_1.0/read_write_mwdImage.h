@@ -22,13 +22,23 @@
 #include <string.h>
 #include "ias_logging.h"
 #include "read_parameter.h"
+#include "mwdImage_frame_index.h"
 
 
-#define MEM_BLOCK_SIZE 1073741824UL
-#define REDUNDANCY 1024*1024
+/* Size of the sliding window mapped from the mwdImage file at a time. Only
+ * the pages holding frame headers are actually touched, so this bounds the
+ * address space used per pass, not the amount of I/O. */
+#define MWD_WINDOW_SIZE 268435456UL
 #define J2000_SUB_UTC_EPOCH 946727935861UL
 #define LOCK_TIMES 2
-#define PROCESS_TIME 5
+
+/* Byte offsets of the fields in the frame header of the mwdImage file */
+#define FRAME_LENGTH_OFFSET 6
+#define FRAME_LONGITUDE_OFFSET 10
+#define FRAME_LATITUDE_OFFSET 18
+#define FRAME_TIME_OFFSET 26
+#define FRAME_MODE_OFFSET 36
+#define FRAME_HEADER_SIZE 40
 
 typedef struct frame_header
 {
@@ -44,30 +54,61 @@ typedef struct frame_header
 
 
 
+/* The mwdImage file being updated. The lat/lon are written through a shared
+ * mapping of this file, either the input itself (in-place mode) or a copy of
+ * it at the output location. */
+typedef struct mwdImage_file
+{
+	int fd;								//descriptor of the file being updated
+	int in_place;						//1 if the input file is updated in place
+	long long file_size;				//size of the file in bytes
+	long long next_oli_frame;			//next frame to map in the OLI index
+}MWDIMAGE_FILE;
+
 
 typedef struct mwdImage_buffer_info
 {
-	char* mem_mapped_buffer;
-	long long num_bytes_in_buffer;
-	size_t oli_frame_start_bytes_in_buffer[4096];
+	char* mem_mapped_buffer;			//start of the mapped window
+	long long num_bytes_in_buffer;		//length of the mapped window
+	long long file_offset_of_buffer;	//file offset of the mapped window
+	const MWD_FRAME_INDEX_ENTRY *oli_frames; //OLI frames of the window
 	int num_oli_frame;
 }MWDIMAGE_BUFFER_INFO;
 
+/* Start of a frame of the index in the mapped window */
+#define FRAME_IN_BUFFER(buffer_info,entry) \
+	((buffer_info)->mem_mapped_buffer \
+	 + ((entry)->offset - (buffer_info)->file_offset_of_buffer))
 
-int get_process_time_needed
+
+int open_mwdImage
 (
-	PARAMETERS* param,
-	size_t* process_times_needed
+	PARAMETERS* param, 					//I:parameters
+	MWDIMAGE_FILE* mwdImage_file		//O:the file to update
 );
 
-int read_mwdImage
+int map_mwdImage_window
 (
-		PARAMETERS* param, 							 //I:parmaeters
-		int process_times,							 //I:the process time of the mwdImage file
-		MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info,   //O:pointer of mapped buffer
-													 //	 and the info of oli frame
-		double ephemeris_start_time,
-		double ephemeris_end_time
+	MWDIMAGE_FILE* mwdImage_file,				 //I/O:the file to update
+	const MWD_FRAME_INDEX *oli_frame_index,		 //I:OLI frames to update
+	MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info   //O:pointer of mapped buffer
+												 //	 and the info of oli frame
+);
+
+void prefetch_mwdImage_window
+(
+	const MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info   //I:the window to read
+);
+
+int unmap_mwdImage_window
+(
+	MWDIMAGE_FILE* mwdImage_file,				 //I:the file of the window
+	MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info   //I/O:the window to release
+);
+
+int close_mwdImage
+(
+	MWDIMAGE_FILE* mwdImage_file		//I/O:the file to close
 );
 
 int frame_header_sync
@@ -77,11 +118,4 @@ int frame_header_sync
 	size_t* star_sync_position	//O:the start sync bytes of the mapped buffer
 );
 
-int write_mwdImage
-(
-	PARAMETERS* param, 							 //I:parmaeters
-	int process_times,							 //I:the process time of the mwdImage file
-	MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info   //O:pointer of mapped buffer
-													 //	 and the info of oli frame
-);
 #endif /* READ_WRITE_MWDIMAGE_H_ */
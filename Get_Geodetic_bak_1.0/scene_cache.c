@@ -0,0 +1,283 @@
+/*
+ * scene_cache.c
+ *
+ *  Reference counted LRU cache of values loaded from files.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "ias_const.h"
+#include "ias_logging.h"
+#include "scene_cache.h"
+
+
+/* *********************************************************************************
+ * NAME:			unlink_entry / link_entry_at_head
+ *
+ * PURPOSE:	move the entries in the list ordered from the most to the least
+ * 			recently used. The cache lock is held by the caller.
+ *
+ * RETURN: void
+ * *********************************************************************************/
+static void unlink_entry(SCENE_CACHE *cache, SCENE_CACHE_ENTRY *entry)
+{
+	if(entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->head = entry->next;
+	if(entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->tail = entry->prev;
+	entry->prev = entry->next = NULL;
+}
+
+static void link_entry_at_head(SCENE_CACHE *cache, SCENE_CACHE_ENTRY *entry)
+{
+	entry->prev = NULL;
+	entry->next = cache->head;
+	if(cache->head)
+		cache->head->prev = entry;
+	else
+		cache->tail = entry;
+	cache->head = entry;
+}
+
+static SCENE_CACHE_ENTRY *find_entry(const SCENE_CACHE *cache,
+		const char *key)
+{
+	SCENE_CACHE_ENTRY *entry;
+
+	for(entry = cache->head; entry != NULL; entry = entry->next)
+	{
+		if(strcmp(entry->key,key) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+
+/* *********************************************************************************
+ * NAME:			evict_unused_entries
+ *
+ * PURPOSE:	free the least recently used entries not in use until the cache
+ * 			is back to its capacity. The values are freed after the lock is
+ * 			released since freeing a model can take a while.
+ *
+ * RETURN: void
+ * *********************************************************************************/
+static void evict_unused_entries(SCENE_CACHE *cache)
+{
+	SCENE_CACHE_ENTRY *evicted = NULL;
+	SCENE_CACHE_ENTRY *entry;
+	SCENE_CACHE_ENTRY *prev;
+
+	pthread_mutex_lock(&cache->lock);
+	for(entry = cache->tail; entry != NULL
+			&& cache->num_entries > cache->capacity; entry = prev)
+	{
+		prev = entry->prev;
+		if(entry->ref_count > 0)
+			continue;
+		unlink_entry(cache,entry);
+		cache->num_entries--;
+		entry->next = evicted;
+		evicted = entry;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	while(evicted != NULL)
+	{
+		entry = evicted;
+		evicted = entry->next;
+		IAS_LOG_DEBUG("Evicting %s from the cache",entry->key);
+		cache->free_value(entry->value);
+		free(entry);
+	}
+}
+
+
+/* *********************************************************************************
+ * NAME:			scene_cache_init
+ *
+ * PURPOSE:	initialize an empty cache
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int scene_cache_init(SCENE_CACHE *cache, int capacity,
+		void (*free_value)(void *value))
+{
+	memset(cache,0,sizeof(*cache));
+	if(pthread_mutex_init(&cache->lock,NULL) != 0)
+	{
+		IAS_LOG_ERROR("failed to create the cache lock!\n");
+		return ERROR;
+	}
+	cache->capacity = capacity;
+	cache->free_value = free_value;
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			scene_cache_destroy
+ *
+ * PURPOSE:	free all the values of a cache. No value may be in use.
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void scene_cache_destroy(SCENE_CACHE *cache)
+{
+	SCENE_CACHE_ENTRY *entry;
+
+	IAS_LOG_INFO("Cache of %d entries: %lld hits, %lld misses",
+			cache->num_entries,cache->num_hits,cache->num_misses);
+
+	while((entry = cache->head) != NULL)
+	{
+		if(entry->ref_count > 0)
+			IAS_LOG_WARNING("%s is still in use",entry->key);
+		unlink_entry(cache,entry);
+		cache->free_value(entry->value);
+		free(entry);
+	}
+	cache->num_entries = 0;
+	pthread_mutex_destroy(&cache->lock);
+}
+
+
+/* *********************************************************************************
+ * NAME:			scene_cache_append_file_key
+ *
+ * PURPOSE:	append the identity of a file to a key: its name, device, inode,
+ * 			size and modification time, so a file replaced or rewritten
+ * 			under the same name gives another key
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int scene_cache_append_file_key(const char *filename, char *key,
+		size_t key_size)
+{
+	struct stat file_stat;
+	size_t length = strlen(key);
+	int count;
+
+	if(stat(filename,&file_stat) != 0)
+	{
+		IAS_LOG_ERROR("failed to get the status of %s!\n",filename);
+		return ERROR;
+	}
+
+	count = snprintf(key + length,key_size - length,"%s|%llu|%llu|%lld|%lld.%09ld|",
+			filename,(unsigned long long)file_stat.st_dev,
+			(unsigned long long)file_stat.st_ino,
+			(long long)file_stat.st_size,(long long)file_stat.st_mtim.tv_sec,
+			file_stat.st_mtim.tv_nsec);
+	if(count < 0 || (size_t)count >= key_size - length)
+	{
+		IAS_LOG_ERROR("the cache key of %s is too long!\n",filename);
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			scene_cache_acquire
+ *
+ * PURPOSE:	look up a value and mark it in use until it is released
+ *
+ * RETURN: the value, NULL if it is not in the cache
+ * *********************************************************************************/
+void *scene_cache_acquire(SCENE_CACHE *cache, const char *key)
+{
+	SCENE_CACHE_ENTRY *entry;
+	void *value = NULL;
+
+	pthread_mutex_lock(&cache->lock);
+	entry = find_entry(cache,key);
+	if(entry != NULL)
+	{
+		entry->ref_count++;
+		unlink_entry(cache,entry);
+		link_entry_at_head(cache,entry);
+		value = entry->value;
+		cache->num_hits++;
+	}
+	else
+		cache->num_misses++;
+	pthread_mutex_unlock(&cache->lock);
+
+	return value;
+}
+
+
+/* *********************************************************************************
+ * NAME:			scene_cache_insert
+ *
+ * PURPOSE:	add a value loaded by the caller, in use by the caller until it
+ * 			is released. Least recently used values not in use are evicted
+ * 			past the capacity.
+ *
+ * RETURN: SUCCESS or ERROR
+ * *********************************************************************************/
+int scene_cache_insert(SCENE_CACHE *cache, const char *key, void *value)
+{
+	SCENE_CACHE_ENTRY *entry;
+
+	entry = calloc(1,sizeof(*entry));
+	if(entry == NULL)
+	{
+		IAS_LOG_ERROR("failed to allocate a cache entry!\n");
+		return ERROR;
+	}
+	strncpy(entry->key,key,sizeof(entry->key) - 1);
+	entry->value = value;
+	entry->ref_count = 1;
+
+	pthread_mutex_lock(&cache->lock);
+	if(find_entry(cache,key) != NULL)
+	{
+		pthread_mutex_unlock(&cache->lock);
+		IAS_LOG_ERROR("%s is already in the cache!\n",key);
+		free(entry);
+		return ERROR;
+	}
+	link_entry_at_head(cache,entry);
+	cache->num_entries++;
+	pthread_mutex_unlock(&cache->lock);
+
+	evict_unused_entries(cache);
+	return SUCCESS;
+}
+
+
+/* *********************************************************************************
+ * NAME:			scene_cache_release
+ *
+ * PURPOSE:	mark a value acquired or inserted by the caller as no longer in
+ * 			use by it
+ *
+ * RETURN: void
+ * *********************************************************************************/
+void scene_cache_release(SCENE_CACHE *cache, const char *key)
+{
+	SCENE_CACHE_ENTRY *entry;
+
+	pthread_mutex_lock(&cache->lock);
+	entry = find_entry(cache,key);
+	if(entry != NULL && entry->ref_count > 0)
+		entry->ref_count--;
+	pthread_mutex_unlock(&cache->lock);
+
+	if(entry == NULL)
+	{
+		IAS_LOG_WARNING("%s is not in the cache",key);
+	}
+	else
+		evict_unused_entries(cache);
+}
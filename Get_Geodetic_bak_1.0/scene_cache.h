@@ -0,0 +1,80 @@
+/*
+ * scene_cache.h
+ *
+ *  Least recently used cache of the values loaded from files, such as the
+ *  parsed CPFs and the scene models, keyed by the identity of the files
+ *  they were loaded from. Entries are reference counted: an entry in use
+ *  is never evicted, so the cache may hold more entries than its capacity
+ *  while they are all in use.
+ */
+
+#ifndef SCENE_CACHE_H_
+#define SCENE_CACHE_H_
+
+#include <pthread.h>
+
+/* size of a key, room for the identity of two files */
+#define SCENE_CACHE_KEY_SIZE 8448
+
+
+typedef struct scene_cache_entry
+{
+	char key[SCENE_CACHE_KEY_SIZE];		//identity of the files of the value
+	void *value;						//cached value
+	int ref_count;						//number of users of the value
+	struct scene_cache_entry *prev;		//more recently used entry
+	struct scene_cache_entry *next;		//less recently used entry
+}SCENE_CACHE_ENTRY;
+
+typedef struct scene_cache
+{
+	pthread_mutex_t lock;				//protects the entries and counters
+	SCENE_CACHE_ENTRY *head;			//most recently used entry
+	SCENE_CACHE_ENTRY *tail;			//least recently used entry
+	int num_entries;					//number of entries
+	int capacity;						//entries kept when not in use
+	void (*free_value)(void *value);	//frees an evicted value
+	long long num_hits;					//lookups finding the value
+	long long num_misses;				//lookups not finding it
+}SCENE_CACHE;
+
+
+int scene_cache_init
+(
+	SCENE_CACHE *cache,					//O:cache to initialize
+	int capacity,						//I:entries kept when not in use
+	void (*free_value)(void *value)		//I:frees an evicted value
+);
+
+void scene_cache_destroy
+(
+	SCENE_CACHE *cache					//I/O:cache to free the values of
+);
+
+int scene_cache_append_file_key
+(
+	const char *filename,				//I:file the value depends on
+	char *key,							//I/O:key to append the identity to
+	size_t key_size						//I:size of the key buffer
+);
+
+void *scene_cache_acquire
+(
+	SCENE_CACHE *cache,					//I/O:cache to look in
+	const char *key						//I:key of the value
+);
+
+int scene_cache_insert
+(
+	SCENE_CACHE *cache,					//I/O:cache to add to
+	const char *key,					//I:key of the value
+	void *value							//I:value, acquired by the caller
+);
+
+void scene_cache_release
+(
+	SCENE_CACHE *cache,					//I/O:cache of the value
+	const char *key						//I:key of the value
+);
+
+#endif /* SCENE_CACHE_H_ */
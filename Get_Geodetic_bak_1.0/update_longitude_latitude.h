@@ -15,22 +15,29 @@
 #include "ias_ancillary.h"
 #include "read_parameter.h"
 #include "read_write_mwdImage.h"
+#include "geolocation_grid.h"
+#include "mwd_metrics.h"
 
+/* band index, SCA index and detector located in the frame headers */
+#define FRAME_LOCATION_BAND_INDEX 7
+#define FRAME_LOCATION_SCA_INDEX 9
+#define FRAME_LOCATION_SAMPLE 100
 
 
 typedef struct update_longitude_latitude_args
 {
-	int start_oli_frame_to_update;		//the first frame to update
-	int end_oli_frame_to_update;		//the last frame to update
 	IAS_LOS_MODEL *model;			   //I:pointer to the LOS model
 	MWDIMAGE_BUFFER_INFO* mwdImage_buffer_info;  //I: mapped buffer information
+	const GEOLOCATION_GRID *grid;	   //I:per-pixel grid to fill, or NULL
+	MWD_METRICS *metrics;			   //I/O:stage metrics, or NULL
 }UPDATE_LONGITUDE_LATITUDE_ARGS;
 
 
+/* Run by the frame executor on a chunk of the OLI frames of a window */
 void update_longitude_latitude
 (
-//	double* ephemeris_start_time,      //I:start time of ephemeris data
-//	double* ephemeris_end_time,		   //I:end time of ephemeris data
-	UPDATE_LONGITUDE_LATITUDE_ARGS* update_longitude_latitude_args
+	void* update_longitude_latitude_args,	//I:UPDATE_LONGITUDE_LATITUDE_ARGS
+	long long start_oli_frame_to_update,	//I:the first frame to update
+	long long end_oli_frame_to_update		//I:the frame after the last one
 );
 #endif /* UPDATE_LONGITUDE_LATITUDE_H_ */
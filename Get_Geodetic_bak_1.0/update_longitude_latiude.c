@@ -12,45 +12,89 @@
 
 void update_longitude_latitude
 (
-//	double* ephemeris_start_time,      //I:start time of ephemeris data
-//	double* ephemeris_end_time,		   //I:end time of ephemeris data
-	UPDATE_LONGITUDE_LATITUDE_ARGS* update_longitude_latitude_args
-//	int start_oli_frame_to_update,		//the first frame to update
-//	int end_oli_frame_to_update,		//the last frame to update
-//	IAS_LOS_MODEL *model,			   //I:pointer to the LOS model
-//	MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info  //I: mapped buffer information)
+	void* update_longitude_latitude_args,	//I:UPDATE_LONGITUDE_LATITUDE_ARGS
+	long long start_oli_frame_to_update,	//I:the first frame to update
+	long long end_oli_frame_to_update		//I:the frame after the last one
 )
 {
-	int start_oli_frame_to_update = update_longitude_latitude_args->start_oli_frame_to_update;
-	int end_oli_frame_to_update = update_longitude_latitude_args->end_oli_frame_to_update;
-	IAS_LOS_MODEL *model = update_longitude_latitude_args->model;
-	MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info = update_longitude_latitude_args->mwdImage_buffer_info;
-
-	FRAME_HEADER* frame_head;
-	frame_head = (FRAME_HEADER*)malloc(sizeof(*frame_head));
-	//Check the time to make sure that
+	UPDATE_LONGITUDE_LATITUDE_ARGS *args = update_longitude_latitude_args;
+	IAS_LOS_MODEL *model = args->model;
+	MWDIMAGE_BUFFER_INFO *mwdImage_buffer_info = args->mwdImage_buffer_info;
+
+	long long image_time[IAS_LOS_MODEL_BATCH_SIZE];
+	double latitude[IAS_LOS_MODEL_BATCH_SIZE];
+	double longitude[IAS_LOS_MODEL_BATCH_SIZE];
+	int point_status[IAS_LOS_MODEL_BATCH_SIZE];
+	const MWD_FRAME_INDEX_ENTRY *entry;
+	char* frame;
+	long long start;
+	int count;
 	int i;
 
-	int n_band = 7;
-	int n_sca = 9;
-	double n_sample = 100;
+	int n_band = FRAME_LOCATION_BAND_INDEX;
+	int n_sca = FRAME_LOCATION_SCA_INDEX;
+	double n_sample = FRAME_LOCATION_SAMPLE;
 	double target_elev = 0;
 	IAS_SENSOR_DETECTOR_TYPE dettype = IAS_NOMINAL_DETECTOR;
+	long long start_ns = mwd_metrics_now_ns();
+
+	/* The frame times come from the frame index and only the 16 bytes of
+	 * lat/lon in the frame header are written, so only the pages holding
+	 * them are touched in the mapped window. The frames are located a batch
+	 * at a time, the sensor LOS being the same for all of them. */
+	for(start = start_oli_frame_to_update ; start < end_oli_frame_to_update ;
+			start += count)
+	{
+		count = end_oli_frame_to_update - start;
+		if(count > IAS_LOS_MODEL_BATCH_SIZE)
+		{
+			count = IAS_LOS_MODEL_BATCH_SIZE;
+		}
+
+		entry = &mwdImage_buffer_info->oli_frames[start];
+		for(i = 0 ; i < count ; i++)
+		{
+			image_time[i] = entry[i].time;
+		}
+
+		ias_los_model_input_line_samp_to_geodetic_batch(count,image_time,
+				NULL,NULL,NULL,n_sample,n_band,n_sca,target_elev,model,
+				dettype,latitude,longitude,point_status);
+
+		for(i = 0 ; i < count ; i++)
+		{
+			if(point_status[i] != SUCCESS)
+			{
+				IAS_LOG_WARNING("failed to locate the frame at time %lld",
+						image_time[i]);
+				continue;
+			}
+			frame = FRAME_IN_BUFFER(mwdImage_buffer_info,&entry[i]);
+			memcpy(frame+FRAME_LONGITUDE_OFFSET,&longitude[i],sizeof(double));
+			memcpy(frame+FRAME_LATITUDE_OFFSET,&latitude[i],sizeof(double));
+		}
+	}
+
+	/* The per-pixel grid of the same frames, if one is wanted */
+	if(args->grid != NULL)
+	{
+		entry = &mwdImage_buffer_info->oli_frames[start_oli_frame_to_update];
+		if(geolocation_grid_locate_frames(args->grid,model,entry,
+				end_oli_frame_to_update - start_oli_frame_to_update)
+				!= SUCCESS)
+		{
+			IAS_LOG_WARNING("failed to write the geolocation grid of %lld "
+					"frames",end_oli_frame_to_update-start_oli_frame_to_update);
+		}
+	}
 
-	for(i = start_oli_frame_to_update ; i < end_oli_frame_to_update ; i++)
+	/* The lat/lon written are the bytes of the chunk */
+	if(args->metrics != NULL)
 	{
-		memcpy(&(frame_head->time),mwdImage_buffer_info->mem_mapped_buffer
-				    +mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[i]+26,
-				    sizeof(long long));
-		ias_los_model_input_line_samp_to_geodetic
-					(frame_head->time, n_sample,n_band, n_sca,target_elev,model,
-					 dettype, NULL ,&frame_head->latitude,&frame_head->longtitude);
-		memcpy(mwdImage_buffer_info->mem_mapped_buffer+
-				mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[i]+10,
-				&(frame_head->longtitude), sizeof(double));
-		memcpy(mwdImage_buffer_info->mem_mapped_buffer+
-				mwdImage_buffer_info->oli_frame_start_bytes_in_buffer[i]+10,
-				&(frame_head->latitude), sizeof(double));
+		mwd_metrics_record_stage(args->metrics,MWD_STAGE_GEOLOCATE,start_ns,
+				end_oli_frame_to_update - start_oli_frame_to_update,
+				(end_oli_frame_to_update - start_oli_frame_to_update)
+					* 2 * sizeof(double));
 	}
 }
 